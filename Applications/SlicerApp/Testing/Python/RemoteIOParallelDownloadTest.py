@@ -0,0 +1,227 @@
+from __future__ import print_function
+import os
+import shutil
+import tempfile
+import threading
+import time
+import unittest
+import zlib
+
+try:
+  from http.server import BaseHTTPRequestHandler, HTTPServer
+  from socketserver import ThreadingMixIn
+except ImportError:
+  from BaseHTTPServer import BaseHTTPRequestHandler, HTTPServer
+  from SocketServer import ThreadingMixIn
+
+import slicer
+import vtk
+
+#
+# Test downloading of multiple files in parallel and resuming of interrupted
+# downloads by the HTTP handler, using a local HTTP server.
+#
+
+class ThreadingHTTPServer(ThreadingMixIn, HTTPServer):
+  daemon_threads = True
+
+class RangeRequestHandler(BaseHTTPRequestHandler):
+  """Serves server.files content, supports byte range requests.
+  Each file is sent with the ETag stored in server.etags. Ranges are only sent
+  if the If-Range header matches the ETag of the file.
+  Each request is delayed by server.responseDelaySec to allow detection of parallel downloads.
+  """
+
+  def log_message(self, format, *args):
+    pass
+
+  def do_GET(self):
+    server = self.server
+    name = self.path.lstrip('/')
+    with server.lock:
+      server.requests.append((name, self.headers.get('Range'), self.headers.get('If-Range')))
+      server.numberOfActiveRequests += 1
+      server.maximumNumberOfActiveRequests = max(server.maximumNumberOfActiveRequests, server.numberOfActiveRequests)
+    try:
+      time.sleep(server.responseDelaySec)
+      if name not in server.files:
+        self.send_error(404)
+        return
+      content = server.files[name]
+      etag = server.etags[name]
+      rangeHeader = self.headers.get('Range')
+      ifRangeHeader = self.headers.get('If-Range')
+      if ifRangeHeader is not None and ifRangeHeader != etag:
+        # file has changed since the partial file was downloaded, send the complete file
+        rangeHeader = None
+      if rangeHeader and server.rangeSupported:
+        start = int(rangeHeader.split('=')[1].split('-')[0])
+        if start >= len(content):
+          self.send_response(416)
+          self.send_header('Content-Range', 'bytes */%d' % len(content))
+          self.end_headers()
+          return
+        self.send_response(206)
+        self.send_header('Content-Range', 'bytes %d-%d/%d' % (start, len(content) - 1, len(content)))
+        content = content[start:]
+      else:
+        self.send_response(200)
+      self.send_header('ETag', etag)
+      self.send_header('Content-Length', str(len(content)))
+      self.end_headers()
+      self.wfile.write(content)
+    finally:
+      with server.lock:
+        server.numberOfActiveRequests -= 1
+
+
+class RemoteIOParallelDownloadTest(unittest.TestCase):
+
+  def setUp(self):
+    self.server = ThreadingHTTPServer(('127.0.0.1', 0), RangeRequestHandler)
+    self.server.lock = threading.Lock()
+    self.server.files = {}
+    self.server.etags = {}
+    self.server.requests = []
+    self.server.numberOfActiveRequests = 0
+    self.server.maximumNumberOfActiveRequests = 0
+    self.server.responseDelaySec = 0.0
+    self.server.rangeSupported = True
+    self.serverThread = threading.Thread(target=self.server.serve_forever)
+    self.serverThread.daemon = True
+    self.serverThread.start()
+    self.baseURL = 'http://127.0.0.1:%d/' % self.server.server_address[1]
+    self.tempDir = tempfile.mkdtemp()
+    self.handler = slicer.mrmlScene.FindURIHandlerByName('HTTPHandler')
+    self.assertIsNotNone(self.handler)
+
+  def tearDown(self):
+    self.server.shutdown()
+    self.server.server_close()
+    shutil.rmtree(self.tempDir, True)
+
+  def addFile(self, name, size):
+    content = bytes(bytearray((i * 7 + len(name)) % 256 for i in range(size)))
+    self.server.files[name] = content
+    self.server.etags[name] = '"%s-%08x"' % (name, zlib.crc32(content) & 0xffffffff)
+    return content
+
+  def download(self, names):
+    sources = vtk.vtkStringArray()
+    destinations = vtk.vtkStringArray()
+    for name in names:
+      sources.InsertNextValue(self.baseURL + name)
+      destinations.InsertNextValue(os.path.join(self.tempDir, name))
+    return self.handler.StageFilesRead(sources, destinations)
+
+  def writePartialFile(self, name, content, validator=None):
+    """Write a partial file as if a previous download was interrupted.
+    The validator is the ETag of the response that the partial file was downloaded from.
+    """
+    partialFileName = os.path.join(self.tempDir, name + '.partial')
+    with open(partialFileName, 'wb') as f:
+      f.write(content)
+    validatorFileName = partialFileName + '.validator'
+    if validator is not None:
+      with open(validatorFileName, 'w') as f:
+        f.write(validator + '\n')
+    elif os.path.exists(validatorFileName):
+      os.remove(validatorFileName)
+
+  def readFile(self, name):
+    with open(os.path.join(self.tempDir, name), 'rb') as f:
+      return f.read()
+
+  def test_ParallelDownload(self):
+    names = ['file%d.bin' % i for i in range(8)]
+    contents = [self.addFile(name, 100000 + i) for i, name in enumerate(names)]
+    self.server.responseDelaySec = 0.3
+    self.handler.SetMaximumNumberOfParallelTransfers(4)
+    startTime = time.time()
+    self.assertEqual(self.download(names), 1)
+    print('Downloaded {0} files in {1:.2f} s'.format(len(names), time.time() - startTime))
+    for name, content in zip(names, contents):
+      self.assertEqual(self.readFile(name), content)
+      self.assertFalse(os.path.exists(os.path.join(self.tempDir, name + '.partial')))
+    self.assertEqual(self.server.maximumNumberOfActiveRequests, 4)
+
+    # Failed downloads are reported and do not create a file
+    self.assertEqual(self.download(['missing.bin']), 0)
+    self.assertFalse(os.path.exists(os.path.join(self.tempDir, 'missing.bin')))
+
+  def test_ResumeDownload(self):
+    content = self.addFile('resumed.bin', 200000)
+    etag = self.server.etags['resumed.bin']
+    partialSize = 123456
+    partialFileName = os.path.join(self.tempDir, 'resumed.bin.partial')
+
+    # Partial file is resumed if the file has not changed on the server
+    self.writePartialFile('resumed.bin', content[:partialSize], etag)
+    self.assertEqual(self.download(['resumed.bin']), 1)
+    self.assertEqual(self.readFile('resumed.bin'), content)
+    self.assertEqual(self.server.requests[-1], ('resumed.bin', 'bytes=%d-' % partialSize, etag))
+    self.assertFalse(os.path.exists(partialFileName))
+    self.assertFalse(os.path.exists(partialFileName + '.validator'))
+
+    # If the file has changed on the server (If-Range does not match) then
+    # the complete new file is downloaded in the same request
+    self.writePartialFile('resumed.bin', content[:partialSize], etag)
+    changedContent = self.addFile('resumed.bin', 210000)
+    self.assertNotEqual(self.server.etags['resumed.bin'], etag)
+    numberOfRequests = len(self.server.requests)
+    self.assertEqual(self.download(['resumed.bin']), 1)
+    self.assertEqual(self.readFile('resumed.bin'), changedContent)
+    self.assertEqual(len(self.server.requests), numberOfRequests + 1)
+    self.assertEqual(self.server.requests[-1], ('resumed.bin', 'bytes=%d-' % partialSize, etag))
+    content = changedContent
+    etag = self.server.etags['resumed.bin']
+
+    # Partial file without validator is discarded, because it may belong to a different version of the file
+    self.writePartialFile('resumed.bin', content[:partialSize])
+    self.assertEqual(self.download(['resumed.bin']), 1)
+    self.assertEqual(self.readFile('resumed.bin'), content)
+    self.assertEqual(self.server.requests[-1], ('resumed.bin', None, None))
+
+    # If the server ignores the range request then the complete file is downloaded
+    self.server.rangeSupported = False
+    self.writePartialFile('resumed.bin', content[:partialSize], etag)
+    self.assertEqual(self.download(['resumed.bin']), 1)
+    self.assertEqual(self.readFile('resumed.bin'), content)
+
+    # If the partial file is larger than the file on the server then it is downloaded again
+    self.server.rangeSupported = True
+    self.writePartialFile('resumed.bin', content + content, etag)
+    self.assertEqual(self.download(['resumed.bin']), 1)
+    self.assertEqual(self.readFile('resumed.bin'), content)
+
+    # Disabled resume ignores existing partial files
+    self.handler.ResumeEnabledOff()
+    self.writePartialFile('resumed.bin', content[:partialSize], etag)
+    self.assertEqual(self.download(['resumed.bin']), 1)
+    self.assertEqual(self.readFile('resumed.bin'), content)
+    self.assertIsNone(self.server.requests[-1][1])
+    self.handler.ResumeEnabledOn()
+
+  def test_CacheIndex(self):
+    cacheManager = slicer.mrmlScene.GetCacheManager()
+    originalCacheDirectory = cacheManager.GetRemoteCacheDirectory()
+    cacheDirectory = os.path.join(self.tempDir, 'cache')
+    try:
+      cacheManager.SetRemoteCacheDirectory(cacheDirectory)
+      self.assertEqual(cacheManager.GetCurrentCacheSize(), 0.0)
+
+      fileSize = 1500000
+      self.addFile('cached.bin', fileSize)
+      destination = os.path.join(cacheDirectory, 'cached.bin')
+      self.handler.StageFileRead(self.baseURL + 'cached.bin', destination)
+      cacheManager.UpdateCacheIndex(destination)
+      self.assertAlmostEqual(cacheManager.GetCurrentCacheSize(), fileSize / 1000000.0, places=5)
+      self.assertAlmostEqual(cacheManager.ComputeCacheSize(cacheDirectory, 0), fileSize / 1000000.0, places=5)
+
+      # Index is updated when the file is updated or removed
+      cacheManager.UpdateCacheIndex(destination)
+      self.assertAlmostEqual(cacheManager.GetCurrentCacheSize(), fileSize / 1000000.0, places=5)
+      cacheManager.DeleteFromCache(destination)
+      self.assertEqual(cacheManager.GetCurrentCacheSize(), 0.0)
+    finally:
+      cacheManager.SetRemoteCacheDirectory(originalCacheDirectory)
@@ -0,0 +1,127 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Slicer includes
+#include "vtkSlicerApplicationLogic.h"
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+void CountModifiedEvents(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+  void* clientData, void* vtkNotUsed(callData))
+{
+  int* numberOfModifiedEvents = reinterpret_cast<int*>(clientData);
+  (*numberOfModifiedEvents)++;
+}
+
+//-----------------------------------------------------------------------------
+int TestModifiedQueue(double timeBudget)
+{
+  const int numberOfObjects = 10;
+  const int numberOfRequestsPerObject = 50;
+
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  appLogic->SetNumberOfProcessingThreads(1);
+  appLogic->SetRequestProcessingTimeBudget(timeBudget);
+
+  std::vector<vtkSmartPointer<vtkObject> > objects;
+  std::vector<int> numberOfModifiedEvents(numberOfObjects, 0);
+  for (int i = 0; i < numberOfObjects; ++i)
+    {
+    vtkSmartPointer<vtkCallbackCommand> objectCallback = vtkSmartPointer<vtkCallbackCommand>::New();
+    objectCallback->SetCallback(CountModifiedEvents);
+    objectCallback->SetClientData(&numberOfModifiedEvents[i]);
+    vtkSmartPointer<vtkObject> object = vtkSmartPointer<vtkObject>::New();
+    object->AddObserver(vtkCommand::ModifiedEvent, objectCallback);
+    objects.push_back(object);
+    }
+
+  // Requests are rejected while the queues are not active
+  CHECK_INT(static_cast<int>(appLogic->RequestModified(objects[0])), 0);
+
+  appLogic->CreateProcessingThread();
+  for (int request = 0; request < numberOfRequestsPerObject; ++request)
+    {
+    for (int i = 0; i < numberOfObjects; ++i)
+      {
+      CHECK_BOOL(appLogic->RequestModified(objects[i]) > 0, true);
+      }
+    }
+
+  // Duplicate requests are coalesced even if they are not adjacent
+  CHECK_INT(static_cast<int>(appLogic->GetModifiedQueueSize()), numberOfObjects);
+  CHECK_INT(static_cast<int>(appLogic->GetNumberOfCoalescedModifiedRequests()),
+    numberOfObjects * (numberOfRequestsPerObject - 1));
+
+  if (timeBudget > 0)
+    {
+    // All requests fit in the time budget
+    appLogic->ProcessModified();
+    CHECK_INT(appLogic->GetLastNumberOfProcessedModifiedRequests(), numberOfObjects);
+    }
+  else
+    {
+    // One request per call
+    for (int i = 0; i < numberOfObjects; ++i)
+      {
+      CHECK_INT(static_cast<int>(appLogic->GetModifiedQueueSize()), numberOfObjects - i);
+      appLogic->ProcessModified();
+      CHECK_INT(appLogic->GetLastNumberOfProcessedModifiedRequests(), 1);
+      }
+    }
+  CHECK_INT(static_cast<int>(appLogic->GetModifiedQueueSize()), 0);
+  for (int i = 0; i < numberOfObjects; ++i)
+    {
+    CHECK_INT(numberOfModifiedEvents[i], 1);
+    }
+
+  // Empty queue
+  appLogic->ProcessModified();
+  CHECK_INT(appLogic->GetLastNumberOfProcessedModifiedRequests(), 0);
+
+  // An object can be queued again after it has been processed
+  CHECK_BOOL(appLogic->RequestModified(objects[0]) > 0, true);
+  CHECK_INT(static_cast<int>(appLogic->GetModifiedQueueSize()), 1);
+  appLogic->ProcessModified();
+  CHECK_INT(numberOfModifiedEvents[0], 2);
+
+  std::cout << "Time budget: " << timeBudget << " ms"
+            << "  Last processing time: " << appLogic->GetLastModifiedProcessingTime() << " ms"
+            << std::endl;
+
+  appLogic->TerminateProcessingThread();
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerApplicationLogicRequestQueueTest(int vtkNotUsed(argc), char * vtkNotUsed(argv) [])
+{
+  CHECK_EXIT_SUCCESS(TestModifiedQueue(1000.0));
+  CHECK_EXIT_SUCCESS(TestModifiedQueue(0.0));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Slicer includes
+#include "vtkSlicerApplicationLogic.h"
+#include "vtkSlicerTask.h"
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+class vtkSlicerTaskTestLogic : public vtkMRMLAbstractLogic
+{
+public:
+  static vtkSlicerTaskTestLogic* New();
+  vtkTypeMacro(vtkSlicerTaskTestLogic, vtkMRMLAbstractLogic);
+
+  struct TaskRecord
+    {
+    double ScheduleTime{0.0};
+    double StartTime{0.0};
+    int ExecutionOrder{-1};
+    };
+
+  /// Record start time and order of execution
+  void RunTask(void* clientData)
+    {
+    TaskRecord* record = reinterpret_cast<TaskRecord*>(clientData);
+    record->StartTime = vtkTimerLog::GetUniversalTime();
+    record->ExecutionOrder = this->NumberOfExecutedTasks++;
+    }
+
+  /// Keep the thread busy until the gate is opened
+  void WaitForGate(void* vtkNotUsed(clientData))
+    {
+    this->GateStarted = true;
+    while (!this->GateOpen)
+      {
+      std::this_thread::yield();
+      }
+    }
+
+  std::atomic<int> NumberOfExecutedTasks{0};
+  std::atomic<bool> GateStarted{false};
+  std::atomic<bool> GateOpen{false};
+
+protected:
+  vtkSlicerTaskTestLogic() = default;
+  ~vtkSlicerTaskTestLogic() override = default;
+};
+
+vtkStandardNewMacro(vtkSlicerTaskTestLogic);
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+bool WaitUntil(const std::atomic<int>& value, int expectedValue, double timeoutSec)
+{
+  double startTime = vtkTimerLog::GetUniversalTime();
+  while (value < expectedValue)
+    {
+    if (vtkTimerLog::GetUniversalTime() - startTime > timeoutSec)
+      {
+      return false;
+      }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool ScheduleTestTask(vtkSlicerApplicationLogic* appLogic, vtkSlicerTaskTestLogic* logic,
+  vtkSlicerTaskTestLogic::TaskRecord* record, int priority = 0, bool cancel = false)
+{
+  vtkNew<vtkSlicerTask> task;
+  task->SetTypeToProcessing();
+  task->SetPriority(priority);
+  task->SetTaskFunction(logic, (vtkSlicerTask::TaskFunctionPointer)
+                        &vtkSlicerTaskTestLogic::RunTask, record);
+  if (cancel)
+    {
+    task->Cancel();
+    }
+  record->ScheduleTime = vtkTimerLog::GetUniversalTime();
+  return appLogic->ScheduleTask(task);
+}
+
+//-----------------------------------------------------------------------------
+int TestPriorityAndCancel()
+{
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  vtkNew<vtkSlicerTaskTestLogic> logic;
+
+  // Tasks are rejected while the processing threads are not running
+  vtkSlicerTaskTestLogic::TaskRecord rejectedRecord;
+  CHECK_BOOL(ScheduleTestTask(appLogic, logic, &rejectedRecord), false);
+
+  // Use a single thread so that the execution order is deterministic
+  appLogic->SetNumberOfProcessingThreads(1);
+  appLogic->CreateProcessingThread();
+
+  // Block the processing thread while the tasks are queued
+  vtkNew<vtkSlicerTask> gateTask;
+  gateTask->SetTaskFunction(logic, (vtkSlicerTask::TaskFunctionPointer)
+                            &vtkSlicerTaskTestLogic::WaitForGate, nullptr);
+  CHECK_BOOL(appLogic->ScheduleTask(gateTask) != 0, true);
+  while (!logic->GateStarted)
+    {
+    std::this_thread::yield();
+    }
+
+  vtkSlicerTaskTestLogic::TaskRecord lowPriorityRecord1;
+  vtkSlicerTaskTestLogic::TaskRecord highPriorityRecord;
+  vtkSlicerTaskTestLogic::TaskRecord canceledRecord;
+  vtkSlicerTaskTestLogic::TaskRecord lowPriorityRecord2;
+  CHECK_BOOL(ScheduleTestTask(appLogic, logic, &lowPriorityRecord1, 0), true);
+  CHECK_BOOL(ScheduleTestTask(appLogic, logic, &highPriorityRecord, 10), true);
+  CHECK_BOOL(ScheduleTestTask(appLogic, logic, &canceledRecord, 5, true), true);
+  CHECK_BOOL(ScheduleTestTask(appLogic, logic, &lowPriorityRecord2, 0), true);
+  CHECK_INT(appLogic->GetNumberOfPendingTasks(), 4);
+
+  logic->GateOpen = true;
+  CHECK_BOOL(WaitUntil(logic->NumberOfExecutedTasks, 3, 10.0), true);
+  appLogic->TerminateProcessingThread();
+
+  CHECK_INT(highPriorityRecord.ExecutionOrder, 0);
+  CHECK_INT(lowPriorityRecord1.ExecutionOrder, 1);
+  CHECK_INT(lowPriorityRecord2.ExecutionOrder, 2);
+  CHECK_INT(canceledRecord.ExecutionOrder, -1);
+  CHECK_INT(logic->NumberOfExecutedTasks, 3);
+  CHECK_INT(appLogic->GetNumberOfPendingTasks(), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+int TestLatencyAndThroughput()
+{
+  const int numberOfTasks = 1000;
+
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  vtkNew<vtkSlicerTaskTestLogic> logic;
+  appLogic->CreateProcessingThread();
+
+  std::vector<vtkSlicerTaskTestLogic::TaskRecord> records(numberOfTasks);
+  double startTime = vtkTimerLog::GetUniversalTime();
+  for (int i = 0; i < numberOfTasks; ++i)
+    {
+    CHECK_BOOL(ScheduleTestTask(appLogic, logic, &records[i]), true);
+    }
+  CHECK_BOOL(WaitUntil(logic->NumberOfExecutedTasks, numberOfTasks, 60.0), true);
+  double totalTime = vtkTimerLog::GetUniversalTime() - startTime;
+  appLogic->TerminateProcessingThread();
+
+  double sumLatency = 0.0;
+  double maxLatency = 0.0;
+  for (const vtkSlicerTaskTestLogic::TaskRecord& record : records)
+    {
+    CHECK_BOOL(record.ExecutionOrder >= 0, true);
+    double latency = record.StartTime - record.ScheduleTime;
+    sumLatency += latency;
+    maxLatency = std::max(maxLatency, latency);
+    }
+
+  std::cout << "Number of processing threads: " << appLogic->GetNumberOfProcessingThreads()
+            << "  Tasks: " << numberOfTasks
+            << "  Mean enqueue-to-start latency: " << sumLatency * 1000.0 / numberOfTasks << " ms"
+            << "  Max latency: " << maxLatency * 1000.0 << " ms"
+            << "  Throughput: " << (totalTime > 0.0 ? numberOfTasks / totalTime : 0.0) << " tasks/s"
+            << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerApplicationLogicTaskTest(int vtkNotUsed(argc), char * vtkNotUsed(argv) [])
+{
+  CHECK_EXIT_SUCCESS(TestPriorityAndCancel());
+  CHECK_EXIT_SUCCESS(TestLatencyAndThroughput());
+  return EXIT_SUCCESS;
+}
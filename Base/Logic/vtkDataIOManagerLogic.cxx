@@ -14,6 +14,7 @@
 #include <vtkCallbackCommand.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkStringArray.h>
 
 // VTKsys includes
 #include <vtksys/SystemTools.hxx>
@@ -22,6 +23,7 @@
 
 // STD includes
 #include <cassert>
+#include <vector>
 
 #ifdef linux
 #include "unistd.h"
@@ -384,6 +386,9 @@ int vtkDataIOManagerLogic::QueueRead ( vtkMRMLNode *node )
     return 0;
     }
 
+  //--- transfers that are executed synchronously, in one batch
+  std::vector< vtkSmartPointer<vtkDataTransfer> > synchronousTransfers;
+
   //--- construct and add a record of the transfer
   //--- which includes the ID of associated node
   vtkNew<vtkDataTransfer> transfer0;
@@ -427,17 +432,10 @@ int vtkDataIOManagerLogic::QueueRead ( vtkMRMLNode *node )
     vtkDebugMacro("QueueRead: Schedule a SYNCHRONOUS data transfer");
     //---
     //--- Execute a SYNCHRONOUS data transfer
+    //--- (all files of the storage node are downloaded together, see below)
     //---
     transfer0->SetTransferStatus( vtkDataTransfer::Running);
-    this->ApplyTransfer ( transfer0.GetPointer() );
-    transfer0->SetTransferStatus( vtkDataTransfer::Completed);
-    // now set the node's storage node state to ready
-    vtkDebugMacro("QueueRead: setting storage node state to transferdone: " << dnode->GetNthStorageNode(storageNodeIndex)->GetURI());
-    if (dnode->GetNthStorageNode(storageNodeIndex)->GetNumberOfURIs() == 0)
-      {
-      // done
-      dnode->GetNthStorageNode(storageNodeIndex)->SetReadStateTransferDone();
-      }
+    synchronousTransfers.push_back(transfer0.GetPointer());
     }
 //  this->DebugOff();
 
@@ -480,15 +478,29 @@ int vtkDataIOManagerLogic::QueueRead ( vtkMRMLNode *node )
       {
       vtkDebugMacro("QueueRead: Schedule a SYNCHRONOUS data transfer, n = " << n);
       transfer1->SetTransferStatus( vtkDataTransfer::Running);
-      this->ApplyTransfer ( transfer1.GetPointer() );
-      transfer1->SetTransferStatus( vtkDataTransfer::Completed);
-      // now set the node's storage node state to ready
-
+      synchronousTransfers.push_back(transfer1.GetPointer());
       }
     }
-  if ( dnode->GetNthStorageNode(storageNodeIndex)->GetNumberOfURIs() > 0 &&
-       !this->GetDataIOManager()->GetEnableAsynchronousIO())
+
+  if ( !synchronousTransfers.empty() )
     {
+    //--- download all files of the storage node at once, which allows
+    //--- the handler to run the transfers in parallel
+    vtkNew<vtkStringArray> sources;
+    vtkNew<vtkStringArray> destinations;
+    for (const vtkSmartPointer<vtkDataTransfer>& transfer : synchronousTransfers)
+      {
+      sources->InsertNextValue(transfer->GetSourceURI());
+      destinations->InsertNextValue(transfer->GetDestinationURI());
+      }
+    vtkDebugMacro("QueueRead: stage " << sources->GetNumberOfValues() << " files read on the handler");
+    int success = handler->StageFilesRead(sources, destinations);
+    for (const vtkSmartPointer<vtkDataTransfer>& transfer : synchronousTransfers)
+      {
+      cm->UpdateCacheIndex(transfer->GetDestinationURI());
+      transfer->SetTransferStatus( success ? vtkDataTransfer::Completed : vtkDataTransfer::CompletedWithErrors );
+      }
+    // now set the node's storage node state to ready
     vtkDebugMacro("QueueRead: setting storage node state to transferdone after synchronous transfer of all files: " << dnode->GetNthStorageNode(storageNodeIndex)->GetURI());
     dnode->GetNthStorageNode(storageNodeIndex)->SetReadStateTransferDone();
     }
@@ -688,10 +700,12 @@ void vtkDataIOManagerLogic::ApplyTransfer( void *clientdata )
 
   //assume synchronous io if no data manager exists.
   int asynchIO = 0;
+  vtkCacheManager *cm = nullptr;
   vtkDataIOManager *iom = this->GetDataIOManager();
   if (iom != nullptr)
     {
     asynchIO = iom->GetEnableAsynchronousIO();
+    cm = iom->GetCacheManager();
     }
 
 
@@ -717,6 +731,10 @@ void vtkDataIOManagerLogic::ApplyTransfer( void *clientdata )
         dt->SetTransferStatusNoModify ( vtkDataTransfer::Running );
         this->GetApplicationLogic()->RequestModified( dt );
         handler->StageFileRead( source, dest);
+        if ( cm != nullptr )
+          {
+          cm->UpdateCacheIndex( dest );
+          }
         dt->SetTransferStatusNoModify ( vtkDataTransfer::Completed );
         this->GetApplicationLogic()->RequestModified( dt );
 
@@ -759,6 +777,10 @@ void vtkDataIOManagerLogic::ApplyTransfer( void *clientdata )
         {
         vtkDebugMacro("ApplyTransfer: stage file read on the handler..., source = " << source << ", dest = " << dest);
         handler->StageFileRead( source, dest);
+        if ( cm != nullptr )
+          {
+          cm->UpdateCacheIndex( dest );
+          }
         }
       }
     }
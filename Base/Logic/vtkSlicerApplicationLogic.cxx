@@ -28,6 +28,7 @@
 // VTK includes
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkTimerLog.h>
 
 // ITKSYS includes
 #include <itksys/SystemTools.hxx>
@@ -42,15 +43,64 @@
 #endif
 
 #include <queue>
+#include <set>
+#include <thread>
 
 #include "vtkSlicerApplicationLogicRequests.h"
 
 //----------------------------------------------------------------------------
-class ProcessingTaskQueue : public std::queue<vtkSmartPointer<vtkSlicerTask> > {};
-class ModifiedQueue : public std::queue<vtkSmartPointer<vtkObject> > {};
+struct ScheduledTask
+{
+  vtkSmartPointer<vtkSlicerTask> Task;
+  int Priority;
+  vtkTypeUInt64 SequenceNumber;
+
+  /// Tasks with higher priority come first, tasks with the same
+  /// priority are processed in the order they were scheduled.
+  bool operator<(const ScheduledTask& other) const
+    {
+    if (this->Priority != other.Priority)
+      {
+      return this->Priority < other.Priority;
+      }
+    return this->SequenceNumber > other.SequenceNumber;
+    }
+};
+
+//----------------------------------------------------------------------------
+class ProcessingTaskQueue
+{
+public:
+  std::priority_queue<ScheduledTask> ProcessingTasks;
+  std::priority_queue<ScheduledTask> NetworkingTasks;
+  vtkTypeUInt64 NextSequenceNumber{0};
+
+  std::priority_queue<ScheduledTask>& GetTasks(int taskType)
+    {
+    return (taskType == vtkSlicerTask::Networking ? this->NetworkingTasks : this->ProcessingTasks);
+    }
+};
+
+//----------------------------------------------------------------------------
+class ModifiedQueue : public std::queue<vtkSmartPointer<vtkObject> >
+{
+public:
+  /// Objects currently in the queue, used for skipping duplicate requests
+  std::set<vtkObject*> QueuedObjects;
+};
 class ReadDataQueue : public std::queue<DataRequest*> {};
 class WriteDataQueue : public std::queue<DataRequest*> {};
 
+namespace
+{
+//----------------------------------------------------------------------------
+/// Returns true if more requests can be processed in the current batch
+bool IsRequestProcessingTimeLeft(double startTime, double timeBudgetMs)
+{
+  return timeBudgetMs > 0 && (vtkTimerLog::GetUniversalTime() - startTime) * 1000.0 < timeBudgetMs;
+}
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerApplicationLogic);
 
@@ -58,8 +108,9 @@ vtkStandardNewMacro(vtkSlicerApplicationLogic);
 vtkSlicerApplicationLogic::vtkSlicerApplicationLogic()
 {
   this->ProcessingThreader = itk::PlatformMultiThreader::New();
-  this->ProcessingThreadId = -1;
   this->ProcessingThreadActive = false;
+  this->NumberOfProcessingThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  this->NumberOfProcessingThreads = std::min(this->NumberOfProcessingThreads, 64);
 
   this->ModifiedQueueActive = false;
 
@@ -74,25 +125,26 @@ vtkSlicerApplicationLogic::vtkSlicerApplicationLogic()
   this->InternalWriteDataQueue = new WriteDataQueue;
 
   this->UserInformation = vtkPersonInformation::New();
+
+  this->RequestProcessingTimeBudget = 8.0;
+  this->NumberOfCoalescedModifiedRequests = 0;
+  this->LastNumberOfProcessedModifiedRequests = 0;
+  this->LastNumberOfProcessedReadDataRequests = 0;
+  this->LastNumberOfProcessedWriteDataRequests = 0;
+  this->LastModifiedProcessingTime = 0.0;
+  this->LastReadDataProcessingTime = 0.0;
+  this->LastWriteDataProcessingTime = 0.0;
 }
 
 //----------------------------------------------------------------------------
 vtkSlicerApplicationLogic::~vtkSlicerApplicationLogic()
 {
   // Note that TerminateThread does not kill a thread, it only waits
-  // for the thread to finish.  We need to signal the thread that we
+  // for the thread to finish.  We need to signal the threads that we
   // want to terminate
-  if (this->ProcessingThreadId != -1 && this->ProcessingThreader)
+  if (!this->ProcessingThreadIDs.empty() && this->ProcessingThreader)
     {
-    // Signal the processingThread that we are terminating.
-    this->ProcessingThreadActiveLock.lock();
-    this->ProcessingThreadActive = false;
-    this->ProcessingThreadActiveLock.unlock();
-
-    // Wait for the thread to finish and clean up the state of the threader
-    this->ProcessingThreader->TerminateThread( this->ProcessingThreadId );
-
-    this->ProcessingThreadId = -1;
+    this->TerminateProcessingThread();
     }
 
   delete this->InternalTaskQueue;
@@ -118,6 +170,27 @@ unsigned int vtkSlicerApplicationLogic::GetReadDataQueueSize()
   return static_cast<unsigned int>( (*this->InternalReadDataQueue).size() );
 }
 
+//----------------------------------------------------------------------------
+unsigned int vtkSlicerApplicationLogic::GetModifiedQueueSize()
+{
+  std::lock_guard<std::mutex> lock(this->ModifiedQueueLock);
+  return static_cast<unsigned int>( (*this->InternalModifiedQueue).size() );
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkSlicerApplicationLogic::GetWriteDataQueueSize()
+{
+  std::lock_guard<std::mutex> lock(this->WriteDataQueueLock);
+  return static_cast<unsigned int>( (*this->InternalWriteDataQueue).size() );
+}
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 vtkSlicerApplicationLogic::GetNumberOfCoalescedModifiedRequests()
+{
+  std::lock_guard<std::mutex> lock(this->ModifiedQueueLock);
+  return this->NumberOfCoalescedModifiedRequests;
+}
+
 //-----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::SetMRMLSceneDataIO(vtkMRMLScene* newMRMLScene,
                                                    vtkMRMLRemoteIOLogic *remoteIOLogic,
@@ -171,21 +244,25 @@ void vtkSlicerApplicationLogic::PrintSelf(ostream& os, vtkIndent indent)
   this->vtkObject::PrintSelf(os, indent);
 
   os << indent << "SlicerApplicationLogic:             " << this->GetClassName() << "\n";
+  os << indent << "NumberOfProcessingThreads:          " << this->NumberOfProcessingThreads << "\n";
+  os << indent << "RequestProcessingTimeBudget:        " << this->RequestProcessingTimeBudget << "\n";
 }
 
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::CreateProcessingThread()
 {
-  if (this->ProcessingThreadId == -1)
+  if (this->ProcessingThreadIDs.empty())
     {
     this->ProcessingThreadActiveLock.lock();
     this->ProcessingThreadActive = true;
     this->ProcessingThreadActiveLock.unlock();
 
-    this->ProcessingThreadId
-      = this->ProcessingThreader
-      ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
-                    this);
+    for (int i = 0; i < this->NumberOfProcessingThreads; ++i)
+      {
+      this->ProcessingThreadIDs.push_back ( this->ProcessingThreader
+            ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
+                      this) );
+      }
 
     // Start four network threads (TODO: make the number of threads a setting)
     this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
@@ -228,7 +305,7 @@ void vtkSlicerApplicationLogic::CreateProcessingThread()
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::TerminateProcessingThread()
 {
-  if (this->ProcessingThreadId != -1)
+  if (!this->ProcessingThreadIDs.empty())
     {
     this->ModifiedQueueActiveLock.lock();
     this->ModifiedQueueActive = false;
@@ -246,18 +323,31 @@ void vtkSlicerApplicationLogic::TerminateProcessingThread()
     this->ProcessingThreadActive = false;
     this->ProcessingThreadActiveLock.unlock();
 
-    this->ProcessingThreader->TerminateThread( this->ProcessingThreadId );
-    this->ProcessingThreadId = -1;
+    // Wake up all waiting threads. The queue lock is acquired to make sure
+    // that no thread is between checking the active flag and starting to wait.
+    this->ProcessingTaskQueueLock.lock();
+    this->ProcessingTaskQueueCondition.notify_all();
+    this->NetworkingTaskQueueCondition.notify_all();
+    this->ProcessingTaskQueueLock.unlock();
 
-    std::vector<int>::const_iterator idIterator;
-    idIterator = this->NetworkingThreadIDs.begin();
-    while (idIterator != this->NetworkingThreadIDs.end())
+    for (int threadID : this->ProcessingThreadIDs)
       {
-      this->ProcessingThreader->TerminateThread( *idIterator );
-      ++idIterator;
+      this->ProcessingThreader->TerminateThread( threadID );
+      }
+    this->ProcessingThreadIDs.clear();
+
+    for (int threadID : this->NetworkingThreadIDs)
+      {
+      this->ProcessingThreader->TerminateThread( threadID );
       }
     this->NetworkingThreadIDs.clear();
 
+    // Pending tasks are not executed anymore
+    this->ProcessingTaskQueueLock.lock();
+    this->InternalTaskQueue->ProcessingTasks = std::priority_queue<ScheduledTask>();
+    this->InternalTaskQueue->NetworkingTasks = std::priority_queue<ScheduledTask>();
+    this->ProcessingTaskQueueLock.unlock();
+
     }
 }
 
@@ -283,50 +373,10 @@ vtkSlicerApplicationLogic::ProcessingThreaderCallback(void* arg)
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::ProcessProcessingTasks()
 {
-  int active = true;
-  vtkSmartPointer<vtkSlicerTask> task = nullptr;
-
-  while (active)
-    {
-    // Check to see if we should be shutting down
-    this->ProcessingThreadActiveLock.lock();
-    active = this->ProcessingThreadActive;
-    this->ProcessingThreadActiveLock.unlock();
-
-    if (active)
-      {
-      // pull a task off the queue
-      this->ProcessingTaskQueueLock.lock();
-      if ((*this->InternalTaskQueue).size() > 0)
-        {
-        // std::cout << "Number of queued tasks: " << (*this->InternalTaskQueue).size() << std::endl;
-
-        // only handle processing tasks in this thread
-        task = (*this->InternalTaskQueue).front();
-        if ( task->GetType() == vtkSlicerTask::Processing )
-          {
-          (*this->InternalTaskQueue).pop();
-          }
-        else
-          {
-          task = nullptr;
-          }
-        }
-      this->ProcessingTaskQueueLock.unlock();
-
-      // process the task (should this be in a separate thread?)
-      if (task)
-        {
-        task->Execute();
-        task = nullptr;
-        }
-      }
-
-    // busy wait
-    itksys::SystemTools::Delay(100);
-    }
+  this->ProcessTasks(vtkSlicerTask::Processing);
 }
 
+//----------------------------------------------------------------------------
 itk::ITK_THREAD_RETURN_TYPE
 vtkSlicerApplicationLogic::NetworkingThreaderCallback(void* arg)
 {
@@ -348,45 +398,47 @@ vtkSlicerApplicationLogic::NetworkingThreaderCallback(void* arg)
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::ProcessNetworkingTasks()
 {
-  int active = true;
-  vtkSmartPointer<vtkSlicerTask> task = nullptr;
+  this->ProcessTasks(vtkSlicerTask::Networking);
+}
 
-  while (active)
-    {
-    // Check to see if we should be shutting down
-    this->ProcessingThreadActiveLock.lock();
-    active = this->ProcessingThreadActive;
-    this->ProcessingThreadActiveLock.unlock();
+//----------------------------------------------------------------------------
+bool vtkSlicerApplicationLogic::IsProcessingThreadActive()
+{
+  std::lock_guard<std::mutex> lock(this->ProcessingThreadActiveLock);
+  return this->ProcessingThreadActive;
+}
 
-    if (active)
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::ProcessTasks(int taskType)
+{
+  std::condition_variable& condition = (taskType == vtkSlicerTask::Networking ?
+    this->NetworkingTaskQueueCondition : this->ProcessingTaskQueueCondition);
+  std::priority_queue<ScheduledTask>& tasks = this->InternalTaskQueue->GetTasks(taskType);
+
+  while (true)
+    {
+    vtkSmartPointer<vtkSlicerTask> task;
       {
-      // pull a task off the queue
-      this->ProcessingTaskQueueLock.lock();
-      if ((*this->InternalTaskQueue).size() > 0)
+      // Sleep until a task is scheduled or the threads are terminated
+      std::unique_lock<std::mutex> lock(this->ProcessingTaskQueueLock);
+      condition.wait(lock, [this, &tasks]
         {
-        // std::cout << "Number of queued tasks: " << (*this->InternalTaskQueue).size() << std::endl;
-        task = (*this->InternalTaskQueue).front();
-        if ( task->GetType() == vtkSlicerTask::Networking )
-          {
-          (*this->InternalTaskQueue).pop();
-          }
-        else
-          {
-          task = nullptr;
-          }
-        }
-      this->ProcessingTaskQueueLock.unlock();
-
-      // process the task (should this be in a separate thread?)
-      if (task)
+        return !this->IsProcessingThreadActive() || !tasks.empty();
+        });
+      if (!this->IsProcessingThreadActive())
         {
-        task->Execute();
-        task = nullptr;
+        return;
         }
+      task = tasks.top().Task;
+      tasks.pop();
       }
 
-    // busy wait
-    itksys::SystemTools::Delay(100);
+    // Tasks that are canceled before they are started are skipped
+    if (task->IsCanceled())
+      {
+      continue;
+      }
+    task->Execute();
     }
 }
 
@@ -397,17 +449,43 @@ int vtkSlicerApplicationLogic::ScheduleTask( vtkSlicerTask *task )
   this->ProcessingThreadActiveLock.lock();
   int active = this->ProcessingThreadActive;
   this->ProcessingThreadActiveLock.unlock();
-  if (!active)
+  if (!active || !task)
     {
     return false;
     }
 
+  // Tasks of undefined type are run in the processing threads
+  int taskType = (task->GetType() == vtkSlicerTask::Networking ?
+    vtkSlicerTask::Networking : vtkSlicerTask::Processing);
+  ScheduledTask scheduledTask;
+  scheduledTask.Task = task;
+  scheduledTask.Priority = task->GetPriority();
+
   this->ProcessingTaskQueueLock.lock();
-  (*this->InternalTaskQueue).push( task );
+  scheduledTask.SequenceNumber = this->InternalTaskQueue->NextSequenceNumber++;
+  this->InternalTaskQueue->GetTasks(taskType).push( scheduledTask );
   this->ProcessingTaskQueueLock.unlock();
+
+  // Wake up one idle thread
+  if (taskType == vtkSlicerTask::Networking)
+    {
+    this->NetworkingTaskQueueCondition.notify_one();
+    }
+  else
+    {
+    this->ProcessingTaskQueueCondition.notify_one();
+    }
   return true;
 }
 
+//----------------------------------------------------------------------------
+int vtkSlicerApplicationLogic::GetNumberOfPendingTasks()
+{
+  std::lock_guard<std::mutex> lock(this->ProcessingTaskQueueLock);
+  return static_cast<int>(this->InternalTaskQueue->ProcessingTasks.size()
+    + this->InternalTaskQueue->NetworkingTasks.size());
+}
+
 //----------------------------------------------------------------------------
 vtkMTimeType vtkSlicerApplicationLogic::RequestModified(vtkObject *obj)
 {
@@ -421,11 +499,19 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestModified(vtkObject *obj)
     return 0;
     }
 
-  obj->Register(this);
   this->ModifiedQueueLock.lock();
   this->RequestTimeStamp.Modified();
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
-  (*this->InternalModifiedQueue).push(obj);
+  if (this->InternalModifiedQueue->QueuedObjects.insert(obj).second)
+    {
+    obj->Register(this);
+    (*this->InternalModifiedQueue).push(obj);
+    }
+  else
+    {
+    // The object is already in the queue, it will be modified only once
+    this->NumberOfCoalescedModifiedRequests++;
+    }
   this->ModifiedQueueLock.unlock();
   return uid;
 }
@@ -575,28 +661,27 @@ void vtkSlicerApplicationLogic::ProcessModified()
     return;
     }
 
-  vtkSmartPointer<vtkObject> obj = nullptr;
-  // pull an object off the queue to modify
-  this->ModifiedQueueLock.lock();
-  if ((*this->InternalModifiedQueue).size() > 0)
+  double startTime = vtkTimerLog::GetUniversalTime();
+  int numberOfProcessedRequests = 0;
+  do
     {
-    obj = (*this->InternalModifiedQueue).front();
-    (*this->InternalModifiedQueue).pop();
-
-    // pop off any extra copies of the same object to save some updates
-    while (!(*this->InternalModifiedQueue).empty()
-           && (obj == (*this->InternalModifiedQueue).front()))
+    vtkSmartPointer<vtkObject> obj = nullptr;
+    // pull an object off the queue to modify
+    this->ModifiedQueueLock.lock();
+    if ((*this->InternalModifiedQueue).size() > 0)
       {
+      obj = (*this->InternalModifiedQueue).front();
       (*this->InternalModifiedQueue).pop();
-      obj->Delete(); // decrement ref count
+      this->InternalModifiedQueue->QueuedObjects.erase(obj);
+      }
+    this->ModifiedQueueLock.unlock();
+    if (!obj.GetPointer())
+      {
+      break;
       }
-    }
-  this->ModifiedQueueLock.unlock();
 
-  // Modify the object
-  //  - decrement reference count that was increased when it was added to the queue
-  if (obj.GetPointer())
-    {
+    // Modify the object
+    //  - decrement reference count that was increased when it was added to the queue
     vtkMRMLNode* node = vtkMRMLNode::SafeDownCast(obj);
     if (node)
       {
@@ -612,11 +697,16 @@ void vtkSlicerApplicationLogic::ProcessModified()
       }
     obj->Delete();
     obj = nullptr;
+    numberOfProcessedRequests++;
     }
+  while (IsRequestProcessingTimeLeft(startTime, this->RequestProcessingTimeBudget));
+
+  this->LastNumberOfProcessedModifiedRequests = numberOfProcessedRequests;
+  this->LastModifiedProcessingTime = (vtkTimerLog::GetUniversalTime() - startTime) * 1000.0;
 
   // schedule the next timer sooner in case there is stuff in the queue
   // otherwise for a while later
-  int delay = (*this->InternalModifiedQueue).size() > 0 ? 0: 200;
+  int delay = this->GetModifiedQueueSize() > 0 ? 0: 200;
   this->InvokeEvent(vtkSlicerApplicationLogic::RequestModifiedEvent, &delay);
 }
 
@@ -632,32 +722,46 @@ void vtkSlicerApplicationLogic::ProcessReadData()
     return;
     }
 
-  // pull an object off the queue
-  DataRequest* req = nullptr;
-  this->ReadDataQueueLock.lock();
-  if ((*this->InternalReadDataQueue).size() > 0)
+  double startTime = vtkTimerLog::GetUniversalTime();
+  std::vector<vtkMTimeType> processedUIDs;
+  do
     {
-    req = (*this->InternalReadDataQueue).front();
-    (*this->InternalReadDataQueue).pop();
-    }
-  this->ReadDataQueueLock.unlock();
+    // pull an object off the queue
+    DataRequest* req = nullptr;
+    this->ReadDataQueueLock.lock();
+    if ((*this->InternalReadDataQueue).size() > 0)
+      {
+      req = (*this->InternalReadDataQueue).front();
+      (*this->InternalReadDataQueue).pop();
+      }
+    this->ReadDataQueueLock.unlock();
+    if (!req)
+      {
+      break;
+      }
 
-  vtkMTimeType uid = 0;
-  if (req)
-    {
-    uid = req->GetUID();
+    processedUIDs.push_back(req->GetUID());
     req->Execute(this);
     delete req;
     }
+  while (IsRequestProcessingTimeLeft(startTime, this->RequestProcessingTimeBudget));
+
+  this->LastNumberOfProcessedReadDataRequests = static_cast<int>(processedUIDs.size());
+  this->LastReadDataProcessingTime = (vtkTimerLog::GetUniversalTime() - startTime) * 1000.0;
 
+  this->ReadDataQueueLock.lock();
   int delay = (*this->InternalReadDataQueue).size() > 0 ? 0: 200;
+  this->ReadDataQueueLock.unlock();
   // schedule the next timer sooner in case there is stuff in the queue
   // otherwise for a while later
   this->InvokeEvent(vtkSlicerApplicationLogic::RequestReadDataEvent, &delay);
-  if (uid)
+  for (vtkMTimeType uid : processedUIDs)
     {
-    this->InvokeEvent(vtkSlicerApplicationLogic::RequestProcessedEvent,
-                      reinterpret_cast<void*>(uid));
+    if (uid)
+      {
+      this->InvokeEvent(vtkSlicerApplicationLogic::RequestProcessedEvent,
+                        reinterpret_cast<void*>(uid));
+      }
     }
 }
 
@@ -673,30 +777,46 @@ void vtkSlicerApplicationLogic::ProcessWriteData()
     return;
     }
 
-  // pull an object off the queue
-  DataRequest *req = nullptr;
-  this->WriteDataQueueLock.lock();
-  if ((*this->InternalWriteDataQueue).size() > 0)
+  double startTime = vtkTimerLog::GetUniversalTime();
+  std::vector<vtkMTimeType> processedUIDs;
+  do
     {
-    req = (*this->InternalWriteDataQueue).front();
-    (*this->InternalWriteDataQueue).pop();
-    }
-  this->WriteDataQueueLock.unlock();
+    // pull an object off the queue
+    DataRequest *req = nullptr;
+    this->WriteDataQueueLock.lock();
+    if ((*this->InternalWriteDataQueue).size() > 0)
+      {
+      req = (*this->InternalWriteDataQueue).front();
+      (*this->InternalWriteDataQueue).pop();
+      }
+    this->WriteDataQueueLock.unlock();
+    if (!req)
+      {
+      break;
+      }
 
-  if (req)
-  {
-    vtkMTimeType uid = req->GetUID();
+    processedUIDs.push_back(req->GetUID());
     req->Execute(this);
     delete req;
+    }
+  while (IsRequestProcessingTimeLeft(startTime, this->RequestProcessingTimeBudget));
 
+  this->LastNumberOfProcessedWriteDataRequests = static_cast<int>(processedUIDs.size());
+  this->LastWriteDataProcessingTime = (vtkTimerLog::GetUniversalTime() - startTime) * 1000.0;
+
+  if (!processedUIDs.empty())
+  {
     // schedule the next timer sooner in case there is stuff in the queue
     // otherwise for a while later
-    int delay = (*this->InternalWriteDataQueue).size() > 0 ? 0 : 200;
+    int delay = this->GetWriteDataQueueSize() > 0 ? 0 : 200;
     this->InvokeEvent(vtkSlicerApplicationLogic::RequestWriteDataEvent, &delay);
-    if (uid)
+    for (vtkMTimeType uid : processedUIDs)
       {
-      this->InvokeEvent(vtkSlicerApplicationLogic::RequestProcessedEvent,
-        reinterpret_cast<void*>(uid));
+      if (uid)
+        {
+        this->InvokeEvent(vtkSlicerApplicationLogic::RequestProcessedEvent,
+          reinterpret_cast<void*>(uid));
+        }
       }
   }
 }
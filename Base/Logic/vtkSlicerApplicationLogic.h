@@ -31,6 +31,7 @@
 #include <itkPlatformMultiThreader.h>
 
 // STL includes
+#include <condition_variable>
 #include <mutex>
 
 class vtkMRMLSelectionNode;
@@ -72,11 +73,17 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
   /// (display it in the Fiducials GUI)
   void PropagateFiducialListSelection();
 
-  /// Create a thread for processing
+  /// Create the processing threads
   void CreateProcessingThread();
 
-  /// Shutdown the processing thread
+  /// Shutdown the processing threads
   void TerminateProcessingThread();
+
+  /// Number of threads that run processing tasks concurrently.
+  /// Default is the number of CPU cores.
+  /// Must be set before the processing threads are created by CreateProcessingThread().
+  vtkSetClampMacro(NumberOfProcessingThreads, int, 1, 64);
+  vtkGetMacro(NumberOfProcessingThreads, int);
   /// List of events potentially fired by the application logic
   enum RequestEvents
     {
@@ -90,11 +97,17 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
       RequestProcessedEvent
     };
 
-  /// Schedule a task to run in the processing thread. Returns true if
+  /// Schedule a task to run in a processing (or networking) thread. Returns true if
   /// task was successfully scheduled. ScheduleTask() is called from the
   /// main thread to run something in the processing thread.
+  /// Tasks with higher priority are started first, tasks with the same priority
+  /// are started in the order they were scheduled.
+  /// \sa vtkSlicerTask::SetPriority(), vtkSlicerTask::Cancel()
   int ScheduleTask( vtkSlicerTask* );
 
+  /// Get number of tasks that are scheduled but not started yet.
+  int GetNumberOfPendingTasks();
+
   /// Request a Modified call on an object.  This method allows a
   /// processing thread to request a Modified call on an object to be
   /// performed in the main thread.  This allows the call to Modified
@@ -170,21 +183,56 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
                        int displayData = false,
                        int deleteFile = false);
 
-  /// Process a request on the Modified queue.  This method is called
+  /// Process requests on the Modified queue.  This method is called
   /// in the main thread of the application because calls to Modified()
   /// can cause an update to the GUI. (Method needs to be public to fit
   /// in the event callback chain.)
+  /// Requests are processed until the queue is empty or RequestProcessingTimeBudget
+  /// is used up.
   void ProcessModified();
 
-  /// Process a request to read data and set it on a referenced node.
+  /// Process requests to read data and set it on a referenced node.
   /// This method is called in the main thread of the application
   /// because calls to load data will cause a Modified() on a node
   /// which can force a render.
+  /// Requests are processed until the queue is empty or RequestProcessingTimeBudget
+  /// is used up.
   void ProcessReadData();
 
-  /// Process a request to write data from a referenced node.
+  /// Process requests to write data from a referenced node.
+  /// Requests are processed until the queue is empty or RequestProcessingTimeBudget
+  /// is used up.
   void ProcessWriteData();
 
+  /// Time (in milliseconds) that ProcessModified(), ProcessReadData() and
+  /// ProcessWriteData() may spend in one call to process queued requests.
+  /// At least one request is processed in each call. If set to 0 then exactly
+  /// one request is processed in each call. Default is 8 ms.
+  vtkSetMacro(RequestProcessingTimeBudget, double);
+  vtkGetMacro(RequestProcessingTimeBudget, double);
+
+  /// Return the number of objects waiting in the Modified queue.
+  unsigned int GetModifiedQueueSize();
+
+  /// Return the number of requests waiting in the WriteData queue.
+  unsigned int GetWriteDataQueueSize();
+
+  /// Return the number of Modified requests that were not added to the queue
+  /// because the object was already waiting in the queue.
+  vtkTypeUInt64 GetNumberOfCoalescedModifiedRequests();
+
+  /// Number of requests processed in the last call of ProcessModified(),
+  /// ProcessReadData() and ProcessWriteData(). For profiling.
+  vtkGetMacro(LastNumberOfProcessedModifiedRequests, int);
+  vtkGetMacro(LastNumberOfProcessedReadDataRequests, int);
+  vtkGetMacro(LastNumberOfProcessedWriteDataRequests, int);
+
+  /// Time (in milliseconds) spent in the last call of ProcessModified(),
+  /// ProcessReadData() and ProcessWriteData(). For profiling.
+  vtkGetMacro(LastModifiedProcessingTime, double);
+  vtkGetMacro(LastReadDataProcessingTime, double);
+  vtkGetMacro(LastWriteDataProcessingTime, double);
+
   /// These routings act as place holders so that test scripts can
   /// turn on and off tracing.  These are just hooks
   /// for use with external tracing tool (such as AQTime)
@@ -237,12 +285,19 @@ protected:
    /// Callback used by a MultiThreader to start a networking thread
   static itk::ITK_THREAD_RETURN_TYPE NetworkingThreaderCallback( void * );
 
-  /// Task processing loop that is run in the processing thread
+  /// Task processing loop that is run in each processing thread
   void ProcessProcessingTasks();
 
   /// Networking Task processing loop that is run in a networking thread
   void ProcessNetworkingTasks();
 
+  /// Wait for tasks of the specified type and execute them until the
+  /// processing threads are terminated.
+  void ProcessTasks(int taskType);
+
+  /// Thread-safe query of the processing thread active flag.
+  bool IsProcessingThreadActive();
+
   /// Process a request to read data into a scene.  This method is
   /// called by ProcessReadData() in the application main thread
   /// because calls to load data will cause a Modified() on a node
@@ -263,6 +318,8 @@ private:
   itk::PlatformMultiThreader::Pointer ProcessingThreader;
   std::mutex ProcessingThreadActiveLock;
   std::mutex ProcessingTaskQueueLock;
+  std::condition_variable ProcessingTaskQueueCondition;
+  std::condition_variable NetworkingTaskQueueCondition;
   std::mutex ModifiedQueueActiveLock;
   std::mutex ModifiedQueueLock;
   std::mutex ReadDataQueueActiveLock;
@@ -270,8 +327,9 @@ private:
   std::mutex WriteDataQueueActiveLock;
   std::mutex WriteDataQueueLock;
   vtkTimeStamp RequestTimeStamp;
-  int ProcessingThreadId;
+  std::vector<int> ProcessingThreadIDs;
   std::vector<int> NetworkingThreadIDs;
+  int NumberOfProcessingThreads;
   int ProcessingThreadActive;
   int ModifiedQueueActive;
   int ReadDataQueueActive;
@@ -284,6 +342,15 @@ private:
 
   vtkPersonInformation* UserInformation;
 
+  double RequestProcessingTimeBudget;
+  vtkTypeUInt64 NumberOfCoalescedModifiedRequests;
+  int LastNumberOfProcessedModifiedRequests;
+  int LastNumberOfProcessedReadDataRequests;
+  int LastNumberOfProcessedWriteDataRequests;
+  double LastModifiedProcessingTime;
+  double LastReadDataProcessingTime;
+  double LastWriteDataProcessingTime;
+
   /// For use with external tracing tool (such as AQTime)
   int Tracing;
 };
@@ -13,6 +13,8 @@ vtkSlicerTask::vtkSlicerTask()
   this->TaskFunction = nullptr;
   this->TaskClientData = nullptr;
   this->Type = vtkSlicerTask::Undefined;
+  this->Priority = 0;
+  this->Canceled = false;
 }
 //----------------------------------------------------------------------------
 vtkSlicerTask::~vtkSlicerTask() = default;
@@ -40,4 +42,7 @@ void vtkSlicerTask::Execute()
 void vtkSlicerTask::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "Type: " << this->GetTypeAsString() << "\n";
+  os << indent << "Priority: " << this->Priority << "\n";
+  os << indent << "Canceled: " << (this->Canceled ? "true" : "false") << "\n";
 }
@@ -6,6 +6,9 @@
 #include "vtkMRMLAbstractLogic.h"
 #include "vtkSlicerBaseLogic.h"
 
+// STD includes
+#include <atomic>
+
 class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerTask : public vtkObject
 {
 public:
@@ -48,6 +51,21 @@ public:
     return "Unknown";
   }
 
+  ///
+  /// Tasks with higher priority are started before tasks with lower priority.
+  /// Tasks with the same priority are started in the order they were scheduled.
+  /// Default is 0. Priority must be set before the task is scheduled.
+  vtkSetMacro(Priority, int);
+  vtkGetMacro(Priority, int);
+
+  ///
+  /// Request cancellation of the task. A canceled task is not started
+  /// if it is still waiting in the queue. A task function that is already
+  /// running may check IsCanceled() to stop early.
+  /// This method is thread-safe.
+  void Cancel() { this->Canceled = true; }
+  bool IsCanceled() { return this->Canceled; }
+
 protected:
   vtkSlicerTask();
   ~vtkSlicerTask() override;
@@ -60,6 +78,8 @@ private:
   void *TaskClientData;
 
   int Type;
+  int Priority;
+  std::atomic<bool> Canceled;
 
 };
 #endif
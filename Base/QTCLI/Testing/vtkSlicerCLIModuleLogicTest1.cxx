@@ -0,0 +1,78 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Qt includes
+#include <QTemporaryDir>
+
+// MRMLCLI includes
+#include <vtkSlicerCLIModuleLogic.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtksys/SystemTools.hxx>
+
+#include "vtkMRMLCoreTestingMacros.h"
+
+//-----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogicTest1(int, char * [] )
+{
+  QTemporaryDir sharedDirectory;
+  CHECK_BOOL(sharedDirectory.isValid(), true);
+  std::string sharedDirectoryPath = sharedDirectory.path().toStdString();
+
+  vtkNew<vtkSlicerCLIModuleLogic> logic;
+  // Without application logic the current directory is used as temporary directory
+  const std::string defaultDirectory = ".";
+
+  // Memory-backed files are disabled by default
+  CHECK_INT(logic->GetUseMemoryBackedTemporaryFiles(), 0);
+  logic->SetMemoryBackedTemporaryDirectory(sharedDirectoryPath);
+  CHECK_STD_STRING(logic->GetMemoryBackedTemporaryDirectory(), sharedDirectoryPath);
+  CHECK_STD_STRING(logic->GetDataExchangeDirectory(), defaultDirectory);
+
+  logic->SetUseMemoryBackedTemporaryFiles(1);
+  std::string dataExchangeDirectory = logic->GetDataExchangeDirectory();
+#ifdef _WIN32
+  // Private directories are not created on Windows
+  CHECK_STD_STRING(dataExchangeDirectory, defaultDirectory);
+#else
+  // Files are written into a private subdirectory, not directly into the shared directory
+  CHECK_BOOL(dataExchangeDirectory.find(sharedDirectoryPath + "/slicer-") == 0, true);
+  CHECK_BOOL(vtksys::SystemTools::FileIsDirectory(dataExchangeDirectory), true);
+  mode_t permissions = 0;
+  CHECK_BOOL(vtksys::SystemTools::GetPermissions(dataExchangeDirectory, permissions), true);
+  CHECK_INT(static_cast<int>(permissions & 0777), 0700);
+
+  // The same directory is used for all executions in the process
+  CHECK_STD_STRING(logic->GetDataExchangeDirectory(), dataExchangeDirectory);
+  CHECK_STD_STRING(logic->GetDataExchangeDirectory(1024), dataExchangeDirectory);
+
+  // Fall back to the temporary directory if there is not enough free space
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  CHECK_STD_STRING(logic->GetDataExchangeDirectory(VTK_TYPE_INT64_MAX), defaultDirectory);
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+#endif
+
+  // Fall back to the temporary directory if the shared directory does not exist
+  logic->SetMemoryBackedTemporaryDirectory(sharedDirectoryPath + "/nonexistent");
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  CHECK_STD_STRING(logic->GetDataExchangeDirectory(), defaultDirectory);
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+
+  logic->SetUseMemoryBackedTemporaryFiles(0);
+  CHECK_STD_STRING(logic->GetDataExchangeDirectory(), defaultDirectory);
+
+  return EXIT_SUCCESS;
+}
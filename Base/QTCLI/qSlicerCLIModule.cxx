@@ -103,6 +103,15 @@ vtkMRMLAbstractLogic* qSlicerCLIModule::createLogic()
     logic->SetAllowInMemoryTransfer(0);
     }
 
+  // Exchange data files with executable CLIs through a memory-backed directory,
+  // unless the CLI requests using regular files
+  bool memoryBackedFilesEnabled = settings.value("Modules/UseMemoryBackedCLIDataFiles", false).toBool();
+  if (memoryBackedFilesEnabled
+    && d->Desc.GetParameterValue("AllowMemoryBackedFileTransfer") != "false")
+    {
+    logic->SetUseMemoryBackedTemporaryFiles(1);
+    }
+
   return logic;
 }
 
@@ -30,13 +30,16 @@
 #include <vtkMRMLStorageNode.h>
 #include <vtkMRMLModelStorageNode.h>
 #include <vtkMRMLTransformNode.h>
+#include <vtkMRMLVolumeNode.h>
 
 // VTK includes
 #include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
 #include <vtkIntArray.h>
 #include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointSet.h>
 #include <vtkStringArray.h>
 #include <vtksys/SystemTools.hxx>
 
@@ -58,6 +61,8 @@
 
 #ifdef _WIN32
 #else
+#include <stdlib.h>
+#include <sys/statvfs.h>
 #include <sys/types.h>
 #include <unistd.h>
 #endif
@@ -76,6 +81,84 @@ struct DigitsToCharacters
     }
 };
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Private directories created in shared (usually world-writable) directories
+/// for exchanging data files with CLIs. Each directory is only accessible by
+/// the current user, so other users cannot create or replace files in it.
+/// The directories are removed when the process exits.
+class PrivateDataExchangeDirectories
+{
+public:
+  ~PrivateDataExchangeDirectories()
+  {
+    for (std::map<std::string, std::string>::iterator it = this->Directories.begin(); it != this->Directories.end(); ++it)
+      {
+      vtksys::SystemTools::RemoveADirectory(it->second);
+      }
+  }
+
+  /// Return the private directory of the process in \a parentDirectory.
+  /// The directory is created at the first call.
+  /// Returns empty string if the directory cannot be created.
+  std::string GetDirectory(const std::string& parentDirectory)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    std::map<std::string, std::string>::iterator it = this->Directories.find(parentDirectory);
+    if (it != this->Directories.end() && vtksys::SystemTools::FileIsDirectory(it->second))
+      {
+      return it->second;
+      }
+#ifdef _WIN32
+    return std::string();
+#else
+    // mkdtemp creates the directory with a unique name and 0700 permissions
+    std::string directoryTemplate = parentDirectory + "/slicer-XXXXXX";
+    std::vector<char> directory(directoryTemplate.begin(), directoryTemplate.end());
+    directory.push_back('\0');
+    if (!mkdtemp(directory.data()))
+      {
+      return std::string();
+      }
+    this->Directories[parentDirectory] = directory.data();
+    return directory.data();
+#endif
+  }
+
+private:
+  std::mutex Mutex;
+  std::map<std::string, std::string> Directories;
+};
+
+//----------------------------------------------------------------------------
+PrivateDataExchangeDirectories& GetPrivateDataExchangeDirectories()
+{
+  static PrivateDataExchangeDirectories directories;
+  return directories;
+}
+
+//----------------------------------------------------------------------------
+/// Return free space (in bytes) that is available in the file system of
+/// \a directory for the current user. Returns -1 if it cannot be determined.
+vtkTypeInt64 GetAvailableSpace(const std::string& directory)
+{
+#ifdef _WIN32
+  (void)directory;
+  return -1;
+#else
+  struct statvfs stats;
+  if (statvfs(directory.c_str(), &stats) != 0)
+    {
+    return -1;
+    }
+  return static_cast<vtkTypeInt64>(stats.f_bavail) * static_cast<vtkTypeInt64>(stats.f_frsize);
+#endif
+}
+
+} // end of anonymous namespace
+
 typedef std::pair<vtkSlicerCLIModuleLogic *, vtkMRMLCommandLineModuleNode *> LogicNodePair;
 class MRMLIDMap : public std::map<std::string, std::string> {};
 
@@ -196,6 +279,8 @@ public:
   ModuleDescription DefaultModuleDescription;
   int DeleteTemporaryFiles;
   int AllowInMemoryTransfer;
+  int UseMemoryBackedTemporaryFiles;
+  std::string MemoryBackedTemporaryDirectory;
 
   int RedirectModuleStreams;
 
@@ -301,6 +386,11 @@ vtkSlicerCLIModuleLogic::vtkSlicerCLIModuleLogic()
 
   this->Internal->DeleteTemporaryFiles = 1;
   this->Internal->AllowInMemoryTransfer = 1;
+  this->Internal->UseMemoryBackedTemporaryFiles = 0;
+#if defined(__linux__)
+  // shared memory file system, available on all common Linux distributions
+  this->Internal->MemoryBackedTemporaryDirectory = "/dev/shm";
+#endif
   this->Internal->RedirectModuleStreams = 1;
   this->Internal->RescheduleCallback =
     vtkSmartPointer<vtkSlicerCLIRescheduleCallback>::New();
@@ -404,6 +494,128 @@ int vtkSlicerCLIModuleLogic::GetAllowInMemoryTransfer() const
   return this->Internal->AllowInMemoryTransfer;
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SetUseMemoryBackedTemporaryFiles(int value)
+{
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting UseMemoryBackedTemporaryFiles to " << value);
+  if (this->Internal->UseMemoryBackedTemporaryFiles != value)
+    {
+    this->Internal->UseMemoryBackedTemporaryFiles = value;
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogic::GetUseMemoryBackedTemporaryFiles() const
+{
+  return this->Internal->UseMemoryBackedTemporaryFiles;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SetMemoryBackedTemporaryDirectory(const std::string& directory)
+{
+  if (this->Internal->MemoryBackedTemporaryDirectory != directory)
+    {
+    this->Internal->MemoryBackedTemporaryDirectory = directory;
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+std::string vtkSlicerCLIModuleLogic::GetMemoryBackedTemporaryDirectory() const
+{
+  return this->Internal->MemoryBackedTemporaryDirectory;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkSlicerCLIModuleLogic::GetDataExchangeDirectory(vtkTypeInt64 requiredSize/*=0*/)
+{
+  if (this->Internal->UseMemoryBackedTemporaryFiles
+    && !this->Internal->MemoryBackedTemporaryDirectory.empty())
+    {
+    std::string privateDirectory;
+    if (vtksys::SystemTools::FileIsDirectory(this->Internal->MemoryBackedTemporaryDirectory))
+      {
+      privateDirectory = GetPrivateDataExchangeDirectories().GetDirectory(this->Internal->MemoryBackedTemporaryDirectory);
+      }
+    if (privateDirectory.empty())
+      {
+      vtkWarningMacro("GetDataExchangeDirectory: memory-backed temporary directory "
+        << this->Internal->MemoryBackedTemporaryDirectory << " is not available, use application temporary directory instead");
+      }
+    else
+      {
+      // Memory-backed file systems are often small (for example, 64MB in Docker containers by default)
+      vtkTypeInt64 availableSpace = GetAvailableSpace(privateDirectory);
+      if (requiredSize <= 0 || availableSpace < 0 || availableSpace >= requiredSize)
+        {
+        return privateDirectory;
+        }
+      vtkWarningMacro("GetDataExchangeDirectory: not enough free space in memory-backed temporary directory "
+        << this->Internal->MemoryBackedTemporaryDirectory << " (" << availableSpace / (1024 * 1024) << "MB available, "
+        << requiredSize / (1024 * 1024) << "MB required), use application temporary directory instead");
+      }
+    }
+
+  // by default use the current directory
+  std::string temporaryDirectory = ".";
+  vtkSlicerApplicationLogic* appLogic = this->GetApplicationLogic();
+  if (appLogic)
+    {
+    temporaryDirectory = appLogic->GetTemporaryPath();
+    }
+  return temporaryDirectory;
+}
+
+//----------------------------------------------------------------------------
+vtkTypeInt64 vtkSlicerCLIModuleLogic::EstimateDataExchangeSize(vtkMRMLCommandLineModuleNode* node)
+{
+  if (!node || !this->GetMRMLScene())
+    {
+    return 0;
+    }
+  vtkTypeInt64 inputSize = 0;
+  vtkTypeInt64 largestInputSize = 0;
+  int numberOfOutputs = 0;
+  const std::vector<ModuleParameterGroup>& parameterGroups = node->GetModuleDescription().GetParameterGroups();
+  for (std::vector<ModuleParameterGroup>::const_iterator pgit = parameterGroups.begin(); pgit != parameterGroups.end(); ++pgit)
+    {
+    const std::vector<ModuleParameter>& parameters = (*pgit).GetParameters();
+    for (std::vector<ModuleParameter>::const_iterator pit = parameters.begin(); pit != parameters.end(); ++pit)
+      {
+      if ((*pit).GetTag() != "image" && (*pit).GetTag() != "geometry")
+        {
+        continue;
+        }
+      if ((*pit).GetChannel() == "output")
+        {
+        ++numberOfOutputs;
+        continue;
+        }
+      vtkMRMLNode* parameterNode = this->GetMRMLScene()->GetNodeByID((*pit).GetValue().c_str());
+      vtkDataObject* data = nullptr;
+      if (vtkMRMLVolumeNode::SafeDownCast(parameterNode))
+        {
+        data = vtkMRMLVolumeNode::SafeDownCast(parameterNode)->GetImageData();
+        }
+      else if (vtkMRMLModelNode::SafeDownCast(parameterNode))
+        {
+        data = vtkMRMLModelNode::SafeDownCast(parameterNode)->GetMesh();
+        }
+      if (!data)
+        {
+        continue;
+        }
+      // GetActualMemorySize returns size in kibibytes
+      vtkTypeInt64 dataSize = static_cast<vtkTypeInt64>(data->GetActualMemorySize()) * 1024;
+      inputSize += dataSize;
+      largestInputSize = std::max(largestInputSize, dataSize);
+      }
+    }
+  // Outputs are usually not larger than the largest input
+  return inputSize + numberOfOutputs * largestInputSize;
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerCLIModuleLogic::RedirectModuleStreamsOn()
 {
@@ -436,7 +648,7 @@ int vtkSlicerCLIModuleLogic::GetRedirectModuleStreams() const
 //----------------------------------------------------------------------------
 std::string
 vtkSlicerCLIModuleLogic
-::ConstructTemporarySceneFileName(vtkMRMLScene *scene)
+::ConstructTemporarySceneFileName(vtkMRMLScene *scene, const std::string& temporaryDirectory)
 {
   std::string fname;
   std::ostringstream fnameString;
@@ -468,13 +680,6 @@ vtkSlicerCLIModuleLogic
 
   // By default, the filename is based on the temporary directory and
   // the pid
-  // by default use the current directory
-  std::string temporaryDirectory = ".";
-  vtkSlicerApplicationLogic* appLogic = this->GetApplicationLogic();
-  if (appLogic)
-    {
-    temporaryDirectory = appLogic->GetTemporaryPath();
-    }
   fname = temporaryDirectory + "/" + pid + "_" + fname + ".mrml";
 
   return fname;
@@ -487,7 +692,8 @@ vtkSlicerCLIModuleLogic
                              const std::string& type,
                              const std::string& name,
                              const std::vector<std::string>& extensions,
-                             CommandLineModuleType commandType)
+                             CommandLineModuleType commandType,
+                             const std::string& temporaryDirectory)
 {
   std::string fname = name;
   std::string pid;
@@ -536,12 +742,6 @@ vtkSlicerCLIModuleLogic
 
   // By default, the filename is based on the temporary directory and
   // the pid
-  std::string temporaryDirectory = ".";
-  vtkSlicerApplicationLogic* appLogic = this->GetApplicationLogic();
-  if (appLogic)
-    {
-    temporaryDirectory = appLogic->GetTemporaryPath();
-    }
   fname = temporaryDirectory + "/" + pid + "_" + fname;
 
   if (tag == "image")
@@ -900,8 +1100,12 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
   // Additional handling is necessary because we use SmartPointers
   // (see http://slicer.spl.harvard.edu/slicerWiki/index.php/Slicer3:Memory_Management#SmartPointers)
   vtkNew<vtkMRMLScene> miniscene;
+  // Choose the directory of the data files based on their estimated size,
+  // all files of this execution are placed in this directory.
+  // The directory is not stored in the logic, because multiple CLIs may run at the same time.
+  const std::string temporaryDirectory = this->GetDataExchangeDirectory(this->EstimateDataExchangeSize(node0));
   std::string minisceneFilename
-    = this->ConstructTemporarySceneFileName(miniscene.GetPointer());
+    = this->ConstructTemporarySceneFileName(miniscene.GetPointer(), temporaryDirectory);
   miniscene->SetRootDirectory(vtksys::SystemTools::GetParentDirectory(minisceneFilename.c_str()).c_str());
 
   // vector of files to delete
@@ -954,7 +1158,8 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
                                              (*pit).GetType(),
                                              id,
                                              (*pit).GetFileExtensions(),
-                                             commandType);
+                                             commandType,
+                                             temporaryDirectory);
 
         filesToDelete.insert(fname);
         if ((*pit).GetChannel() == "input")
@@ -985,15 +1190,6 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       }
     }
 
-  // Define a temporary directory for storing files
-  // by default use the current directory for storing files
-  std::string temporaryDirectory = ".";
-  vtkSlicerApplicationLogic* appLogic = this->GetApplicationLogic();
-  if (appLogic)
-    {
-    temporaryDirectory = appLogic->GetTemporaryPath();
-    }
-
   // write out the input datasets
   //
   //
@@ -1107,7 +1303,7 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     vtkMRMLModelHierarchyNode *mhnd = vtkMRMLModelHierarchyNode::SafeDownCast(nd);
     if (mhnd)
       {
-      this->AddCompleteModelHierarchyToMiniScene(miniscene.GetPointer(), mhnd, &sceneToMiniSceneMap, filesToDelete);
+      this->AddCompleteModelHierarchyToMiniScene(miniscene.GetPointer(), mhnd, &sceneToMiniSceneMap, filesToDelete, temporaryDirectory);
       }
 
     // if the file is to be written, then write it
@@ -2756,7 +2952,8 @@ void vtkSlicerCLIModuleLogic
 
 //---------------------------------------------------------------------------
 void vtkSlicerCLIModuleLogic::AddCompleteModelHierarchyToMiniScene(vtkMRMLScene *miniscene, vtkMRMLModelHierarchyNode *mhnd,
-                                                                   MRMLIDMap *sceneToMiniSceneMap, std::set<std::string> &filesToDelete)
+                                                                   MRMLIDMap *sceneToMiniSceneMap, std::set<std::string> &filesToDelete,
+                                                                   const std::string& temporaryDirectory)
 {
   if (!mhnd)
     {
@@ -2836,7 +3033,7 @@ void vtkSlicerCLIModuleLogic::AddCompleteModelHierarchyToMiniScene(vtkMRMLScene
         if (msnd)
           {
           vtkMRMLModelStorageNode *s = vtkMRMLModelStorageNode::SafeDownCast(miniscene->CopyNode(msnd));
-          std::string fname = this->ConstructTemporaryFileName("geometry", "", tmcp->GetID(), std::vector<std::string>(), CommandLineModule);
+          std::string fname = this->ConstructTemporaryFileName("geometry", "", tmcp->GetID(), std::vector<std::string>(), CommandLineModule, temporaryDirectory);
           s->SetFileName(fname.c_str());
           filesToDelete.insert(fname);
           tmcp->SetAndObserveStorageNodeID( s->GetID());
@@ -91,6 +91,31 @@ public:
   void SetAllowInMemoryTransfer(int value);
   int GetAllowInMemoryTransfer() const;
 
+  /// Control if data files exchanged with executable CLIs are written into a
+  /// memory-backed directory (such as /dev/shm) instead of the temporary
+  /// directory of the application. This avoids disk I/O for large inputs and
+  /// outputs but the files consume RAM while the CLI is running.
+  /// Disabled by default.
+  /// \sa SetMemoryBackedTemporaryDirectory()
+  void SetUseMemoryBackedTemporaryFiles(int value);
+  int GetUseMemoryBackedTemporaryFiles() const;
+
+  /// Directory used for exchanging data files when UseMemoryBackedTemporaryFiles is enabled.
+  /// Default is /dev/shm on Linux and empty on other platforms.
+  /// Files are not written directly into this (usually world-writable) directory
+  /// but into a private subdirectory that is created for the process with
+  /// owner-only access and removed when the process exits.
+  /// If the directory is empty or does not exist then the temporary directory
+  /// of the application is used.
+  void SetMemoryBackedTemporaryDirectory(const std::string& directory);
+  std::string GetMemoryBackedTemporaryDirectory() const;
+
+  /// Return the directory where data files exchanged with CLIs are written to.
+  /// If \a requiredSize (in bytes) is specified and the memory-backed directory
+  /// does not have that much free space then the temporary directory of the
+  /// application is returned.
+  std::string GetDataExchangeDirectory(vtkTypeInt64 requiredSize = 0);
+
   /// For debugging, control redirection of cout and cerr
   virtual void RedirectModuleStreamsOn();
   virtual void RedirectModuleStreamsOff();
@@ -134,15 +159,23 @@ protected:
   void ProcessMRMLLogicsEvents(vtkObject*, long unsigned int, void*) override;
 
 
+  /// Construct the name of a file that is exchanged with the CLI.
+  /// \param temporaryDirectory Directory of the exchanged files of the current execution (\sa GetDataExchangeDirectory)
   std::string ConstructTemporaryFileName(const std::string& tag,
                                          const std::string& type,
                                          const std::string& name,
                                      const std::vector<std::string>& extensions,
-                                     CommandLineModuleType commandType);
-  std::string ConstructTemporarySceneFileName(vtkMRMLScene *scene);
+                                     CommandLineModuleType commandType,
+                                     const std::string& temporaryDirectory);
+  std::string ConstructTemporarySceneFileName(vtkMRMLScene *scene, const std::string& temporaryDirectory);
   std::string FindHiddenNodeID(const ModuleDescription& d,
                                const ModuleParameter& p);
 
+  /// Estimate the total size (in bytes) of the data files that are exchanged
+  /// with the CLI: size of input nodes and, for each output node, the size of
+  /// the largest input node.
+  vtkTypeInt64 EstimateDataExchangeSize(vtkMRMLCommandLineModuleNode* node);
+
   // The method that runs the command line module
   void ApplyTask(void *clientdata);
 
@@ -165,7 +198,8 @@ protected:
   // Add a model hierarchy node and all its descendents to a scene (miniscene to sent to a CLI).
   // The mapping of ids from the original scene to the mini scene is put in (added to) sceneToMiniSceneMap.
   // Any files that will be created by writing out the miniscene are added to filesToDelete (i.e. models)
-  void AddCompleteModelHierarchyToMiniScene(vtkMRMLScene*, vtkMRMLModelHierarchyNode*, MRMLIDMap* sceneToMiniSceneMap, std::set<std::string> &filesToDelete);
+  void AddCompleteModelHierarchyToMiniScene(vtkMRMLScene*, vtkMRMLModelHierarchyNode*, MRMLIDMap* sceneToMiniSceneMap,
+    std::set<std::string> &filesToDelete, const std::string& temporaryDirectory);
 
   int GetCoordinateSystemFromString(const char* coordinateSystemStr)const;
 
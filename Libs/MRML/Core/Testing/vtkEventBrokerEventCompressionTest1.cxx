@@ -0,0 +1,220 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct CallbackCounter
+{
+  int NumberOfCalls = 0;
+  std::vector<void*> CallData;
+};
+
+//----------------------------------------------------------------------------
+void CountingCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid), void* clientData, void* callData)
+{
+  CallbackCounter* counter = reinterpret_cast<CallbackCounter*>(clientData);
+  counter->NumberOfCalls++;
+  counter->CallData.push_back(callData);
+}
+
+//----------------------------------------------------------------------------
+int TestEventCompression()
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  broker->ResetEventCompressionCounters();
+
+  CallbackCounter counter;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(CountingCallback);
+  callback->SetClientData(&counter);
+  vtkNew<vtkObject> observer;
+  vtkNew<vtkObject> subject1;
+  vtkNew<vtkObject> subject2;
+  broker->AddObservation(subject1, vtkCommand::ModifiedEvent, observer, callback);
+  broker->AddObservation(subject2, vtkCommand::ModifiedEvent, observer, callback);
+  broker->AddObservation(subject1, vtkCommand::UserEvent, observer, callback);
+
+  // Events are invoked immediately without compression
+  for (int i = 0; i < 10; ++i)
+    {
+    subject1->Modified();
+    }
+  CHECK_INT(counter.NumberOfCalls, 10);
+
+  // Identical events are invoked once at the end of compression
+  counter.NumberOfCalls = 0;
+  broker->StartEventCompression();
+  CHECK_BOOL(broker->IsEventCompressionActive(), true);
+  for (int i = 0; i < 100; ++i)
+    {
+    subject1->Modified();
+    }
+  for (int i = 0; i < 50; ++i)
+    {
+    subject2->Modified();
+    }
+  CHECK_INT(counter.NumberOfCalls, 0);
+  CHECK_INT(broker->GetNumberOfPendingCompressedEvents(), 2);
+
+  // Events that are not compressed are invoked immediately
+  subject1->InvokeEvent(vtkCommand::UserEvent);
+  CHECK_INT(counter.NumberOfCalls, 1);
+
+  // Nested compression: events are invoked at the end of the outermost compression
+  broker->StartEventCompression();
+  subject2->Modified();
+  broker->EndEventCompression();
+  CHECK_INT(counter.NumberOfCalls, 1);
+
+  broker->EndEventCompression();
+  CHECK_BOOL(broker->IsEventCompressionActive(), false);
+  CHECK_INT(counter.NumberOfCalls, 3);
+  CHECK_INT(broker->GetNumberOfPendingCompressedEvents(), 0);
+  CHECK_INT(broker->GetNumberOfCompressedEvents(), 151);
+  CHECK_INT(broker->GetNumberOfSuppressedEvents(), 149);
+
+  // Events with call data are not compressed but invoked immediately
+  // (call data may not be valid anymore at the end of the compression)
+  counter.NumberOfCalls = 0;
+  counter.CallData.clear();
+  int callData1 = 1;
+  int callData2 = 2;
+  broker->StartEventCompression();
+  subject1->InvokeEvent(vtkCommand::ModifiedEvent, &callData1);
+  subject1->InvokeEvent(vtkCommand::ModifiedEvent, &callData2);
+  subject1->InvokeEvent(vtkCommand::ModifiedEvent, &callData1);
+  CHECK_INT(counter.NumberOfCalls, 3);
+  CHECK_INT(broker->GetNumberOfPendingCompressedEvents(), 0);
+  broker->EndEventCompression();
+  CHECK_INT(counter.NumberOfCalls, 3);
+  CHECK_POINTER(counter.CallData[0], &callData1);
+  CHECK_POINTER(counter.CallData[1], &callData2);
+  CHECK_POINTER(counter.CallData[2], &callData1);
+
+  // Events of deleted subjects are not invoked
+  counter.NumberOfCalls = 0;
+  vtkSmartPointer<vtkObject> deletedSubject = vtkSmartPointer<vtkObject>::New();
+  broker->AddObservation(deletedSubject, vtkCommand::ModifiedEvent, observer, callback);
+  broker->StartEventCompression();
+  deletedSubject->Modified();
+  subject1->Modified();
+  CHECK_INT(broker->GetNumberOfPendingCompressedEvents(), 2);
+  deletedSubject = nullptr;
+  CHECK_INT(broker->GetNumberOfPendingCompressedEvents(), 1);
+  broker->EndEventCompression();
+  CHECK_INT(counter.NumberOfCalls, 1);
+
+  // Compressed events can be customized
+  counter.NumberOfCalls = 0;
+  broker->AddCompressedEvent(vtkCommand::UserEvent);
+  CHECK_BOOL(broker->IsCompressedEvent(vtkCommand::UserEvent), true);
+  broker->StartEventCompression();
+  subject1->InvokeEvent(vtkCommand::UserEvent);
+  subject1->InvokeEvent(vtkCommand::UserEvent);
+  CHECK_INT(counter.NumberOfCalls, 0);
+  broker->EndEventCompression();
+  CHECK_INT(counter.NumberOfCalls, 1);
+  broker->RemoveCompressedEvent(vtkCommand::UserEvent);
+  CHECK_BOOL(broker->IsCompressedEvent(vtkCommand::UserEvent), false);
+
+  broker->RemoveObservations(observer);
+  broker->ResetEventCompressionCounters();
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestEventCompressionPerformance()
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+
+  CallbackCounter counter;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(CountingCallback);
+  callback->SetClientData(&counter);
+  vtkNew<vtkObject> observer;
+  const int numberOfSubjects = 1000;
+  const int numberOfModificationsPerSubject = 100;
+  std::vector<vtkSmartPointer<vtkObject> > subjects;
+  for (int i = 0; i < numberOfSubjects; ++i)
+    {
+    subjects.push_back(vtkSmartPointer<vtkObject>::New());
+    broker->AddObservation(subjects.back(), vtkCommand::ModifiedEvent, observer, callback);
+    }
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int modification = 0; modification < numberOfModificationsPerSubject; ++modification)
+    {
+    for (vtkObject* subject : subjects)
+      {
+      subject->Modified();
+      }
+    }
+  timer->StopTimer();
+  double uncompressedTime = timer->GetElapsedTime();
+  CHECK_INT(counter.NumberOfCalls, numberOfSubjects * numberOfModificationsPerSubject);
+
+  counter.NumberOfCalls = 0;
+  broker->ResetEventCompressionCounters();
+  timer->StartTimer();
+  broker->StartEventCompression();
+  for (int modification = 0; modification < numberOfModificationsPerSubject; ++modification)
+    {
+    for (vtkObject* subject : subjects)
+      {
+      subject->Modified();
+      }
+    }
+  broker->EndEventCompression();
+  timer->StopTimer();
+  double compressedTime = timer->GetElapsedTime();
+  CHECK_INT(counter.NumberOfCalls, numberOfSubjects);
+  CHECK_INT(broker->GetNumberOfSuppressedEvents(), numberOfSubjects * (numberOfModificationsPerSubject - 1));
+
+  std::cout << numberOfSubjects * numberOfModificationsPerSubject << " modified events: "
+    << "without compression " << uncompressedTime * 1000.0 << " ms, "
+    << "with compression " << compressedTime * 1000.0 << " ms ("
+    << broker->GetNumberOfSuppressedEvents() << " events suppressed)" << std::endl;
+
+  broker->RemoveObservations(observer);
+  broker->ResetEventCompressionCounters();
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkEventBrokerEventCompressionTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestEventCompression());
+  CHECK_EXIT_SUCCESS(TestEventCompressionPerformance());
+  return EXIT_SUCCESS;
+}
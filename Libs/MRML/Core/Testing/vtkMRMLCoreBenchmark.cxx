@@ -0,0 +1,470 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Stand-alone benchmark of core scene operations.
+//
+// Usage:
+//   vtkMRMLCoreBenchmark [--sizes 1000,10000,100000] [--output results.json] [--thresholds thresholds.txt]
+//
+// For each scene size, a synthetic scene is generated (half of the nodes are model nodes,
+// the other half are display nodes referenced by the model nodes) and the time and
+// number of memory allocations of each operation is measured. Results are printed
+// and optionally written into a JSON file.
+//
+// Thresholds file contains one line for each checked operation:
+//   operation maxTimePerNodeMicroseconds maxScalingFactor
+// Scaling factor is the time per node at the largest size divided by the time per node
+// at the smallest size (1 for operations that take constant time per node).
+// The program returns with failure if any of the thresholds is exceeded.
+
+// MRML includes
+#include "vtkMRMLModelDisplayNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+#include <vtksys/FStream.hxx>
+
+// STD includes
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+std::atomic<long long> NumberOfAllocations(0);
+std::atomic<long long> NumberOfAllocatedBytes(0);
+
+//----------------------------------------------------------------------------
+void* CountedAllocate(std::size_t size)
+{
+  NumberOfAllocations++;
+  NumberOfAllocatedBytes += static_cast<long long>(size);
+  return malloc(size > 0 ? size : 1);
+}
+
+} // end of anonymous namespace
+
+// Allocations are counted by replacing the global allocation functions.
+// On Windows, each DLL uses the allocation functions of its C runtime,
+// therefore allocations made in MRML libraries cannot be counted there.
+#ifndef _WIN32
+#define MRML_BENCHMARK_COUNT_ALLOCATIONS
+//----------------------------------------------------------------------------
+void* operator new(std::size_t size)
+{
+  void* ptr = CountedAllocate(size);
+  if (!ptr)
+    {
+    throw std::bad_alloc();
+    }
+  return ptr;
+}
+
+//----------------------------------------------------------------------------
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+//----------------------------------------------------------------------------
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return CountedAllocate(size);
+}
+
+//----------------------------------------------------------------------------
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return CountedAllocate(size);
+}
+
+//----------------------------------------------------------------------------
+void operator delete(void* ptr) noexcept
+{
+  free(ptr);
+}
+
+//----------------------------------------------------------------------------
+void operator delete[](void* ptr) noexcept
+{
+  free(ptr);
+}
+
+//----------------------------------------------------------------------------
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  free(ptr);
+}
+
+//----------------------------------------------------------------------------
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+  free(ptr);
+}
+#endif
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct BenchmarkResult
+{
+  std::string Operation;
+  int NumberOfNodes;
+  double Time; // in seconds
+  long long NumberOfAllocations; // -1 if not available
+  long long NumberOfAllocatedBytes; // -1 if not available
+
+  double GetTimePerNodeMicroseconds() const
+  {
+    return this->Time * 1e6 / this->NumberOfNodes;
+  }
+};
+
+//----------------------------------------------------------------------------
+/// Measures time and allocations between Start and Stop calls.
+class Measurement
+{
+public:
+  void Start()
+  {
+    this->StartNumberOfAllocations = NumberOfAllocations;
+    this->StartNumberOfAllocatedBytes = NumberOfAllocatedBytes;
+    this->Timer->StartTimer();
+  }
+
+  void Stop(const std::string& operation, int numberOfNodes, std::vector<BenchmarkResult>& results)
+  {
+    this->Timer->StopTimer();
+    BenchmarkResult result;
+    result.Operation = operation;
+    result.NumberOfNodes = numberOfNodes;
+    result.Time = this->Timer->GetElapsedTime();
+#ifdef MRML_BENCHMARK_COUNT_ALLOCATIONS
+    result.NumberOfAllocations = NumberOfAllocations - this->StartNumberOfAllocations;
+    result.NumberOfAllocatedBytes = NumberOfAllocatedBytes - this->StartNumberOfAllocatedBytes;
+#else
+    result.NumberOfAllocations = -1;
+    result.NumberOfAllocatedBytes = -1;
+#endif
+    results.push_back(result);
+    std::cout << std::setw(22) << std::left << operation << std::right
+      << std::setw(8) << numberOfNodes << " nodes"
+      << std::setw(12) << std::fixed << std::setprecision(2) << result.Time * 1000.0 << " ms"
+      << std::setw(12) << std::setprecision(3) << result.GetTimePerNodeMicroseconds() << " us/node"
+      << std::setw(12) << result.NumberOfAllocations << " allocations" << std::endl;
+  }
+
+private:
+  vtkNew<vtkTimerLog> Timer;
+  long long StartNumberOfAllocations = 0;
+  long long StartNumberOfAllocatedBytes = 0;
+};
+
+//----------------------------------------------------------------------------
+/// Returns node indices in a pseudo-random but reproducible order
+std::vector<int> GetShuffledIndices(int numberOfIndices)
+{
+  std::vector<int> indices(numberOfIndices);
+  for (int i = 0; i < numberOfIndices; ++i)
+    {
+    indices[i] = i;
+    }
+  unsigned int state = 12345;
+  for (int i = numberOfIndices - 1; i > 0; --i)
+    {
+    state = state * 1103515245u + 12345u;
+    std::swap(indices[i], indices[(state >> 8) % (i + 1)]);
+    }
+  return indices;
+}
+
+//----------------------------------------------------------------------------
+bool RunBenchmarks(int numberOfNodes, std::vector<BenchmarkResult>& results)
+{
+  const int numberOfModels = numberOfNodes / 2;
+  Measurement measurement;
+
+  // Create nodes
+  std::vector<vtkSmartPointer<vtkMRMLModelNode> > modelNodes;
+  std::vector<vtkSmartPointer<vtkMRMLModelDisplayNode> > displayNodes;
+  for (int i = 0; i < numberOfModels; ++i)
+    {
+    vtkSmartPointer<vtkMRMLModelDisplayNode> displayNode = vtkSmartPointer<vtkMRMLModelDisplayNode>::New();
+    displayNode->SetName(("Display" + std::to_string(i)).c_str());
+    displayNodes.push_back(displayNode);
+    vtkSmartPointer<vtkMRMLModelNode> modelNode = vtkSmartPointer<vtkMRMLModelNode>::New();
+    modelNode->SetName(("Model" + std::to_string(i)).c_str());
+    modelNodes.push_back(modelNode);
+    }
+
+  vtkNew<vtkMRMLScene> scene;
+  measurement.Start();
+  for (int i = 0; i < numberOfModels; ++i)
+    {
+    scene->AddNode(displayNodes[i]);
+    scene->AddNode(modelNodes[i]);
+    }
+  measurement.Stop("AddNode", numberOfNodes, results);
+
+  measurement.Start();
+  for (int i = 0; i < numberOfModels; ++i)
+    {
+    modelNodes[i]->SetAndObserveDisplayNodeID(displayNodes[i]->GetID());
+    }
+  measurement.Stop("SetNodeReference", numberOfModels, results);
+
+  measurement.Start();
+  for (int i = 0; i < numberOfModels; ++i)
+    {
+    modelNodes[i]->SetAndObserveDisplayNodeID(displayNodes[(i + 1) % numberOfModels]->GetID());
+    }
+  measurement.Stop("ModifyNodeReference", numberOfModels, results);
+
+  std::vector<std::string> nodeIDs;
+  for (int i = 0; i < numberOfModels; ++i)
+    {
+    nodeIDs.push_back(displayNodes[i]->GetID());
+    nodeIDs.push_back(modelNodes[i]->GetID());
+    }
+  std::vector<int> shuffledIndices = GetShuffledIndices(static_cast<int>(nodeIDs.size()));
+  int numberOfFoundNodes = 0;
+  measurement.Start();
+  for (int index : shuffledIndices)
+    {
+    if (scene->GetNodeByID(nodeIDs[index].c_str()))
+      {
+      numberOfFoundNodes++;
+      }
+    }
+  measurement.Stop("GetNodeByID", numberOfNodes, results);
+  if (numberOfFoundNodes != static_cast<int>(nodeIDs.size()))
+    {
+    std::cerr << "Line " << __LINE__ << ": GetNodeByID found " << numberOfFoundNodes
+      << " nodes, expected " << nodeIDs.size() << std::endl;
+    return false;
+    }
+
+  measurement.Start();
+  for (int i = 0; i < numberOfModels; ++i)
+    {
+    vtkSmartPointer<vtkMRMLNode> modelCopy = vtkSmartPointer<vtkMRMLNode>::Take(modelNodes[i]->CreateNodeInstance());
+    modelCopy->Copy(modelNodes[i]);
+    vtkSmartPointer<vtkMRMLNode> displayCopy = vtkSmartPointer<vtkMRMLNode>::Take(displayNodes[i]->CreateNodeInstance());
+    displayCopy->Copy(displayNodes[i]);
+    }
+  measurement.Stop("Copy", numberOfNodes, results);
+
+  // WriteXML of all nodes
+  scene->SetSaveToXMLString(1);
+  measurement.Start();
+  scene->Commit();
+  measurement.Stop("WriteXML", numberOfNodes, results);
+  std::string sceneXMLString = scene->GetSceneXMLString();
+
+  // Parse XML and ReadXMLAttributes of all nodes
+  vtkNew<vtkMRMLScene> importedScene;
+  importedScene->SetLoadFromXMLString(1);
+  importedScene->SetSceneXMLString(sceneXMLString);
+  measurement.Start();
+  importedScene->Import();
+  measurement.Stop("Import", numberOfNodes, results);
+  if (importedScene->GetNumberOfNodesByClass("vtkMRMLModelNode") != numberOfModels)
+    {
+    std::cerr << "Line " << __LINE__ << ": imported scene contains " << importedScene->GetNumberOfNodesByClass("vtkMRMLModelNode")
+      << " model nodes, expected " << numberOfModels << std::endl;
+    return false;
+    }
+
+  measurement.Start();
+  for (int i = 0; i < numberOfModels; ++i)
+    {
+    scene->RemoveNode(modelNodes[i]);
+    scene->RemoveNode(displayNodes[i]);
+    }
+  measurement.Stop("RemoveNode", numberOfNodes, results);
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool WriteResults(const std::string& fileName, const std::vector<BenchmarkResult>& results)
+{
+  vtksys::ofstream file(fileName.c_str(), std::ios::out);
+  if (!file)
+    {
+    std::cerr << "Failed to open output file " << fileName << std::endl;
+    return false;
+    }
+  file << "{\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); ++i)
+    {
+    const BenchmarkResult& result = results[i];
+    file << (i > 0 ? "," : "") << "\n    {"
+      << "\"operation\": \"" << result.Operation << "\", "
+      << "\"numberOfNodes\": " << result.NumberOfNodes << ", "
+      << "\"timeSec\": " << result.Time << ", "
+      << "\"timePerNodeUs\": " << result.GetTimePerNodeMicroseconds() << ", "
+      << "\"allocations\": " << result.NumberOfAllocations << ", "
+      << "\"allocatedBytes\": " << result.NumberOfAllocatedBytes << "}";
+    }
+  file << "\n  ]\n}\n";
+  file.close();
+  return !file.fail();
+}
+
+//----------------------------------------------------------------------------
+/// Returns number of exceeded thresholds, or -1 if the thresholds file cannot be read
+int CheckThresholds(const std::string& fileName, const std::vector<BenchmarkResult>& results)
+{
+  vtksys::ifstream file(fileName.c_str());
+  if (!file)
+    {
+    std::cerr << "Failed to open thresholds file " << fileName << std::endl;
+    return -1;
+    }
+  // Results by operation, ordered by number of nodes
+  std::map<std::string, std::vector<const BenchmarkResult*> > operationResults;
+  for (const BenchmarkResult& result : results)
+    {
+    operationResults[result.Operation].push_back(&result);
+    }
+
+  int numberOfFailures = 0;
+  std::string line;
+  while (std::getline(file, line))
+    {
+    if (line.empty() || line[0] == '#')
+      {
+      continue;
+      }
+    std::istringstream lineStream(line);
+    std::string operation;
+    double maxTimePerNode = 0.0;
+    double maxScalingFactor = 0.0;
+    if (!(lineStream >> operation >> maxTimePerNode >> maxScalingFactor))
+      {
+      continue;
+      }
+    std::vector<const BenchmarkResult*>& measurements = operationResults[operation];
+    if (measurements.empty())
+      {
+      std::cerr << "No results for operation " << operation << std::endl;
+      numberOfFailures++;
+      continue;
+      }
+    for (const BenchmarkResult* result : measurements)
+      {
+      if (result->GetTimePerNodeMicroseconds() > maxTimePerNode)
+        {
+        std::cerr << "Threshold exceeded: " << operation << " with " << result->NumberOfNodes << " nodes took "
+          << result->GetTimePerNodeMicroseconds() << " us/node (maximum: " << maxTimePerNode << " us/node)" << std::endl;
+        numberOfFailures++;
+        }
+      }
+    // Scaling is only checked if the measured time is long enough to be reliable
+    const BenchmarkResult* smallest = measurements.front();
+    const BenchmarkResult* largest = measurements.back();
+    if (largest->NumberOfNodes > smallest->NumberOfNodes && largest->Time > 0.01 && smallest->Time > 0.0)
+      {
+      double scalingFactor = largest->GetTimePerNodeMicroseconds() / smallest->GetTimePerNodeMicroseconds();
+      if (scalingFactor > maxScalingFactor)
+        {
+        std::cerr << "Threshold exceeded: " << operation << " time per node increased by a factor of " << scalingFactor
+          << " from " << smallest->NumberOfNodes << " to " << largest->NumberOfNodes << " nodes (maximum: "
+          << maxScalingFactor << ")" << std::endl;
+        numberOfFailures++;
+        }
+      }
+    }
+  return numberOfFailures;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  std::vector<int> sizes = { 1000, 10000, 100000 };
+  std::string outputFileName;
+  std::string thresholdsFileName;
+  for (int i = 1; i < argc; ++i)
+    {
+    std::string arg = argv[i];
+    if (arg == "--sizes" && i + 1 < argc)
+      {
+      sizes.clear();
+      std::istringstream sizesStream(argv[++i]);
+      std::string size;
+      while (std::getline(sizesStream, size, ','))
+        {
+        sizes.push_back(atoi(size.c_str()));
+        }
+      }
+    else if (arg == "--output" && i + 1 < argc)
+      {
+      outputFileName = argv[++i];
+      }
+    else if (arg == "--thresholds" && i + 1 < argc)
+      {
+      thresholdsFileName = argv[++i];
+      }
+    else
+      {
+      std::cerr << "Usage: " << argv[0]
+        << " [--sizes 1000,10000,100000] [--output results.json] [--thresholds thresholds.txt]" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  std::sort(sizes.begin(), sizes.end());
+  if (sizes.empty() || sizes.front() < 2)
+    {
+    std::cerr << "Invalid scene sizes" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::vector<BenchmarkResult> results;
+  for (int numberOfNodes : sizes)
+    {
+    if (!RunBenchmarks(numberOfNodes, results))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  if (!outputFileName.empty() && !WriteResults(outputFileName, results))
+    {
+    return EXIT_FAILURE;
+    }
+
+  if (!thresholdsFileName.empty() && CheckThresholds(thresholdsFileName, results) != 0)
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
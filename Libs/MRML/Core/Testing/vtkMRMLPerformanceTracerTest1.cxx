@@ -0,0 +1,154 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLPerformanceTracer.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void RecordSpans(int numberOfSpans)
+{
+  for (int i = 0; i < numberOfSpans; ++i)
+    {
+    MRML_TRACE_SCOPE("Test", "RecordSpans");
+    }
+}
+
+//----------------------------------------------------------------------------
+int TestRecording()
+{
+  vtkMRMLPerformanceTracer* tracer = vtkMRMLPerformanceTracer::GetInstance();
+  tracer->EnabledOff();
+  tracer->Clear();
+
+  // Nothing is recorded while tracing is disabled
+  RecordSpans(10);
+  CHECK_INT(tracer->GetNumberOfSpans(), 0);
+
+  tracer->EnabledOn();
+  RecordSpans(10);
+  CHECK_INT(tracer->GetNumberOfSpans(), 10);
+  tracer->AddSpan("Script", "Scripted \"span\"", vtkMRMLPerformanceTracer::GetTimestamp(), 5);
+  CHECK_INT(tracer->GetNumberOfSpans(), 11);
+
+  // Spans of multiple threads
+  const int numberOfThreads = 4;
+  const int numberOfSpansPerThread = 1000;
+  std::vector<std::thread> threads;
+  for (int threadIndex = 0; threadIndex < numberOfThreads; ++threadIndex)
+    {
+    threads.emplace_back(RecordSpans, numberOfSpansPerThread);
+    }
+  for (std::thread& thread : threads)
+    {
+    thread.join();
+    }
+  CHECK_INT(tracer->GetNumberOfSpans(), 11 + numberOfThreads * numberOfSpansPerThread);
+
+  std::string trace = tracer->GetChromeTrace();
+  CHECK_BOOL(trace.find("{\"traceEvents\":[") == 0, true);
+  CHECK_BOOL(trace.find("\"name\":\"RecordSpans\",\"cat\":\"Test\",\"ph\":\"X\"") != std::string::npos, true);
+  CHECK_BOOL(trace.find("\"name\":\"Scripted \\\"span\\\"\"") != std::string::npos, true);
+  // Spans of other threads are recorded in separate buffers
+  CHECK_BOOL(trace.find("\"tid\":2") != std::string::npos, true);
+
+  // Oldest spans are overwritten when the buffer is full
+  tracer->Clear();
+  CHECK_INT(tracer->GetNumberOfSpans(), 0);
+  RecordSpans(vtkMRMLPerformanceTracer::GetThreadBufferSize() + 100);
+  CHECK_INT(tracer->GetNumberOfSpans(), vtkMRMLPerformanceTracer::GetThreadBufferSize());
+
+  tracer->Clear();
+  tracer->EnabledOff();
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestSceneImport()
+{
+  vtkMRMLPerformanceTracer* tracer = vtkMRMLPerformanceTracer::GetInstance();
+  tracer->Clear();
+  tracer->EnabledOn();
+
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetLoadFromXMLString(1);
+  scene->SetSceneXMLString("<MRML version=\"Slicer4.4.0\"></MRML>");
+  scene->Import();
+
+  tracer->EnabledOff();
+  std::string trace = tracer->GetChromeTrace();
+  CHECK_BOOL(trace.find("\"name\":\"Import\",\"cat\":\"Scene\"") != std::string::npos, true);
+  tracer->Clear();
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestThreadBufferReuse()
+{
+  vtkMRMLPerformanceTracer* tracer = vtkMRMLPerformanceTracer::GetInstance();
+  tracer->Clear();
+  tracer->EnabledOn();
+
+  // Threads that do not run at the same time share the same buffer,
+  // spans of exited threads are kept
+  const int numberOfThreads = 4;
+  const int numberOfSpansPerThread = 100;
+  for (int threadIndex = 0; threadIndex < numberOfThreads; ++threadIndex)
+    {
+    std::thread thread(RecordSpans, numberOfSpansPerThread);
+    thread.join();
+    }
+  tracer->EnabledOff();
+  CHECK_INT(tracer->GetNumberOfSpans(), numberOfThreads * numberOfSpansPerThread);
+
+  // Thread IDs are assigned consecutively, a few buffers are already created by previous tests
+  std::string trace = tracer->GetChromeTrace();
+  const int maximumThreadId = 100;
+  int numberOfThreadIds = 0;
+  for (int threadId = 1; threadId <= maximumThreadId; ++threadId)
+    {
+    if (trace.find("\"tid\":" + std::to_string(threadId) + "}") != std::string::npos)
+      {
+      ++numberOfThreadIds;
+      }
+    }
+  CHECK_INT(numberOfThreadIds, 1);
+
+  tracer->Clear();
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLPerformanceTracerTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestRecording());
+  CHECK_EXIT_SUCCESS(TestSceneImport());
+  CHECK_EXIT_SUCCESS(TestThreadBufferReuse());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScalarVolumeDisplayNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+void CreateImage(vtkImageData* imageData, int seed)
+{
+  // Uniformly distributed pseudo-random intensities between -1000 and +999
+  imageData->SetDimensions(256, 256, 128);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  short* voxels = static_cast<short*>(imageData->GetScalarPointer());
+  vtkIdType numberOfVoxels = imageData->GetNumberOfPoints();
+  unsigned int random = static_cast<unsigned int>(seed);
+  for (vtkIdType i = 0; i < numberOfVoxels; ++i)
+    {
+    random = random * 1664525u + 1013904223u;
+    voxels[i] = static_cast<short>((random >> 8) % 2000) - 1000;
+    }
+}
+
+//-----------------------------------------------------------------------------
+double UpdateAutoLevels(vtkMRMLScalarVolumeDisplayNode* displayNode, double range[2])
+{
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  // Modified event of the display node triggers automatic window/level computation
+  displayNode->Modified();
+  timer->StopTimer();
+  range[0] = displayNode->GetWindowLevelMin();
+  range[1] = displayNode->GetWindowLevelMax();
+  return timer->GetElapsedTime();
+}
+
+//-----------------------------------------------------------------------------
+int TestSampledAutoLevels()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  scene->AddNode(volumeNode);
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  displayNode->AutoWindowLevelOn();
+  scene->AddNode(displayNode);
+  volumeNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+
+  vtkNew<vtkImageData> imageData;
+  CreateImage(imageData, 1);
+  volumeNode->SetAndObserveImageData(imageData);
+
+  // Exact
+  vtkMRMLScalarVolumeDisplayNode::ClearAutoLevelsCache();
+  double exactRange[2] = { 0.0, 0.0 };
+  double exactTime = UpdateAutoLevels(displayNode, exactRange);
+
+  // Sampled
+  const vtkIdType maximumNumberOfSamples = 100000;
+  displayNode->SetAutoLevelsMaximumNumberOfSamples(maximumNumberOfSamples);
+  vtkMRMLScalarVolumeDisplayNode::ClearAutoLevelsCache();
+  double sampledRange[2] = { 0.0, 0.0 };
+  double sampledTime = UpdateAutoLevels(displayNode, sampledRange);
+
+  // Sampling does not guarantee a bound on the percentile rank error. For this image
+  // (no pattern aligned with the sampling stride) the error is expected to be in the order
+  // of 1/sqrt(number of samples) as for random sampling, which corresponds to
+  // 2000/sqrt(100000) = 6.3 intensity difference.
+  double tolerance = 2000.0 / sqrt(static_cast<double>(maximumNumberOfSamples));
+  CHECK_DOUBLE_TOLERANCE(sampledRange[0], exactRange[0], tolerance);
+  CHECK_DOUBLE_TOLERANCE(sampledRange[1], exactRange[1], tolerance);
+
+  // Cached
+  double cachedRange[2] = { 0.0, 0.0 };
+  double cachedTime = UpdateAutoLevels(displayNode, cachedRange);
+  CHECK_DOUBLE(cachedRange[0], sampledRange[0]);
+  CHECK_DOUBLE(cachedRange[1], sampledRange[1]);
+
+  std::cout << "Number of voxels: " << imageData->GetNumberOfPoints()
+    << "  Exact: " << exactTime * 1000.0 << " ms [" << exactRange[0] << ", " << exactRange[1] << "]"
+    << "  Sampled: " << sampledTime * 1000.0 << " ms [" << sampledRange[0] << ", " << sampledRange[1] << "]"
+    << "  Cached: " << cachedTime * 1000.0 << " ms" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+int TestAutoLevelsCache()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  scene->AddNode(volumeNode);
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  displayNode->AutoWindowLevelOn();
+  scene->AddNode(displayNode);
+  volumeNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+  vtkMRMLScalarVolumeDisplayNode::ClearAutoLevelsCache();
+
+  // Switch between images, as in sequence replay
+  vtkNew<vtkImageData> imageData1;
+  CreateImage(imageData1, 1);
+  vtkNew<vtkImageData> imageData2;
+  CreateImage(imageData2, 2);
+  short* voxels2 = static_cast<short*>(imageData2->GetScalarPointer());
+  for (vtkIdType i = 0; i < imageData2->GetNumberOfPoints(); ++i)
+    {
+    voxels2[i] /= 2;
+    }
+
+  volumeNode->SetAndObserveImageData(imageData1);
+  double range1[2] = { displayNode->GetWindowLevelMin(), displayNode->GetWindowLevelMax() };
+  volumeNode->SetAndObserveImageData(imageData2);
+  double range2[2] = { displayNode->GetWindowLevelMin(), displayNode->GetWindowLevelMax() };
+  CHECK_BOOL(range2[1] - range2[0] < (range1[1] - range1[0]) * 0.6, true);
+
+  // Overwrite voxels without indicating modification: if the result is
+  // the same as before then it was retrieved from the cache.
+  memset(imageData1->GetScalarPointer(), 0, imageData1->GetNumberOfPoints() * sizeof(short));
+  volumeNode->SetAndObserveImageData(imageData1);
+  CHECK_DOUBLE(displayNode->GetWindowLevelMin(), range1[0]);
+  CHECK_DOUBLE(displayNode->GetWindowLevelMax(), range1[1]);
+
+  // Modified voxels are processed again
+  imageData1->GetPointData()->GetScalars()->Modified();
+  displayNode->Modified();
+  CHECK_DOUBLE_TOLERANCE(displayNode->GetWindowLevelMax() - displayNode->GetWindowLevelMin(), 0.0, 1.0);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkMRMLScalarVolumeDisplayNodeTest2(int vtkNotUsed(argc), char * vtkNotUsed(argv) [])
+{
+  CHECK_EXIT_SUCCESS(TestSampledAutoLevels());
+  CHECK_EXIT_SUCCESS(TestAutoLevelsCache());
+  return EXIT_SUCCESS;
+}
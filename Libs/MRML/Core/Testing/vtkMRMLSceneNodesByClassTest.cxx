@@ -0,0 +1,158 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLScriptedModuleNode.h"
+#include "vtkMRMLStorableNode.h"
+#include "vtkMRMLTextNode.h"
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+int TestNodesByClassConsistency()
+{
+  vtkNew<vtkMRMLScene> scene;
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLTextNode"), 0);
+
+  vtkNew<vtkMRMLTextNode> text1;
+  vtkNew<vtkMRMLScriptedModuleNode> scripted1;
+  vtkNew<vtkMRMLTextNode> text2;
+  scene->AddNode(text1);
+  scene->AddNode(scripted1);
+  // query once so that the class is indexed before more nodes are added
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLTextNode"), 1);
+  scene->AddNode(text2);
+
+  // Exact class and superclass queries
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLTextNode"), 2);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLStorableNode"), 2);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLNode"), 3);
+  CHECK_POINTER(scene->GetNthNodeByClass(1, "vtkMRMLTextNode"), text2.GetPointer());
+  CHECK_NULL(scene->GetNthNodeByClass(2, "vtkMRMLTextNode"));
+
+  // Nodes are returned in scene order
+  std::vector<vtkMRMLNode*> nodes;
+  scene->GetNodesByClass("vtkMRMLNode", nodes);
+  CHECK_INT(static_cast<int>(nodes.size()), 3);
+  CHECK_POINTER(nodes[0], text1.GetPointer());
+  CHECK_POINTER(nodes[1], scripted1.GetPointer());
+  CHECK_POINTER(nodes[2], text2.GetPointer());
+
+  // Insertion in the middle of the scene keeps the order
+  vtkNew<vtkMRMLTextNode> text3;
+  scene->InsertBeforeNode(text1, text3);
+  scene->GetNodesByClass("vtkMRMLTextNode", nodes);
+  CHECK_INT(static_cast<int>(nodes.size()), 3);
+  CHECK_POINTER(nodes[0], text3.GetPointer());
+  CHECK_POINTER(nodes[1], text1.GetPointer());
+  CHECK_POINTER(nodes[2], text2.GetPointer());
+
+  // Removal
+  CHECK_POINTER(scene->GetNthNodeByClass(1, "vtkMRMLTextNode"), text1.GetPointer());
+  scene->RemoveNode(text1);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLTextNode"), 2);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLNode"), 3);
+  CHECK_POINTER(scene->GetNthNodeByClass(1, "vtkMRMLTextNode"), text2.GetPointer());
+
+  // Appended node after GetNthNodeByClass query
+  vtkNew<vtkMRMLTextNode> text4;
+  scene->AddNode(text4);
+  CHECK_POINTER(scene->GetNthNodeByClass(2, "vtkMRMLTextNode"), text4.GetPointer());
+  CHECK_NULL(scene->GetNthNodeByClass(3, "vtkMRMLTextNode"));
+  scene->RemoveNode(text4);
+
+  text2->SetName("MyText");
+  vtkSmartPointer<vtkCollection> namedNodes = vtkSmartPointer<vtkCollection>::Take(
+    scene->GetNodesByClassByName("vtkMRMLTextNode", "MyText"));
+  CHECK_INT(namedNodes->GetNumberOfItems(), 1);
+  CHECK_POINTER(namedNodes->GetItemAsObject(0), text2.GetPointer());
+
+  scene->Clear(1);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLTextNode"), 0);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLNode"), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestNodesByClassScaling()
+{
+  // 1 out of 100 nodes is a text node, the rest are scripted module nodes.
+  // Query time of text nodes is expected to be proportional to the number of
+  // text nodes and not to the total number of nodes.
+  const int numberOfNodesList[] = { 100, 1000, 10000, 100000 };
+  const int numberOfQueries = 1000;
+  for (int numberOfNodes : numberOfNodesList)
+    {
+    vtkNew<vtkMRMLScene> scene;
+    vtkNew<vtkTimerLog> timer;
+    timer->StartTimer();
+    for (int i = 0; i < numberOfNodes; ++i)
+      {
+      vtkSmartPointer<vtkMRMLNode> node;
+      if (i % 100 == 0)
+        {
+        node = vtkSmartPointer<vtkMRMLTextNode>::New();
+        }
+      else
+        {
+        node = vtkSmartPointer<vtkMRMLScriptedModuleNode>::New();
+        }
+      scene->AddNode(node);
+      }
+    timer->StopTimer();
+    double addTime = timer->GetElapsedTime();
+
+    int expectedNumberOfTextNodes = (numberOfNodes + 99) / 100;
+    std::vector<vtkMRMLNode*> nodes;
+    timer->StartTimer();
+    for (int i = 0; i < numberOfQueries; ++i)
+      {
+      scene->GetNodesByClass("vtkMRMLTextNode", nodes);
+      }
+    timer->StopTimer();
+    double queryTime = timer->GetElapsedTime();
+    CHECK_INT(static_cast<int>(nodes.size()), expectedNumberOfTextNodes);
+
+    std::cout << "Number of nodes: " << numberOfNodes
+              << "  AddNode: " << addTime * 1000.0 / numberOfNodes << " ms/node"
+              << "  GetNodesByClass: " << queryTime * 1000.0 / numberOfQueries << " ms/query"
+              << std::endl;
+    }
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneNodesByClassTest(int vtkNotUsed(argc), char * vtkNotUsed(argv) [])
+{
+  CHECK_EXIT_SUCCESS(TestNodesByClassConsistency());
+  CHECK_EXIT_SUCCESS(TestNodesByClassScaling());
+  return EXIT_SUCCESS;
+}
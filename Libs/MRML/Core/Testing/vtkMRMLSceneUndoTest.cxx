@@ -0,0 +1,276 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLScriptedModuleNode.h"
+
+// VTK includes
+#include <vtkCommand.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+vtkMRMLScriptedModuleNode* AddUndoEnabledNode(vtkMRMLScene* scene, const std::string& value)
+{
+  vtkNew<vtkMRMLScriptedModuleNode> node;
+  node->UndoEnabledOn();
+  node->SetParameter("value", value);
+  scene->AddNode(node);
+  return node;
+}
+
+//---------------------------------------------------------------------------
+std::string GetValue(vtkMRMLScene* scene, const std::string& nodeID)
+{
+  vtkMRMLScriptedModuleNode* node = vtkMRMLScriptedModuleNode::SafeDownCast(scene->GetNodeByID(nodeID));
+  if (!node)
+    {
+    return "(none)";
+    }
+  return node->GetParameter("value");
+}
+
+//---------------------------------------------------------------------------
+int TestUndoRedo()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+
+  std::string node1ID = AddUndoEnabledNode(scene, "1a")->GetID();
+  std::string node2ID = AddUndoEnabledNode(scene, "2a")->GetID();
+  scene->SaveStateForUndo();
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 1);
+
+  // Modify a node
+  vtkMRMLScriptedModuleNode::SafeDownCast(scene->GetNodeByID(node1ID))->SetParameter("value", "1b");
+  scene->SaveStateForUndo();
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 2);
+
+  // Add and remove nodes
+  std::string node3ID = AddUndoEnabledNode(scene, "3a")->GetID();
+  vtkSmartPointer<vtkMRMLNode> node2 = scene->GetNodeByID(node2ID);
+  scene->RemoveNode(node2);
+  vtkMRMLScriptedModuleNode::SafeDownCast(scene->GetNodeByID(node1ID))->SetParameter("value", "1c");
+
+  // Undo restores the last saved state
+  vtkSmartPointer<vtkMRMLNode> node3 = scene->GetNodeByID(node3ID);
+  scene->Undo();
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 1);
+  CHECK_INT(scene->GetNumberOfRedoLevels(), 1);
+  CHECK_STD_STRING(GetValue(scene, node1ID), "1b");
+  CHECK_STD_STRING(GetValue(scene, node2ID), "2a");
+  CHECK_STD_STRING(GetValue(scene, node3ID), "(none)");
+  // Undo of a node removal adds back the same node object
+  CHECK_POINTER(scene->GetNodeByID(node2ID), node2.GetPointer());
+
+  scene->Undo();
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 0);
+  CHECK_INT(scene->GetNumberOfRedoLevels(), 2);
+  CHECK_STD_STRING(GetValue(scene, node1ID), "1a");
+
+  // Redo goes forward in history
+  scene->Redo();
+  CHECK_STD_STRING(GetValue(scene, node1ID), "1b");
+  CHECK_STD_STRING(GetValue(scene, node2ID), "2a");
+  scene->Redo();
+  CHECK_INT(scene->GetNumberOfRedoLevels(), 0);
+  CHECK_STD_STRING(GetValue(scene, node1ID), "1c");
+  CHECK_STD_STRING(GetValue(scene, node2ID), "(none)");
+  CHECK_STD_STRING(GetValue(scene, node3ID), "3a");
+  // Redo of a node addition adds back the same node object
+  CHECK_POINTER(scene->GetNodeByID(node3ID), node3.GetPointer());
+
+  // Undo after redo
+  scene->Undo();
+  CHECK_STD_STRING(GetValue(scene, node1ID), "1b");
+  CHECK_STD_STRING(GetValue(scene, node2ID), "2a");
+  CHECK_STD_STRING(GetValue(scene, node3ID), "(none)");
+  CHECK_POINTER(scene->GetNodeByID(node2ID), node2.GetPointer());
+
+  // Saving a new state clears the redo stack
+  scene->SaveStateForUndo();
+  CHECK_INT(scene->GetNumberOfRedoLevels(), 0);
+
+  // Maximum number of undo levels
+  scene->SetMaximumNumberOfSavedUndoStates(2);
+  for (int i = 0; i < 5; ++i)
+    {
+    std::stringstream ss;
+    ss << "1_" << i;
+    vtkMRMLScriptedModuleNode::SafeDownCast(scene->GetNodeByID(node1ID))->SetParameter("value", ss.str());
+    scene->SaveStateForUndo();
+    }
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 2);
+  vtkMRMLScriptedModuleNode::SafeDownCast(scene->GetNodeByID(node1ID))->SetParameter("value", "last");
+  scene->Undo();
+  CHECK_STD_STRING(GetValue(scene, node1ID), "1_4");
+  scene->Undo();
+  CHECK_STD_STRING(GetValue(scene, node1ID), "1_3");
+
+  // Memory budget keeps at least one state
+  scene->SetMaximumNumberOfSavedUndoStates(20);
+  for (int i = 0; i < 5; ++i)
+    {
+    vtkMRMLScriptedModuleNode::SafeDownCast(scene->GetNodeByID(node1ID))->SetParameter("value", "x");
+    scene->SaveStateForUndo();
+    }
+  CHECK_BOOL(scene->GetUndoMemorySize() > 0, true);
+  scene->SetMaximumUndoMemorySize(1);
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 1);
+
+  scene->ClearUndoStack();
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 0);
+  CHECK_INT(static_cast<int>(scene->GetUndoMemorySize()), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestUndoFlag()
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  // Node modifications are not observed while undo is off
+  vtkMRMLScriptedModuleNode* node1 = AddUndoEnabledNode(scene, "1a");
+  std::string node1ID = node1->GetID();
+  CHECK_BOOL(node1->HasObserver(vtkCommand::ModifiedEvent), false);
+
+  scene->SetUndoOn();
+  CHECK_BOOL(node1->HasObserver(vtkCommand::ModifiedEvent), true);
+  scene->SaveStateForUndo();
+  node1->SetParameter("value", "1b");
+  scene->SaveStateForUndo();
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 2);
+
+  // Changes made while undo is off are detected when undo is turned on again
+  scene->SetUndoOff();
+  CHECK_BOOL(node1->HasObserver(vtkCommand::ModifiedEvent), false);
+  node1->SetParameter("value", "1c");
+  std::string node2ID = AddUndoEnabledNode(scene, "2a")->GetID();
+  scene->SetUndoOn();
+  scene->Undo();
+  CHECK_STD_STRING(GetValue(scene, node1ID), "1b");
+  CHECK_STD_STRING(GetValue(scene, node2ID), "(none)");
+
+  // Saved states are released when there is nothing left to undo
+  scene->Undo();
+  CHECK_STD_STRING(GetValue(scene, node1ID), "1a");
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 0);
+  CHECK_INT(static_cast<int>(scene->GetUndoMemorySize()), 0);
+  scene->Redo();
+  CHECK_STD_STRING(GetValue(scene, node1ID), "1b");
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestUndoScaling()
+{
+  // Time of saving a state after modifying a single node is expected to be
+  // independent of the number of undo-enabled nodes in the scene.
+  const int numberOfNodesList[] = { 1000, 10000, 100000 };
+  const int numberOfSteps = 100;
+  // Time measurements below this value (in seconds) are considered to be noise
+  const double minimumStepTime = 0.0001;
+  double smallestSceneStepTime = 0.0;
+  vtkTypeInt64 smallestSceneMemorySizePerStep = 0;
+  for (int numberOfNodes : numberOfNodesList)
+    {
+    vtkNew<vtkMRMLScene> scene;
+    scene->SetUndoOn();
+    scene->SetMaximumNumberOfSavedUndoStates(numberOfSteps);
+    std::string modifiedNodeID;
+    for (int i = 0; i < numberOfNodes; ++i)
+      {
+      modifiedNodeID = AddUndoEnabledNode(scene, "0")->GetID();
+      }
+    vtkMRMLScriptedModuleNode* modifiedNode = vtkMRMLScriptedModuleNode::SafeDownCast(scene->GetNodeByID(modifiedNodeID));
+
+    // first saved state copies all nodes
+    scene->SaveStateForUndo();
+    vtkTypeInt64 initialMemorySize = scene->GetUndoMemorySize();
+
+    vtkNew<vtkTimerLog> timer;
+    timer->StartTimer();
+    for (int i = 0; i < numberOfSteps; ++i)
+      {
+      std::stringstream ss;
+      ss << i;
+      modifiedNode->SetParameter("value", ss.str());
+      scene->SaveStateForUndo();
+      }
+    timer->StopTimer();
+    double saveTime = timer->GetElapsedTime();
+    vtkTypeInt64 memorySizePerStep = (scene->GetUndoMemorySize() - initialMemorySize) / numberOfSteps;
+
+    timer->StartTimer();
+    for (int i = 0; i < numberOfSteps; ++i)
+      {
+      scene->Undo();
+      }
+    timer->StopTimer();
+    double undoTime = timer->GetElapsedTime();
+    CHECK_STD_STRING(modifiedNode->GetParameter("value"), "0");
+
+    std::cout << "Number of undo-enabled nodes: " << numberOfNodes
+              << "  SaveStateForUndo: " << saveTime * 1000.0 / numberOfSteps << " ms/step"
+              << "  Undo: " << undoTime * 1000.0 / numberOfSteps << " ms/step"
+              << "  Memory: " << memorySizePerStep << " bytes/step"
+              << std::endl;
+
+    // Per-step time and memory must stay flat. A cost proportional to the
+    // scene size would make steps 100x slower in the largest scene, the limit
+    // leaves a wide margin for timing noise.
+    double stepTime = std::max((saveTime + undoTime) / numberOfSteps, minimumStepTime);
+    if (numberOfNodes == numberOfNodesList[0])
+      {
+      smallestSceneStepTime = stepTime;
+      smallestSceneMemorySizePerStep = memorySizePerStep;
+      continue;
+      }
+    if (stepTime > 10.0 * smallestSceneStepTime)
+      {
+      std::cerr << "Line " << __LINE__ << " - Undo step time is not independent of the scene size: "
+                << stepTime * 1000.0 << " ms/step with " << numberOfNodes << " nodes, "
+                << smallestSceneStepTime * 1000.0 << " ms/step with " << numberOfNodesList[0] << " nodes"
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    CHECK_BOOL(memorySizePerStep <= 2 * smallestSceneMemorySizePerStep, true);
+    }
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneUndoTest(int vtkNotUsed(argc), char * vtkNotUsed(argv) [])
+{
+  CHECK_EXIT_SUCCESS(TestUndoRedo());
+  CHECK_EXIT_SUCCESS(TestUndoFlag());
+  CHECK_EXIT_SUCCESS(TestUndoScaling());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSubjectHierarchyConstants.h"
+#include "vtkMRMLSubjectHierarchyNode.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+std::string GetInstanceUID(int itemIndex, int instanceIndex)
+{
+  std::stringstream ss;
+  ss << "1.2.826.0.1." << itemIndex << "." << instanceIndex;
+  return ss.str();
+}
+
+//---------------------------------------------------------------------------
+std::string GetSeriesUID(int itemIndex)
+{
+  std::stringstream ss;
+  ss << "1.2.826.0.2." << itemIndex;
+  return ss.str();
+}
+
+//---------------------------------------------------------------------------
+int TestLookupConsistency()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene);
+  CHECK_NOT_NULL(shNode);
+  const char* uidName = vtkMRMLSubjectHierarchyConstants::GetDICOMUIDName();
+  const char* instanceUIDName = vtkMRMLSubjectHierarchyConstants::GetDICOMInstanceUIDName();
+
+  vtkIdType studyItemID = shNode->CreateStudyItem(shNode->GetSceneItemID(), "Study");
+  vtkIdType folderItemID = shNode->CreateFolderItem(studyItemID, "Folder");
+  vtkMRMLNode* volumeNode = scene->AddNewNodeByClass("vtkMRMLScalarVolumeNode");
+  vtkIdType volumeItemID = shNode->GetItemByDataNode(volumeNode);
+  CHECK_BOOL(volumeItemID != vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID, true);
+  shNode->SetItemParent(volumeItemID, folderItemID);
+  CHECK_INT(shNode->GetItemByDataNode(volumeNode), volumeItemID);
+
+  // UID and UID list lookup
+  shNode->SetItemUID(volumeItemID, uidName, "SERIES1");
+  shNode->SetItemUID(volumeItemID, instanceUIDName, "1.2.3 1.2.34 1.2.345");
+  CHECK_INT(shNode->GetItemByUID(uidName, "SERIES1"), volumeItemID);
+  CHECK_INT(shNode->GetItemByUID(uidName, "SERIES"), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+  CHECK_INT(shNode->GetItemByUIDList(instanceUIDName, "1.2.34"), volumeItemID);
+  CHECK_INT(shNode->GetItemByUIDList(instanceUIDName, "1.2.3456"), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+  CHECK_INT(shNode->GetItemByUIDList(instanceUIDName, "1.2.3 1.2.34"), volumeItemID);
+
+  // Changed UID value replaces the old one
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  shNode->SetItemUID(volumeItemID, uidName, "SERIES2");
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+  CHECK_INT(shNode->GetItemByUID(uidName, "SERIES1"), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+  CHECK_INT(shNode->GetItemByUID(uidName, "SERIES2"), volumeItemID);
+
+  // Reparented item is still found
+  shNode->SetItemParent(volumeItemID, shNode->GetSceneItemID());
+  CHECK_INT(shNode->GetItemByUID(uidName, "SERIES2"), volumeItemID);
+  CHECK_INT(shNode->GetItemByDataNode(volumeNode), volumeItemID);
+
+  // Removed item is not found
+  scene->RemoveNode(volumeNode);
+  CHECK_INT(shNode->GetItemByUID(uidName, "SERIES2"), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+  CHECK_INT(shNode->GetItemByUIDList(instanceUIDName, "1.2.34"), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+
+  // UIDs of items without data node
+  shNode->SetItemUID(studyItemID, uidName, "STUDY1");
+  CHECK_INT(shNode->GetItemByUID(uidName, "STUDY1"), studyItemID);
+  shNode->RemoveItem(studyItemID);
+  CHECK_INT(shNode->GetItemByUID(uidName, "STUDY1"), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestLookupPerformance()
+{
+  // Simulate loading a DICOM study: for each loaded node the item is looked up
+  // by data node, UIDs are set, and referenced instances are looked up by UID.
+  // Time per item is expected to be independent of the number of items.
+  const int numberOfItems = 5000;
+  const int numberOfInstancesPerItem = 5;
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene);
+  CHECK_NOT_NULL(shNode);
+  const char* uidName = vtkMRMLSubjectHierarchyConstants::GetDICOMUIDName();
+  const char* instanceUIDName = vtkMRMLSubjectHierarchyConstants::GetDICOMInstanceUIDName();
+  vtkIdType studyItemID = shNode->CreateStudyItem(shNode->GetSceneItemID(), "Study");
+
+  std::vector<vtkMRMLNode*> dataNodes;
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int itemIndex = 0; itemIndex < numberOfItems; ++itemIndex)
+    {
+    vtkMRMLNode* dataNode = scene->AddNewNodeByClass("vtkMRMLScalarVolumeNode");
+    dataNodes.push_back(dataNode);
+    vtkIdType itemID = shNode->GetItemByDataNode(dataNode);
+    shNode->SetItemParent(itemID, studyItemID);
+    shNode->SetItemUID(itemID, uidName, GetSeriesUID(itemIndex));
+    std::string instanceUIDs;
+    for (int instanceIndex = 0; instanceIndex < numberOfInstancesPerItem; ++instanceIndex)
+      {
+      instanceUIDs += (instanceIndex > 0 ? " " : "") + GetInstanceUID(itemIndex, instanceIndex);
+      }
+    shNode->SetItemUID(itemID, instanceUIDName, instanceUIDs);
+    // Look up an item referenced by the new item
+    if (itemIndex > 0 && shNode->GetItemByUIDList(instanceUIDName, GetInstanceUID(itemIndex / 2, 0).c_str())
+      == vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID)
+      {
+      std::cerr << "Referenced instance of item " << itemIndex / 2 << " not found" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  timer->StopTimer();
+  double loadTime = timer->GetElapsedTime();
+
+  timer->StartTimer();
+  for (int itemIndex = 0; itemIndex < numberOfItems; ++itemIndex)
+    {
+    vtkIdType itemID = shNode->GetItemByDataNode(dataNodes[itemIndex]);
+    if (shNode->GetItemByUID(uidName, GetSeriesUID(itemIndex).c_str()) != itemID
+      || shNode->GetItemByUIDList(instanceUIDName, GetInstanceUID(itemIndex, numberOfInstancesPerItem - 1).c_str()) != itemID)
+      {
+      std::cerr << "Lookup of item " << itemIndex << " failed" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  timer->StopTimer();
+  double lookupTime = timer->GetElapsedTime();
+
+  std::cout << "Number of items: " << numberOfItems
+            << "  Load: " << loadTime * 1000.0 / numberOfItems << " ms/item"
+            << "  Lookup by data node, UID and UID list: " << lookupTime * 1000.0 / numberOfItems << " ms/item"
+            << std::endl;
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSubjectHierarchyNodeLookupTest(int vtkNotUsed(argc), char * vtkNotUsed(argv) [])
+{
+  CHECK_EXIT_SUCCESS(TestLookupConsistency());
+  CHECK_EXIT_SUCCESS(TestLookupPerformance());
+  return EXIT_SUCCESS;
+}
@@ -11,6 +11,7 @@
 =========================================================================auto=*/
 
 #include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScalarVolumeNode.h"
 #include "vtkMRMLScene.h"
 #include "vtkMRMLVectorVolumeNode.h"
 #include "vtkMRMLVolumeArchetypeStorageNode.h"
@@ -20,6 +21,8 @@
 #include "vtkPointData.h"
 #include <vtksys/SystemTools.hxx>
 
+#include <sstream>
+
 std::string tempFilename(std::string tempDir, std::string suffix, std::string fileExtension, bool remove=false)
 {
   std::string filename = tempDir + "/vtkMRMLVolumeArchetypeStorageNodeTest1_" + suffix + "." + fileExtension;
@@ -124,6 +127,81 @@ int TestVoxelVectorType(const std::string& tempDir, const std::string& fileExten
   return EXIT_SUCCESS;
 }
 
+//---------------------------------------------------------------------------
+int TestMemoryMappedSave(const std::string& tempDir, const std::string& fileExtension)
+{
+  // Check that a memory-mapped volume can be saved into the file that it was loaded from.
+  std::cout << "TestMemoryMappedSave: " << fileExtension << std::endl;
+
+  vtkNew<vtkMRMLScene> scene;
+  std::string fileName = tempFilename(tempDir, "memory_mapped", fileExtension, true);
+
+  vtkMRMLScalarVolumeNode* volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLScalarVolumeNode"));
+  CHECK_NOT_NULL(volumeNode);
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(40, 30, 20);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  vtkDataArray* scalars = imageData->GetPointData()->GetScalars();
+  for (vtkIdType i = 0; i < scalars->GetNumberOfTuples(); ++i)
+    {
+    scalars->SetTuple1(i, i % 1000);
+    }
+  volumeNode->SetAndObserveImageData(imageData);
+
+  // Write uncompressed, so that the voxels can be memory-mapped
+  vtkMRMLVolumeArchetypeStorageNode* storageNode = vtkMRMLVolumeArchetypeStorageNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLVolumeArchetypeStorageNode"));
+  CHECK_NOT_NULL(storageNode);
+  storageNode->SetSingleFile(true);
+  storageNode->UseCompressionOff();
+  storageNode->SetFileName(fileName.c_str());
+  CHECK_BOOL(storageNode->WriteData(volumeNode), true);
+
+  // Load with memory mapping, modify a voxel, and save into the same file
+  vtkMRMLScalarVolumeNode* mappedVolumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLScalarVolumeNode"));
+  vtkMRMLVolumeArchetypeStorageNode* mappedStorageNode = vtkMRMLVolumeArchetypeStorageNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLVolumeArchetypeStorageNode"));
+  mappedStorageNode->UseMemoryMappingOn();
+  mappedStorageNode->UseCompressionOff();
+  mappedStorageNode->SetFileName(fileName.c_str());
+  CHECK_BOOL(mappedStorageNode->ReadData(mappedVolumeNode), true);
+  vtkDataArray* mappedScalars = mappedVolumeNode->GetImageData()->GetPointData()->GetScalars();
+  CHECK_NOT_NULL(mappedScalars);
+  CHECK_INT(static_cast<int>(mappedScalars->GetTuple1(1234)), 234);
+  mappedScalars->SetTuple1(1234, -5);
+  mappedScalars->Modified();
+  CHECK_BOOL(mappedStorageNode->WriteData(mappedVolumeNode), true);
+
+  // Voxels of the saved volume are still valid in memory
+  CHECK_INT(static_cast<int>(mappedScalars->GetTuple1(1233)), 233);
+  CHECK_INT(static_cast<int>(mappedScalars->GetTuple1(1234)), -5);
+  CHECK_INT(static_cast<int>(mappedScalars->GetTuple1(mappedScalars->GetNumberOfTuples() - 1)),
+    static_cast<int>((mappedScalars->GetNumberOfTuples() - 1) % 1000));
+
+  // Saved file contains all the voxels, including the modification
+  storageNode->UseMemoryMappingOff();
+  CHECK_BOOL(storageNode->ReadData(volumeNode), true);
+  vtkDataArray* savedScalars = volumeNode->GetImageData()->GetPointData()->GetScalars();
+  CHECK_INT(static_cast<int>(savedScalars->GetNumberOfTuples()), 40 * 30 * 20);
+  CHECK_INT(static_cast<int>(savedScalars->GetTuple1(1233)), 233);
+  CHECK_INT(static_cast<int>(savedScalars->GetTuple1(1234)), -5);
+  CHECK_INT(static_cast<int>(savedScalars->GetTuple1(savedScalars->GetNumberOfTuples() - 1)),
+    static_cast<int>((savedScalars->GetNumberOfTuples() - 1) % 1000));
+
+  // Memory mapping flag is only stored in the scene if it is enabled
+  std::stringstream defaultXML;
+  storageNode->WriteXML(defaultXML, 0);
+  CHECK_BOOL(defaultXML.str().find("useMemoryMapping") == std::string::npos, true);
+  std::stringstream mappedXML;
+  mappedStorageNode->WriteXML(mappedXML, 0);
+  CHECK_BOOL(mappedXML.str().find("useMemoryMapping=\"1\"") != std::string::npos, true);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
 int vtkMRMLVolumeArchetypeStorageNodeTest1(int argc, char* argv[])
 {
   if (argc != 2)
@@ -144,6 +222,9 @@ int vtkMRMLVolumeArchetypeStorageNodeTest1(int argc, char* argv[])
   CHECK_EXIT_SUCCESS(TestVoxelVectorType(tempDir, "tif",  false,     false,   true,  false));
   CHECK_EXIT_SUCCESS(TestVoxelVectorType(tempDir, "jpg",  false,     false,   true,  false));
 
+  CHECK_EXIT_SUCCESS(TestMemoryMappedSave(tempDir, "nrrd"));
+  CHECK_EXIT_SUCCESS(TestMemoryMappedSave(tempDir, "nhdr"));
+
   std::cout << "Test passed." << std::endl;
   return EXIT_SUCCESS;
 }
@@ -10,14 +10,81 @@
 #include <vtkCallbackCommand.h>
 #include <vtkObjectFactory.h>
 
+// STD includes
+#include <algorithm>
+#include <mutex>
+
 vtkStandardNewMacro ( vtkCacheManager );
 
 #define MB 1000000.0
 
+//----------------------------------------------------------------------------
+class vtkCacheManager::vtkInternal
+{
+public:
+  /// Set size of a file in the index (negative size removes the file from the index)
+  void SetFileSize(const std::string& path, vtkTypeInt64 size)
+    {
+    std::map<std::string, vtkTypeInt64>::iterator it = this->FileSizes.find(path);
+    if (it != this->FileSizes.end())
+      {
+      this->TotalSize -= it->second;
+      if (size < 0)
+        {
+        this->FileSizes.erase(it);
+        return;
+        }
+      it->second = size;
+      }
+    else if (size < 0)
+      {
+      return;
+      }
+    else
+      {
+      this->FileSizes[path] = size;
+      }
+    this->TotalSize += size;
+    }
+
+  /// Remove the file and all files in the directory (if path is a directory) from the index
+  void RemovePath(const std::string& path)
+    {
+    this->SetFileSize(path, -1);
+    std::string directoryPath = path + "/";
+    std::map<std::string, vtkTypeInt64>::iterator it = this->FileSizes.lower_bound(directoryPath);
+    while (it != this->FileSizes.end() && it->first.compare(0, directoryPath.size(), directoryPath) == 0)
+      {
+      this->TotalSize -= it->second;
+      it = this->FileSizes.erase(it);
+      }
+    }
+
+  void Clear()
+    {
+    this->FileSizes.clear();
+    this->TotalSize = 0;
+    }
+
+  /// Remove all occurrences of a file name from a file name list
+  static void RemoveFileName(std::vector<std::string>& fileNames, const std::string& fileName)
+    {
+    fileNames.erase(std::remove(fileNames.begin(), fileNames.end(), fileName), fileNames.end());
+    }
+
+  /// Protects the index and CachedFileList, as files may be downloaded in a processing thread
+  std::mutex Mutex;
+  /// Full path of each file in the cache and its size in bytes
+  std::map<std::string, vtkTypeInt64> FileSizes;
+  /// Sum of all file sizes in bytes
+  vtkTypeInt64 TotalSize{ 0 };
+};
+
 //----------------------------------------------------------------------------
 vtkCacheManager::vtkCacheManager()
 {
   this->MRMLScene = nullptr;
+  this->Internal = new vtkInternal;
   this->CallbackCommand = vtkCallbackCommand::New();
   this->CachedFileList.clear();
   //--- what seem reasonable default values here?
@@ -48,6 +115,7 @@ vtkCacheManager::~vtkCacheManager()
   this->EnableForceRedownload = 0;
   this->InsufficientFreeBufferNotificationFlag = 0;
 //  this->EnableRemoteCacheOverwriting = 1;
+  delete this->Internal;
 }
 
 
@@ -260,8 +328,12 @@ void vtkCacheManager::PrintSelf(ostream& os, vtkIndent indent)
 //----------------------------------------------------------------------------
 std::vector< std::string > vtkCacheManager::GetAllCachedFiles ( )
 {
-  this->CachedFileList.clear();
+    {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    this->CachedFileList.clear();
+    }
   this->GetCachedFileList ( this->GetRemoteCacheDirectory() );
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
   return ( this->CachedFileList );
 }
 
@@ -269,6 +341,7 @@ std::vector< std::string > vtkCacheManager::GetAllCachedFiles ( )
 //----------------------------------------------------------------------------
 std::vector< std::string > vtkCacheManager::GetCachedFiles ( ) const
 {
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
   return this->CachedFileList;
 }
 
@@ -309,7 +382,10 @@ int vtkCacheManager::GetCachedFileList ( const char *dirname )
             }
           else
             {
+            std::lock_guard<std::mutex> lock(this->Internal->Mutex);
             this->CachedFileList.emplace_back(dir.GetFile(static_cast<unsigned long>(fileNum)));
+            this->Internal->SetFileSize(fullName,
+              static_cast<vtkTypeInt64>(vtksys::SystemTools::FileLength(fullName)));
             }
           }
         }
@@ -515,33 +591,56 @@ void vtkCacheManager::UpdateCacheInformation ( )
   // this->RemoteCacheFreeBufferSize = ?;
 
   //--- and refresh list of cached files.
-  this->CachedFileList.clear();
+    {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    this->CachedFileList.clear();
+    this->Internal->Clear();
+    }
   this->GetCachedFileList ( this->GetRemoteCacheDirectory() );
   this->Modified();
 }
 
+//----------------------------------------------------------------------------
+void vtkCacheManager::UpdateCacheIndex ( const char *path )
+{
+  if ( path == nullptr )
+    {
+    return;
+    }
+  std::string pathString = path;
+  std::string fileName = vtksys::SystemTools::GetFilenameName ( pathString );
+  bool fileExists = vtksys::SystemTools::FileExists ( pathString, true );
+  vtkTypeInt64 fileSize = fileExists ? static_cast<vtkTypeInt64>(vtksys::SystemTools::FileLength(pathString)) : -1;
+
+  // This method may be called from a processing thread, therefore both the index
+  // and the list of cached files are only accessed while holding the lock.
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->SetFileSize(pathString, fileSize);
+  if ( fileExists )
+    {
+    if ( std::find ( this->CachedFileList.begin(), this->CachedFileList.end(), fileName ) == this->CachedFileList.end() )
+      {
+      this->CachedFileList.push_back ( fileName );
+      }
+    }
+  else
+    {
+    vtkInternal::RemoveFileName(this->CachedFileList, fileName);
+    }
+}
+
 
 
 
 //----------------------------------------------------------------------------
 void vtkCacheManager::DeleteFromCachedFileList ( const char * target )
 {
-
-  std::string tstring = target;
-  std::vector< std::string > tmp = this->CachedFileList;
-  std::vector< std::string >::iterator it;
-  this->CachedFileList.clear();
-
-  for (it = tmp.begin(); it < tmp.end(); it++ )
-      {
-    // look at each filename in the list and keep all but filename to delete
-    if ( *it != tstring )
-      {
-      this->CachedFileList.push_back ( *it );
-      }
+  if ( target == nullptr )
+    {
+    return;
     }
-  tmp.clear();
-
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  vtkInternal::RemoveFileName(this->CachedFileList, target);
 }
 
 
@@ -580,6 +679,7 @@ void vtkCacheManager::DeleteFromCache( const char *target )
         }
       else
         {
+        // files of the directory are removed from the list by rescanning the cache
         this->UpdateCacheInformation ( );
         this->InvokeEvent ( vtkCacheManager::CacheDeleteEvent );
         }
@@ -592,7 +692,7 @@ void vtkCacheManager::DeleteFromCache( const char *target )
         }
       else
         {
-        this->UpdateCacheInformation ( );
+        this->UpdateCacheIndex ( str.c_str() );
         this->InvokeEvent ( vtkCacheManager::CacheDeleteEvent );
         }
       }
@@ -662,8 +762,12 @@ float vtkCacheManager::GetCurrentCacheSize ()
     {
     return (0.0);
     }
-  float size = this->ComputeCacheSize ( this->RemoteCacheDirectory.c_str(), 0 );
-  this->SetCurrentCacheSize ( size );
+  vtkTypeInt64 totalSize = 0;
+    {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    totalSize = this->Internal->TotalSize;
+    }
+  this->SetCurrentCacheSize ( static_cast<float>(totalSize / MB) );
   return ( this->CurrentCacheSize );
 
 }
@@ -773,7 +877,7 @@ float vtkCacheManager::ComputeCacheSize( const char *dirName, unsigned long sz )
   //--- subdirectory size notwithstanding.
   //--- TODO: is there a more accurate way to assess?
 
-  unsigned long cachesize = sz;
+  double cachesize = sz;
   std::string testFile;
   std::string longName;;
   std::string subdirString;
@@ -799,7 +903,7 @@ float vtkCacheManager::ComputeCacheSize( const char *dirName, unsigned long sz )
         if (vtksys::SystemTools::FileIsDirectory(subdirString.c_str()))
           {
           ///---compute dir and filename for recursive hunt
-          cachesize += (long unsigned int)ceil(this->ComputeCacheSize (subdirString.c_str(), 0));
+          cachesize += this->ComputeCacheSize (subdirString.c_str(), 0) * MB;
           }
         else
           {
@@ -821,8 +925,7 @@ float vtkCacheManager::ComputeCacheSize( const char *dirName, unsigned long sz )
     return (-1);
     }
 
-  int byteSize = static_cast<int>(cachesize );
-  this->CurrentCacheSize =  (float)byteSize / MB;
+  this->CurrentCacheSize = static_cast<float>(cachesize / MB);
   return (this->CurrentCacheSize);
 }
 
@@ -830,8 +933,8 @@ float vtkCacheManager::ComputeCacheSize( const char *dirName, unsigned long sz )
 void vtkCacheManager::CacheSizeCheck()
 {
 
-  //--- Compute size of the current cache
-  this->ComputeCacheSize(this->RemoteCacheDirectory.c_str(), 0);
+  //--- Get size of the current cache
+  this->GetCurrentCacheSize();
   //--- Invoke an event if cache size is exceeded.
   if ( this->CurrentCacheSize > (float) (this->RemoteCacheLimit) )
     {
@@ -844,7 +947,7 @@ void vtkCacheManager::CacheSizeCheck()
 float vtkCacheManager::GetFreeCacheSpaceRemaining()
 {
 
-  float cachesize = this->ComputeCacheSize(this->RemoteCacheDirectory.c_str(), 0);
+  float cachesize = this->GetCurrentCacheSize();
   // cache limit - current cache size = total space left in cache.
   // total space in cache - free buffer size = amount that can be used.
   float diff = ( float (this->RemoteCacheLimit) - cachesize );
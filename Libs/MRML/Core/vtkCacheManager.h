@@ -42,9 +42,16 @@ class VTK_MRML_EXPORT vtkCacheManager : public vtkObject
   const char *GetRemoteCacheDirectory ();
 
   ///
-  /// Called when a file is loaded or removed from the cache.
+  /// Rescans the cache directory and rebuilds the list and size index of cached files.
+  /// Called when the cache directory is changed or cleared.
   void UpdateCacheInformation ( );
   ///
+  /// Updates the size index of a single file in the cache, without scanning the
+  /// cache directory. Call this method after a file is downloaded into the cache.
+  /// If the file does not exist anymore then it is removed from the index.
+  /// Thread-safe, may be called from a processing thread.
+  void UpdateCacheIndex ( const char *path );
+  ///
   /// Removes a target from the list of locally cached files and directories
   void DeleteFromCachedFileList ( const char * target );
 
@@ -110,7 +117,10 @@ class VTK_MRML_EXPORT vtkCacheManager : public vtkObject
 
   void CacheSizeCheck();
   void FreeCacheBufferCheck();
+  /// Traverses the directory and computes the combined size of all files (in MB).
+  /// This is slow for large caches, GetCurrentCacheSize() returns the size from the cache index.
   float ComputeCacheSize( const char *dirname, unsigned long size );
+  /// Returns the size of files in the cache directory (in MB), as stored in the cache index.
   float GetCurrentCacheSize();
   float GetFreeCacheSpaceRemaining();
 
@@ -170,8 +180,12 @@ class VTK_MRML_EXPORT vtkCacheManager : public vtkObject
   /// in case it's faster to search thru this list than to
   /// snuffle thru a large cache dir. Must keep current
   /// with every download, remove from cache, and clearcache call.
+  /// Only accessed while holding the lock of the cache index (it is updated from processing threads).
   std::vector< std::string > CachedFileList;
 
+  class vtkInternal;
+  vtkInternal* Internal;
+
  protected:
   vtkCacheManager();
   ~vtkCacheManager() override;
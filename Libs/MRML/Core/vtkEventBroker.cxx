@@ -14,6 +14,7 @@
 
 // MRML includes
 #include "vtkEventBroker.h"
+#include "vtkMRMLPerformanceTracer.h"
 #include "vtkObservation.h"
 
 // VTK includes
@@ -100,6 +101,10 @@ vtkEventBroker::vtkEventBroker()
   this->ScriptHandler = nullptr;
   this->ScriptHandlerClientData = nullptr;
   this->RequestModifiedCallback = nullptr;
+  this->EventCompressionNestingLevel = 0;
+  this->NumberOfCompressedEvents = 0;
+  this->NumberOfSuppressedEvents = 0;
+  this->CompressedEvents.insert(vtkCommand::ModifiedEvent);
 }
 
 //----------------------------------------------------------------------------
@@ -147,6 +152,8 @@ void vtkEventBroker::DetachObservations()
       }
     }
   this->SubjectMap.clear();
+  this->CompressedCallQueue.clear();
+  this->CompressedCalls.clear();
 }
 
 //----------------------------------------------------------------------------
@@ -326,6 +333,24 @@ void vtkEventBroker::RemoveObservations (ObservationVector observations)
       }
     }
 
+  // remove from compressed events
+  if (!this->CompressedCallQueue.empty())
+    {
+    for (std::deque< CompressedCall >::iterator callIter = this->CompressedCallQueue.begin();
+      callIter != this->CompressedCallQueue.end();)
+      {
+      if (observations.find(callIter->Observation) != observations.end())
+        {
+        this->CompressedCalls.erase(*callIter);
+        callIter = this->CompressedCallQueue.erase(callIter);
+        }
+      else
+        {
+        ++callIter;
+        }
+      }
+    }
+
   // detach and delete each of the observations
   for(ObservationVector::iterator removeIter=observations.begin(); removeIter != observations.end(); removeIter++)
     {
@@ -688,10 +713,26 @@ void vtkEventBroker::ProcessEvent ( vtkObservation *observation, vtkObject *call
   //
   if ( eid == observation->GetEvent() || observation->GetEvent() == vtkCommand::AnyEvent )
     {
-    if ( this->EventMode == vtkEventBroker::Synchronous || eid == vtkCommand::DeleteEvent )
+    if ( eid == vtkCommand::DeleteEvent )
       {
       this->InvokeObservation( observation, eid, callData );
       }
+    else if ( this->EventMode == vtkEventBroker::Synchronous )
+      {
+      // events with call data are never compressed: the call data may point to
+      // memory (e.g., a local variable of the caller) that is not valid anymore
+      // when the compressed events are processed
+      if ( this->EventCompressionNestingLevel > 0
+        && callData == nullptr
+        && this->CompressedEvents.find(eid) != this->CompressedEvents.end() )
+        {
+        this->CompressObservation( observation, eid );
+        }
+      else
+        {
+        this->InvokeObservation( observation, eid, callData );
+        }
+      }
     else if ( this->EventMode == vtkEventBroker::Asynchronous )
       {
       this->QueueObservation( observation, eid, callData );
@@ -819,6 +860,9 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
 {
   this->EventNestingLevel++;
 
+  vtkObject* observer = observation->GetObserver();
+  MRML_TRACE_SCOPE("EventBroker::InvokeObservation", observer ? observer->GetClassName() : "Script");
+
   double startTime = this->TimerLog->GetUniversalTime();
 
   // Register so observation won't be deleted while callback is running
@@ -889,6 +933,104 @@ void vtkEventBroker::ProcessEventQueue ()
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkEventBroker::StartEventCompression()
+{
+  this->EventCompressionNestingLevel++;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::EndEventCompression()
+{
+  if (this->EventCompressionNestingLevel <= 0)
+    {
+    vtkErrorMacro("EndEventCompression: StartEventCompression was not called");
+    return;
+    }
+  this->EventCompressionNestingLevel--;
+  if (this->EventCompressionNestingLevel == 0)
+    {
+    this->ProcessCompressedEvents();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::AddCompressedEvent(unsigned long eid)
+{
+  if (eid == vtkCommand::DeleteEvent)
+    {
+    vtkErrorMacro("AddCompressedEvent: DeleteEvent cannot be compressed");
+    return;
+    }
+  this->CompressedEvents.insert(eid);
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::RemoveCompressedEvent(unsigned long eid)
+{
+  this->CompressedEvents.erase(eid);
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::RemoveAllCompressedEvents()
+{
+  this->CompressedEvents.clear();
+}
+
+//----------------------------------------------------------------------------
+bool vtkEventBroker::IsCompressedEvent(unsigned long eid)
+{
+  return this->CompressedEvents.find(eid) != this->CompressedEvents.end();
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::ResetEventCompressionCounters()
+{
+  this->NumberOfCompressedEvents = 0;
+  this->NumberOfSuppressedEvents = 0;
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::GetNumberOfPendingCompressedEvents()
+{
+  return static_cast<int>(this->CompressedCallQueue.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::CompressObservation ( vtkObservation *observation,
+                                           unsigned long eid )
+{
+  this->NumberOfCompressedEvents++;
+  CompressedCall call = { observation, eid };
+  if (!this->CompressedCalls.insert(call).second)
+    {
+    // identical event is already waiting to be invoked
+    this->NumberOfSuppressedEvents++;
+    return;
+    }
+  this->CompressedCallQueue.push_back(call);
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::ProcessCompressedEvents ()
+{
+  //
+  // invoke the collected events in the order of their first occurrence
+  // - the event is removed from the queue before invoking it, so that
+  //   the same event can be collected again if compression is restarted
+  //   during the callback
+  // - observations removed during the callbacks are removed from the queue
+  //   by RemoveObservations
+  //
+  while ( !this->CompressedCallQueue.empty() && this->EventCompressionNestingLevel == 0 )
+    {
+    CompressedCall call = this->CompressedCallQueue.front();
+    this->CompressedCallQueue.pop_front();
+    this->CompressedCalls.erase(call);
+    this->InvokeObservation( call.Observation, call.EventID, nullptr );
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -899,6 +1041,10 @@ void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "EventMode: " << this->GetEventModeAsString() << "\n";
   os << indent << "EventLogging: " << this->EventLogging << "\n";
   os << indent << "EventNestingLevel: " << this->EventNestingLevel << "\n";
+  os << indent << "EventCompressionNestingLevel: " << this->EventCompressionNestingLevel << "\n";
+  os << indent << "NumberOfPendingCompressedEvents: " << this->GetNumberOfPendingCompressedEvents() << "\n";
+  os << indent << "NumberOfCompressedEvents: " << this->NumberOfCompressedEvents << "\n";
+  os << indent << "NumberOfSuppressedEvents: " << this->NumberOfSuppressedEvents << "\n";
   os << indent << "LogFileName: " <<
     (this->LogFileName ? this->LogFileName : "(none)") << "\n";
 }
@@ -24,10 +24,13 @@ class vtkTimerLog;
 
 // STD includes
 #include <deque>
+#include <functional>
 #include <vector>
 #include <set>
 #include <map>
 #include <fstream>
+#include <unordered_map>
+#include <unordered_set>
 
 class vtkCollection;
 class vtkCallbackCommand;
@@ -52,7 +55,7 @@ public:
   vtkTypeMacro(vtkEventBroker, vtkObject);
   void PrintSelf(ostream& os, vtkIndent indent) override;
 
-  typedef std::set< vtkObservation * > ObservationVector;
+  typedef std::unordered_set< vtkObservation * > ObservationVector;
 
   ///
   /// Return the singleton instance with no reference counting.
@@ -233,6 +236,45 @@ public:
   vtkGetMacro (CompressCallData, int);
   vtkSetMacro (CompressCallData, int);
 
+  /// Event compression
+  ///
+  /// Between StartEventCompression() and EndEventCompression() calls, compressed
+  /// events (by default: ModifiedEvent) are not invoked immediately in synchronous mode
+  /// but they are collected and identical events (same observation and event ID)
+  /// are invoked only once, when the outermost EndEventCompression() is called.
+  /// Only events without call data are compressed, because call data may point to memory
+  /// that is not valid anymore when the outermost EndEventCompression() is called.
+  /// Other events (and events with non-null call data) are invoked immediately.
+  /// This reduces the number of callbacks when many objects are modified in bulk.
+  /// Calls can be nested, each StartEventCompression() call must be followed by a
+  /// EndEventCompression() call.
+  void StartEventCompression();
+  void EndEventCompression();
+  /// Returns true if events are compressed (StartEventCompression was called
+  /// without a matching EndEventCompression).
+  bool IsEventCompressionActive() { return this->EventCompressionNestingLevel > 0; };
+
+  ///
+  /// Set events that are compressed. DeleteEvent is never compressed.
+  void AddCompressedEvent(unsigned long eid);
+  void RemoveCompressedEvent(unsigned long eid);
+  void RemoveAllCompressedEvents();
+  bool IsCompressedEvent(unsigned long eid);
+
+  ///
+  /// Number of events that were collected while event compression was active.
+  vtkGetMacro(NumberOfCompressedEvents, vtkTypeInt64);
+  ///
+  /// Number of collected events that were not invoked because an identical
+  /// event was already waiting to be invoked.
+  vtkGetMacro(NumberOfSuppressedEvents, vtkTypeInt64);
+  ///
+  /// Set the event compression counters to zero.
+  void ResetEventCompressionCounters();
+  ///
+  /// Number of events that are waiting to be invoked at the end of event compression.
+  int GetNumberOfPendingCompressedEvents();
+
   ///
   /// Sets the method pointer to be used for processing script observations
   void SetScriptHandler ( void (*scriptHandler) (const char* script, void *clientData), void *clientData )
@@ -272,12 +314,19 @@ protected:
   void AttachObservation (vtkObservation *observation);
   void DetachObservation (vtkObservation *observation);
 
+  ///
+  /// Collect the event for invocation at the end of event compression.
+  void CompressObservation (vtkObservation *observation, unsigned long eid);
+  ///
+  /// Invoke all events collected during event compression.
+  void ProcessCompressedEvents ();
+
   friend class vtkEventBrokerInitialize;
   typedef vtkEventBroker Self;
 
 
   ///
-  typedef std::map< vtkObject*, ObservationVector > ObjectToObservationVectorMap;
+  typedef std::unordered_map< vtkObject*, ObservationVector > ObjectToObservationVectorMap;
 
   /// maps to manage quick lookup by object
   ObjectToObservationVectorMap SubjectMap;
@@ -286,6 +335,34 @@ protected:
   /// The event queue of triggered but not-yet-invoked observations
   std::deque< vtkObservation * > EventQueue;
 
+  /// Event that is collected during event compression
+  struct CompressedCall
+    {
+    vtkObservation* Observation;
+    unsigned long EventID;
+    bool operator==(const CompressedCall& other) const
+      {
+      return this->Observation == other.Observation && this->EventID == other.EventID;
+      }
+    };
+  struct CompressedCallHash
+    {
+    size_t operator()(const CompressedCall& call) const
+      {
+      size_t hash = std::hash<vtkObservation*>()(call.Observation);
+      hash ^= std::hash<unsigned long>()(call.EventID) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+      return hash;
+      }
+    };
+  /// Events collected during event compression, in the order of their first occurrence
+  std::deque< CompressedCall > CompressedCallQueue;
+  /// Fast lookup of events that are in CompressedCallQueue
+  std::unordered_set< CompressedCall, CompressedCallHash > CompressedCalls;
+  std::set< unsigned long > CompressedEvents;
+  int EventCompressionNestingLevel;
+  vtkTypeInt64 NumberOfCompressedEvents;
+  vtkTypeInt64 NumberOfSuppressedEvents;
+
   void (*ScriptHandler) (const char* script, void* clientData);
   void *ScriptHandlerClientData;
 
@@ -0,0 +1,418 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLPerformanceTracer.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+#include <vtksys/FStream.hxx>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+const int THREAD_BUFFER_SIZE = 65536;
+/// Spans are allocated in chunks, when they are first needed, so that threads
+/// that record only a few spans do not allocate the whole buffer.
+const int SPAN_CHUNK_SIZE = 1024;
+const int NUMBER_OF_SPAN_CHUNKS = THREAD_BUFFER_SIZE / SPAN_CHUNK_SIZE;
+
+//----------------------------------------------------------------------------
+struct TraceSpan
+{
+  const char* Category;
+  const char* Name;
+  vtkTypeInt64 StartTime;
+  vtkTypeInt64 Duration;
+};
+
+//----------------------------------------------------------------------------
+/// Ring buffer of spans recorded by a single thread.
+/// Only the owner thread writes the spans, other threads only read them.
+/// When the owner thread exits, the buffer (with its spans) is kept and
+/// it is reused by the next thread that starts recording.
+struct ThreadBuffer
+{
+  ThreadBuffer(int threadId)
+    : ThreadId(threadId)
+    , NumberOfRecordedSpans(0)
+    , FirstSpanIndex(0)
+  {
+  }
+
+  /// Get a stored span. Only valid for indices returned by GetStoredSpanRange.
+  const TraceSpan& GetSpan(vtkTypeUInt64 spanIndex) const
+  {
+    int bufferIndex = static_cast<int>(spanIndex % THREAD_BUFFER_SIZE);
+    return this->SpanChunks[bufferIndex / SPAN_CHUNK_SIZE][bufferIndex % SPAN_CHUNK_SIZE];
+  }
+
+  /// Get the span to write. Allocates the chunk of the span if needed.
+  /// Must only be called by the owner thread.
+  TraceSpan& GetSpanForWriting(vtkTypeUInt64 spanIndex)
+  {
+    int bufferIndex = static_cast<int>(spanIndex % THREAD_BUFFER_SIZE);
+    std::unique_ptr<TraceSpan[]>& chunk = this->SpanChunks[bufferIndex / SPAN_CHUNK_SIZE];
+    if (!chunk)
+      {
+      chunk.reset(new TraceSpan[SPAN_CHUNK_SIZE]);
+      }
+    return chunk[bufferIndex % SPAN_CHUNK_SIZE];
+  }
+
+  /// Chunks are published to readers by the release store of NumberOfRecordedSpans
+  std::unique_ptr<TraceSpan[]> SpanChunks[NUMBER_OF_SPAN_CHUNKS];
+  int ThreadId;
+  /// Total number of spans recorded since the buffer was created
+  std::atomic<vtkTypeUInt64> NumberOfRecordedSpans;
+  /// Spans before this index are cleared
+  std::atomic<vtkTypeUInt64> FirstSpanIndex;
+
+  /// Get index range of spans that are still stored in the buffer.
+  void GetStoredSpanRange(vtkTypeUInt64& first, vtkTypeUInt64& end) const
+  {
+    end = this->NumberOfRecordedSpans.load(std::memory_order_acquire);
+    first = std::max(this->FirstSpanIndex.load(std::memory_order_relaxed),
+      end > static_cast<vtkTypeUInt64>(THREAD_BUFFER_SIZE) ? end - THREAD_BUFFER_SIZE : 0);
+  }
+};
+
+//----------------------------------------------------------------------------
+struct TracerRegistry
+{
+  std::mutex Mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> ThreadBuffers;
+  /// Buffers of exited threads, which can be reused by new threads
+  std::vector<ThreadBuffer*> FreeThreadBuffers;
+  /// Strings of spans added by AddSpan
+  std::set<std::string> Strings;
+};
+
+//----------------------------------------------------------------------------
+TracerRegistry& GetRegistry()
+{
+  static TracerRegistry registry;
+  return registry;
+}
+
+//----------------------------------------------------------------------------
+/// Assigns a buffer to the current thread and returns it to the free list
+/// when the thread exits. This keeps the number of buffers bounded by the
+/// maximum number of threads that recorded spans at the same time.
+struct ThreadBufferOwner
+{
+  ThreadBufferOwner()
+  {
+    TracerRegistry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.Mutex);
+    if (!registry.FreeThreadBuffers.empty())
+      {
+      this->Buffer = registry.FreeThreadBuffers.back();
+      registry.FreeThreadBuffers.pop_back();
+      }
+    else
+      {
+      registry.ThreadBuffers.emplace_back(new ThreadBuffer(static_cast<int>(registry.ThreadBuffers.size()) + 1));
+      this->Buffer = registry.ThreadBuffers.back().get();
+      }
+  }
+
+  ~ThreadBufferOwner()
+  {
+    TracerRegistry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.Mutex);
+    registry.FreeThreadBuffers.push_back(this->Buffer);
+  }
+
+  ThreadBuffer* Buffer;
+};
+
+//----------------------------------------------------------------------------
+ThreadBuffer* GetCurrentThreadBuffer()
+{
+  thread_local ThreadBufferOwner owner;
+  return owner.Buffer;
+}
+
+//----------------------------------------------------------------------------
+void WriteJsonString(std::ostream& os, const char* str)
+{
+  os << '"';
+  for (const char* c = (str ? str : ""); *c; ++c)
+    {
+    switch (*c)
+      {
+      case '"': os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\n': os << "\\n"; break;
+      case '\r': os << "\\r"; break;
+      case '\t': os << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20)
+          {
+          os << ' ';
+          }
+        else
+          {
+          os << *c;
+          }
+      }
+    }
+  os << '"';
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// The tracer singleton.
+// This MUST be default initialized to zero by the compiler and is
+// therefore not initialized here.  The ClassInitialize and
+// ClassFinalize methods handle this instance.
+static vtkMRMLPerformanceTracer* vtkMRMLPerformanceTracerInstance;
+
+//----------------------------------------------------------------------------
+// Must NOT be initialized.  Default initialization to zero is necessary.
+unsigned int vtkMRMLPerformanceTracerInitialize::Count;
+
+std::atomic<bool> vtkMRMLPerformanceTracer::Enabled(false);
+
+//----------------------------------------------------------------------------
+// Implementation of vtkMRMLPerformanceTracerInitialize class.
+//----------------------------------------------------------------------------
+vtkMRMLPerformanceTracerInitialize::vtkMRMLPerformanceTracerInitialize()
+{
+  if(++Self::Count == 1)
+    {
+    vtkMRMLPerformanceTracer::classInitialize();
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLPerformanceTracerInitialize::~vtkMRMLPerformanceTracerInitialize()
+{
+  if(--Self::Count == 0)
+    {
+    vtkMRMLPerformanceTracer::classFinalize();
+    }
+}
+
+//----------------------------------------------------------------------------
+// Up the reference count so it behaves like New
+vtkMRMLPerformanceTracer* vtkMRMLPerformanceTracer::New()
+{
+  vtkMRMLPerformanceTracer* ret = vtkMRMLPerformanceTracer::GetInstance();
+  ret->Register(nullptr);
+  return ret;
+}
+
+//----------------------------------------------------------------------------
+// Return the single instance of the vtkMRMLPerformanceTracer
+vtkMRMLPerformanceTracer* vtkMRMLPerformanceTracer::GetInstance()
+{
+  if(!vtkMRMLPerformanceTracerInstance)
+    {
+    // Try the factory first
+    vtkMRMLPerformanceTracerInstance = (vtkMRMLPerformanceTracer*)vtkObjectFactory::CreateInstance("vtkMRMLPerformanceTracer");
+    // if the factory did not provide one, then create it here
+    if(!vtkMRMLPerformanceTracerInstance)
+      {
+      vtkMRMLPerformanceTracerInstance = new vtkMRMLPerformanceTracer;
+#ifdef VTK_HAS_INITIALIZE_OBJECT_BASE
+      vtkMRMLPerformanceTracerInstance->InitializeObjectBase();
+#endif
+      }
+    }
+  // return the instance
+  return vtkMRMLPerformanceTracerInstance;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLPerformanceTracer::vtkMRMLPerformanceTracer() = default;
+
+//----------------------------------------------------------------------------
+vtkMRMLPerformanceTracer::~vtkMRMLPerformanceTracer() = default;
+
+//----------------------------------------------------------------------------
+void vtkMRMLPerformanceTracer::classInitialize()
+{
+  // Allocate the singleton
+  vtkMRMLPerformanceTracerInstance = vtkMRMLPerformanceTracer::GetInstance();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLPerformanceTracer::classFinalize()
+{
+  vtkMRMLPerformanceTracerInstance->Delete();
+  vtkMRMLPerformanceTracerInstance = nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLPerformanceTracer::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Enabled: " << this->GetEnabled() << "\n";
+  os << indent << "NumberOfSpans: " << this->GetNumberOfSpans() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLPerformanceTracer::SetEnabled(bool enabled)
+{
+  if (vtkMRMLPerformanceTracer::Enabled.load() == enabled)
+    {
+    return;
+    }
+  if (enabled)
+    {
+    // Initialize time reference
+    vtkMRMLPerformanceTracer::GetTimestamp();
+    }
+  vtkMRMLPerformanceTracer::Enabled.store(enabled);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLPerformanceTracer::GetEnabled()
+{
+  return vtkMRMLPerformanceTracer::Enabled.load();
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLPerformanceTracer::GetThreadBufferSize()
+{
+  return THREAD_BUFFER_SIZE;
+}
+
+//----------------------------------------------------------------------------
+vtkTypeInt64 vtkMRMLPerformanceTracer::GetTimestamp()
+{
+  static const std::chrono::steady_clock::time_point referenceTime = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - referenceTime).count();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLPerformanceTracer::RecordSpan(const char* category, const char* name, vtkTypeInt64 startTime, vtkTypeInt64 duration)
+{
+  ThreadBuffer* buffer = GetCurrentThreadBuffer();
+  vtkTypeUInt64 spanIndex = buffer->NumberOfRecordedSpans.load(std::memory_order_relaxed);
+  TraceSpan& span = buffer->GetSpanForWriting(spanIndex);
+  span.Category = category;
+  span.Name = name;
+  span.StartTime = startTime;
+  span.Duration = duration;
+  buffer->NumberOfRecordedSpans.store(spanIndex + 1, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLPerformanceTracer::AddSpan(const char* category, const char* name, vtkTypeInt64 startTime, vtkTypeInt64 duration)
+{
+  const char* storedCategory = nullptr;
+  const char* storedName = nullptr;
+  {
+    TracerRegistry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.Mutex);
+    storedCategory = registry.Strings.insert(category ? category : "").first->c_str();
+    storedName = registry.Strings.insert(name ? name : "").first->c_str();
+  }
+  vtkMRMLPerformanceTracer::RecordSpan(storedCategory, storedName, startTime, duration);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLPerformanceTracer::Clear()
+{
+  TracerRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.Mutex);
+  for (const std::unique_ptr<ThreadBuffer>& buffer : registry.ThreadBuffers)
+    {
+    buffer->FirstSpanIndex.store(buffer->NumberOfRecordedSpans.load(std::memory_order_acquire));
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLPerformanceTracer::GetNumberOfSpans()
+{
+  TracerRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.Mutex);
+  vtkTypeUInt64 numberOfSpans = 0;
+  for (const std::unique_ptr<ThreadBuffer>& buffer : registry.ThreadBuffers)
+    {
+    vtkTypeUInt64 first = 0;
+    vtkTypeUInt64 end = 0;
+    buffer->GetStoredSpanRange(first, end);
+    numberOfSpans += end - first;
+    }
+  return static_cast<int>(numberOfSpans);
+}
+
+//----------------------------------------------------------------------------
+std::string vtkMRMLPerformanceTracer::GetChromeTrace()
+{
+  std::ostringstream os;
+  os << "{\"traceEvents\":[";
+  bool firstEvent = true;
+  TracerRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.Mutex);
+  for (const std::unique_ptr<ThreadBuffer>& buffer : registry.ThreadBuffers)
+    {
+    vtkTypeUInt64 first = 0;
+    vtkTypeUInt64 end = 0;
+    buffer->GetStoredSpanRange(first, end);
+    for (vtkTypeUInt64 spanIndex = first; spanIndex < end; ++spanIndex)
+      {
+      const TraceSpan& span = buffer->GetSpan(spanIndex);
+      os << (firstEvent ? "\n" : ",\n") << "{\"name\":";
+      WriteJsonString(os, span.Name);
+      os << ",\"cat\":";
+      WriteJsonString(os, span.Category);
+      os << ",\"ph\":\"X\",\"ts\":" << span.StartTime << ",\"dur\":" << span.Duration
+        << ",\"pid\":1,\"tid\":" << buffer->ThreadId << "}";
+      firstEvent = false;
+      }
+    }
+  os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return os.str();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLPerformanceTracer::WriteChromeTrace(const char* fileName)
+{
+  if (!fileName)
+    {
+    vtkErrorMacro("WriteChromeTrace failed: invalid filename");
+    return false;
+    }
+  vtksys::ofstream file(fileName, std::ios::out | std::ios::binary);
+  if (!file)
+    {
+    vtkErrorMacro("WriteChromeTrace failed: cannot open file " << fileName << " for writing");
+    return false;
+    }
+  file << this->GetChromeTrace();
+  file.close();
+  if (file.fail())
+    {
+    vtkErrorMacro("WriteChromeTrace failed: error writing file " << fileName);
+    return false;
+    }
+  return true;
+}
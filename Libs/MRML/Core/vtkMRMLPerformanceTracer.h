@@ -0,0 +1,196 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkMRMLPerformanceTracer_h
+#define __vtkMRMLPerformanceTracer_h
+
+// MRML includes
+#include "vtkMRML.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <atomic>
+#include <string>
+
+/// \brief Records timed spans of scene operations for performance analysis.
+///
+/// Spans (scene import, storage node read and write, displayable manager updates,
+/// slice logic pipeline updates, event broker dispatch, ...) are recorded into
+/// per-thread ring buffers without locking. When the buffer of a thread is full then
+/// the oldest spans of that thread are overwritten. Buffers are allocated as spans
+/// are recorded, and the buffer of an exited thread is reused by the next thread
+/// that records spans (spans of the exited thread are kept).
+///
+/// Recorded spans can be exported in Chrome trace event format (JSON), which can be
+/// displayed in chrome://tracing or https://ui.perfetto.dev.
+///
+/// Tracing is disabled by default. When disabled, a traced scope costs a single
+/// relaxed atomic load. In C++, spans are recorded using MRML_TRACE_SCOPE:
+/// \code
+/// void vtkMRMLSomeLogic::UpdatePipeline()
+/// {
+///   MRML_TRACE_SCOPE("UpdatePipeline", this->GetClassName());
+///   ...
+/// }
+/// \endcode
+///
+/// Example of tracing from Python:
+/// \code
+/// tracer = slicer.vtkMRMLPerformanceTracer.GetInstance()
+/// tracer.Clear()
+/// tracer.EnabledOn()
+/// slicer.util.loadVolume(...)
+/// tracer.EnabledOff()
+/// tracer.WriteChromeTrace("/tmp/trace.json")
+/// \endcode
+class VTK_MRML_EXPORT vtkMRMLPerformanceTracer : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkMRMLPerformanceTracer, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  ///
+  /// Return the singleton instance with no reference counting.
+  static vtkMRMLPerformanceTracer* GetInstance();
+
+  ///
+  /// This is a singleton pattern New. There will only be ONE
+  /// reference to a vtkMRMLPerformanceTracer object per process. Clients that
+  /// call this must call Delete on the object so that the reference
+  /// counting will work. The single instance will be unreferenced when
+  /// the program exits.
+  static vtkMRMLPerformanceTracer* New();
+
+  /// Enable/disable recording of spans. Already recorded spans are kept.
+  void SetEnabled(bool enabled);
+  bool GetEnabled();
+  vtkBooleanMacro(Enabled, bool);
+
+  /// Remove all recorded spans.
+  void Clear();
+
+  /// Number of spans currently stored, in all threads.
+  int GetNumberOfSpans();
+
+  /// Maximum number of spans stored for each thread.
+  static int GetThreadBufferSize();
+
+  /// Record a span from scripted code. Start time and duration are in microseconds,
+  /// start time is relative to the time returned by GetTimestamp().
+  /// Category and name strings are copied.
+  void AddSpan(const char* category, const char* name, vtkTypeInt64 startTime, vtkTypeInt64 duration);
+
+  /// Current time in microseconds, relative to the first use of the tracer.
+  static vtkTypeInt64 GetTimestamp();
+
+  /// Get recorded spans in Chrome trace event format (JSON).
+  /// Spans that are being recorded while the trace is exported may be
+  /// incomplete, therefore tracing should be disabled before export.
+  std::string GetChromeTrace();
+
+  /// Write recorded spans in Chrome trace event format (JSON) into a file.
+  /// Returns false on failure.
+  bool WriteChromeTrace(const char* fileName);
+
+#ifndef __VTK_WRAP__
+  /// Returns true if tracing is enabled. Fast, can be called from any thread.
+  static bool IsEnabled()
+    {
+    return Enabled.load(std::memory_order_relaxed);
+    }
+
+  /// Record a span in the buffer of the current thread. Lock-free.
+  /// Category and name are not copied, therefore they must remain valid until
+  /// the trace is exported (string literals or class names returned by GetClassName()).
+  static void RecordSpan(const char* category, const char* name, vtkTypeInt64 startTime, vtkTypeInt64 duration);
+#endif
+
+protected:
+  vtkMRMLPerformanceTracer();
+  ~vtkMRMLPerformanceTracer() override;
+  vtkMRMLPerformanceTracer(const vtkMRMLPerformanceTracer&);
+  void operator=(const vtkMRMLPerformanceTracer&);
+
+  ///
+  /// Singleton management functions.
+  static void classInitialize();
+  static void classFinalize();
+
+  friend class vtkMRMLPerformanceTracerInitialize;
+  typedef vtkMRMLPerformanceTracer Self;
+
+#ifndef __VTK_WRAP__
+  static std::atomic<bool> Enabled;
+#endif
+};
+
+/// Utility class to make sure vtkMRMLPerformanceTracer is initialized before it is used.
+class VTK_MRML_EXPORT vtkMRMLPerformanceTracerInitialize
+{
+public:
+  typedef vtkMRMLPerformanceTracerInitialize Self;
+
+  vtkMRMLPerformanceTracerInitialize();
+  ~vtkMRMLPerformanceTracerInitialize();
+private:
+  static unsigned int Count;
+};
+
+/// This instance will show up in any translation unit that uses
+/// vtkMRMLPerformanceTracer. It will make sure vtkMRMLPerformanceTracer is initialized
+/// before it is used.
+static vtkMRMLPerformanceTracerInitialize vtkMRMLPerformanceTracerInitializer;
+
+#ifndef __VTK_WRAP__
+/// Records a span from its construction until its destruction.
+/// Use it via the MRML_TRACE_SCOPE macro.
+class vtkMRMLPerformanceTraceScope
+{
+public:
+  vtkMRMLPerformanceTraceScope(const char* category, const char* name)
+    : Category(category)
+    , Name(name)
+    , StartTime(vtkMRMLPerformanceTracer::IsEnabled() ? vtkMRMLPerformanceTracer::GetTimestamp() : -1)
+    {
+    }
+  ~vtkMRMLPerformanceTraceScope()
+    {
+    if (this->StartTime >= 0)
+      {
+      vtkMRMLPerformanceTracer::RecordSpan(this->Category, this->Name, this->StartTime,
+        vtkMRMLPerformanceTracer::GetTimestamp() - this->StartTime);
+      }
+    }
+private:
+  vtkMRMLPerformanceTraceScope(const vtkMRMLPerformanceTraceScope&) = delete;
+  void operator=(const vtkMRMLPerformanceTraceScope&) = delete;
+  const char* Category;
+  const char* Name;
+  vtkTypeInt64 StartTime;
+};
+
+#define MRML_TRACE_SCOPE_CONCAT_INTERNAL(a, b) a##b
+#define MRML_TRACE_SCOPE_CONCAT(a, b) MRML_TRACE_SCOPE_CONCAT_INTERNAL(a, b)
+
+/// Record the time spent in the current scope.
+/// Category and name must remain valid until the trace is exported
+/// (string literals or class names returned by GetClassName()).
+#define MRML_TRACE_SCOPE(category, name) \
+  vtkMRMLPerformanceTraceScope MRML_TRACE_SCOPE_CONCAT(mrmlTraceScope, __LINE__)(category, name)
+#endif
+
+#endif
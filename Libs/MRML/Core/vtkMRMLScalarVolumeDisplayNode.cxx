@@ -23,6 +23,7 @@ Version:   $Revision: 1.2 $
 #include <vtkAlgorithmOutput.h>
 #include <vtkCallbackCommand.h>
 #include <vtkColorTransferFunction.h>
+#include <vtkDataArray.h>
 #include <vtkImageAppendComponents.h>
 #include <vtkImageCast.h>
 #include <vtkImageData.h>
@@ -34,12 +35,142 @@ Version:   $Revision: 1.2 $
 #include <vtkImageThreshold.h>
 #include <vtkObjectFactory.h>
 #include <vtkLookupTable.h>
+#include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkVersion.h>
+#include <vtkWeakPointer.h>
 
 
 // STD includes
 #include <cassert>
+#include <deque>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Automatic window/level results of the most recently processed images.
+// Entries are identified by the image data object, its scalar array, and their
+// modified times. The cache is shared between all display nodes, so that when
+// a proxy node of a sequence shows an item again (it refers to the same image data
+// object as the sequence item) the range does not have to be computed again.
+struct AutoLevelsCacheEntry
+{
+  vtkWeakPointer<vtkImageData> ImageData;
+  vtkMTimeType ImageDataMTime;
+  vtkWeakPointer<vtkDataArray> Scalars;
+  vtkMTimeType ScalarsMTime;
+  vtkIdType MaximumNumberOfSamples;
+  double Range[2];
+};
+
+const unsigned int AUTO_LEVELS_CACHE_SIZE = 32;
+
+std::deque<AutoLevelsCacheEntry>& GetAutoLevelsCache()
+{
+  static std::deque<AutoLevelsCacheEntry> cache;
+  return cache;
+}
+
+//----------------------------------------------------------------------------
+bool GetAutoLevelsFromCache(vtkImageData* imageData, vtkIdType maximumNumberOfSamples, double range[2])
+{
+  vtkDataArray* scalars = imageData->GetPointData()->GetScalars();
+  std::deque<AutoLevelsCacheEntry>& cache = GetAutoLevelsCache();
+  for (std::deque<AutoLevelsCacheEntry>::iterator entryIt = cache.begin(); entryIt != cache.end(); ++entryIt)
+    {
+    if (entryIt->ImageData.GetPointer() == imageData
+      && entryIt->ImageDataMTime == imageData->GetMTime()
+      && entryIt->Scalars.GetPointer() == scalars
+      && entryIt->ScalarsMTime == scalars->GetMTime()
+      && entryIt->MaximumNumberOfSamples == maximumNumberOfSamples)
+      {
+      range[0] = entryIt->Range[0];
+      range[1] = entryIt->Range[1];
+      // move to front, to keep most recently used items in the cache
+      AutoLevelsCacheEntry entry = *entryIt;
+      cache.erase(entryIt);
+      cache.push_front(entry);
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void AddAutoLevelsToCache(vtkImageData* imageData, vtkIdType maximumNumberOfSamples, double range[2])
+{
+  vtkDataArray* scalars = imageData->GetPointData()->GetScalars();
+  std::deque<AutoLevelsCacheEntry>& cache = GetAutoLevelsCache();
+  AutoLevelsCacheEntry entry;
+  entry.ImageData = imageData;
+  entry.ImageDataMTime = imageData->GetMTime();
+  entry.Scalars = scalars;
+  entry.ScalarsMTime = scalars->GetMTime();
+  entry.MaximumNumberOfSamples = maximumNumberOfSamples;
+  entry.Range[0] = range[0];
+  entry.Range[1] = range[1];
+  cache.push_front(entry);
+  while (cache.size() > AUTO_LEVELS_CACHE_SIZE)
+    {
+    cache.pop_back();
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType GetGreatestCommonDivisor(vtkIdType a, vtkIdType b)
+{
+  while (b != 0)
+    {
+    vtkIdType remainder = a % b;
+    a = b;
+    b = remainder;
+    }
+  return a;
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void CopySampledScalars(T* inPtr, T* outPtr, vtkIdType numberOfSamples, vtkIdType increment)
+{
+  for (vtkIdType sampleIndex = 0; sampleIndex < numberOfSamples; ++sampleIndex)
+    {
+    *(outPtr++) = *inPtr;
+    inPtr += increment;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Create a single-row image from every stride-th voxel (first scalar component) of the input.
+// Stride is chosen to be relatively prime to the row and slice size, so that
+// samples are spread across all columns and rows instead of being aligned with a few of them.
+void CreateSampledImage(vtkImageData* imageData, vtkIdType maximumNumberOfSamples, vtkImageData* sampledImageData)
+{
+  int* dimensions = imageData->GetDimensions();
+  vtkIdType numberOfVoxels = imageData->GetNumberOfPoints();
+  vtkIdType stride = (numberOfVoxels + maximumNumberOfSamples - 1) / maximumNumberOfSamples;
+  vtkIdType rowSize = dimensions[0];
+  vtkIdType sliceSize = rowSize * dimensions[1];
+  while (GetGreatestCommonDivisor(stride, rowSize) != 1 || GetGreatestCommonDivisor(stride, sliceSize) != 1)
+    {
+    ++stride;
+    }
+  vtkIdType numberOfSamples = (numberOfVoxels - 1) / stride + 1;
+
+  sampledImageData->SetDimensions(static_cast<int>(numberOfSamples), 1, 1);
+  sampledImageData->AllocateScalars(imageData->GetScalarType(), 1);
+  vtkIdType increment = stride * imageData->GetNumberOfScalarComponents();
+  void* inPtr = imageData->GetScalarPointer();
+  void* outPtr = sampledImageData->GetScalarPointer();
+  switch (imageData->GetScalarType())
+    {
+    vtkTemplateMacro(CopySampledScalars(static_cast<VTK_TT*>(inPtr), static_cast<VTK_TT*>(outPtr), numberOfSamples, increment));
+    default:
+      break;
+    }
+}
+
+} // end of anonymous namespace
 
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLScalarVolumeDisplayNode);
@@ -53,6 +184,7 @@ vtkMRMLScalarVolumeDisplayNode::vtkMRMLScalarVolumeDisplayNode()
   this->AutoWindowLevel = 1;
   this->AutoThreshold = 0;
   this->ApplyThreshold = 0;
+  this->AutoLevelsMaximumNumberOfSamples = 0;
   //this->LowerThreshold = VTK_SHORT_MIN;
   //this->UpperThreshold = VTK_SHORT_MAX;
 
@@ -248,6 +380,10 @@ void vtkMRMLScalarVolumeDisplayNode::WriteXML(ostream& of, int nIndent)
   ss << this->AutoThreshold;
   of << " autoThreshold=\"" << ss.str() << "\"";
   }
+  if (this->AutoLevelsMaximumNumberOfSamples > 0)
+    {
+    of << " autoLevelsMaximumNumberOfSamples=\"" << this->AutoLevelsMaximumNumberOfSamples << "\"";
+    }
   if (this->WindowLevelPresets.size() > 0)
     {
     for (int p = 0; p < this->GetNumberOfWindowLevelPresets(); p++)
@@ -334,6 +470,12 @@ void vtkMRMLScalarVolumeDisplayNode::ReadXMLAttributes(const char** atts)
       ss << attValue;
       ss >> this->AutoThreshold;
       }
+    else if (!strcmp(attName, "autoLevelsMaximumNumberOfSamples"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      ss >> this->AutoLevelsMaximumNumberOfSamples;
+      }
     else if (!strncmp(attName, "windowLevelPreset", 17))
       {
       this->AddWindowLevelPresetFromString(attValue);
@@ -357,6 +499,7 @@ void vtkMRMLScalarVolumeDisplayNode::Copy(vtkMRMLNode *anode)
   this->SetAutoWindowLevel( node->GetAutoWindowLevel() );
   this->SetWindowLevel(node->GetWindow(), node->GetLevel());
   this->SetAutoThreshold( node->GetAutoThreshold() ); // don't want to run CalculateAutoLevel
+  this->SetAutoLevelsMaximumNumberOfSamples(node->GetAutoLevelsMaximumNumberOfSamples());
   this->SetApplyThreshold(node->GetApplyThreshold());
   this->SetThreshold(node->GetLowerThreshold(), node->GetUpperThreshold());
   this->SetInterpolate(node->Interpolate);
@@ -385,6 +528,7 @@ void vtkMRMLScalarVolumeDisplayNode::PrintSelf(ostream& os, vtkIndent indent)
     os << indent.GetNextIndent() << p << " Window: " << this->GetWindowPreset(p) << " | Level: " << this->GetLevelPreset(p) << "\n";
     }
   os << indent << "AutoThreshold:     " << this->AutoThreshold << "\n";
+  os << indent << "AutoLevelsMaximumNumberOfSamples: " << this->AutoLevelsMaximumNumberOfSamples << "\n";
   os << indent << "ApplyThreshold:    " << this->GetApplyThreshold() << "\n";
   os << indent << "UpperThreshold:    " << this->GetUpperThreshold() << "\n";
   os << indent << "LowerThreshold:    " << this->GetLowerThreshold() << "\n";
@@ -753,9 +897,28 @@ void vtkMRMLScalarVolumeDisplayNode::CalculateAutoLevels()
     }
 
   this->IsInCalculateAutoLevels = true;
-  this->HistogramStatistics->SetInputData(imageDataScalar);
-  this->HistogramStatistics->Update();
-  double* intensityRange = this->HistogramStatistics->GetAutoRange();
+  bool useSampling = (this->AutoLevelsMaximumNumberOfSamples > 0
+    && imageDataScalar->GetNumberOfPoints() > this->AutoLevelsMaximumNumberOfSamples);
+  vtkIdType maximumNumberOfSamples = (useSampling ? this->AutoLevelsMaximumNumberOfSamples : 0);
+  double intensityRange[2] = { 0.0, 0.0 };
+  if (!GetAutoLevelsFromCache(imageDataScalar, maximumNumberOfSamples, intensityRange))
+    {
+    if (useSampling)
+      {
+      vtkNew<vtkImageData> sampledImageData;
+      CreateSampledImage(imageDataScalar, maximumNumberOfSamples, sampledImageData);
+      this->HistogramStatistics->SetInputData(sampledImageData);
+      }
+    else
+      {
+      this->HistogramStatistics->SetInputData(imageDataScalar);
+      }
+    this->HistogramStatistics->Update();
+    this->HistogramStatistics->GetAutoRange(intensityRange);
+    // Do not keep a reference to the image data
+    this->HistogramStatistics->SetInputData(nullptr);
+    AddAutoLevelsToCache(imageDataScalar, maximumNumberOfSamples, intensityRange);
+    }
   vtkDebugMacro("CalculateScalarAutoLevels:"
                 << " lower: " << intensityRange[0] << " upper: " << intensityRange[1]);
 
@@ -771,3 +934,9 @@ void vtkMRMLScalarVolumeDisplayNode::CalculateAutoLevels()
   this->EndModify(disabledModify);
   this->IsInCalculateAutoLevels = false;
 }
+
+//---------------------------------------------------------------------------
+void vtkMRMLScalarVolumeDisplayNode::ClearAutoLevelsCache()
+{
+  GetAutoLevelsCache().clear();
+}
@@ -78,6 +78,25 @@ class VTK_MRML_EXPORT vtkMRMLScalarVolumeDisplayNode : public vtkMRMLVolumeDispl
   vtkGetMacro(AutoWindowLevel, int);
   vtkSetMacro(AutoWindowLevel, int);
 
+  ///
+  /// Maximum number of voxels used for computing automatic window/level and threshold.
+  /// If the image has more voxels then the percentiles are computed from a deterministic,
+  /// evenly strided sample of the voxels, which makes the computation time independent of
+  /// the image size. The stride is chosen to be relatively prime to the row and slice size,
+  /// so that samples are spread over all rows and columns. There is no guarantee on the error
+  /// of the percentile rank: it is small for typical images, but it may be large for images
+  /// with a repeating pattern that is aligned with the sampling stride.
+  /// 0 means that all voxels are used (this is the default).
+  vtkGetMacro(AutoLevelsMaximumNumberOfSamples, vtkIdType);
+  vtkSetMacro(AutoLevelsMaximumNumberOfSamples, vtkIdType);
+
+  ///
+  /// Remove all automatic window/level results from the cache.
+  /// Results are cached for the most recently used images, so that
+  /// images that are shown again (such as sequence items during replay)
+  /// do not have to be processed again.
+  static void ClearAutoLevelsCache();
+
   ///
   /// The window value to use when autoWindowLevel is 'no'
   double GetWindow();
@@ -225,6 +244,7 @@ protected:
   int AutoWindowLevel;
   int ApplyThreshold;
   int AutoThreshold;
+  vtkIdType AutoLevelsMaximumNumberOfSamples;
 
   vtkImageLogic *AlphaLogic;
   vtkImageMapToColors *MapToColors;
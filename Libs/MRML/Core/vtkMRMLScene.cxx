@@ -14,6 +14,7 @@ Version:   $Revision: 1.18 $
 
 #include "vtkMRMLScene.h"
 #include "vtkMRMLParser.h"
+#include "vtkMRMLPerformanceTracer.h"
 
 #include "vtkArchive.h"
 #include "vtkCacheManager.h"
@@ -76,6 +77,7 @@ Version:   $Revision: 1.18 $
 #include "vtkMRMLVectorVolumeDisplayNode.h"
 #include "vtkMRMLViewNode.h"
 #include "vtkMRMLVolumeArchetypeStorageNode.h"
+#include "vtkMRMLVolumeNode.h"
 #include "vtkMRMLVolumeSequenceStorageNode.h"
 #include "vtkURIHandler.h"
 
@@ -93,8 +95,10 @@ Version:   $Revision: 1.18 $
 #include <vtkCollection.h>
 #include <vtkDebugLeaks.h>
 #include <vtkErrorCode.h>
+#include <vtkImageData.h>
 #include <vtkObjectFactory.h>
 #include <vtkPNGWriter.h>
+#include <vtkPointSet.h>
 #include <vtkSmartPointer.h>
 
 // VTKSYS includes
@@ -104,6 +108,7 @@ Version:   $Revision: 1.18 $
 
 // STD includes
 #include <algorithm>
+#include <iterator>
 #include <numeric>
 
 //#define MRMLSCENE_VERBOSE
@@ -124,12 +129,17 @@ vtkMRMLScene::vtkMRMLScene()
 
   this->NodeIDsMTime = 0;
 
+  this->NodeClassIndexNextPosition = 0;
+  this->NodeClassIndexValid = false;
+  this->NodeClassIndexMTime = 0;
+
   this->RegisteredNodeClasses.clear();
   this->UniqueIDs.clear();
   this->UniqueNames.clear();
 
   this->Nodes =  vtkCollection::New();
   this->MaximumNumberOfSavedUndoStates = 20;
+  this->MaximumUndoMemorySize = 0;
   this->UndoFlag = false;
 
   this->NodeReferences.clear();
@@ -160,6 +170,10 @@ vtkMRMLScene::vtkMRMLScene()
   // is caught by other observers.
   this->AddObserver(vtkCommand::DeleteEvent, this->DeleteEventCallback, 1000.);
 
+  this->UndoNodeModifiedCallbackCommand = vtkCallbackCommand::New();
+  this->UndoNodeModifiedCallbackCommand->SetClientData( reinterpret_cast<void *>(this) );
+  this->UndoNodeModifiedCallbackCommand->SetCallback( vtkMRMLScene::UndoNodeModifiedCallback );
+
   //
   // Register all the 'built-in' nodes for the library
   // SmartPointer is used to create an instance of the class, and destroy immediately after registration is complete.
@@ -253,6 +267,13 @@ vtkMRMLScene::~vtkMRMLScene()
     if (this->Nodes->GetNumberOfItems() > 0)
       {
       vtkDebugMacro("CurrentScene should have already been cleared in DeleteEvent callback: ");
+      vtkMRMLNode *node = nullptr;
+      vtkCollectionSimpleIterator it;
+      for (this->Nodes->InitTraversal(it);
+        (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it));)
+        {
+        this->RemoveUndoNodeObserver(node);
+        }
       this->Nodes->RemoveAllItems ( );
       }
     this->Nodes->Delete();
@@ -292,6 +313,11 @@ vtkMRMLScene::~vtkMRMLScene()
     this->DeleteEventCallback->Delete();
     this->DeleteEventCallback = nullptr;
     }
+  if ( this->UndoNodeModifiedCallbackCommand != nullptr )
+    {
+    this->UndoNodeModifiedCallbackCommand->Delete();
+    this->UndoNodeModifiedCallbackCommand = nullptr;
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -311,6 +337,19 @@ void vtkMRMLScene::SceneCallback( vtkObject *vtkNotUsed(caller),
   self->Clear(1);
 }
 
+//------------------------------------------------------------------------------
+void vtkMRMLScene::UndoNodeModifiedCallback( vtkObject *caller,
+                                             unsigned long vtkNotUsed(eid),
+                                             void *clientData, void *vtkNotUsed(callData) )
+{
+  vtkMRMLScene *self = reinterpret_cast<vtkMRMLScene *>(clientData);
+  if (self == nullptr)
+    {
+    return;
+    }
+  self->SetUndoNodeModified(vtkMRMLNode::SafeDownCast(caller));
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::Clear(int removeSingletons)
 {
@@ -728,6 +767,7 @@ void vtkMRMLScene::ProgressState(unsigned long state, int progress)
 //------------------------------------------------------------------------------
 int vtkMRMLScene::Connect()
 {
+  MRML_TRACE_SCOPE("Scene", "Connect");
   if (this->IsClosing())
     {
     vtkWarningMacro("vtkMRMLScene::Connect(): scene is in closing state");
@@ -759,6 +799,7 @@ int vtkMRMLScene::Connect()
 //------------------------------------------------------------------------------
 int vtkMRMLScene::Import()
 {
+  MRML_TRACE_SCOPE("Scene", "Import");
 #ifdef MRMLSCENE_VERBOSE
   vtkTimerLog* addNodesTimer = vtkTimerLog::New();
   vtkTimerLog* updateSceneTimer = vtkTimerLog::New();
@@ -928,6 +969,7 @@ int vtkMRMLScene::LoadIntoScene(vtkCollection* nodeCollection)
         // put it on disk somewhere
         const char *localURL = this->GetCacheManager()->GetFilenameFromURI(this->URL.c_str());
         handler->StageFileRead(this->URL.c_str(), localURL);
+        this->GetCacheManager()->UpdateCacheIndex(localURL);
         // now over ride the URL setting
         vtkDebugMacro("LoadIntoScene: downloaded the remote MRML file " << this->URL.c_str() << ", resetting URL to local file " << localURL);
         this->SetURL(localURL);
@@ -1223,6 +1265,8 @@ vtkMRMLNode* vtkMRMLScene::AddNodeNoNotify(vtkMRMLNode *n)
 
   // cache the node so the whole scene cache stays up-to date
   this->AddNodeID(n);
+  this->AddNodeToClassIndex(n);
+  this->AddUndoNodeObserver(n);
 
   // Keep the SH up-to-date
   if (vtkMRMLSubjectHierarchyNode::SafeDownCast(n) != nullptr &&
@@ -1440,6 +1484,8 @@ void vtkMRMLScene::RemoveNode(vtkMRMLNode *n)
 
   std::string nid = (n->GetID() ? n->GetID() : "");
   this->RemoveNodeID(n->GetID());
+  this->RemoveNodeFromClassIndex(n);
+  this->RemoveUndoNodeObserver(n);
 
   this->InvokeEvent(vtkMRMLScene::NodeRemovedEvent, n);
 
@@ -1617,18 +1663,7 @@ int vtkMRMLScene::GetNumberOfNodesByClass(const char *className)
     vtkErrorMacro("GetNumberOfNodesByClass: class name is null.");
     return 0;
     }
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      num++;
-      }
-    }
-  return num;
+  return static_cast<int>(this->GetClassIndexedNodes(className).size());
 }
 
 //------------------------------------------------------------------------------
@@ -1640,15 +1675,12 @@ int vtkMRMLScene::GetNodesByClass(const char *className, std::vector<vtkMRMLNode
     vtkErrorMacro("GetNodesByClass: class name is null.");
     return 0;
     }
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::map<vtkIdType, vtkMRMLNode*>& classNodes = this->GetClassIndexedNodes(className);
+  nodes.reserve(classNodes.size());
+  for (std::map<vtkIdType, vtkMRMLNode*>::const_iterator nodeIt = classNodes.begin();
+    nodeIt != classNodes.end(); ++nodeIt)
     {
-    if (node->IsA(className))
-      {
-      nodes.push_back(node);
-      }
+    nodes.push_back(nodeIt->second);
     }
   return static_cast<int>(nodes.size());
 }
@@ -1662,15 +1694,11 @@ vtkCollection* vtkMRMLScene::GetNodesByClass(const char *className)
     return nullptr;
     }
   vtkCollection* nodes = vtkCollection::New();
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::map<vtkIdType, vtkMRMLNode*>& classNodes = this->GetClassIndexedNodes(className);
+  for (std::map<vtkIdType, vtkMRMLNode*>::const_iterator nodeIt = classNodes.begin();
+    nodeIt != classNodes.end(); ++nodeIt)
     {
-    if (node->IsA(className))
-      {
-      nodes->AddItem(node);
-      }
+    nodes->AddItem(nodeIt->second);
     }
   return nodes;
 }
@@ -1731,13 +1759,12 @@ vtkMRMLNode* vtkMRMLScene::GetSingletonNode(const char* singletonTag, const char
     return nullptr;
     }
 
-  vtkCollectionSimpleIterator it;
-  vtkMRMLNode* node = nullptr;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::map<vtkIdType, vtkMRMLNode*>& classNodes = this->GetClassIndexedNodes(className);
+  for (std::map<vtkIdType, vtkMRMLNode*>::const_iterator nodeIt = classNodes.begin();
+    nodeIt != classNodes.end(); ++nodeIt)
     {
-    if (node->IsA(className) &&
-        node->GetSingletonTag() != nullptr &&
+    vtkMRMLNode* node = nodeIt->second;
+    if (node->GetSingletonTag() != nullptr &&
         strcmp(node->GetSingletonTag(), singletonTag) == 0)
       {
       return node;
@@ -1807,22 +1834,23 @@ vtkMRMLNode* vtkMRMLScene::GetNthNodeByClass(int n, const char *className)
     return nullptr;
     }
 
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::map<vtkIdType, vtkMRMLNode*>& classNodes = this->GetClassIndexedNodes(className);
+  if (n >= static_cast<int>(classNodes.size()))
+    {
+    return nullptr;
+    }
+  std::map< std::string, std::vector<vtkMRMLNode*> >::iterator classVectorIt = this->NodesByClassVectors.find(className);
+  if (classVectorIt == this->NodesByClassVectors.end())
     {
-    if (node->IsA(className))
+    std::vector<vtkMRMLNode*>& classNodesVector = this->NodesByClassVectors[className];
+    classNodesVector.reserve(classNodes.size());
+    for (std::map<vtkIdType, vtkMRMLNode*>::const_iterator nodeIt = classNodes.begin(); nodeIt != classNodes.end(); ++nodeIt)
       {
-      if (num == n)
-        {
-        return node;
-        }
-      num++;
+      classNodesVector.push_back(nodeIt->second);
       }
+    return classNodesVector[n];
     }
-  return nullptr;
+  return classVectorIt->second[n];
 }
 
 //------------------------------------------------------------------------------
@@ -1969,11 +1997,12 @@ vtkCollection* vtkMRMLScene::GetNodesByClassByName(const char* className, const
     return nodes;
     }
 
-  vtkMRMLNode *node;
-  for (int n=0; n < this->Nodes->GetNumberOfItems(); n++)
+  const std::map<vtkIdType, vtkMRMLNode*>& classNodes = this->GetClassIndexedNodes(className);
+  for (std::map<vtkIdType, vtkMRMLNode*>::const_iterator nodeIt = classNodes.begin();
+    nodeIt != classNodes.end(); ++nodeIt)
     {
-    node = (vtkMRMLNode*)this->Nodes->GetItemAsObject(n);
-    if (node->GetName() != nullptr && !strcmp(node->GetName(), name) && node->IsA(className))
+    vtkMRMLNode* node = nodeIt->second;
+    if (node->GetName() != nullptr && !strcmp(node->GetName(), name))
       {
       nodes->AddItem(node);
       }
@@ -2068,6 +2097,9 @@ vtkMRMLNode* vtkMRMLScene::InsertAfterNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-to-date
   this->AddNodeID(n);
+  // node was not appended, positions in the class index are not valid anymore
+  this->ClearNodeClassIndex();
+  this->AddUndoNodeObserver(n);
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -2166,6 +2198,9 @@ vtkMRMLNode* vtkMRMLScene::InsertBeforeNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  // node was not appended, positions in the class index are not valid anymore
+  this->ClearNodeClassIndex();
+  this->AddUndoNodeObserver(n);
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -2359,35 +2394,51 @@ void vtkMRMLScene::GetNodeReferenceIDsFromUndoStack(std::set<std::string>& refer
 {
   referenceIDs.clear();
 
-  std::list<vtkCollection*>::const_iterator undoStackIt;
+  if (this->UndoStack.empty())
+    {
+    return;
+    }
+
+  // Collect all node states: the last saved state and the changes stored in the undo levels
+  std::vector<vtkMRMLNode*> nodeStates;
+  for (std::map< std::string, UndoReferenceState >::const_iterator referenceIt = this->UndoReferenceStates.begin();
+    referenceIt != this->UndoReferenceStates.end(); ++referenceIt)
+    {
+    nodeStates.push_back(referenceIt->second.NodeState.State);
+    }
+  std::list<UndoLevelType>::const_iterator undoStackIt;
   for (undoStackIt = this->UndoStack.begin(); undoStackIt != this->UndoStack.end(); ++undoStackIt)
     {
-    vtkCollection* nodes = *undoStackIt;
-    for (int i = 0; i < nodes->GetNumberOfItems(); ++i)
+    for (UndoLevelType::const_iterator stateIt = undoStackIt->begin(); stateIt != undoStackIt->end(); ++stateIt)
       {
-      vtkMRMLNode* node = vtkMRMLNode::SafeDownCast(nodes->GetItemAsObject(i));
-      if (!node)
-        {
-        continue;
-        }
+      nodeStates.push_back(stateIt->second.State);
+      }
+    }
+
+  for (std::vector<vtkMRMLNode*>::iterator nodeIt = nodeStates.begin(); nodeIt != nodeStates.end(); ++nodeIt)
+    {
+    vtkMRMLNode* node = *nodeIt;
+    if (!node)
+      {
+      continue;
+      }
 
-      std::vector<std::string> roles;
-      node->GetNodeReferenceRoles(roles);
-      std::vector<std::string>::iterator roleIt;
-      for (roleIt = roles.begin(); roleIt != roles.end(); ++roleIt)
+    std::vector<std::string> roles;
+    node->GetNodeReferenceRoles(roles);
+    std::vector<std::string>::iterator roleIt;
+    for (roleIt = roles.begin(); roleIt != roles.end(); ++roleIt)
+      {
+      std::string role = *roleIt;
+      std::vector<const char*> currentReferenceIDs;
+      node->GetNodeReferenceIDs(role.c_str(), currentReferenceIDs);
+      std::vector<const char*>::iterator referenceIDIt;
+      for (referenceIDIt = currentReferenceIDs.begin(); referenceIDIt != currentReferenceIDs.end(); ++referenceIDIt)
         {
-        std::string role = *roleIt;
-        std::vector<const char*> currentReferenceIDs;
-        node->GetNodeReferenceIDs(role.c_str(), currentReferenceIDs);
-        std::vector<const char*>::iterator referenceIDIt;
-        for (referenceIDIt = currentReferenceIDs.begin(); referenceIDIt != currentReferenceIDs.end(); ++referenceIDIt)
+        if (!(*referenceIDIt))
           {
-          if (!(*referenceIDIt))
-            {
-            continue;
-            }
-          referenceIDs.insert(*referenceIDIt);
+          continue;
           }
+        referenceIDs.insert(*referenceIDIt);
         }
       }
     }
@@ -2498,9 +2549,35 @@ void vtkMRMLScene::RemoveReservedIDs()
 }
 
 //------------------------------------------------------------------------------
-// Pushes the current scene onto the undo stack, and makes a backup copy of the
-// passed node so that changes to the node are undoable; several signatures to handle
-// individual nodes or a vtkCollection of nodes, or a vector of nodes
+namespace
+{
+vtkTypeInt64 EstimateUndoNodeStateMemorySize(vtkMRMLNode* node)
+{
+  // Approximate size of node properties, attributes, and references
+  vtkTypeInt64 memorySize = 1024;
+  vtkDataObject* bulkData = nullptr;
+  if (vtkMRMLModelNode::SafeDownCast(node))
+    {
+    bulkData = vtkMRMLModelNode::SafeDownCast(node)->GetMesh();
+    }
+  else if (vtkMRMLVolumeNode::SafeDownCast(node))
+    {
+    bulkData = vtkMRMLVolumeNode::SafeDownCast(node)->GetImageData();
+    }
+  if (bulkData)
+    {
+    // GetActualMemorySize returns size in kibibytes
+    memorySize += static_cast<vtkTypeInt64>(bulkData->GetActualMemorySize()) * 1024;
+    }
+  return memorySize;
+}
+}
+
+//------------------------------------------------------------------------------
+// Pushes the current scene state onto the undo stack. Only states of nodes
+// that have been changed since the last saved state are copied.
+// Several signatures are kept for backward compatibility, all of them save
+// the state of all undo-enabled nodes.
 //
 void vtkMRMLScene::SaveStateForUndo (vtkMRMLNode *node)
 {
@@ -2525,16 +2602,11 @@ void vtkMRMLScene::SaveStateForUndo (vtkMRMLNode *node)
     }
 
   this->ClearRedoStack();
-  //this->SetUndoOn();
   this->PushIntoUndoStack();
-  if (node)
-    {
-    this->CopyNodeInUndoStack(node);
-    }
 }
 
 //------------------------------------------------------------------------------
-void vtkMRMLScene::SaveStateForUndo (std::vector<vtkMRMLNode *> nodes)
+void vtkMRMLScene::SaveStateForUndo (std::vector<vtkMRMLNode *> vtkNotUsed(nodes))
 {
   if (!this->UndoFlag)
     {
@@ -2551,17 +2623,7 @@ void vtkMRMLScene::SaveStateForUndo (std::vector<vtkMRMLNode *> nodes)
     }
 
   this->ClearRedoStack();
-  //this->SetUndoOn();
   this->PushIntoUndoStack();
-  unsigned int n;
-  for (n=0; n<nodes.size(); n++)
-    {
-    vtkMRMLNode *node = nodes[n];
-    if (node && node->GetUndoEnabled())
-      {
-      this->CopyNodeInUndoStack(node);
-      }
-    }
 }
 
 //------------------------------------------------------------------------------
@@ -2588,19 +2650,7 @@ void vtkMRMLScene::SaveStateForUndo (vtkCollection* nodes)
     }
 
   this->ClearRedoStack();
-  //this->SetUndoOn();
   this->PushIntoUndoStack();
-
-  int nnodes = nodes->GetNumberOfItems();
-
-  for (int n=0; n<nnodes; n++)
-    {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(nodes->GetItemAsObject(n));
-    if (node && node->GetUndoEnabled())
-      {
-      this->CopyNodeInUndoStack(node);
-      }
-    }
 }
 
 //------------------------------------------------------------------------------
@@ -2622,368 +2672,410 @@ void vtkMRMLScene::SaveStateForUndo ()
 }
 
 //------------------------------------------------------------------------------
-// Make a new collection that has pointers to all the nodes in the current scene
-void vtkMRMLScene::PushIntoUndoStack()
+void vtkMRMLScene::SetUndoFlag(bool flag)
 {
+  if (flag == this->UndoFlag)
+    {
+    return;
+    }
   if (this->Nodes == nullptr)
     {
+    this->UndoFlag = flag;
     return;
     }
-
-  vtkCollection* newScene = vtkCollection::New();
-
-  vtkCollection* currentScene = this->Nodes;
-
-  int nnodes = currentScene->GetNumberOfItems();
-
-  for (int n=0; n<nnodes; n++)
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  if (!flag)
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(currentScene->GetItemAsObject(n));
-    if (node && node->GetUndoEnabled())
+    for (this->Nodes->InitTraversal(it);
+         (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
       {
-      newScene->AddItem(node);
+      this->RemoveUndoNodeObserver(node);
+      }
+    this->UndoFlag = false;
+    return;
+    }
+  this->UndoFlag = true;
+  // Nodes may have been added, removed, or modified while undo was off,
+  // so all of them have to be compared to the last saved state.
+  for (this->Nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+    {
+    this->AddUndoNodeObserver(node);
+    }
+  if (!this->UndoStack.empty())
+    {
+    for (std::map< std::string, UndoReferenceState >::iterator referenceIt = this->UndoReferenceStates.begin();
+      referenceIt != this->UndoReferenceStates.end(); ++referenceIt)
+      {
+      this->UndoModifiedNodeIDs.insert(referenceIt->first);
       }
     }
-
-  this->UndoStack.push_back(newScene);
-  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
-// Make a new collection that has pointers to the current scene nodes
-void vtkMRMLScene::PushIntoRedoStack()
+void vtkMRMLScene::AddUndoNodeObserver(vtkMRMLNode* node)
 {
-  if (this->Nodes == nullptr)
+  if (!node || !this->UndoFlag)
     {
     return;
     }
+  if (!node->HasObserver(vtkCommand::ModifiedEvent, this->UndoNodeModifiedCallbackCommand))
+    {
+    node->AddObserver(vtkCommand::ModifiedEvent, this->UndoNodeModifiedCallbackCommand);
+    }
+  this->SetUndoNodeModified(node);
+}
 
-  vtkCollection* newScene = vtkCollection::New();
-
-  vtkCollection* currentScene = this->Nodes;
-
-  int nnodes = currentScene->GetNumberOfItems();
-
-  for (int n=0; n<nnodes; n++)
+//------------------------------------------------------------------------------
+void vtkMRMLScene::RemoveUndoNodeObserver(vtkMRMLNode* node)
+{
+  if (!node || !this->UndoFlag)
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(currentScene->GetItemAsObject(n));
-    if (node && node->GetUndoEnabled())
-      {
-      newScene->AddItem(node);
-      }
+    return;
     }
+  node->RemoveObserver(this->UndoNodeModifiedCallbackCommand);
+  this->SetUndoNodeModified(node);
+}
 
-  this->RedoStack.push_back(newScene);
+//------------------------------------------------------------------------------
+void vtkMRMLScene::SetUndoNodeModified(vtkMRMLNode* node)
+{
+  // Modifications only need to be recorded if there is a saved state to compare to.
+  // If the undo stack is empty then all nodes are checked when the next state is saved.
+  if (!node || !node->GetID() || this->UndoStack.empty())
+    {
+    return;
+    }
+  this->UndoModifiedNodeIDs.insert(node->GetID());
 }
 
 //------------------------------------------------------------------------------
-// Put a replacement node into the undoable copy of the scene so that the node
-// can be edited
-void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
+void vtkMRMLScene::GetModifiedNodeIDsSinceLastUndoState(std::set<std::string>& nodeIDs)
 {
-  if (!copyNode)
+  nodeIDs.clear();
+  if (this->Nodes == nullptr)
     {
-    vtkErrorMacro("CopyNodeInUndoStack: node is null");
     return;
     }
 
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != nullptr)
+  std::set<std::string> candidateNodeIDs;
+  if (this->UndoStack.empty())
     {
-    snode->CopyWithScene(copyNode);
+    // Modifications are not recorded while the undo stack is empty,
+    // all nodes have to be checked.
+    vtkMRMLNode *node;
+    vtkCollectionSimpleIterator it;
+    for (this->Nodes->InitTraversal(it);
+         (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+      {
+      if (node->GetID())
+        {
+        candidateNodeIDs.insert(node->GetID());
+        }
+      }
+    for (std::map< std::string, UndoReferenceState >::iterator referenceIt = this->UndoReferenceStates.begin();
+      referenceIt != this->UndoReferenceStates.end(); ++referenceIt)
+      {
+      candidateNodeIDs.insert(referenceIt->first);
+      }
+    }
+  else
+    {
+    // Only nodes that have been added, removed, or modified may differ from the last saved state
+    candidateNodeIDs = this->UndoModifiedNodeIDs;
     }
 
-  vtkCollection* undoScene = this->UndoStack.back();
-  int nnodes = undoScene->GetNumberOfItems();
-  for (int n=0; n<nnodes; n++)
+  for (std::set<std::string>::iterator idIt = candidateNodeIDs.begin(); idIt != candidateNodeIDs.end(); ++idIt)
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(undoScene->GetItemAsObject(n));
-    if (node == copyNode)
+    vtkMRMLNode* node = this->GetNodeByID(*idIt);
+    std::map< std::string, UndoReferenceState >::iterator referenceIt = this->UndoReferenceStates.find(*idIt);
+    if (!node || !node->GetUndoEnabled())
       {
-      undoScene->ReplaceItem (n, snode);
-      break;
+      // Removed node
+      if (referenceIt != this->UndoReferenceStates.end())
+        {
+        nodeIDs.insert(*idIt);
+        }
+      continue;
+      }
+    // Added or modified node
+    if (referenceIt == this->UndoReferenceStates.end()
+      || referenceIt->second.Node.GetPointer() != node
+      || node->GetMTime() > referenceIt->second.NodeMTime)
+      {
+      nodeIDs.insert(*idIt);
       }
     }
-  snode->Delete();
 }
 
 //------------------------------------------------------------------------------
-// Put a replacement node into the redoable copy of the scene so that the node
-// can be replaced by the Undo version
-void vtkMRMLScene::CopyNodeInRedoStack(vtkMRMLNode *copyNode)
+vtkMRMLScene::UndoNodeState vtkMRMLScene::CreateUndoNodeState(vtkMRMLNode* node)
 {
-  if (!copyNode)
-    {
-    vtkErrorMacro("CopyNodeInRedoStack: node is null");
-    return;
-    }
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != nullptr)
+  UndoNodeState nodeState;
+  if (!node)
     {
-    snode->CopyWithScene(copyNode);
+    return nodeState;
     }
-  vtkCollection* undoScene = this->RedoStack.back();
-  int nnodes = undoScene->GetNumberOfItems();
-  for (int n=0; n<nnodes; n++)
+  nodeState.State = vtkSmartPointer<vtkMRMLNode>::Take(node->CreateNodeInstance());
+  if (nodeState.State != nullptr)
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(undoScene->GetItemAsObject(n));
-    if (node == copyNode)
-      {
-      undoScene->ReplaceItem (n, snode);
-      break;
-      }
+    nodeState.State->CopyWithScene(node);
+    nodeState.MemorySize = EstimateUndoNodeStateMemorySize(nodeState.State);
     }
-  snode->Delete();
+  return nodeState;
 }
 
 //------------------------------------------------------------------------------
-// Replace the current scene by the top of the undo stack
-// -- move the current scene on the redo stack
-void vtkMRMLScene::Undo()
+// Store the state of nodes that changed since the last saved state
+void vtkMRMLScene::PushIntoUndoStack()
 {
-  if (!this->UndoFlag)
+  if (this->Nodes == nullptr)
     {
     return;
     }
 
-  if (this->UndoStack.size() == 0)
+  if (this->MaximumNumberOfSavedUndoStates <= 0)
     {
+    this->ClearUndoStack();
     return;
     }
 
-  this->StartState(vtkMRMLScene::UndoState);
-  this->RemoveUnusedNodeReferences();
-
-  int nnodes;
-  int n;
-  unsigned int nn;
+  std::set<std::string> modifiedNodeIDs;
+  this->GetModifiedNodeIDsSinceLastUndoState(modifiedNodeIDs);
+  this->UndoModifiedNodeIDs.clear();
 
-  this->PushIntoRedoStack();
+  // The first saved state does not have a previous state to go back to,
+  // so node states only need to be stored as reference.
+  bool firstState = this->UndoStack.empty();
 
-  vtkCollection* currentScene = this->Nodes;
-  // We use 2 vectors instead of a map in order to keep the ordering of the
-  // nodes.
-  std::vector<std::string> currentIDs;
-  std::vector<vtkMRMLNode*> currentNodes;
-  nnodes = currentScene->GetNumberOfItems();
-  for (n=0; n<nnodes; n++)
+  UndoLevelType undoLevel;
+  for (std::set<std::string>::iterator idIt = modifiedNodeIDs.begin(); idIt != modifiedNodeIDs.end(); ++idIt)
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(currentScene->GetItemAsObject(n));
+    UndoReferenceState& referenceState = this->UndoReferenceStates[*idIt];
+    vtkMRMLNode* node = this->GetNodeByID(*idIt);
+    if (!firstState)
+      {
+      // Move the previous state to the undo level, so that undo can restore it
+      undoLevel[*idIt] = referenceState.NodeState;
+      if (referenceState.Node && node != referenceState.Node)
+        {
+        // Keep the removed node object, undo adds it back to the scene
+        undoLevel[*idIt].Node = referenceState.Node;
+        }
+      }
     if (node && node->GetUndoEnabled())
       {
-      currentIDs.emplace_back(node->GetID());
-      currentNodes.push_back(node);
+      referenceState.NodeState = this->CreateUndoNodeState(node);
+      referenceState.Node = node;
+      referenceState.NodeMTime = node->GetMTime();
       }
-    }
-
-  vtkCollection* undoScene = nullptr;
-  std::vector<std::string> undoIDs;
-  std::vector<vtkMRMLNode*> undoNodes;
-
-  if (!this->UndoStack.empty())
-    {
-    undoScene = this->UndoStack.back();
-    nnodes = undoScene->GetNumberOfItems();
-    for (n=0; n<nnodes; n++)
+    else
       {
-      vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(undoScene->GetItemAsObject(n));
-      if (node && node->GetUndoEnabled())
-        {
-        undoIDs.emplace_back(node->GetID());
-        undoNodes.push_back(node);
-        }
+      this->UndoReferenceStates.erase(*idIt);
       }
     }
 
-  std::vector<std::string>::iterator iterID;
-  std::vector<vtkMRMLNode*>::iterator iterNode;
-  std::vector<std::string>::iterator curIterID;
-  std::vector<vtkMRMLNode*>::iterator curIterNode;
-
-  // copy back changes and add deleted nodes to the current scene
-  std::vector<vtkMRMLNode*> addNodes;
+  this->UndoStack.push_back(undoLevel);
+  this->TrimUndoStack();
+}
 
-  for(iterID=undoIDs.begin(), iterNode = undoNodes.begin(); iterID != undoIDs.end(); iterID++, iterNode++)
+//------------------------------------------------------------------------------
+// Store the current state of the nodes that undo is about to change
+void vtkMRMLScene::PushIntoRedoStack(const std::set<std::string>& nodeIDs)
+{
+  UndoLevelType redoLevel;
+  for (std::set<std::string>::const_iterator idIt = nodeIDs.begin(); idIt != nodeIDs.end(); ++idIt)
     {
-    curIterID = std::find(currentIDs.begin(), currentIDs.end(), *iterID);
-    curIterNode = currentNodes.begin() + std::distance(currentIDs.begin(), curIterID);
-    if ( curIterID == currentIDs.end() )
+    vtkMRMLNode* node = this->GetNodeByID(*idIt);
+    if (node && node->GetUndoEnabled())
       {
-      // the node was deleted, add Node back to the current scene
-      addNodes.push_back(*iterNode);
+      redoLevel[*idIt] = this->CreateUndoNodeState(node);
+      // Keep the node object in case undo removes it, redo adds it back to the scene
+      redoLevel[*idIt].Node = node;
       }
-    else if (*iterNode != *curIterNode)
+    else
       {
-      // nodes differ, copy from undo to current scene
-      // but before create a copy in redo stack from current
-      this->CopyNodeInRedoStack(*curIterNode);
-      (*curIterNode)->CopyWithScene(*iterNode);
+      // node was not in the scene
+      redoLevel[*idIt] = UndoNodeState();
       }
     }
+  this->RedoStack.push_back(redoLevel);
+}
 
-  // remove new nodes created before Undo
-  std::vector<vtkMRMLNode*> removeNodes;
-  for(curIterID=currentIDs.begin(), curIterNode = currentNodes.begin(); curIterID != currentIDs.end(); curIterID++, curIterNode++)
+//------------------------------------------------------------------------------
+void vtkMRMLScene::RestoreUndoNodeStates(const UndoLevelType& nodeStates, bool updateReferenceStates)
+{
+  // Nodes are added and updated first and only then removed, because
+  // removal of a node may have side effects on other nodes.
+  std::vector< vtkWeakPointer<vtkMRMLNode> > removeNodes;
+  for (UndoLevelType::const_iterator stateIt = nodeStates.begin(); stateIt != nodeStates.end(); ++stateIt)
     {
-    iterID = std::find(undoIDs.begin(),undoIDs.end(), *curIterID);
-    // Remove only if the node is not present in the previous state.
-    if ( iterID == undoIDs.end() )
+    vtkMRMLNode* node = this->GetNodeByID(stateIt->first);
+    if (node && !node->GetUndoEnabled())
       {
-      removeNodes.push_back(*curIterNode);
+      // node is not managed by undo
+      continue;
+      }
+    vtkMRMLNode* state = stateIt->second.State;
+    if (!state)
+      {
+      // the node was not present in the restored state
+      if (node)
+        {
+        removeNodes.emplace_back(node);
+        }
+      continue;
+      }
+    vtkMRMLNode* originalNode = stateIt->second.Node;
+    if (node && (strcmp(node->GetClassName(), state->GetClassName()) != 0
+      || (originalNode && originalNode != node && !originalNode->GetScene())))
+      {
+      // A different node has the same ID, it has to be replaced
+      this->RemoveNode(node);
+      node = nullptr;
+      }
+    if (node)
+      {
+      node->CopyWithScene(state);
+      }
+    else
+      {
+      // The node was removed, add it back to the current scene.
+      // The same node object is added back (if it is not in a scene already)
+      // so that observers and references to the node remain valid.
+      vtkSmartPointer<vtkMRMLNode> restoredNode = originalNode;
+      if (!restoredNode || restoredNode->GetScene())
+        {
+        restoredNode = vtkSmartPointer<vtkMRMLNode>::Take(state->CreateNodeInstance());
+        }
+      restoredNode->CopyWithScene(state);
+      this->AddNode(restoredNode);
+      restoredNode->SetSceneReferences();
+      node = restoredNode;
+      }
+    if (updateReferenceStates)
+      {
+      UndoReferenceState& referenceState = this->UndoReferenceStates[stateIt->first];
+      referenceState.Node = node;
+      referenceState.NodeMTime = node->GetMTime();
       }
     }
 
-  for (nn=0; nn<addNodes.size(); nn++)
-    {
-    this->AddNode(addNodes[nn]);
-    addNodes[nn]->SetSceneReferences();
-    }
-  for (nn=0; nn<removeNodes.size(); nn++)
+  for (std::vector< vtkWeakPointer<vtkMRMLNode> >::iterator nodeIt = removeNodes.begin(); nodeIt != removeNodes.end(); ++nodeIt)
     {
-    vtkMRMLNode* nodeToRemove = removeNodes[nn];
+    vtkMRMLNode* nodeToRemove = *nodeIt;
     // Maybe the node has been removed already by a side effect of a previous
-    // node removal.
-    if (this->IsNodePresent(nodeToRemove))
+    // node removal. Node ID lookup is used instead of IsNodePresent to avoid
+    // iterating through all the nodes in the scene.
+    if (nodeToRemove && nodeToRemove->GetID() && this->GetNodeByID(nodeToRemove->GetID()) == nodeToRemove)
       {
       this->RemoveNode(nodeToRemove);
       }
     }
-
-  if (undoScene)
-    {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
-    }
-
-  if (!this->UndoStack.empty())
-   {
-   this->UndoStack.pop_back();
-   }
-  this->Modified();
-
-  this->EndState(vtkMRMLScene::UndoState);
-
-  // Some untracked nodes may need to be restored to the scene after undo has completed
-  // Do not remove unused node references until these nodes have been added
-  this->RemoveUnusedNodeReferences();
 }
 
 //------------------------------------------------------------------------------
-void vtkMRMLScene::Redo()
+// Restore the last saved state and make the previous saved state the reference
+// -- save the current state of the changed nodes on the redo stack
+void vtkMRMLScene::Undo()
 {
   if (!this->UndoFlag)
     {
     return;
     }
 
-  if (this->RedoStack.size() == 0)
+  if (this->UndoStack.size() == 0)
     {
     return;
     }
 
-  int nnodes;
-  int n;
-  unsigned int nn;
-
-  this->StartState(vtkMRMLScene::RedoState);
-
+  this->StartState(vtkMRMLScene::UndoState);
   this->RemoveUnusedNodeReferences();
 
-  this->PushIntoUndoStack();
-
-
-  vtkCollection* currentScene = this->Nodes;
-  //std::hash_map<std::string, vtkMRMLNode*> currentMap;
-  std::map<std::string, vtkWeakPointer<vtkMRMLNode> > currentMap;
-  nnodes = currentScene->GetNumberOfItems();
-  for (n=0; n<nnodes; n++)
-    {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(currentScene->GetItemAsObject(n));
-    if (node && node->GetUndoEnabled())
-      {
-      currentMap[node->GetID()] = node;
-      }
-    }
-
-  //std::hash_map<std::string, vtkMRMLNode*> undoMap;
-  std::map<std::string, vtkWeakPointer<vtkMRMLNode> > undoMap;
+  std::set<std::string> modifiedNodeIDs;
+  this->GetModifiedNodeIDsSinceLastUndoState(modifiedNodeIDs);
 
-  vtkCollection* undoScene = nullptr;
+  this->PushIntoRedoStack(modifiedNodeIDs);
 
-  if (!this->RedoStack.empty())
+  // Restore the last saved state of the changed nodes
+  UndoLevelType lastSavedStates;
+  for (std::set<std::string>::iterator idIt = modifiedNodeIDs.begin(); idIt != modifiedNodeIDs.end(); ++idIt)
     {
-    undoScene = this->RedoStack.back();
-    if (undoScene)
+    std::map< std::string, UndoReferenceState >::iterator referenceIt = this->UndoReferenceStates.find(*idIt);
+    if (referenceIt == this->UndoReferenceStates.end())
       {
-      nnodes = undoScene->GetNumberOfItems();
-      for (n=0; n<nnodes; n++)
-        {
-        vtkMRMLNode *node = vtkMRMLNode::SafeDownCast(undoScene->GetItemAsObject(n));
-        if (node && node->GetUndoEnabled())
-          {
-          undoMap[node->GetID()] = node;
-          }
-        }
+      lastSavedStates[*idIt] = UndoNodeState();
+      continue;
       }
+    lastSavedStates[*idIt] = referenceIt->second.NodeState;
+    lastSavedStates[*idIt].Node = referenceIt->second.Node;
     }
+  this->RestoreUndoNodeStates(lastSavedStates, true);
 
-  std::map<std::string, vtkWeakPointer<vtkMRMLNode> >::iterator iter;
-  std::map<std::string, vtkWeakPointer<vtkMRMLNode> >::iterator curIter;
-
-  // copy back changes and add deleted nodes to the current scene
-  std::vector<vtkWeakPointer<vtkMRMLNode> > addNodes;
-  for(iter=undoMap.begin(); iter != undoMap.end(); iter++)
+  // The previous saved state becomes the reference state
+  UndoLevelType& undoLevel = this->UndoStack.back();
+  for (UndoLevelType::iterator stateIt = undoLevel.begin(); stateIt != undoLevel.end(); ++stateIt)
     {
-    curIter = currentMap.find(iter->first);
-    if ( curIter == currentMap.end() )
-      {
-      // the node was deleted, add Node back to the current scene
-      addNodes.push_back(iter->second);
-      }
-    else if (!curIter->second || !iter->second)
+    if (!stateIt->second.State)
       {
+      this->UndoReferenceStates.erase(stateIt->first);
       continue;
       }
-    else if (iter->second != curIter->second)
+    UndoReferenceState& referenceState = this->UndoReferenceStates[stateIt->first];
+    referenceState.NodeState = stateIt->second;
+    if (stateIt->second.Node)
       {
-      // nodes differ, copy from redo to current scene
-      // but before create a copy in undo stack from current
-      this->CopyNodeInUndoStack(curIter->second);
-      curIter->second->CopyWithScene(iter->second);
+      referenceState.Node = stateIt->second.Node;
       }
+    referenceState.NodeState.Node = nullptr;
+    // the node in the scene is not in this state, so it must be reported as modified
+    referenceState.NodeMTime = 0;
     }
-
-  // remove new nodes created before Undo
-  std::vector<vtkWeakPointer<vtkMRMLNode> > removeNodes;
-  for(curIter=currentMap.begin(); curIter != currentMap.end(); curIter++)
+  // Nodes that differ from the new reference state
+  for (UndoLevelType::iterator stateIt = undoLevel.begin(); stateIt != undoLevel.end(); ++stateIt)
     {
-    if (!curIter->second)
-      {
-      continue;
-      }
-
-    iter = undoMap.find(curIter->first);
-    if ( iter == undoMap.end() )
-      {
-      this->CopyNodeInUndoStack(curIter->second);
-      removeNodes.push_back(curIter->second);
-      }
+    this->UndoModifiedNodeIDs.insert(stateIt->first);
     }
-
-  for (nn=0; nn<addNodes.size(); nn++)
+  this->UndoStack.pop_back();
+  if (this->UndoStack.empty())
     {
-    this->AddNode(addNodes[nn]);
+    // There is nothing to go back to, the saved states are not needed anymore
+    this->UndoReferenceStates.clear();
+    this->UndoModifiedNodeIDs.clear();
     }
-  for (nn=0; nn<removeNodes.size(); nn++)
+  this->Modified();
+
+  this->EndState(vtkMRMLScene::UndoState);
+
+  // Some untracked nodes may need to be restored to the scene after undo has completed
+  // Do not remove unused node references until these nodes have been added
+  this->RemoveUnusedNodeReferences();
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::Redo()
+{
+  if (!this->UndoFlag)
     {
-    this->RemoveNode(removeNodes[nn]);
+    return;
     }
 
-  if (undoScene)
+  if (this->RedoStack.size() == 0)
     {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
+    return;
     }
+
+  this->StartState(vtkMRMLScene::RedoState);
+
+  this->RemoveUnusedNodeReferences();
+
+  this->PushIntoUndoStack();
+
+  // Nodes changed by the redo will be detected as modified
+  // compared to the new reference state.
+  this->RestoreUndoNodeStates(this->RedoStack.back(), false);
+
   this->RedoStack.pop_back();
   this->Modified();
 
@@ -2993,25 +3085,53 @@ void vtkMRMLScene::Redo()
 //------------------------------------------------------------------------------
 void vtkMRMLScene::ClearUndoStack()
 {
-  std::list< vtkCollection* >::iterator iter;
-  for(iter=this->UndoStack.begin(); iter != this->UndoStack.end(); iter++)
-    {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
-    }
   this->UndoStack.clear();
+  this->UndoReferenceStates.clear();
+  this->UndoModifiedNodeIDs.clear();
 }
 
 //------------------------------------------------------------------------------
 void vtkMRMLScene::ClearRedoStack()
 {
-  std::list< vtkCollection* >::iterator iter;
-  for(iter=this->RedoStack.begin(); iter != this->RedoStack.end(); iter++)
+  this->RedoStack.clear();
+}
+
+//------------------------------------------------------------------------------
+vtkTypeInt64 vtkMRMLScene::GetUndoLevelMemorySize(const UndoLevelType& level) const
+{
+  vtkTypeInt64 memorySize = 0;
+  for (UndoLevelType::const_iterator stateIt = level.begin(); stateIt != level.end(); ++stateIt)
     {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
+    memorySize += stateIt->second.MemorySize;
     }
-  this->RedoStack.clear();
+  return memorySize;
+}
+
+//------------------------------------------------------------------------------
+vtkTypeInt64 vtkMRMLScene::GetUndoMemorySize()
+{
+  vtkTypeInt64 memorySize = 0;
+  for (std::map< std::string, UndoReferenceState >::iterator referenceIt = this->UndoReferenceStates.begin();
+    referenceIt != this->UndoReferenceStates.end(); ++referenceIt)
+    {
+    memorySize += referenceIt->second.NodeState.MemorySize;
+    }
+  for (std::list< UndoLevelType >::iterator levelIt = this->UndoStack.begin(); levelIt != this->UndoStack.end(); ++levelIt)
+    {
+    memorySize += this->GetUndoLevelMemorySize(*levelIt);
+    }
+  return memorySize;
+}
+
+//------------------------------------------------------------------------------
+vtkTypeInt64 vtkMRMLScene::GetRedoMemorySize()
+{
+  vtkTypeInt64 memorySize = 0;
+  for (std::list< UndoLevelType >::iterator levelIt = this->RedoStack.begin(); levelIt != this->RedoStack.end(); ++levelIt)
+    {
+    memorySize += this->GetUndoLevelMemorySize(*levelIt);
+    }
+  return memorySize;
 }
 
 //------------------------------------------------------------------------------
@@ -3339,6 +3459,119 @@ void vtkMRMLScene::ClearNodeIDs()
   }
 }
 
+//-----------------------------------------------------------------------------
+const std::map<vtkIdType, vtkMRMLNode*>& vtkMRMLScene::GetClassIndexedNodes(const char* className)
+{
+  if (!this->NodeClassIndexValid || this->Nodes->GetMTime() > this->NodeClassIndexMTime)
+    {
+    // The Nodes collection has been modified without AddNode/RemoveNode
+    // (or nodes were inserted in the middle), positions must be recomputed.
+    this->NodesByClass.clear();
+    this->NodesByClassVectors.clear();
+    this->NodeClassIndexPositions.clear();
+    this->NodeClassIndexNextPosition = 0;
+    vtkMRMLNode *node;
+    vtkCollectionSimpleIterator it;
+    for (this->Nodes->InitTraversal(it);
+         (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+      {
+      this->NodeClassIndexPositions[node] = this->NodeClassIndexNextPosition++;
+      }
+    this->NodeClassIndexValid = true;
+    this->NodeClassIndexMTime = this->Nodes->GetMTime();
+    }
+
+  std::map< std::string, std::map<vtkIdType, vtkMRMLNode*> >::iterator classIt =
+    this->NodesByClass.find(className);
+  if (classIt != this->NodesByClass.end())
+    {
+    return classIt->second;
+    }
+
+  // First query of this class, scan the scene once
+  std::map<vtkIdType, vtkMRMLNode*>& classNodes = this->NodesByClass[className];
+  for (std::map<vtkMRMLNode*, vtkIdType>::iterator positionIt = this->NodeClassIndexPositions.begin();
+    positionIt != this->NodeClassIndexPositions.end(); ++positionIt)
+    {
+    if (positionIt->first->IsA(className))
+      {
+      classNodes[positionIt->second] = positionIt->first;
+      }
+    }
+  return classNodes;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::AddNodeToClassIndex(vtkMRMLNode* node)
+{
+  if (!this->Nodes || !node || !this->NodeClassIndexValid)
+    {
+    // the index will be rebuilt at the next query
+    return;
+    }
+  if (static_cast<int>(this->NodeClassIndexPositions.size()) + 1 != this->Nodes->GetNumberOfItems())
+    {
+    // Nodes collection was modified directly, the index is out of sync
+    this->ClearNodeClassIndex();
+    return;
+    }
+  vtkIdType position = this->NodeClassIndexNextPosition++;
+  this->NodeClassIndexPositions[node] = position;
+  for (std::map< std::string, std::map<vtkIdType, vtkMRMLNode*> >::iterator classIt = this->NodesByClass.begin();
+    classIt != this->NodesByClass.end(); ++classIt)
+    {
+    if (node->IsA(classIt->first.c_str()))
+      {
+      classIt->second[position] = node;
+      // the node is the last one in the collection, so it can be appended
+      std::map< std::string, std::vector<vtkMRMLNode*> >::iterator classVectorIt = this->NodesByClassVectors.find(classIt->first);
+      if (classVectorIt != this->NodesByClassVectors.end())
+        {
+        classVectorIt->second.push_back(node);
+        }
+      }
+    }
+  this->NodeClassIndexMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::RemoveNodeFromClassIndex(vtkMRMLNode* node)
+{
+  if (!this->Nodes || !node || !this->NodeClassIndexValid)
+    {
+    return;
+    }
+  std::map<vtkMRMLNode*, vtkIdType>::iterator positionIt = this->NodeClassIndexPositions.find(node);
+  if (positionIt == this->NodeClassIndexPositions.end()
+    || static_cast<int>(this->NodeClassIndexPositions.size()) - 1 != this->Nodes->GetNumberOfItems())
+    {
+    this->ClearNodeClassIndex();
+    return;
+    }
+  vtkIdType position = positionIt->second;
+  this->NodeClassIndexPositions.erase(positionIt);
+  for (std::map< std::string, std::map<vtkIdType, vtkMRMLNode*> >::iterator classIt = this->NodesByClass.begin();
+    classIt != this->NodesByClass.end(); ++classIt)
+    {
+    if (node->IsA(classIt->first.c_str()))
+      {
+      classIt->second.erase(position);
+      this->NodesByClassVectors.erase(classIt->first);
+      }
+    }
+  this->NodeClassIndexMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::ClearNodeClassIndex()
+{
+  this->NodesByClass.clear();
+  this->NodesByClassVectors.clear();
+  this->NodeClassIndexPositions.clear();
+  this->NodeClassIndexNextPosition = 0;
+  this->NodeClassIndexValid = false;
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::AddURIHandler(vtkURIHandler *handler)
 {
@@ -3706,14 +3939,43 @@ void vtkMRMLScene::SetMaximumNumberOfSavedUndoStates(int stackSize)
   this->Modified();
 }
 
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::SetMaximumUndoMemorySize(vtkTypeInt64 size)
+{
+  if (size == this->MaximumUndoMemorySize)
+    {
+    return;
+    }
+  if (size < 0)
+    {
+    vtkErrorMacro("Cannot set maximum undo memory size to be a value less than 0");
+    return;
+    }
+  this->MaximumUndoMemorySize = size;
+  this->TrimUndoStack();
+  this->Modified();
+}
+
 //-----------------------------------------------------------------------------
 void vtkMRMLScene::TrimUndoStack()
 {
-  std::list<vtkSmartPointer<vtkCollection> > removedStacks;
-  while(static_cast<int>(this->UndoStack.size()) > this->MaximumNumberOfSavedUndoStates)
+  vtkTypeInt64 undoMemorySize = (this->MaximumUndoMemorySize > 0 ? this->GetUndoMemorySize() : 0);
+  while (static_cast<int>(this->UndoStack.size()) > this->MaximumNumberOfSavedUndoStates
+    || (this->MaximumUndoMemorySize > 0 && this->UndoStack.size() > 1 && undoMemorySize > this->MaximumUndoMemorySize))
     {
-    removedStacks.emplace_back(this->UndoStack.front());
+    undoMemorySize -= this->GetUndoLevelMemorySize(this->UndoStack.front());
     this->UndoStack.pop_front();
+    if (!this->UndoStack.empty())
+      {
+      // The oldest saved state cannot be undone, so the states before it are not needed
+      undoMemorySize -= this->GetUndoLevelMemorySize(this->UndoStack.front());
+      this->UndoStack.front().clear();
+      }
+    }
+  if (this->UndoStack.empty())
+    {
+    this->UndoReferenceStates.clear();
+    this->UndoModifiedNodeIDs.clear();
     }
 }
 
@@ -293,6 +293,8 @@ public:
   vtkMRMLNode* GetNthNode(int n);
 
   /// Get n-th node of a specified class in the scene
+  /// Iterating through nodes of a class with this method takes constant time per node,
+  /// unless nodes of the class are removed during the iteration.
   vtkMRMLNode* GetNthNodeByClass(int n, const char* className );
   /// Convenience function for getting 0-th node of a specified class in the scene
   vtkMRMLNode* GetFirstNodeByClass(const char* className);
@@ -351,10 +353,13 @@ public:
   vtkMRMLNode* InsertBeforeNode(vtkMRMLNode *item, vtkMRMLNode *newItem);
 
   /// Set undo on/off
-  void SetUndoOn() {UndoFlag=true;}
-  void SetUndoOff() {UndoFlag=false;}
+  /// Modifications of nodes are only observed while undo is on.
+  /// Turning undo off does not clear the undo stack, call ClearUndoStack()
+  /// to release the memory used by the saved states.
+  void SetUndoOn() {this->SetUndoFlag(true);}
+  void SetUndoOff() {this->SetUndoFlag(false);}
   bool GetUndoFlag() {return UndoFlag;}
-  void SetUndoFlag(bool flag) {UndoFlag = flag;}
+  void SetUndoFlag(bool flag);
 
   /// undo, set the scene to previous state
   void Undo();
@@ -363,6 +368,7 @@ public:
   void Redo();
 
   /// clear Undo stack, delete undo history
+  /// Releases all saved node states, including the copies of the last saved state.
   void ClearUndoStack();
 
   /// clear Redo stack, delete redo history
@@ -374,7 +380,11 @@ public:
   /// returns number of redo steps in the history buffer
   int GetNumberOfRedoLevels() {return static_cast<int>(this->RedoStack.size());}
 
-  /// Save current state in the undo buffer
+  /// \brief Save current state in the undo buffer
+  ///
+  /// Only the undo-enabled nodes that have been added, removed, or modified
+  /// since the previously saved state are copied, therefore the cost of saving
+  /// a state is proportional to the number of changed nodes.
   void SaveStateForUndo();
 
   /// Save current state of the node in the undo buffer
@@ -749,6 +759,24 @@ public:
   void SetMaximumNumberOfSavedUndoStates(int stackSize);
   vtkGetMacro(MaximumNumberOfSavedUndoStates, int);
 
+  /// \brief Sets the maximum memory size (in bytes) of saved undo states.
+  ///
+  /// Oldest saved states are removed while the estimated memory usage of the undo
+  /// stack is above this limit. At least one saved state is always kept.
+  /// 0 (default) means that only MaximumNumberOfSavedUndoStates limits the undo stack size.
+  /// \sa GetUndoMemorySize()
+  void SetMaximumUndoMemorySize(vtkTypeInt64 size);
+  vtkGetMacro(MaximumUndoMemorySize, vtkTypeInt64);
+
+  /// \brief Get estimated memory size (in bytes) of the node states stored for undo.
+  ///
+  /// Size of bulk data (meshes, images) of model and volume nodes are taken into account,
+  /// other nodes are counted with a fixed approximate size.
+  vtkTypeInt64 GetUndoMemorySize();
+
+  /// Get estimated memory size (in bytes) of the node states stored for redo.
+  vtkTypeInt64 GetRedoMemorySize();
+
   /// \brief Write the scene to a MRML scene bundle (.mrb) file.
   /// If thumbnail image is provided then it is saved in the scene's root folder.
   /// If userMessages is not nullptr then the method may add messages to it about issues
@@ -799,11 +827,61 @@ protected:
   vtkMRMLScene();
   ~vtkMRMLScene() override;
 
+  /// Copy of an undo-enabled node in a saved state.
+  /// State is nullptr if the node was not in the scene.
+  /// Node is the node object that was in this state when it was removed from
+  /// the scene, it is added back to the scene when the state is restored,
+  /// so that references to the node object remain valid.
+  struct UndoNodeState
+    {
+    vtkSmartPointer<vtkMRMLNode> State;
+    vtkSmartPointer<vtkMRMLNode> Node;
+    vtkTypeInt64 MemorySize{0};
+    };
+
+  /// Node states that differ between two saved states (node ID -> node state)
+  typedef std::map< std::string, UndoNodeState > UndoLevelType;
+
+  /// State of a node in the last saved state and the node that is in that
+  /// state if its modified time is not newer than NodeMTime.
+  struct UndoReferenceState
+    {
+    UndoNodeState NodeState;
+    vtkSmartPointer<vtkMRMLNode> Node;
+    vtkMTimeType NodeMTime{0};
+    };
+
+  /// Save the current state on the undo stack.
+  /// Only undo-enabled nodes that changed since the last saved state are copied.
   void PushIntoUndoStack();
-  void PushIntoRedoStack();
 
-  void CopyNodeInUndoStack(vtkMRMLNode *node);
-  void CopyNodeInRedoStack(vtkMRMLNode *node);
+  /// Save current state of nodes specified by \a nodeIDs on the redo stack.
+  void PushIntoRedoStack(const std::set<std::string>& nodeIDs);
+
+  /// Get IDs of undo-enabled nodes that have been added, removed, or modified
+  /// since the last saved state (UndoReferenceStates).
+  /// Only nodes in UndoModifiedNodeIDs are checked if the undo stack is not empty.
+  void GetModifiedNodeIDsSinceLastUndoState(std::set<std::string>& nodeIDs);
+
+  /// Start/stop recording modifications of the node in UndoModifiedNodeIDs.
+  /// Nothing is done if undo is off. When undo is turned on, all nodes of the scene are observed.
+  void AddUndoNodeObserver(vtkMRMLNode* node);
+  void RemoveUndoNodeObserver(vtkMRMLNode* node);
+
+  /// Record that the node has been added, removed, or modified since the last saved state.
+  void SetUndoNodeModified(vtkMRMLNode* node);
+
+  /// Create a copy of the node that can be stored in the undo or redo stack.
+  UndoNodeState CreateUndoNodeState(vtkMRMLNode* node);
+
+  /// Set nodes in the scene to the states stored in \a nodeStates.
+  /// Nodes are added or removed as needed.
+  /// If \a updateReferenceStates is true then nodes are registered as being in
+  /// the last saved state.
+  void RestoreUndoNodeStates(const UndoLevelType& nodeStates, bool updateReferenceStates);
+
+  /// Get estimated memory size of all node states stored in \a level.
+  vtkTypeInt64 GetUndoLevelMemorySize(const UndoLevelType& level) const;
 
   /// Add a node to the scene without invoking a vtkMRMLScene::NodeAddedEvent event.
   ///
@@ -818,6 +896,9 @@ protected:
   /// Handle vtkMRMLScene::DeleteEvent: clear the scene.
   static void SceneCallback(vtkObject *caller, unsigned long eid, void *clientData, void *callData);
 
+  /// Handle vtkCommand::ModifiedEvent of nodes in the scene: record the node as modified for undo.
+  static void UndoNodeModifiedCallback(vtkObject *caller, unsigned long eid, void *clientData, void *callData);
+
   std::string GenerateUniqueID(vtkMRMLNode* node);
   std::string GenerateUniqueID(const std::string& baseID);
   int GetUniqueIDIndex(const std::string& baseID);
@@ -849,6 +930,25 @@ protected:
   /// Clear NodeIDs map used to speedup GetByID() method.
   void ClearNodeIDs();
 
+  /// \brief Get nodes of class \a className (or any of its subclasses) in the
+  /// order they appear in the \a Nodes collection.
+  ///
+  /// The list of nodes of a class is computed on the first query and then kept
+  /// up-to-date by AddNode() and RemoveNode(), therefore queries cost
+  /// proportional to the number of returned nodes instead of the scene size.
+  /// \sa GetNodesByClass(), AddNodeToClassIndex(), RemoveNodeFromClassIndex()
+  const std::map<vtkIdType, vtkMRMLNode*>& GetClassIndexedNodes(const char* className);
+
+  /// Add node to \a NodesByClass index used to speedup GetNodesByClass() methods.
+  /// The node must have been appended at the end of the \a Nodes collection.
+  void AddNodeToClassIndex(vtkMRMLNode* node);
+
+  /// Remove node from \a NodesByClass index used to speedup GetNodesByClass() methods.
+  void RemoveNodeFromClassIndex(vtkMRMLNode* node);
+
+  /// Invalidate \a NodesByClass index. It will be rebuilt at the next class query.
+  void ClearNodeClassIndex();
+
   /// Get a NodeReferences iterator for a node reference.
   NodeReferencesType::iterator FindNodeReference(const char* referencedId, vtkMRMLNode* referencingNode);
 
@@ -887,10 +987,20 @@ protected:
   std::vector<unsigned long> States;
 
   int  MaximumNumberOfSavedUndoStates;
+  vtkTypeInt64 MaximumUndoMemorySize;
   bool UndoFlag;
 
-  std::list< vtkCollection* >  UndoStack;
-  std::list< vtkCollection* >  RedoStack;
+  /// Each undo level stores states of nodes that changed between the previous
+  /// and this saved state. The last saved state is stored in UndoReferenceStates.
+  std::list< UndoLevelType >  UndoStack;
+  /// Each redo level stores state of nodes that were changed by the undo operation.
+  std::list< UndoLevelType >  RedoStack;
+  /// State of all undo-enabled nodes at the last saved state (node ID -> state).
+  /// Only kept while the undo stack is not empty.
+  std::map< std::string, UndoReferenceState > UndoReferenceStates;
+  /// IDs of nodes that have been added, removed, or modified since the last saved state.
+  /// Only recorded while the undo stack is not empty.
+  std::set<std::string> UndoModifiedNodeIDs;
 
   std::string                 URL;
   std::string                 RootDirectory;
@@ -906,6 +1016,18 @@ protected:
   std::map< std::string, std::string > ReferencedIDChanges;
   std::map< std::string, vtkSmartPointer<vtkMRMLNode> > NodeIDs;
 
+  // Class name -> nodes that are IsA() of the class, keyed by their position
+  // in the Nodes collection (NodeClassIndexPositions). Only queried classes are indexed.
+  std::map< std::string, std::map<vtkIdType, vtkMRMLNode*> > NodesByClass;
+  // Class name -> nodes of NodesByClass in a vector, for constant-time GetNthNodeByClass().
+  // Built at the first GetNthNodeByClass() query, nodes are appended by AddNode() and the
+  // vector is rebuilt at the next query after a node of the class is removed.
+  std::map< std::string, std::vector<vtkMRMLNode*> > NodesByClassVectors;
+  std::map< vtkMRMLNode*, vtkIdType > NodeClassIndexPositions;
+  vtkIdType NodeClassIndexNextPosition;
+  bool NodeClassIndexValid;
+  vtkMTimeType NodeClassIndexMTime;
+
   // Stores default nodes. If a class is created or reset (using CreateNodeByClass or Clear) and
   // a default node is defined for it then the content of the default node will be used to initialize
   // the class. It is useful for overriding default values that are set in a node's constructor.
@@ -929,6 +1051,7 @@ protected:
   char * LastLoadedVersion;
 
   vtkCallbackCommand *DeleteEventCallback;
+  vtkCallbackCommand *UndoNodeModifiedCallbackCommand;
 
   std::default_random_engine RandomGenerator;
 
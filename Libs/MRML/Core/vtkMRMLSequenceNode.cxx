@@ -80,6 +80,7 @@ vtkMRMLSequenceNode::~vtkMRMLSequenceNode()
 void vtkMRMLSequenceNode::RemoveAllDataNodes()
 {
   this->IndexEntries.clear();
+  this->InvalidateIndexCache();
   if (!this->SequenceScene)
     {
     return;
@@ -214,6 +215,7 @@ void vtkMRMLSequenceNode::ReadIndexValues(const std::string& indexText)
 
   if (modified)
     {
+    this->InvalidateIndexCache();
     this->Modified();
     }
 }
@@ -281,6 +283,7 @@ void vtkMRMLSequenceNode::Copy(vtkMRMLNode *anode)
       }
     this->IndexEntries.push_back(seqItem);
     }
+  this->InvalidateIndexCache();
   this->Modified();
   this->StorableModifiedTime.Modified();
 
@@ -314,6 +317,7 @@ void vtkMRMLSequenceNode::CopySequenceIndex(vtkMRMLNode *anode)
       seqItem.DataNode = nullptr;
       this->IndexEntries.push_back(seqItem);
       }
+    this->InvalidateIndexCache();
     this->Modified();
     }
   this->EndModify(wasModified);
@@ -376,7 +380,8 @@ int vtkMRMLSequenceNode::GetInsertPosition(const std::string& indexValue)
     {
     int itemNumber = this->GetItemNumberFromIndexValue(indexValue, false);
     double numericIndexValue = atof(indexValue.c_str());
-    double foundNumericIndexValue = atof(this->IndexEntries[itemNumber].IndexValue.c_str());
+    this->UpdateNumericIndexCache();
+    double foundNumericIndexValue = this->NumericIndexValues[itemNumber];
     if (numericIndexValue < foundNumericIndexValue) // Deals with case of index value being smaller than any in the sequence and numeric tolerances
       {
       insertPosition = itemNumber;
@@ -409,7 +414,7 @@ vtkMRMLNode* vtkMRMLSequenceNode::SetDataNodeAtValue(vtkMRMLNode* node, const st
     // Create new item
     IndexEntryType seqItem;
     seqItem.IndexValue = indexValue;
-    this->IndexEntries.insert(this->IndexEntries.begin() + seqItemIndex, seqItem);
+    this->InsertIndexEntry(seqItemIndex, seqItem);
     }
   this->IndexEntries[seqItemIndex].DataNode = newNode;
   this->IndexEntries[seqItemIndex].DataNodeID.clear();
@@ -434,7 +439,7 @@ void vtkMRMLSequenceNode::RemoveDataNodeAtValue(const std::string& indexValue)
     }
   // TODO: remove associated nodes as well (such as storage node)?
   this->SequenceScene->RemoveNode(this->IndexEntries[seqItemIndex].DataNode);
-  this->IndexEntries.erase(this->IndexEntries.begin()+seqItemIndex);
+  this->EraseIndexEntry(seqItemIndex);
   this->Modified();
   this->StorableModifiedTime.Modified();
 }
@@ -451,13 +456,14 @@ int vtkMRMLSequenceNode::GetItemNumberFromIndexValue(const std::string& indexVal
   // Binary search will be faster for numeric index
   if (this->IndexType == NumericIndex)
     {
+    this->UpdateNumericIndexCache();
     int lowerBound = 0;
     int upperBound = numberOfSeqItems-1;
 
     // Deal with index values not within the range of index values in the Sequence
     double numericIndexValue = atof(indexValue.c_str());
-    double lowerNumericIndexValue = atof(this->IndexEntries[lowerBound].IndexValue.c_str());
-    double upperNumericIndexValue = atof(this->IndexEntries[upperBound].IndexValue.c_str());
+    double lowerNumericIndexValue = this->NumericIndexValues[lowerBound];
+    double upperNumericIndexValue = this->NumericIndexValues[upperBound];
     if (numericIndexValue <= lowerNumericIndexValue + this->NumericIndexValueTolerance)
       {
       if (numericIndexValue < lowerNumericIndexValue - this->NumericIndexValueTolerance && exactMatchRequired)
@@ -485,7 +491,7 @@ int vtkMRMLSequenceNode::GetItemNumberFromIndexValue(const std::string& indexVal
       {
       // Note that if middle is equal to either lowerBound or upperBound then upperBound - lowerBound <= 1
       int middle = int((lowerBound + upperBound)/2);
-      double middleNumericIndexValue = atof(this->IndexEntries[middle].IndexValue.c_str());
+      double middleNumericIndexValue = this->NumericIndexValues[middle];
       if (fabs(numericIndexValue - middleNumericIndexValue) <= this->NumericIndexValueTolerance)
         {
         return middle;
@@ -505,16 +511,14 @@ int vtkMRMLSequenceNode::GetItemNumberFromIndexValue(const std::string& indexVal
       }
     }
 
-  // Need linear search for non-numeric index
-  for (int i=0; i<numberOfSeqItems; i++)
+  // Exact string match for non-numeric index
+  this->UpdateTextIndexCache();
+  std::unordered_map<std::string, int>::iterator itemNumberIt = this->TextIndexItemNumbers.find(indexValue);
+  if (itemNumberIt == this->TextIndexItemNumbers.end())
     {
-    if (this->IndexEntries[i].IndexValue.compare(indexValue)==0)
-      {
-      return i;
-      }
+    return -1;
     }
-
-  return -1;
+  return itemNumberIt->second;
 }
 
 //---------------------------------------------------------------------------
@@ -545,6 +549,99 @@ std::string vtkMRMLSequenceNode::GetNthIndexValue(int seqItemIndex)
   return this->IndexEntries[seqItemIndex].IndexValue;
 }
 
+//-----------------------------------------------------------------------------
+void vtkMRMLSequenceNode::InsertIndexEntry(int itemNumber, const IndexEntryType& entry)
+{
+  bool appended = (itemNumber == static_cast<int>(this->IndexEntries.size()));
+  this->IndexEntries.insert(this->IndexEntries.begin() + itemNumber, entry);
+  if (this->NumericIndexValuesValid)
+    {
+    this->NumericIndexValues.insert(this->NumericIndexValues.begin() + itemNumber, atof(entry.IndexValue.c_str()));
+    }
+  if (this->TextIndexItemNumbersValid)
+    {
+    if (appended)
+      {
+      // item numbers of existing entries are not changed, only the new item has to be added
+      // (if the same index value already exists then the first occurrence is kept)
+      this->TextIndexItemNumbers.insert(std::make_pair(entry.IndexValue, itemNumber));
+      }
+    else
+      {
+      this->TextIndexItemNumbersValid = false;
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLSequenceNode::EraseIndexEntry(int itemNumber)
+{
+  bool last = (itemNumber == static_cast<int>(this->IndexEntries.size()) - 1);
+  if (this->TextIndexItemNumbersValid)
+    {
+    if (last)
+      {
+      std::unordered_map<std::string, int>::iterator itemNumberIt =
+        this->TextIndexItemNumbers.find(this->IndexEntries[itemNumber].IndexValue);
+      if (itemNumberIt != this->TextIndexItemNumbers.end() && itemNumberIt->second == itemNumber)
+        {
+        this->TextIndexItemNumbers.erase(itemNumberIt);
+        }
+      }
+    else
+      {
+      this->TextIndexItemNumbersValid = false;
+      }
+    }
+  this->IndexEntries.erase(this->IndexEntries.begin() + itemNumber);
+  if (this->NumericIndexValuesValid)
+    {
+    this->NumericIndexValues.erase(this->NumericIndexValues.begin() + itemNumber);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLSequenceNode::InvalidateIndexCache()
+{
+  this->NumericIndexValuesValid = false;
+  this->NumericIndexValues.clear();
+  this->TextIndexItemNumbersValid = false;
+  this->TextIndexItemNumbers.clear();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLSequenceNode::UpdateNumericIndexCache()
+{
+  if (this->NumericIndexValuesValid)
+    {
+    return;
+    }
+  this->NumericIndexValues.clear();
+  this->NumericIndexValues.reserve(this->IndexEntries.size());
+  for (const IndexEntryType& entry : this->IndexEntries)
+    {
+    this->NumericIndexValues.push_back(atof(entry.IndexValue.c_str()));
+    }
+  this->NumericIndexValuesValid = true;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLSequenceNode::UpdateTextIndexCache()
+{
+  if (this->TextIndexItemNumbersValid)
+    {
+    return;
+    }
+  this->TextIndexItemNumbers.clear();
+  int numberOfSeqItems = static_cast<int>(this->IndexEntries.size());
+  for (int i = 0; i < numberOfSeqItems; i++)
+    {
+    // insert does not overwrite existing items, so the first occurrence is kept
+    this->TextIndexItemNumbers.insert(std::make_pair(this->IndexEntries[i].IndexValue, i));
+    }
+  this->TextIndexItemNumbersValid = true;
+}
+
 //-----------------------------------------------------------------------------
 int vtkMRMLSequenceNode::GetNumberOfDataNodes()
 {
@@ -571,15 +668,20 @@ bool vtkMRMLSequenceNode::UpdateIndexValue(const std::string& oldIndexValue, con
     return false;
     }
   // Update the index value
-  this->IndexEntries[oldSeqItemIndex].IndexValue = newIndexValue;
   if (this->IndexType == vtkMRMLSequenceNode::NumericIndex)
     {
     IndexEntryType movingEntry = this->IndexEntries[oldSeqItemIndex];
+    movingEntry.IndexValue = newIndexValue;
     // Remove from current position
-    this->IndexEntries.erase(this->IndexEntries.begin() + oldSeqItemIndex);
+    this->EraseIndexEntry(oldSeqItemIndex);
     // Insert into new position
     int insertPosition = this->GetInsertPosition(newIndexValue);
-    this->IndexEntries.insert(this->IndexEntries.begin() + insertPosition, movingEntry);
+    this->InsertIndexEntry(insertPosition, movingEntry);
+    }
+  else
+    {
+    this->IndexEntries[oldSeqItemIndex].IndexValue = newIndexValue;
+    this->InvalidateIndexCache();
     }
   this->Modified();
   this->StorableModifiedTime.Modified();
@@ -25,6 +25,8 @@
 // std includes
 #include <deque>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
 
 /// \brief MRML node for representing a sequence of MRML nodes
@@ -186,6 +188,19 @@ protected:
     std::string DataNodeID; // only used temporarily, during scene load
     };
 
+  /// Insert an item into IndexEntries and update index value caches.
+  void InsertIndexEntry(int itemNumber, const IndexEntryType& entry);
+  /// Remove an item from IndexEntries and update index value caches.
+  void EraseIndexEntry(int itemNumber);
+
+  /// Invalidate cached index values. Must be called after IndexEntries
+  /// are modified without using InsertIndexEntry() or EraseIndexEntry().
+  void InvalidateIndexCache();
+  /// Rebuild cached numeric index values if they are invalid.
+  void UpdateNumericIndexCache();
+  /// Rebuild text index value lookup table if it is invalid.
+  void UpdateTextIndexCache();
+
 protected:
 
   /// Describes index of the sequence node
@@ -200,6 +215,15 @@ protected:
 
   /// List of data items (the scene may contain some more nodes, such as storage nodes)
   std::deque< IndexEntryType > IndexEntries;
+
+  /// Numeric value of each index entry (same order as IndexEntries), to avoid
+  /// parsing index value strings during search.
+  std::vector<double> NumericIndexValues;
+  bool NumericIndexValuesValid{false};
+
+  /// Item number of the first index entry of each index value, for fast exact lookup.
+  std::unordered_map<std::string, int> TextIndexItemNumbers;
+  bool TextIndexItemNumbersValid{false};
 };
 
 #endif
@@ -18,6 +18,7 @@ Version:   $Revision: 1.1.1.1 $
 #include "vtkDataFileFormatHelper.h"
 #include "vtkDataIOManager.h"
 #include "vtkMRMLMessageCollection.h"
+#include "vtkMRMLPerformanceTracer.h"
 #include "vtkMRMLScene.h"
 #include "vtkMRMLStorableNode.h"
 #include "vtkMRMLStorageNode.h"
@@ -1200,6 +1201,7 @@ bool vtkMRMLStorageNode::CanWriteFromReferenceNode(vtkMRMLNode *refNode)
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
 {
+  MRML_TRACE_SCOPE("StorageNode::ReadData", this->GetClassName());
   if (refNode == nullptr)
     {
     vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLStorageNode::ReadData",
@@ -1299,6 +1301,7 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::WriteData(vtkMRMLNode* refNode)
 {
+  MRML_TRACE_SCOPE("StorageNode::WriteData", this->GetClassName());
   this->WriteState = this->Idle;
   if (refNode == nullptr)
     {
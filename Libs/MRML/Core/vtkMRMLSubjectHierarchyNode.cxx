@@ -108,6 +108,13 @@ public:
   static std::map<vtkIdType, vtkSubjectHierarchyItem*> ItemCache;
   static std::map<vtkMRMLNode*, vtkSubjectHierarchyItem*> DataNodeCache;
 
+  /// UID caches to speed up lookups by UID. Only items that are in the tree are cached.
+  /// UIDCache maps (UID name, UID value) to items, UIDListCache maps (UID name, UID list element)
+  /// to items (for example each instance UID in the instance UID list of a series).
+  typedef std::map<std::pair<std::string, std::string>, std::vector<vtkSubjectHierarchyItem*> > UIDCacheType;
+  static UIDCacheType UIDCache;
+  static UIDCacheType UIDListCache;
+
 // Get/set functions
 public:
   /// Add data item to tree under parent, specifying basic properties
@@ -149,6 +156,9 @@ public:
 
 // Child related functions
 public:
+  /// Determine whether this item is in the branch of the given item
+  /// \param recursive Flag whether to consider only direct children (false) or the whole branch (true)
+  bool IsInBranch(vtkSubjectHierarchyItem* ancestor, bool recursive=true);
   /// Determine whether this item has any children
   bool HasChildren();
   /// Determine whether this item is the parent of a virtual branch
@@ -160,16 +170,18 @@ public:
   /// \param recursive Flag whether to find only direct children (false) or in the whole branch (true). True by default
   /// \return Item if found, nullptr otherwise
   vtkSubjectHierarchyItem* FindChildByID(vtkIdType itemID, bool recursive=true);
-  /// Find child by associated data MRML node
+  /// Find child by associated data MRML node. Uses the data node cache.
   /// \param dataNode Data MRML node to find
   /// \param recursive Flag whether to find only direct children (false) or in the whole branch (true). True by default
   /// \return Item if found, nullptr otherwise
   vtkSubjectHierarchyItem* FindChildByDataNode(vtkMRMLNode* dataNode, bool recursive=true);
-  /// Find child by UID (exact match)
+  /// Find child by UID (exact match). Uses the UID cache.
   /// \param recursive Flag whether to find only direct children (false) or in the whole branch (true). True by default
   /// \return Item if found, nullptr otherwise
   vtkSubjectHierarchyItem* FindChildByUID(std::string uidName, std::string uidValue, bool recursive=true);
-  /// Find child by UID list (containing). For example find UID in instance UID list
+  /// Find child by UID list (containing). For example find UID in instance UID list.
+  /// A single UID is looked up in the UID cache, in which case it has to match a complete
+  /// element of the UID list.
   /// \param recursive Flag whether to find only direct children (false) or in the whole branch (true). True by default
   /// \return Item if found, nullptr otherwise
   vtkSubjectHierarchyItem* FindChildByUIDList(std::string uidName, std::string uidValue, bool recursive=true);
@@ -216,6 +228,21 @@ public:
   /// Remove all children. Do not delete data nodes from the scene. Used in destructor, and for deleting virtual branches
   void RemoveAllChildren();
 
+// Cache functions
+public:
+  /// Add all UIDs of the item to the UID caches
+  void AddUIDsToCache();
+  /// Remove all UIDs of the item from the UID caches
+  void RemoveUIDsFromCache();
+  /// Add a UID of the item to the UID caches
+  void AddUIDToCache(const std::string& uidName, const std::string& uidValue);
+  /// Remove a UID of the item from the UID caches
+  void RemoveUIDFromCache(const std::string& uidName, const std::string& uidValue);
+  /// Find first item in the branch of the given item in a list of cached items
+  static vtkSubjectHierarchyItem* FindCachedItemInBranch(
+    UIDCacheType& cache, const std::string& uidName, const std::string& uidValue,
+    vtkSubjectHierarchyItem* ancestor, bool recursive);
+
 // Utility functions
 public:
   /// Get attribute value from an upper level in the subject hierarchy
@@ -248,6 +275,8 @@ vtkIdType vtkSubjectHierarchyItem::NextSubjectHierarchyItemID = vtkMRMLSubjectHi
 
 std::map<vtkIdType, vtkSubjectHierarchyItem*> vtkSubjectHierarchyItem::ItemCache = std::map<vtkIdType, vtkSubjectHierarchyItem*>();
 std::map<vtkMRMLNode*, vtkSubjectHierarchyItem*> vtkSubjectHierarchyItem::DataNodeCache = std::map<vtkMRMLNode*, vtkSubjectHierarchyItem*>();
+vtkSubjectHierarchyItem::UIDCacheType vtkSubjectHierarchyItem::UIDCache = vtkSubjectHierarchyItem::UIDCacheType();
+vtkSubjectHierarchyItem::UIDCacheType vtkSubjectHierarchyItem::UIDListCache = vtkSubjectHierarchyItem::UIDCacheType();
 
 //---------------------------------------------------------------------------
 // vtkSubjectHierarchyItem methods
@@ -305,6 +334,8 @@ vtkIdType vtkSubjectHierarchyItem::AddToTree(vtkSubjectHierarchyItem* parent, vt
       {
       vtkSubjectHierarchyItem::DataNodeCache[dataNode] = this;
       }
+    // UIDs are already set if the item is being resolved after scene import
+    this->AddUIDsToCache();
     }
   else
     {
@@ -342,6 +373,7 @@ vtkIdType vtkSubjectHierarchyItem::AddToTree(vtkSubjectHierarchyItem* parent, st
 
     // Add to cache (DataNode is nullptr, so no need to add to node cache)
     vtkSubjectHierarchyItem::ItemCache[this->ID] = this;
+    this->AddUIDsToCache();
     }
   else if (! ( (!name.compare("Scene") && !level.compare("Scene"))
             || (!name.compare("UnresolvedItems") && !level.compare("UnresolvedItems")) ) )
@@ -687,6 +719,27 @@ std::string vtkSubjectHierarchyItem::GetName()
   return this->Name;
 }
 
+//---------------------------------------------------------------------------
+bool vtkSubjectHierarchyItem::IsInBranch(vtkSubjectHierarchyItem* ancestor, bool recursive/*=true*/)
+{
+  if (!ancestor)
+    {
+    return false;
+    }
+  if (!recursive)
+    {
+    return (this->Parent == ancestor);
+    }
+  for (vtkSubjectHierarchyItem* currentParent = this->Parent; currentParent; currentParent = currentParent->Parent)
+    {
+    if (currentParent == ancestor)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
 //---------------------------------------------------------------------------
 bool vtkSubjectHierarchyItem::HasChildren()
 {
@@ -755,22 +808,12 @@ vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindChildByDataNode(vtkMRMLNod
     return nullptr;
     }
 
-  ChildVector::iterator childIt;
-  for (childIt=this->Children.begin(); childIt!=this->Children.end(); ++childIt)
+  // Look up item in cache. All items in the tree with a data node are cached.
+  std::map<vtkMRMLNode*, vtkSubjectHierarchyItem*>::iterator itemIt = vtkSubjectHierarchyItem::DataNodeCache.find(dataNode);
+  if (itemIt != vtkSubjectHierarchyItem::DataNodeCache.end()
+    && itemIt->second && itemIt->second->DataNode == dataNode)
     {
-    vtkSubjectHierarchyItem* currentItem = childIt->GetPointer();
-    if (dataNode == currentItem->DataNode.GetPointer())
-      {
-      return currentItem;
-      }
-    if (recursive)
-      {
-      vtkSubjectHierarchyItem* foundItemInBranch = currentItem->FindChildByDataNode(dataNode);
-      if (foundItemInBranch)
-        {
-        return foundItemInBranch;
-        }
-      }
+    return (itemIt->second->IsInBranch(this, recursive) ? itemIt->second : nullptr);
     }
   return nullptr;
 }
@@ -782,24 +825,8 @@ vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindChildByUID(std::string uid
     {
     return nullptr;
     }
-  ChildVector::iterator childIt;
-  for (childIt=this->Children.begin(); childIt!=this->Children.end(); ++childIt)
-    {
-    vtkSubjectHierarchyItem* currentItem = childIt->GetPointer();
-    if (!currentItem->GetUID(uidName).compare(uidValue))
-      {
-      return currentItem;
-      }
-    if (recursive)
-      {
-      vtkSubjectHierarchyItem* foundItemInBranch = currentItem->FindChildByUID(uidName, uidValue);
-      if (foundItemInBranch)
-        {
-        return foundItemInBranch;
-        }
-      }
-    }
-  return nullptr;
+  return vtkSubjectHierarchyItem::FindCachedItemInBranch(
+    vtkSubjectHierarchyItem::UIDCache, uidName, uidValue, this, recursive);
 }
 
 //---------------------------------------------------------------------------
@@ -809,6 +836,14 @@ vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindChildByUIDList(std::string
     {
     return nullptr;
     }
+  if (uidValue.find(' ') == std::string::npos)
+    {
+    // Single UID is looked up in the UID list element cache
+    return vtkSubjectHierarchyItem::FindCachedItemInBranch(
+      vtkSubjectHierarchyItem::UIDListCache, uidName, uidValue, this, recursive);
+    }
+
+  // Search for a part of a UID list is only possible by traversing the tree
   ChildVector::iterator childIt;
   for (childIt=this->Children.begin(); childIt!=this->Children.end(); ++childIt)
     {
@@ -1129,6 +1164,7 @@ bool vtkSubjectHierarchyItem::RemoveChild(vtkSubjectHierarchyItem* item)
     {
     vtkSubjectHierarchyItem::DataNodeCache.erase(removedItem->DataNode);
     }
+  removedItem->RemoveUIDsFromCache();
 
   // Invoke events
   this->InvokeEvent(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemRemovedEvent, item);
@@ -1177,6 +1213,7 @@ bool vtkSubjectHierarchyItem::RemoveChild(vtkIdType itemID)
     {
     vtkSubjectHierarchyItem::DataNodeCache.erase(removedItem->DataNode);
     }
+  removedItem->RemoveUIDsFromCache();
 
   // Invoke events
   this->InvokeEvent(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemRemovedEvent, removedItem.GetPointer());
@@ -1268,12 +1305,117 @@ void vtkSubjectHierarchyItem::SetUID(std::string uidName, std::string uidValue)
       {
       return; // Do nothing if the UID values match
       }
+    this->RemoveUIDFromCache(uidName, this->UIDs[uidName]);
     }
   this->UIDs[uidName] = uidValue;
+  // Only items in the tree are cached
+  std::map<vtkIdType, vtkSubjectHierarchyItem*>::iterator itemIt = vtkSubjectHierarchyItem::ItemCache.find(this->ID);
+  if (itemIt != vtkSubjectHierarchyItem::ItemCache.end() && itemIt->second == this)
+    {
+    this->AddUIDToCache(uidName, uidValue);
+    }
   this->InvokeEvent(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemUIDAddedEvent, this);
   this->Modified();
 }
 
+//---------------------------------------------------------------------------
+void vtkSubjectHierarchyItem::AddUIDsToCache()
+{
+  for (std::map<std::string, std::string>::iterator uidIt = this->UIDs.begin(); uidIt != this->UIDs.end(); ++uidIt)
+    {
+    this->AddUIDToCache(uidIt->first, uidIt->second);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSubjectHierarchyItem::RemoveUIDsFromCache()
+{
+  for (std::map<std::string, std::string>::iterator uidIt = this->UIDs.begin(); uidIt != this->UIDs.end(); ++uidIt)
+    {
+    this->RemoveUIDFromCache(uidIt->first, uidIt->second);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSubjectHierarchyItem::AddUIDToCache(const std::string& uidName, const std::string& uidValue)
+{
+  if (uidName.empty() || uidValue.empty())
+    {
+    return;
+    }
+  std::vector<vtkSubjectHierarchyItem*>& items = vtkSubjectHierarchyItem::UIDCache[std::make_pair(uidName, uidValue)];
+  if (std::find(items.begin(), items.end(), this) == items.end())
+    {
+    items.push_back(this);
+    }
+
+  std::vector<std::string> uidList;
+  vtkMRMLSubjectHierarchyNode::DeserializeUIDList(uidValue, uidList);
+  for (std::vector<std::string>::iterator uidIt = uidList.begin(); uidIt != uidList.end(); ++uidIt)
+    {
+    std::vector<vtkSubjectHierarchyItem*>& listItems = vtkSubjectHierarchyItem::UIDListCache[std::make_pair(uidName, *uidIt)];
+    if (std::find(listItems.begin(), listItems.end(), this) == listItems.end())
+      {
+      listItems.push_back(this);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSubjectHierarchyItem::RemoveUIDFromCache(const std::string& uidName, const std::string& uidValue)
+{
+  if (uidName.empty() || uidValue.empty())
+    {
+    return;
+    }
+  UIDCacheType::iterator cacheIt = vtkSubjectHierarchyItem::UIDCache.find(std::make_pair(uidName, uidValue));
+  if (cacheIt != vtkSubjectHierarchyItem::UIDCache.end())
+    {
+    cacheIt->second.erase(std::remove(cacheIt->second.begin(), cacheIt->second.end(), this), cacheIt->second.end());
+    if (cacheIt->second.empty())
+      {
+      vtkSubjectHierarchyItem::UIDCache.erase(cacheIt);
+      }
+    }
+
+  std::vector<std::string> uidList;
+  vtkMRMLSubjectHierarchyNode::DeserializeUIDList(uidValue, uidList);
+  for (std::vector<std::string>::iterator uidIt = uidList.begin(); uidIt != uidList.end(); ++uidIt)
+    {
+    UIDCacheType::iterator listCacheIt = vtkSubjectHierarchyItem::UIDListCache.find(std::make_pair(uidName, *uidIt));
+    if (listCacheIt == vtkSubjectHierarchyItem::UIDListCache.end())
+      {
+      continue;
+      }
+    listCacheIt->second.erase(std::remove(listCacheIt->second.begin(), listCacheIt->second.end(), this), listCacheIt->second.end());
+    if (listCacheIt->second.empty())
+      {
+      vtkSubjectHierarchyItem::UIDListCache.erase(listCacheIt);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindCachedItemInBranch(
+  UIDCacheType& cache, const std::string& uidName, const std::string& uidValue,
+  vtkSubjectHierarchyItem* ancestor, bool recursive)
+{
+  UIDCacheType::iterator cacheIt = cache.find(std::make_pair(uidName, uidValue));
+  if (cacheIt == cache.end())
+    {
+    return nullptr;
+    }
+  // The same UID may be present in multiple subject hierarchies (or multiple times in one)
+  for (std::vector<vtkSubjectHierarchyItem*>::iterator itemIt = cacheIt->second.begin(); itemIt != cacheIt->second.end(); ++itemIt)
+    {
+    if ((*itemIt)->IsInBranch(ancestor, recursive))
+      {
+      return (*itemIt);
+      }
+    }
+  return nullptr;
+}
+
 //---------------------------------------------------------------------------
 std::string vtkSubjectHierarchyItem::GetUID(std::string uidName)
 {
@@ -2962,14 +3104,9 @@ vtkIdType vtkMRMLSubjectHierarchyNode::GetItemByDataNode(vtkMRMLNode* dataNode)
       }
     }
 
-  vtkSubjectHierarchyItem* item = this->Internal->SceneItem->FindChildByDataNode(dataNode);
-  if (item)
-    {
-    // item was not in the cache, add it now
-    vtkErrorMacro("vtkSubjectHierarchyItem::DataNodeCache item was missing");
-    vtkSubjectHierarchyItem::DataNodeCache[dataNode] = item;
-    }
-  return (item ? item->ID : INVALID_ITEM_ID);
+  // All items in the tree that have a data node are in the cache,
+  // therefore the data node is not in the subject hierarchy.
+  return INVALID_ITEM_ID;
 }
 
 //---------------------------------------------------------------------------
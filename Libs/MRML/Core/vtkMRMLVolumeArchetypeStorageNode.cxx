@@ -23,6 +23,11 @@ Version:   $Revision: 1.6 $
 #endif
 #include "vtkMRMLVolumeArchetypeStorageNode.h"
 
+#ifdef MRML_USE_vtkTeem
+// vtkTeem includes
+#include <vtkTeemNRRDReader.h>
+#endif
+
 // VTK ITK includes
 #include "vtkITKArchetypeImageSeriesScalarReader.h"
 #include "vtkITKArchetypeDiffusionTensorImageReaderFile.h"
@@ -39,6 +44,9 @@ Version:   $Revision: 1.6 $
 #include <vtkDataArray.h>
 #include <vtkErrorCode.h>
 #include <vtkImageChangeInformation.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationStringKey.h>
 #include <vtkMatrix3x3.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
@@ -85,6 +93,7 @@ vtkMRMLVolumeArchetypeStorageNode::vtkMRMLVolumeArchetypeStorageNode()
   this->CenterImage = 0;
   this->SingleFile  = 0;
   this->UseOrientationFromFile = 1;
+  this->UseMemoryMapping = 0;
   this->DefaultWriteFileExtension = "nrrd";
 }
 
@@ -105,6 +114,10 @@ void vtkMRMLVolumeArchetypeStorageNode::WriteXML(ostream& of, int nIndent)
   ss << this->UseOrientationFromFile;
   of << " UseOrientationFromFile=\"" << ss.str() << "\"";
   }
+  if (this->UseMemoryMapping)
+    {
+    of << " useMemoryMapping=\"" << this->UseMemoryMapping << "\"";
+    }
   // SingleFile attribute is not written to file. GetNumberOfFileNames()
   // is used to determine if reader should read from single/multiple files.
 }
@@ -134,6 +147,12 @@ void vtkMRMLVolumeArchetypeStorageNode::ReadXMLAttributes(const char** atts)
       ss << attValue;
       ss >> this->UseOrientationFromFile;
       }
+    if (!strcmp(attName, "useMemoryMapping"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      ss >> this->UseMemoryMapping;
+      }
     }
 
   // SingleFile attribute used to be read from the scene, but often
@@ -158,6 +177,7 @@ void vtkMRMLVolumeArchetypeStorageNode::Copy(vtkMRMLNode *anode)
   this->SetCenterImage(node->CenterImage);
   this->SetSingleFile(node->SingleFile);
   this->SetUseOrientationFromFile(node->UseOrientationFromFile);
+  this->SetUseMemoryMapping(node->UseMemoryMapping);
 
   this->EndModify(disabledModify);
 }
@@ -169,6 +189,7 @@ void vtkMRMLVolumeArchetypeStorageNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "CenterImage:   " << this->CenterImage << "\n";
   os << indent << "SingleFile:   " << this->SingleFile << "\n";
   os << indent << "UseOrientationFromFile:   " << this->UseOrientationFromFile << "\n";
+  os << indent << "UseMemoryMapping:   " << this->UseMemoryMapping << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -327,6 +348,17 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
+  if (this->UseMemoryMapping
+    && !refNode->IsA("vtkMRMLVectorVolumeNode")
+    && !refNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
+    {
+    int result = this->ReadMemoryMappedNRRD(volNode, fullName);
+    if (result >= 0)
+      {
+      return result;
+      }
+    }
+
   vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
 
   if (refNode->IsA("vtkMRMLVectorVolumeNode"))
@@ -529,6 +561,85 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   return 1;
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::ReadMemoryMappedNRRD(vtkMRMLScalarVolumeNode* volNode, const std::string& fullName)
+{
+#ifdef MRML_USE_vtkTeem
+  std::string fileExt = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
+  if (fileExt != std::string(".nrrd") && fileExt != std::string(".nhdr"))
+    {
+    return -1;
+    }
+
+  vtkNew<vtkTeemNRRDReader> reader;
+  if (!reader->CanReadFile(fullName.c_str()))
+    {
+    return -1;
+    }
+  reader->SetFileName(fullName.c_str());
+  if (this->CenterImage)
+    {
+    reader->SetUseNativeOriginOff();
+    }
+  else
+    {
+    reader->SetUseNativeOriginOn();
+    }
+  reader->UseMemoryMappingOn();
+  reader->UpdateInformation();
+  if (reader->GetReadStatus() != 0
+    || reader->GetPointDataType() != vtkDataSetAttributes::SCALARS
+    || reader->GetNumberOfComponents() != 1)
+    {
+    // not a scalar volume, use the generic reader
+    return -1;
+    }
+  reader->AddObserver(vtkCommand::ProgressEvent, this->MRMLCallbackCommand);
+  reader->Update();
+  if (reader->GetOutput() == nullptr || reader->GetOutput()->GetPointData()->GetScalars() == nullptr)
+    {
+    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeArchetypeStorageNode::ReadMemoryMappedNRRD",
+      "Unable to read ScalarVolume data from file: " << fullName);
+    return 0;
+    }
+
+  // Set header fields as node attributes, similarly to the generic reader
+  std::vector<std::string> keys = reader->GetHeaderKeysVector();
+  for (std::vector<std::string>::iterator kit = keys.begin(); kit != keys.end(); ++kit)
+    {
+    volNode->SetAttribute(kit->c_str(), reader->GetHeaderValue(kit->c_str()));
+    }
+
+  // Spacing and origin are stored in the IJK to RAS matrix
+  vtkNew<vtkImageChangeInformation> ici;
+  ici->SetInputConnection(reader->GetOutputPort());
+  ici->SetOutputSpacing(1, 1, 1);
+  ici->SetOutputOrigin(0, 0, 0);
+  ici->Update();
+
+  if (volNode->GetImageData())
+    {
+    volNode->SetAndObserveImageData(nullptr);
+    }
+  vtkNew<vtkImageData> outputImage;
+  outputImage->ShallowCopy(ici->GetOutput());
+  volNode->SetAndObserveImageData(outputImage.GetPointer());
+  volNode->SetRASToIJKMatrix(reader->GetRasToIjkMatrix());
+
+  vtkInfoMacro(<<"Loaded volume from file: "<<fullName \
+    <<(reader->GetMemoryMapped() ? " (memory-mapped)" : "") \
+    <<". Dimensions: "<<outputImage->GetDimensions()[0]<<"x"<<outputImage->GetDimensions()[1]<<"x"<<outputImage->GetDimensions()[2] \
+    <<". Number of components: "<<outputImage->GetNumberOfScalarComponents() \
+    <<". Pixel type: "<<vtkImageScalarTypeNameMacro(outputImage->GetScalarType())<<".");
+
+  return 1;
+#else
+  (void)volNode;
+  (void)fullName;
+  return -1;
+#endif
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLVolumeArchetypeStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
 {
@@ -548,9 +659,6 @@ int vtkMRMLVolumeArchetypeStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     return 1;
     }
 
-  // update the file list
-  std::string moveFromDir = this->UpdateFileList(refNode, 1);
-
   std::string fullName = this->GetFullNameFromFileName();
   if (fullName.empty())
     {
@@ -559,6 +667,12 @@ int vtkMRMLVolumeArchetypeStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
+  // The file that is written may be the file that the voxels are memory-mapped from
+  this->DetachMemoryMappedScalars(volNode->GetImageData(), fullName);
+
+  // update the file list
+  std::string moveFromDir = this->UpdateFileList(refNode, 1);
+
   if (volNode->GetVoxelVectorType() == vtkMRMLVolumeNode::VoxelVectorTypeSpatial)
     {
     if (volNode->GetImageData()->GetNumberOfScalarComponents() != 3)
@@ -727,6 +841,45 @@ int vtkMRMLVolumeArchetypeStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   return result;
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeArchetypeStorageNode::DetachMemoryMappedScalars(vtkImageData* imageData, const std::string& fileName)
+{
+#ifdef MRML_USE_vtkTeem
+  vtkDataArray* scalars = imageData ? imageData->GetPointData()->GetScalars() : nullptr;
+  if (!scalars || !scalars->HasInformation()
+    || !scalars->GetInformation()->Has(vtkTeemNRRDReader::MEMORY_MAPPED_FILE_NAME()))
+    {
+    return;
+    }
+  // Writers store the voxels in the written file or in a data file next to it
+  // with the same base name (e.g., .nhdr and .raw). Names are compared case-insensitively,
+  // because the file system may be case-insensitive.
+  std::string mappedFileName = scalars->GetInformation()->Get(vtkTeemNRRDReader::MEMORY_MAPPED_FILE_NAME());
+  std::string mappedFilePath = vtksys::SystemTools::LowerCase(vtksys::SystemTools::CollapseFullPath(
+    vtksys::SystemTools::GetFilenamePath(mappedFileName) + "/"
+    + vtksys::SystemTools::GetFilenameWithoutExtension(mappedFileName)));
+  std::string writtenFilePath = vtksys::SystemTools::LowerCase(vtksys::SystemTools::CollapseFullPath(
+    vtksys::SystemTools::GetFilenamePath(fileName) + "/"
+    + vtksys::SystemTools::GetFilenameWithoutExtension(fileName)));
+  if (mappedFilePath != writtenFilePath)
+    {
+    return;
+    }
+  // Copy the voxels into memory. The array object is kept (only its buffer is replaced),
+  // so that all images that share the array stop referring to the mapped file,
+  // which is unmapped when the buffer is released.
+  vtkDebugMacro("DetachMemoryMappedScalars: copy voxels into memory before overwriting " << mappedFileName);
+  vtkSmartPointer<vtkDataArray> scalarsInMemory = vtkSmartPointer<vtkDataArray>::Take(scalars->NewInstance());
+  scalarsInMemory->DeepCopy(scalars);
+  scalars->ShallowCopy(scalarsInMemory);
+  scalars->GetInformation()->Remove(vtkTeemNRRDReader::MEMORY_MAPPED_FILE_NAME());
+  scalars->Modified();
+#else
+  (void)imageData;
+  (void)fileName;
+#endif
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLVolumeArchetypeStorageNode::InitializeSupportedWriteFileTypes()
 {
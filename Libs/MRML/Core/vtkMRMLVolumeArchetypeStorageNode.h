@@ -19,6 +19,7 @@
 
 class vtkImageData;
 class vtkITKArchetypeImageSeriesReader;
+class vtkMRMLScalarVolumeNode;
 class vtkMRMLVolumeNode;
 
 /// \brief MRML node for representing a volume storage.
@@ -75,6 +76,15 @@ public:
   vtkSetMacro(UseOrientationFromFile, int);
   vtkGetMacro(UseOrientationFromFile, int);
 
+  ///
+  /// Whether to memory-map the voxel data of scalar volumes in raw-encoded NRRD files
+  /// instead of reading it into memory. Voxels are only read from disk when they are
+  /// accessed, which allows quick loading and viewing of very large volumes.
+  /// Disabled by default.
+  vtkSetMacro(UseMemoryMapping, int);
+  vtkGetMacro(UseMemoryMapping, int);
+  vtkBooleanMacro(UseMemoryMapping, int);
+
   /// Return true if the reference node is supported by the storage node
   bool CanReadInReferenceNode(vtkMRMLNode* refNode) override;
   bool CanWriteFromReferenceNode(vtkMRMLNode* refNode) override;
@@ -105,6 +115,14 @@ protected:
 
   void ConvertSpatialVectorVoxelsBetweenRasLps(vtkImageData* imageData);
 
+  /// Read a scalar volume from a NRRD file, using memory mapping if possible.
+  /// Returns -1 if the file cannot be read this way and the generic reader has to be used.
+  int ReadMemoryMappedNRRD(vtkMRMLScalarVolumeNode* volNode, const std::string& fullName);
+
+  /// Copy memory-mapped voxels of the image into memory if writing the file
+  /// may overwrite the file that the voxels are mapped from.
+  void DetachMemoryMappedScalars(vtkImageData* imageData, const std::string& fileName);
+
   /// Read data and set it in the referenced node
   int ReadDataInternal(vtkMRMLNode *refNode) override;
 
@@ -114,6 +132,7 @@ protected:
   int CenterImage;
   int SingleFile;
   int UseOrientationFromFile;
+  int UseMemoryMapping;
 
 };
 
@@ -4,6 +4,7 @@
 
 // VTK includes
 #include <vtkObjectFactory.h>
+#include <vtkStringArray.h>
 
 vtkStandardNewMacro ( vtkURIHandler );
 vtkCxxSetObjectMacro( vtkURIHandler, PermissionPrompter, vtkPermissionPrompter );
@@ -16,6 +17,7 @@ vtkURIHandler::vtkURIHandler()
   this->Prefix = nullptr;
   this->Name = nullptr;
   this->HostName = nullptr;
+  this->MaximumNumberOfParallelTransfers = 4;
 }
 
 
@@ -47,6 +49,7 @@ vtkURIHandler::~vtkURIHandler()
 void vtkURIHandler::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf ( os, indent );
+  os << indent << "MaximumNumberOfParallelTransfers: " << this->MaximumNumberOfParallelTransfers << "\n";
 }
 
 
@@ -111,6 +114,22 @@ void vtkURIHandler::StageFileWrite ( const char * vtkNotUsed( source ), const ch
 {
 }
 
+//----------------------------------------------------------------------------
+int vtkURIHandler::StageFilesRead(vtkStringArray* sources, vtkStringArray* destinations)
+{
+  if (sources == nullptr || destinations == nullptr
+    || sources->GetNumberOfValues() != destinations->GetNumberOfValues())
+    {
+    vtkErrorMacro("StageFilesRead: sources and destinations must be valid and contain the same number of values");
+    return 0;
+    }
+  for (vtkIdType i = 0; i < sources->GetNumberOfValues(); i++)
+    {
+    this->StageFileRead(sources->GetValue(i).c_str(), destinations->GetValue(i).c_str());
+    }
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 void vtkURIHandler::StageFileRead(const char * vtkNotUsed( source ),
                              const char * vtkNotUsed( destination ),
@@ -4,6 +4,7 @@
 // MRML includes
 #include "vtkMRML.h"
 class vtkPermissionPrompter;
+class vtkStringArray;
 
 // VTK includes
 #include <vtkObject.h>
@@ -40,6 +41,19 @@ public:
                               const char *hostname,
                               const char *sessionID );
 
+  ///
+  /// Download multiple files. sources and destinations must contain the same
+  /// number of values. Handlers that support it perform up to
+  /// MaximumNumberOfParallelTransfers transfers at the same time, the default
+  /// implementation calls StageFileRead for each file.
+  /// Returns 1 if all files were downloaded successfully, 0 otherwise.
+  virtual int StageFilesRead(vtkStringArray* sources, vtkStringArray* destinations);
+
+  ///
+  /// Maximum number of transfers that StageFilesRead may run at the same time.
+  vtkGetMacro ( MaximumNumberOfParallelTransfers, int );
+  vtkSetClampMacro ( MaximumNumberOfParallelTransfers, int, 1, 64 );
+
   /// need something that goes the other way too...
 
   ///
@@ -96,6 +110,7 @@ public:
   char *Prefix;
   char *Name;
   char *HostName;
+  int MaximumNumberOfParallelTransfers;
 
 };
 
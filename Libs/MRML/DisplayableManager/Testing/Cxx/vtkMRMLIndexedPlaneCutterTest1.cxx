@@ -0,0 +1,259 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLDisplayableManager includes
+#include <vtkMRMLIndexedPlaneCutter.h>
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+
+// VTK includes
+#include <vtkVersion.h> // must precede reference to VTK_MAJOR_VERSION
+#include <vtkCellArray.h>
+#include <vtkCutter.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPlane.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
+#include <vtkCompositeDataGeometryFilter.h>
+#include <vtkPlaneCutter.h>
+#endif
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+const int NUMBER_OF_SLICES = 20;
+
+//----------------------------------------------------------------------------
+double GetTotalLineLength(vtkPolyData* polyData)
+{
+  double totalLength = 0.0;
+  vtkCellArray* lines = polyData->GetLines();
+  lines->InitTraversal();
+  vtkIdType npts = 0;
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 90)
+  const vtkIdType* pts = nullptr;
+#else
+  vtkIdType* pts = nullptr;
+#endif
+  while (lines->GetNextCell(npts, pts))
+    {
+    for (vtkIdType i = 0; i + 1 < npts; ++i)
+      {
+      double point1[3] = { 0.0, 0.0, 0.0 };
+      double point2[3] = { 0.0, 0.0, 0.0 };
+      polyData->GetPoint(pts[i], point1);
+      polyData->GetPoint(pts[i + 1], point2);
+      totalLength += sqrt(vtkMath::Distance2BetweenPoints(point1, point2));
+      }
+    }
+  return totalLength;
+}
+
+//----------------------------------------------------------------------------
+double GetSliceOffset(int sliceIndex)
+{
+  // Slices through the sphere of radius 50, avoiding exact hits of sphere vertices
+  return -45.0 + 90.0 * (sliceIndex + 0.37) / NUMBER_OF_SLICES;
+}
+
+//----------------------------------------------------------------------------
+int TestIndexReuse()
+{
+  vtkNew<vtkSphereSource> sphereSource;
+  sphereSource->SetRadius(50.0);
+  sphereSource->SetThetaResolution(64);
+  sphereSource->SetPhiResolution(64);
+  sphereSource->Update();
+  vtkNew<vtkPolyData> sphere;
+  sphere->DeepCopy(sphereSource->GetOutput());
+
+  vtkNew<vtkPlane> plane;
+  plane->SetNormal(0.2, 0.3, 0.9);
+  plane->SetOrigin(0.0, 0.0, 10.0);
+  vtkNew<vtkMRMLIndexedPlaneCutter> cutter;
+  cutter->SetInputData(sphere);
+  cutter->SetPlane(plane);
+  cutter->Update();
+  CHECK_BOOL(cutter->GetIndexRebuilt(), true);
+
+  // Compare with vtkCutter
+  vtkNew<vtkCutter> referenceCutter;
+  referenceCutter->SetCutFunction(plane);
+  referenceCutter->SetGenerateCutScalars(0);
+  referenceCutter->SetInputData(sphere);
+  for (int sliceIndex = 0; sliceIndex < NUMBER_OF_SLICES; ++sliceIndex)
+    {
+    plane->SetOrigin(0.0, 0.0, GetSliceOffset(sliceIndex));
+    cutter->Update();
+    referenceCutter->Update();
+    CHECK_BOOL(cutter->GetIndexRebuilt(), false);
+    CHECK_BOOL(cutter->GetOutput()->GetNumberOfLines() > 0, true);
+    CHECK_DOUBLE_TOLERANCE(GetTotalLineLength(cutter->GetOutput()), GetTotalLineLength(referenceCutter->GetOutput()), 1e-3);
+    }
+
+  // Flipped normal reuses the index
+  plane->SetNormal(-0.2, -0.3, -0.9);
+  cutter->Update();
+  CHECK_BOOL(cutter->GetIndexRebuilt(), false);
+  CHECK_BOOL(cutter->GetOutput()->GetNumberOfLines() > 0, true);
+
+  // Different normal or modified input rebuilds the index
+  plane->SetNormal(1.0, 0.0, 0.0);
+  cutter->Update();
+  CHECK_BOOL(cutter->GetIndexRebuilt(), true);
+  sphere->GetPoints()->Modified();
+  cutter->Update();
+  CHECK_BOOL(cutter->GetIndexRebuilt(), true);
+  cutter->Update();
+  CHECK_BOOL(cutter->GetIndexRebuilt(), false);
+
+  // Plane outside the mesh
+  plane->SetOrigin(100.0, 0.0, 0.0);
+  cutter->Update();
+  CHECK_INT(cutter->GetOutput()->GetNumberOfLines(), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestNonConvexPolygon()
+{
+  // U-shaped polygon in the XZ plane, cut by the z = 1 plane
+  vtkNew<vtkPoints> points;
+  points->InsertNextPoint(0.0, 0.0, 0.0);
+  points->InsertNextPoint(3.0, 0.0, 0.0);
+  points->InsertNextPoint(3.0, 0.0, 2.0);
+  points->InsertNextPoint(2.0, 0.0, 2.0);
+  points->InsertNextPoint(2.0, 0.0, 0.5);
+  points->InsertNextPoint(1.0, 0.0, 0.5);
+  points->InsertNextPoint(1.0, 0.0, 2.0);
+  points->InsertNextPoint(0.0, 0.0, 2.0);
+  vtkNew<vtkCellArray> polys;
+  vtkIdType pointIds[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+  polys->InsertNextCell(8, pointIds);
+  vtkNew<vtkPolyData> polygon;
+  polygon->SetPoints(points);
+  polygon->SetPolys(polys);
+
+  vtkNew<vtkPlane> plane;
+  plane->SetNormal(0.0, 0.0, 1.0);
+  plane->SetOrigin(0.0, 0.0, 1.0);
+  vtkNew<vtkMRMLIndexedPlaneCutter> cutter;
+  cutter->SetInputData(polygon);
+  cutter->SetPlane(plane);
+  cutter->Update();
+  CHECK_INT(cutter->GetOutput()->GetNumberOfLines(), 2);
+  CHECK_DOUBLE_TOLERANCE(GetTotalLineLength(cutter->GetOutput()), 2.0, 1e-9);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestSliceScrollPerformance(int resolution)
+{
+  vtkNew<vtkSphereSource> sphereSource;
+  sphereSource->SetRadius(50.0);
+  sphereSource->SetThetaResolution(resolution);
+  sphereSource->SetPhiResolution(resolution);
+  sphereSource->Update();
+  vtkPolyData* sphere = sphereSource->GetOutput();
+
+  vtkNew<vtkPlane> plane;
+  plane->SetNormal(0.0, 0.0, 1.0);
+  vtkNew<vtkTimerLog> timer;
+
+  // Indexed cutter
+  vtkNew<vtkMRMLIndexedPlaneCutter> cutter;
+  cutter->SetInputData(sphere);
+  cutter->SetPlane(plane);
+  plane->SetOrigin(0.0, 0.0, GetSliceOffset(0));
+  timer->StartTimer();
+  cutter->Update();
+  timer->StopTimer();
+  double indexBuildTime = timer->GetElapsedTime();
+  vtkIdType numberOfVisitedCells = 0;
+  timer->StartTimer();
+  for (int sliceIndex = 1; sliceIndex < NUMBER_OF_SLICES; ++sliceIndex)
+    {
+    plane->SetOrigin(0.0, 0.0, GetSliceOffset(sliceIndex));
+    cutter->Update();
+    numberOfVisitedCells += cutter->GetNumberOfVisitedCells();
+    }
+  timer->StopTimer();
+  double indexedTime = timer->GetElapsedTime() / (NUMBER_OF_SLICES - 1);
+
+  // Only a small fraction of cells are visited in each slice
+  vtkIdType numberOfCells = sphere->GetNumberOfCells();
+  if (resolution >= 256 && numberOfVisitedCells / (NUMBER_OF_SLICES - 1) > numberOfCells / 10)
+    {
+    std::cerr << "Line " << __LINE__ << ": too many cells are visited per slice: "
+      << numberOfVisitedCells / (NUMBER_OF_SLICES - 1) << " (number of cells: " << numberOfCells << ")" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Plane cutter, as used before indexing was introduced
+  double referenceTime = 0.0;
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
+  vtkNew<vtkPlaneCutter> referenceCutter;
+  referenceCutter->SetInputData(sphere);
+  referenceCutter->SetPlane(plane);
+  referenceCutter->BuildTreeOff();
+  vtkNew<vtkCompositeDataGeometryFilter> geometryFilter;
+  geometryFilter->SetInputConnection(referenceCutter->GetOutputPort());
+#else
+  vtkNew<vtkCutter> referenceCutter;
+  referenceCutter->SetInputData(sphere);
+  referenceCutter->SetCutFunction(plane);
+  referenceCutter->SetGenerateCutScalars(0);
+  vtkCutter* geometryFilter = referenceCutter;
+#endif
+  timer->StartTimer();
+  for (int sliceIndex = 1; sliceIndex < NUMBER_OF_SLICES; ++sliceIndex)
+    {
+    plane->SetOrigin(0.0, 0.0, GetSliceOffset(sliceIndex));
+    geometryFilter->Update();
+    }
+  timer->StopTimer();
+  referenceTime = timer->GetElapsedTime() / (NUMBER_OF_SLICES - 1);
+
+  std::cout << "Number of triangles: " << numberOfCells
+    << "  Index build: " << indexBuildTime * 1000.0 << " ms"
+    << "  Indexed cut: " << indexedTime * 1000.0 << " ms/slice"
+    << "  Visited cells: " << numberOfVisitedCells / (NUMBER_OF_SLICES - 1) << "/slice"
+    << "  Plane cutter: " << referenceTime * 1000.0 << " ms/slice" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLIndexedPlaneCutterTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestIndexReuse());
+  CHECK_EXIT_SUCCESS(TestNonConvexPolygon());
+  CHECK_EXIT_SUCCESS(TestSliceScrollPerformance(64));
+  CHECK_EXIT_SUCCESS(TestSliceScrollPerformance(256));
+  CHECK_EXIT_SUCCESS(TestSliceScrollPerformance(1024));
+  return EXIT_SUCCESS;
+}
@@ -29,6 +29,7 @@
 // MRML includes
 #include <vtkMRMLAbstractViewNode.h>
 #include <vtkMRMLInteractionNode.h>
+#include <vtkMRMLPerformanceTracer.h>
 #include <vtkMRMLScene.h>
 #include <vtkMRMLSelectionNode.h>
 
@@ -831,6 +832,7 @@ void vtkMRMLAbstractDisplayableManager::RequestRender()
 
   if (this->Internal->UpdateFromMRMLRequested)
     {
+    MRML_TRACE_SCOPE("DisplayableManager::UpdateFromMRML", this->GetClassName());
     this->UpdateFromMRML();
     }
 
@@ -0,0 +1,429 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkMRMLIndexedPlaneCutter.h"
+
+// VTK includes
+#include <vtkVersion.h> // must precede reference to VTK_MAJOR_VERSION
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkCutter.h>
+#include <vtkDataArray.h>
+#include <vtkInformation.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPlane.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkMRMLIndexedPlaneCutter);
+
+//----------------------------------------------------------------------------
+class vtkMRMLIndexedPlaneCutter::vtkInternal
+{
+public:
+  struct CellInterval
+    {
+    double Minimum;
+    double Maximum;
+    vtkIdType CellId;
+    bool operator<(const CellInterval& other) const { return this->Minimum < other.Minimum; }
+    };
+
+  /// Cells whose extent along the normal is in the same power-of-two range.
+  /// Grouping keeps the search range small even if a few cells are very large.
+  struct CellGroup
+    {
+    double MaximumExtent{ 0.0 };
+    std::vector<CellInterval> Cells;
+    };
+
+  void Clear()
+    {
+    this->IndexedInput = nullptr;
+    this->IndexedInputMTime = 0;
+    this->PointDistances.clear();
+    this->CellGroups.clear();
+    }
+
+  bool IsValid(vtkPolyData* input, const double normal[3])
+    {
+    if (!this->IndexedInput || this->IndexedInput != input || this->IndexedInputMTime != input->GetMTime())
+      {
+      return false;
+      }
+    // Index can be used for the opposite normal direction as well
+    return fabs(fabs(vtkMath::Dot(normal, this->Normal)) - 1.0) < 1e-9;
+    }
+
+  void Build(vtkPolyData* input, const double normal[3]);
+
+  vtkWeakPointer<vtkPolyData> IndexedInput;
+  vtkMTimeType IndexedInputMTime{ 0 };
+  double Normal[3]{ 0.0, 0.0, 1.0 };
+  std::vector<double> PointDistances;
+  std::vector<CellGroup> CellGroups;
+
+  vtkNew<vtkCutter> Cutter;
+};
+
+//----------------------------------------------------------------------------
+void vtkMRMLIndexedPlaneCutter::vtkInternal::Build(vtkPolyData* input, const double normal[3])
+{
+  this->Clear();
+  this->Normal[0] = normal[0];
+  this->Normal[1] = normal[1];
+  this->Normal[2] = normal[2];
+
+  vtkIdType numberOfPoints = input->GetNumberOfPoints();
+  this->PointDistances.resize(numberOfPoints);
+  double point[3] = { 0.0, 0.0, 0.0 };
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    input->GetPoint(pointId, point);
+    this->PointDistances[pointId] = vtkMath::Dot(point, this->Normal);
+    }
+
+  std::map<int, size_t> groupIndexByExponent;
+  vtkIdType numberOfCells = input->GetNumberOfCells();
+  for (vtkIdType cellId = 0; cellId < numberOfCells; ++cellId)
+    {
+    vtkIdType npts = 0;
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 90)
+    const vtkIdType* pts = nullptr;
+#else
+    vtkIdType* pts = nullptr;
+#endif
+    input->GetCellPoints(cellId, npts, pts);
+    if (npts < 3)
+      {
+      continue;
+      }
+    CellInterval interval;
+    interval.Minimum = this->PointDistances[pts[0]];
+    interval.Maximum = interval.Minimum;
+    interval.CellId = cellId;
+    for (vtkIdType i = 1; i < npts; ++i)
+      {
+      interval.Minimum = std::min(interval.Minimum, this->PointDistances[pts[i]]);
+      interval.Maximum = std::max(interval.Maximum, this->PointDistances[pts[i]]);
+      }
+    double extent = interval.Maximum - interval.Minimum;
+    int exponent = 0;
+    frexp(extent, &exponent); // exponent is 0 for zero extent
+    auto groupIt = groupIndexByExponent.find(exponent);
+    if (groupIt == groupIndexByExponent.end())
+      {
+      groupIt = groupIndexByExponent.insert(std::make_pair(exponent, this->CellGroups.size())).first;
+      this->CellGroups.emplace_back();
+      }
+    CellGroup& group = this->CellGroups[groupIt->second];
+    group.MaximumExtent = std::max(group.MaximumExtent, extent);
+    group.Cells.push_back(interval);
+    }
+
+  for (CellGroup& group : this->CellGroups)
+    {
+    std::sort(group.Cells.begin(), group.Cells.end());
+    }
+
+  this->IndexedInput = input;
+  this->IndexedInputMTime = input->GetMTime();
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLIndexedPlaneCutter::vtkMRMLIndexedPlaneCutter()
+  : Plane(nullptr)
+  , UseIndex(true)
+  , IndexRebuilt(false)
+  , NumberOfVisitedCells(0)
+{
+  this->Internal = new vtkInternal;
+  this->Internal->Cutter->SetGenerateCutScalars(0);
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLIndexedPlaneCutter::~vtkMRMLIndexedPlaneCutter()
+{
+  this->SetPlane(nullptr);
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLIndexedPlaneCutter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Plane: " << this->Plane << "\n";
+  os << indent << "UseIndex: " << (this->UseIndex ? "true" : "false") << "\n";
+  os << indent << "IndexRebuilt: " << (this->IndexRebuilt ? "true" : "false") << "\n";
+  os << indent << "NumberOfVisitedCells: " << this->NumberOfVisitedCells << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLIndexedPlaneCutter::SetPlane(vtkPlane* plane)
+{
+  if (this->Plane == plane)
+    {
+    return;
+    }
+  if (this->Plane)
+    {
+    this->Plane->UnRegister(this);
+    }
+  this->Plane = plane;
+  if (this->Plane)
+    {
+    this->Plane->Register(this);
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkMRMLIndexedPlaneCutter::GetMTime()
+{
+  vtkMTimeType mTime = this->Superclass::GetMTime();
+  if (this->Plane)
+    {
+    mTime = std::max(mTime, this->Plane->GetMTime());
+    }
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLIndexedPlaneCutter::ClearIndex()
+{
+  this->Internal->Clear();
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLIndexedPlaneCutter::FillInputPortInformation(int vtkNotUsed(port), vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkDataSet");
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLIndexedPlaneCutter::IsIndexable(vtkDataSet* input)
+{
+  vtkPolyData* polyData = vtkPolyData::SafeDownCast(input);
+  if (!polyData || !polyData->GetPoints())
+    {
+    return false;
+    }
+  return polyData->GetNumberOfVerts() == 0 && polyData->GetNumberOfLines() == 0 && polyData->GetNumberOfStrips() == 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLIndexedPlaneCutter::CutWithoutIndex(vtkDataSet* input, vtkPolyData* output)
+{
+  this->Internal->Cutter->SetCutFunction(this->Plane);
+  this->Internal->Cutter->SetInputData(input);
+  this->Internal->Cutter->Update();
+  output->ShallowCopy(this->Internal->Cutter->GetOutput());
+  // Do not keep a reference to the input mesh
+  this->Internal->Cutter->SetInputData(nullptr);
+  this->NumberOfVisitedCells = input->GetNumberOfCells();
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLIndexedPlaneCutter::RequestData(vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** inputVector, vtkInformationVector* outputVector)
+{
+  vtkDataSet* input = vtkDataSet::GetData(inputVector[0]);
+  vtkPolyData* output = vtkPolyData::GetData(outputVector);
+  this->IndexRebuilt = false;
+  this->NumberOfVisitedCells = 0;
+  if (!input || !output)
+    {
+    vtkErrorMacro("RequestData failed: invalid input or output");
+    return 0;
+    }
+  if (!this->Plane)
+    {
+    vtkErrorMacro("RequestData failed: plane is not set");
+    return 0;
+    }
+  if (input->GetNumberOfPoints() < 1 || input->GetNumberOfCells() < 1)
+    {
+    return 1;
+    }
+  if (!this->UseIndex || !vtkMRMLIndexedPlaneCutter::IsIndexable(input))
+    {
+    this->CutWithoutIndex(input, output);
+    return 1;
+    }
+
+  vtkPolyData* polyData = vtkPolyData::SafeDownCast(input);
+  double normal[3] = { 0.0, 0.0, 1.0 };
+  this->Plane->GetNormal(normal);
+  if (vtkMath::Normalize(normal) == 0.0)
+    {
+    vtkErrorMacro("RequestData failed: invalid plane normal");
+    return 0;
+    }
+  if (!this->Internal->IsValid(polyData, normal))
+    {
+    this->Internal->Build(polyData, normal);
+    this->IndexRebuilt = true;
+    }
+  const std::vector<double>& pointDistances = this->Internal->PointDistances;
+  const double planeDistance = vtkMath::Dot(this->Plane->GetOrigin(), this->Internal->Normal);
+  const vtkIdType numberOfInputPoints = polyData->GetNumberOfPoints();
+
+  vtkPoints* inputPoints = polyData->GetPoints();
+  vtkPointData* inputPointData = polyData->GetPointData();
+  vtkCellData* inputCellData = polyData->GetCellData();
+
+  vtkNew<vtkPoints> outputPoints;
+  outputPoints->SetDataType(inputPoints->GetDataType());
+  vtkNew<vtkCellArray> outputLines;
+  vtkPointData* outputPointData = output->GetPointData();
+  vtkCellData* outputCellData = output->GetCellData();
+  outputPointData->InterpolateAllocate(inputPointData);
+  outputCellData->CopyAllocate(inputCellData);
+
+  // Intersection points are shared between neighbor cells. Points are identified by
+  // the input edge (smaller point ID first) or by the input point if it lies in the plane.
+  std::unordered_map<vtkTypeUInt64, vtkIdType> outputPointIdByEdge;
+  auto getIntersectionPoint = [&](vtkIdType pointId1, vtkIdType pointId2) -> vtkIdType
+    {
+    vtkIdType lowId = std::min(pointId1, pointId2);
+    vtkIdType highId = std::max(pointId1, pointId2);
+    double lowDistance = pointDistances[lowId] - planeDistance;
+    double highDistance = pointDistances[highId] - planeDistance;
+    if (lowDistance == 0.0)
+      {
+      highId = lowId;
+      }
+    else if (highDistance == 0.0)
+      {
+      lowId = highId;
+      }
+    vtkTypeUInt64 key = static_cast<vtkTypeUInt64>(lowId) * static_cast<vtkTypeUInt64>(numberOfInputPoints)
+      + static_cast<vtkTypeUInt64>(highId);
+    auto pointIt = outputPointIdByEdge.find(key);
+    if (pointIt != outputPointIdByEdge.end())
+      {
+      return pointIt->second;
+      }
+    double t = (lowId == highId ? 0.0 : -lowDistance / (highDistance - lowDistance));
+    double lowPoint[3] = { 0.0, 0.0, 0.0 };
+    double highPoint[3] = { 0.0, 0.0, 0.0 };
+    inputPoints->GetPoint(lowId, lowPoint);
+    inputPoints->GetPoint(highId, highPoint);
+    double intersectionPoint[3] =
+      {
+      lowPoint[0] + t * (highPoint[0] - lowPoint[0]),
+      lowPoint[1] + t * (highPoint[1] - lowPoint[1]),
+      lowPoint[2] + t * (highPoint[2] - lowPoint[2])
+      };
+    vtkIdType outputPointId = outputPoints->InsertNextPoint(intersectionPoint);
+    outputPointData->InterpolateEdge(inputPointData, outputPointId, lowId, highId, t);
+    outputPointIdByEdge[key] = outputPointId;
+    return outputPointId;
+    };
+
+  std::vector<vtkIdType> intersectionPointIds;
+  for (const vtkInternal::CellGroup& group : this->Internal->CellGroups)
+    {
+    // Only cells that have minimum distance in [planeDistance - MaximumExtent, planeDistance] may intersect the plane
+    vtkInternal::CellInterval searchInterval;
+    searchInterval.Minimum = planeDistance - group.MaximumExtent;
+    auto cellIt = std::lower_bound(group.Cells.begin(), group.Cells.end(), searchInterval);
+    for (; cellIt != group.Cells.end() && cellIt->Minimum <= planeDistance; ++cellIt)
+      {
+      this->NumberOfVisitedCells++;
+      if (cellIt->Maximum < planeDistance)
+        {
+        continue;
+        }
+      vtkIdType npts = 0;
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 90)
+      const vtkIdType* pts = nullptr;
+#else
+      vtkIdType* pts = nullptr;
+#endif
+      polyData->GetCellPoints(cellIt->CellId, npts, pts);
+
+      // The contour is the boundary of the region below the plane
+      intersectionPointIds.clear();
+      for (vtkIdType i = 0; i < npts; ++i)
+        {
+        vtkIdType pointId1 = pts[i];
+        vtkIdType pointId2 = pts[(i + 1) % npts];
+        if ((pointDistances[pointId1] >= planeDistance) != (pointDistances[pointId2] >= planeDistance))
+          {
+          intersectionPointIds.push_back(getIntersectionPoint(pointId1, pointId2));
+          }
+        }
+      if (intersectionPointIds.size() > 2)
+        {
+        // Non-convex polygon: intersection points are collinear, line segments connect
+        // every second pair of points along the intersection line.
+        double bounds[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+        double point[3] = { 0.0, 0.0, 0.0 };
+        for (vtkIdType pointId : intersectionPointIds)
+          {
+          outputPoints->GetPoint(pointId, point);
+          for (int axis = 0; axis < 3; ++axis)
+            {
+            bounds[axis * 2] = std::min(bounds[axis * 2], point[axis]);
+            bounds[axis * 2 + 1] = std::max(bounds[axis * 2 + 1], point[axis]);
+            }
+          }
+        int sortAxis = 0;
+        for (int axis = 1; axis < 3; ++axis)
+          {
+          if (bounds[axis * 2 + 1] - bounds[axis * 2] > bounds[sortAxis * 2 + 1] - bounds[sortAxis * 2])
+            {
+            sortAxis = axis;
+            }
+          }
+        std::sort(intersectionPointIds.begin(), intersectionPointIds.end(),
+          [&](vtkIdType a, vtkIdType b)
+            {
+            return outputPoints->GetData()->GetComponent(a, sortAxis) < outputPoints->GetData()->GetComponent(b, sortAxis);
+            });
+        }
+      for (size_t i = 0; i + 1 < intersectionPointIds.size(); i += 2)
+        {
+        if (intersectionPointIds[i] == intersectionPointIds[i + 1])
+          {
+          // the cell touches the plane in a single point
+          continue;
+          }
+        vtkIdType linePointIds[2] = { intersectionPointIds[i], intersectionPointIds[i + 1] };
+        vtkIdType outputCellId = outputLines->InsertNextCell(2, linePointIds);
+        outputCellData->CopyData(inputCellData, cellIt->CellId, outputCellId);
+        }
+      }
+    }
+
+  output->SetPoints(outputPoints);
+  output->SetLines(outputLines);
+  output->Squeeze();
+  return 1;
+}
@@ -0,0 +1,104 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+/**
+ * @class   vtkMRMLIndexedPlaneCutter
+ * @brief   Cut a surface mesh with a plane, reusing a cell index between cuts
+ *
+ * Computes the intersection of the input mesh with a plane, similarly to
+ * vtkPlaneCutter, but the output is a single vtkPolyData containing line cells.
+ * Point data is interpolated along the cut edges, cell data is copied from the cut cells.
+ *
+ * When the input is a polygonal mesh, the filter builds an index that stores the
+ * distance of each point along the plane normal and the cells sorted by their minimum
+ * distance. The index is kept as long as the input mesh is not modified and the plane
+ * normal does not change (a flipped normal is also accepted), therefore moving the plane
+ * along its normal (as it happens when scrolling through slices) only visits cells
+ * that may intersect the plane.
+ *
+ * Other input types (such as unstructured grids, or polydata containing vertices,
+ * lines, or triangle strips) are cut using vtkCutter, without indexing.
+ *
+ * @sa
+ * vtkPlaneCutter vtkCutter
+*/
+
+#ifndef vtkMRMLIndexedPlaneCutter_h
+#define vtkMRMLIndexedPlaneCutter_h
+
+#include "vtkMRMLDisplayableManagerExport.h" // For export macro
+
+// VTK includes
+#include <vtkPolyDataAlgorithm.h>
+
+class vtkPlane;
+
+class VTK_MRML_DISPLAYABLEMANAGER_EXPORT vtkMRMLIndexedPlaneCutter : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkMRMLIndexedPlaneCutter *New();
+  vtkTypeMacro(vtkMRMLIndexedPlaneCutter, vtkPolyDataAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Plane that is used for cutting the input mesh.
+  /// Modification of the plane is taken into account in the modified time of the filter.
+  virtual void SetPlane(vtkPlane* plane);
+  vtkGetObjectMacro(Plane, vtkPlane);
+
+  /// If enabled (default) then the cell index is built for polygonal inputs and reused
+  /// between cuts. If disabled then the input is cut using vtkCutter, visiting all cells in each update.
+  vtkSetMacro(UseIndex, bool);
+  vtkGetMacro(UseIndex, bool);
+  vtkBooleanMacro(UseIndex, bool);
+
+  /// Delete the cell index. It will be rebuilt in the next update, if needed.
+  void ClearIndex();
+
+  /// Returns true if the cell index was built or rebuilt during the last update.
+  vtkGetMacro(IndexRebuilt, bool);
+
+  /// Number of cells that were tested for intersection during the last update.
+  vtkGetMacro(NumberOfVisitedCells, vtkIdType);
+
+  /// Modified time includes the modified time of the plane.
+  vtkMTimeType GetMTime() override;
+
+protected:
+  vtkMRMLIndexedPlaneCutter();
+  ~vtkMRMLIndexedPlaneCutter() override;
+
+  int FillInputPortInformation(int port, vtkInformation* info) override;
+  int RequestData(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector) override;
+
+  /// Returns true if the input can be cut using the cell index.
+  static bool IsIndexable(vtkDataSet* input);
+
+  /// Cut input using vtkCutter.
+  void CutWithoutIndex(vtkDataSet* input, vtkPolyData* output);
+
+  vtkPlane* Plane;
+  bool UseIndex;
+  bool IndexRebuilt;
+  vtkIdType NumberOfVisitedCells;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkMRMLIndexedPlaneCutter(const vtkMRMLIndexedPlaneCutter&) = delete;
+  void operator=(const vtkMRMLIndexedPlaneCutter&) = delete;
+};
+
+#endif
@@ -24,6 +24,7 @@
 #include <vtkMRMLGlyphableVolumeDisplayNode.h>
 #include <vtkMRMLLinearTransformNode.h>
 #include <vtkMRMLModelNode.h>
+#include <vtkMRMLPerformanceTracer.h>
 #include <vtkMRMLProceduralColorNode.h>
 #include <vtkMRMLScalarVolumeDisplayNode.h>
 #include <vtkMRMLScene.h>
@@ -858,6 +859,7 @@ vtkAlgorithmOutput * vtkMRMLSliceLogic::GetImageDataConnection()
 //----------------------------------------------------------------------------
 void vtkMRMLSliceLogic::UpdateImageData ()
 {
+  MRML_TRACE_SCOPE("SliceLogic", "UpdateImageData");
   if (this->SliceNode->GetSliceResolutionMode() == vtkMRMLSliceNode::SliceResolutionMatch2DView)
     {
     this->ExtractModelTexture->SetInputConnection( this->Pipeline->Blend->GetOutputPort() );
@@ -943,6 +945,7 @@ bool vtkMRMLSliceLogic::UpdateBlendLayers(vtkImageBlend* blend, const std::deque
 //----------------------------------------------------------------------------
 void vtkMRMLSliceLogic::UpdatePipeline()
 {
+  MRML_TRACE_SCOPE("SliceLogic", "UpdatePipeline");
   int modified = 0;
   if ( this->SliceCompositeNode )
     {
@@ -5,9 +5,21 @@
 // MRML includes
 #include <vtkPermissionPrompter.h>
 
+// VTK includes
+#include <vtkNew.h>
+#include <vtkStringArray.h>
+
+// VTKsys includes
+#include <vtksys/SystemTools.hxx>
+
 // CURL includes
 #include <curl/curl.h>
 
+// STD includes
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
 #if defined(_MSC_VER)
 #pragma warning ( disable : 4786 )
 #endif
@@ -19,9 +31,43 @@ public:
   vtkInternal(vtkHTTPHandler* external);
   ~vtkInternal();
 
+  /// State of a single download in StageFilesRead
+  struct Transfer
+    {
+    std::string Source;
+    std::string Destination;
+    std::string PartialFileName;
+    std::string ValidatorFileName;
+    CURL* CurlHandle{ nullptr };
+    curl_slist* Headers{ nullptr };
+    FILE* File{ nullptr };
+    vtkTypeInt64 ResumeOffset{ 0 };
+    bool ResponseChecked{ false };
+    bool Restarted{ false };
+    /// Validators received in the response headers
+    std::string ETag;
+    std::string LastModified;
+    };
+
+  bool StartTransfer(CURLM* multiHandle, Transfer* transfer);
+  bool FinishTransfer(Transfer* transfer, CURLcode result);
+
+  static size_t WriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
+  static size_t HeaderCallback(char* buffer, size_t size, size_t nitems, void* userdata);
+  static vtkTypeInt64 GetFileSize(FILE* file);
+
+  /// Read the validator (ETag or Last-Modified value) stored for a partial file.
+  /// Returns empty string if there is no validator.
+  static std::string ReadValidator(const std::string& validatorFileName);
+  /// Store the validator of the response that is written into the partial file.
+  /// If the response has no usable validator then the validator file is removed,
+  /// so that the partial file will not be resumed.
+  static void WriteValidator(Transfer* transfer);
+
   vtkHTTPHandler* External;
   CURL* CurlHandle;
   int ForbidReuse;
+  bool ResumeEnabled;
 };
 
 //----------------------------------------------------------------------------
@@ -32,6 +78,7 @@ vtkHTTPHandler::vtkInternal::vtkInternal(vtkHTTPHandler* external):External(exte
 {
   this->CurlHandle = nullptr;
   this->ForbidReuse = 0;
+  this->ResumeEnabled = true;
 }
 
 //-----------------------------------------------------------------------------
@@ -40,6 +87,245 @@ vtkHTTPHandler::vtkInternal::~vtkInternal()
   this->CurlHandle = nullptr;
 }
 
+//----------------------------------------------------------------------------
+vtkTypeInt64 vtkHTTPHandler::vtkInternal::GetFileSize(FILE* file)
+{
+#if defined(_WIN32)
+  _fseeki64(file, 0, SEEK_END);
+  return static_cast<vtkTypeInt64>(_ftelli64(file));
+#else
+  fseeko(file, 0, SEEK_END);
+  return static_cast<vtkTypeInt64>(ftello(file));
+#endif
+}
+
+//----------------------------------------------------------------------------
+std::string vtkHTTPHandler::vtkInternal::ReadValidator(const std::string& validatorFileName)
+{
+  std::ifstream validatorFile(validatorFileName.c_str());
+  std::string validator;
+  if (validatorFile.is_open())
+    {
+    std::getline(validatorFile, validator);
+    }
+  return validator;
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPHandler::vtkInternal::WriteValidator(Transfer* transfer)
+{
+  // Weak ETags cannot be used in If-Range, use the modification time instead
+  std::string validator;
+  if (!transfer->ETag.empty() && transfer->ETag.compare(0, 2, "W/") != 0)
+    {
+    validator = transfer->ETag;
+    }
+  else
+    {
+    validator = transfer->LastModified;
+    }
+  if (validator.empty())
+    {
+    vtksys::SystemTools::RemoveFile(transfer->ValidatorFileName.c_str());
+    return;
+    }
+  std::ofstream validatorFile(transfer->ValidatorFileName.c_str(), std::ios::out | std::ios::trunc);
+  validatorFile << validator << std::endl;
+}
+
+//----------------------------------------------------------------------------
+size_t vtkHTTPHandler::vtkInternal::HeaderCallback(char* buffer, size_t size, size_t nitems, void* userdata)
+{
+  Transfer* transfer = static_cast<Transfer*>(userdata);
+  size_t length = size * nitems;
+  std::string line(buffer, length);
+  if (line.compare(0, 5, "HTTP/") == 0)
+    {
+    // status line of a new response (for example, after a redirect)
+    transfer->ETag.clear();
+    transfer->LastModified.clear();
+    return length;
+    }
+  std::string::size_type separatorPosition = line.find(':');
+  if (separatorPosition == std::string::npos)
+    {
+    return length;
+    }
+  std::string name = vtksys::SystemTools::LowerCase(line.substr(0, separatorPosition));
+  std::string value = vtksys::SystemTools::TrimWhitespace(line.substr(separatorPosition + 1));
+  if (name == "etag")
+    {
+    transfer->ETag = value;
+    }
+  else if (name == "last-modified")
+    {
+    transfer->LastModified = value;
+    }
+  return length;
+}
+
+//----------------------------------------------------------------------------
+size_t vtkHTTPHandler::vtkInternal::WriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata)
+{
+  Transfer* transfer = static_cast<Transfer*>(userdata);
+  if (!transfer->ResponseChecked)
+    {
+    transfer->ResponseChecked = true;
+    long responseCode = 0;
+    curl_easy_getinfo(transfer->CurlHandle, CURLINFO_RESPONSE_CODE, &responseCode);
+    if (transfer->ResumeOffset > 0 && responseCode != 206)
+      {
+      // The server sends the complete file instead of the requested range (the file
+      // has changed since the partial file was downloaded or ranges are not supported),
+      // therefore the partial file has to be overwritten.
+      transfer->File = freopen(transfer->PartialFileName.c_str(), "wb", transfer->File);
+      transfer->ResumeOffset = 0;
+      }
+    if (transfer->ResumeOffset == 0)
+      {
+      // Partial file is written from the beginning, store the validator of this response
+      vtkInternal::WriteValidator(transfer);
+      }
+    }
+  if (transfer->File == nullptr)
+    {
+    // returning a value different from the number of bytes aborts the transfer
+    return 0;
+    }
+  return fwrite(ptr, 1, size * nmemb, transfer->File);
+}
+
+//----------------------------------------------------------------------------
+bool vtkHTTPHandler::vtkInternal::StartTransfer(CURLM* multiHandle, Transfer* transfer)
+{
+  transfer->ResumeOffset = 0;
+  transfer->ResponseChecked = false;
+  transfer->ETag.clear();
+  transfer->LastModified.clear();
+  std::string validator;
+  if (this->ResumeEnabled)
+    {
+    validator = vtkInternal::ReadValidator(transfer->ValidatorFileName);
+    }
+  if (this->ResumeEnabled && !validator.empty())
+    {
+    transfer->File = fopen(transfer->PartialFileName.c_str(), "ab");
+    if (transfer->File)
+      {
+      transfer->ResumeOffset = vtkInternal::GetFileSize(transfer->File);
+      }
+    }
+  else
+    {
+    // Without a validator it cannot be checked that the partial file is
+    // part of the current version of the file, therefore it is discarded.
+    transfer->File = fopen(transfer->PartialFileName.c_str(), "wb");
+    }
+  if (transfer->File == nullptr)
+    {
+    vtkErrorWithObjectMacro(this->External, "StageFilesRead: failed to open file for writing: " << transfer->PartialFileName);
+    return false;
+    }
+
+  transfer->CurlHandle = curl_easy_init();
+  if (transfer->CurlHandle == nullptr)
+    {
+    vtkErrorWithObjectMacro(this->External, "StageFilesRead: unable to initialise curl");
+    fclose(transfer->File);
+    transfer->File = nullptr;
+    return false;
+    }
+  CURL* curlHandle = transfer->CurlHandle;
+  if (this->ForbidReuse)
+    {
+    curl_easy_setopt(curlHandle, CURLOPT_FORBID_REUSE, 1L);
+    }
+  curl_easy_setopt(curlHandle, CURLOPT_HTTPGET, 1L);
+  curl_easy_setopt(curlHandle, CURLOPT_URL, transfer->Source.c_str());
+  curl_easy_setopt(curlHandle, CURLOPT_FOLLOWLOCATION, 1L);
+  // do not write error pages into the file
+  curl_easy_setopt(curlHandle, CURLOPT_FAILONERROR, 1L);
+  curl_easy_setopt(curlHandle, CURLOPT_WRITEFUNCTION, vtkInternal::WriteCallback);
+  curl_easy_setopt(curlHandle, CURLOPT_WRITEDATA, transfer);
+  curl_easy_setopt(curlHandle, CURLOPT_PRIVATE, transfer);
+  // quick timeout during connection phase if URL is not accessible (e.g. blocked by a firewall)
+  curl_easy_setopt(curlHandle, CURLOPT_CONNECTTIMEOUT, 3L); // in seconds (type long)
+  curl_easy_setopt(curlHandle, CURLOPT_HEADERFUNCTION, vtkInternal::HeaderCallback);
+  curl_easy_setopt(curlHandle, CURLOPT_HEADERDATA, transfer);
+  if (transfer->ResumeOffset > 0)
+    {
+    // The server only sends the requested range if the file has not changed,
+    // otherwise it sends the complete file.
+    // CURLOPT_RANGE is used instead of CURLOPT_RESUME_FROM_LARGE, because with the latter
+    // curl aborts the transfer if the server sends the complete file (CURLE_RANGE_ERROR).
+    std::string ifRangeHeader = "If-Range: " + validator;
+    transfer->Headers = curl_slist_append(transfer->Headers, ifRangeHeader.c_str());
+    curl_easy_setopt(curlHandle, CURLOPT_HTTPHEADER, transfer->Headers);
+    std::string range = std::to_string(transfer->ResumeOffset) + "-";
+    curl_easy_setopt(curlHandle, CURLOPT_RANGE, range.c_str());
+    }
+  curl_multi_add_handle(multiHandle, curlHandle);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkHTTPHandler::vtkInternal::FinishTransfer(Transfer* transfer, CURLcode result)
+{
+  long responseCode = 0;
+  curl_easy_getinfo(transfer->CurlHandle, CURLINFO_RESPONSE_CODE, &responseCode);
+  curl_easy_cleanup(transfer->CurlHandle);
+  transfer->CurlHandle = nullptr;
+  curl_slist_free_all(transfer->Headers);
+  transfer->Headers = nullptr;
+  if (transfer->File)
+    {
+    fclose(transfer->File);
+    transfer->File = nullptr;
+    }
+
+  if (result == CURLE_OK)
+    {
+    vtksys::SystemTools::RemoveFile(transfer->Destination.c_str());
+    if (rename(transfer->PartialFileName.c_str(), transfer->Destination.c_str()) != 0)
+      {
+      vtkErrorWithObjectMacro(this->External, "StageFilesRead: failed to rename " << transfer->PartialFileName
+        << " to " << transfer->Destination);
+      return false;
+      }
+    vtksys::SystemTools::RemoveFile(transfer->ValidatorFileName.c_str());
+    vtkDebugWithObjectMacro(this->External, "StageFilesRead: successful return from curl for " << transfer->Source);
+    return true;
+    }
+
+  if (transfer->ResumeOffset > 0 && (responseCode == 416 || result == CURLE_RANGE_ERROR) && !transfer->Restarted)
+    {
+    // Range not satisfiable or the server did not accept the range request:
+    // the partial file cannot be resumed.
+    // Remove the partial file and download the complete file (only once).
+    vtksys::SystemTools::RemoveFile(transfer->PartialFileName.c_str());
+    vtksys::SystemTools::RemoveFile(transfer->ValidatorFileName.c_str());
+    transfer->Restarted = true;
+    return false;
+    }
+
+  vtkErrorWithObjectMacro(this->External, "StageFilesRead: error running curl for " << transfer->Source
+    << ": " << curl_easy_strerror(result) << " (HTTP response code: " << responseCode << ")");
+  if (!this->ResumeEnabled)
+    {
+    vtksys::SystemTools::RemoveFile(transfer->PartialFileName.c_str());
+    vtksys::SystemTools::RemoveFile(transfer->ValidatorFileName.c_str());
+    }
+  //--- in case the permissions were not correct and that's
+  //--- the reason the read command failed,
+  //--- reset the 'remember check' in the permissions
+  //--- prompter so that new login info  will be prompted.
+  if ( this->External->GetPermissionPrompter() != nullptr )
+    {
+    this->External->GetPermissionPrompter()->SetRemember ( 0 );
+    }
+  return false;
+}
+
 //----------------------------------------------------------------------------
 // vtkHTTPHandler methods
 
@@ -162,6 +448,35 @@ int vtkHTTPHandler::GetForbidReuse()
   return this->Internal->ForbidReuse;
 }
 
+//----------------------------------------------------------------------------
+void vtkHTTPHandler::SetResumeEnabled(bool enabled)
+{
+  if (this->Internal->ResumeEnabled == enabled)
+    {
+    return;
+    }
+  this->Internal->ResumeEnabled = enabled;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkHTTPHandler::GetResumeEnabled()
+{
+  return this->Internal->ResumeEnabled;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkHTTPHandler::GetPartialFileName(const std::string& destination)
+{
+  return destination + ".partial";
+}
+
+//----------------------------------------------------------------------------
+std::string vtkHTTPHandler::GetPartialFileValidatorName(const std::string& destination)
+{
+  return vtkHTTPHandler::GetPartialFileName(destination) + ".validator";
+}
+
 //----------------------------------------------------------------------------
 void vtkHTTPHandler::InitTransfer( )
 {
@@ -190,76 +505,102 @@ void vtkHTTPHandler::StageFileRead(const char * source, const char * destination
     vtkErrorMacro("StageFileRead: source or dest is null!");
     return;
     }
-  /*
-  if (this->LocalFile)
-    {
-    this->LocalFile->close();
-    delete this->LocalFile;
-    this->LocalFile = nullptr;
-    }
-  this->LocalFile = new std::ofstream(destination, std::ios::binary);
-  */
-  this->InitTransfer( );
-
+  vtkNew<vtkStringArray> sources;
+  sources->InsertNextValue(source);
+  vtkNew<vtkStringArray> destinations;
+  destinations->InsertNextValue(destination);
+  this->StageFilesRead(sources, destinations);
+}
 
-  if ( this->Internal->ForbidReuse )
+//----------------------------------------------------------------------------
+int vtkHTTPHandler::StageFilesRead(vtkStringArray* sources, vtkStringArray* destinations)
+{
+  if (sources == nullptr || destinations == nullptr
+    || sources->GetNumberOfValues() != destinations->GetNumberOfValues())
     {
-    curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_FORBID_REUSE, 1);
+    vtkErrorMacro("StageFilesRead: sources and destinations must be valid and contain the same number of values");
+    return 0;
     }
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_HTTPGET, 1);
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_URL, source);
-//  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_NOPROGRESS, false);
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_FOLLOWLOCATION, true);
-  // use the default curl write call back
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_WRITEFUNCTION, nullptr); // write_callback);
-  this->LocalFile = fopen(destination, "wb");
-  // output goes into LocalFile, must be  FILE*
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_WRITEDATA, this->LocalFile);
-//  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_PROGRESSDATA, nullptr);
-//  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_PROGRESSFUNCTION, ProgressCallback);
 
-  // quick timeout during connection phase if URL is not accessible (e.g. blocked by a firewall)
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_CONNECTTIMEOUT, 3); // in seconds (type long)
-
-  vtkDebugMacro("StageFileRead: about to do the curl download... source = " << source << ", dest = " << destination);
-  CURLcode retval = curl_easy_perform(this->Internal->CurlHandle);
-
-  if (retval == CURLE_OK)
-    {
-    vtkDebugMacro("StageFileRead: successful return from curl");
-    }
-  else if (retval == CURLE_BAD_FUNCTION_ARGUMENT)
+  curl_global_init(CURL_GLOBAL_ALL);
+  CURLM* multiHandle = curl_multi_init();
+  if (multiHandle == nullptr)
     {
-    vtkErrorMacro("StageFileRead: bad function argument to curl, did you init CurlHandle?");
+    vtkErrorMacro("StageFilesRead: unable to initialise curl");
+    return 0;
     }
-  else if (retval == CURLE_OUT_OF_MEMORY)
+
+  std::vector<vtkInternal::Transfer> transfers(sources->GetNumberOfValues());
+  for (vtkIdType i = 0; i < sources->GetNumberOfValues(); i++)
     {
-    vtkErrorMacro("StageFileRead: curl ran out of memory!");
+    transfers[i].Source = sources->GetValue(i);
+    transfers[i].Destination = destinations->GetValue(i);
+    transfers[i].PartialFileName = vtkHTTPHandler::GetPartialFileName(transfers[i].Destination);
+    transfers[i].ValidatorFileName = vtkHTTPHandler::GetPartialFileValidatorName(transfers[i].Destination);
     }
-  else
+
+  bool success = true;
+  size_t nextTransferIndex = 0;
+  int numberOfActiveTransfers = 0;
+  while (nextTransferIndex < transfers.size() || numberOfActiveTransfers > 0)
     {
-    const char *stringError = curl_easy_strerror(retval);
-    vtkErrorMacro("StageFileRead: error running curl: " << stringError);
-    //--- in case the permissions were not correct and that's
-    //--- the reason the read command failed,
-    //--- reset the 'remember check' in the permissions
-    //--- prompter so that new login info  will be prompted.
-    if ( this->GetPermissionPrompter() != nullptr )
+    // Start new transfers
+    while (numberOfActiveTransfers < this->MaximumNumberOfParallelTransfers && nextTransferIndex < transfers.size())
       {
-      this->GetPermissionPrompter()->SetRemember ( 0 );
+      vtkDebugMacro("StageFilesRead: about to do the curl download... source = " << transfers[nextTransferIndex].Source
+        << ", dest = " << transfers[nextTransferIndex].Destination);
+      if (this->Internal->StartTransfer(multiHandle, &transfers[nextTransferIndex]))
+        {
+        numberOfActiveTransfers++;
+        }
+      else
+        {
+        success = false;
+        }
+      nextTransferIndex++;
       }
-    }
-  this->CloseTransfer();
 
-  /*
-  this->LocalFile->close();
-  delete this->LocalFile;
-  this->LocalFile = nullptr;
-  */
-  if (this->LocalFile)
-    {
-    fclose(this->LocalFile);
+    // Transfer data
+    int numberOfRunningHandles = 0;
+    curl_multi_perform(multiHandle, &numberOfRunningHandles);
+    if (numberOfRunningHandles > 0)
+      {
+      int numberOfFileDescriptors = 0;
+      curl_multi_wait(multiHandle, nullptr, 0, 1000, &numberOfFileDescriptors);
+      }
+
+    // Process completed transfers
+    int numberOfMessagesLeft = 0;
+    while (CURLMsg* message = curl_multi_info_read(multiHandle, &numberOfMessagesLeft))
+      {
+      if (message->msg != CURLMSG_DONE)
+        {
+        continue;
+        }
+      vtkInternal::Transfer* transfer = nullptr;
+      curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, reinterpret_cast<char**>(&transfer));
+      CURLcode result = message->data.result;
+      curl_multi_remove_handle(multiHandle, message->easy_handle);
+      numberOfActiveTransfers--;
+      bool wasRestarted = transfer->Restarted;
+      if (this->Internal->FinishTransfer(transfer, result))
+        {
+        continue;
+        }
+      if (transfer->Restarted && !wasRestarted)
+        {
+        if (this->Internal->StartTransfer(multiHandle, transfer))
+          {
+          numberOfActiveTransfers++;
+          continue;
+          }
+        }
+      success = false;
+      }
     }
+
+  curl_multi_cleanup(multiHandle);
+  return success ? 1 : 0;
 }
 
 
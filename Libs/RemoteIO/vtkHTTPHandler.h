@@ -12,6 +12,9 @@
 // MRML includes
 #include "vtkURIHandler.h"
 
+// STD includes
+#include <string>
+
 class VTK_RemoteIO_EXPORT vtkHTTPHandler : public vtkURIHandler
 {
 public:
@@ -32,9 +35,32 @@ public:
   void SetForbidReuse(int value);
   int GetForbidReuse();
 
+  /// If enabled (default) then data is downloaded into a partial file next to the
+  /// destination file, which is renamed to the destination file when the download
+  /// is completed. If a partial file already exists (for example, because an earlier
+  /// download was interrupted) then only the remaining part is requested from the server.
+  /// The ETag or Last-Modified value of the response is stored next to the partial file and
+  /// the remaining part is only used if the file has not changed on the server since then
+  /// (If-Range request header). Partial files without a stored validator are downloaded again.
+  void SetResumeEnabled(bool enabled);
+  bool GetResumeEnabled();
+  vtkBooleanMacro(ResumeEnabled, bool);
+
+  /// Returns the name of the file that data is downloaded into before it is complete.
+  static std::string GetPartialFileName(const std::string& destination);
+
+  /// Returns the name of the file that stores the ETag or Last-Modified value
+  /// of the server response that the partial file was downloaded from.
+  static std::string GetPartialFileValidatorName(const std::string& destination);
+
   /// This function wraps curl functionality to download a specified URL to a specified dir
   void StageFileRead(const char * source, const char * destination) override;
   using vtkURIHandler::StageFileRead;
+
+  /// Download multiple files, running up to MaximumNumberOfParallelTransfers
+  /// transfers at the same time.
+  int StageFilesRead(vtkStringArray* sources, vtkStringArray* destinations) override;
+
   void StageFileWrite(const char * source, const char * destination) override;
   using vtkURIHandler::StageFileWrite;
   void InitTransfer () override;
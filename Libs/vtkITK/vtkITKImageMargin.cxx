@@ -34,6 +34,10 @@
 #include <itkCommand.h>
 #include <itkSignedMaurerDistanceMapImageFilter.h>
 
+/// STD includes
+#include <algorithm>
+#include <cmath>
+
 vtkStandardNewMacro(vtkITKImageMargin);
 
 //----------------------------------------------------------------------------
@@ -50,6 +54,7 @@ vtkITKImageMargin::~vtkITKImageMargin() = default;
 void vtkITKImageMargin::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
+  os << indent << "RestrictToEffectiveExtent: " << (this->RestrictToEffectiveExtent ? "true" : "false") << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -93,6 +98,73 @@ sdfMargin(itk::SmartPointer<ImageType> labelImage, int backgroundValue, double i
   return sdfTh->GetOutput();
 }
 
+//----------------------------------------------------------------------------
+/// Get the range of voxel indices that contains all the non-background voxels.
+/// \return False if all voxels are background
+template <class T>
+bool GetForegroundIndexExtent(T* inPtr, const int dims[3], int backgroundValue, int foregroundExtent[6])
+{
+  const T background = static_cast<T>(backgroundValue);
+  foregroundExtent[0] = dims[0];
+  foregroundExtent[1] = -1;
+  foregroundExtent[2] = dims[1];
+  foregroundExtent[3] = -1;
+  foregroundExtent[4] = dims[2];
+  foregroundExtent[5] = -1;
+  for (int k = 0; k < dims[2]; ++k)
+    {
+    for (int j = 0; j < dims[1]; ++j)
+      {
+      T* row = inPtr + (static_cast<vtkIdType>(k) * dims[1] + j) * dims[0];
+      int first = 0;
+      while (first < dims[0] && row[first] == background)
+        {
+        ++first;
+        }
+      if (first == dims[0])
+        {
+        continue;
+        }
+      int last = dims[0] - 1;
+      while (row[last] == background)
+        {
+        --last;
+        }
+      foregroundExtent[0] = std::min(foregroundExtent[0], first);
+      foregroundExtent[1] = std::max(foregroundExtent[1], last);
+      foregroundExtent[2] = std::min(foregroundExtent[2], j);
+      foregroundExtent[3] = std::max(foregroundExtent[3], j);
+      foregroundExtent[4] = std::min(foregroundExtent[4], k);
+      foregroundExtent[5] = std::max(foregroundExtent[5], k);
+      }
+    }
+  return foregroundExtent[1] >= 0;
+}
+
+//----------------------------------------------------------------------------
+/// Copy voxels between a region of an image buffer and a buffer that contains only that region
+template <class T>
+void CopyRegion(T* imagePtr, const int dims[3], const int regionExtent[6], T* regionPtr, bool copyFromImage)
+{
+  const int regionRowLength = regionExtent[1] - regionExtent[0] + 1;
+  for (int k = regionExtent[4]; k <= regionExtent[5]; ++k)
+    {
+    for (int j = regionExtent[2]; j <= regionExtent[3]; ++j)
+      {
+      T* imageRow = imagePtr + (static_cast<vtkIdType>(k) * dims[1] + j) * dims[0] + regionExtent[0];
+      if (copyFromImage)
+        {
+        std::copy(imageRow, imageRow + regionRowLength, regionPtr);
+        }
+      else
+        {
+        std::copy(regionPtr, regionPtr + regionRowLength, imageRow);
+        }
+      regionPtr += regionRowLength;
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 template <class T>
 void vtkITKImageMarginExecute(vtkITKImageMargin *self, vtkImageData* input,
@@ -105,6 +177,49 @@ void vtkITKImageMarginExecute(vtkITKImageMargin *self, vtkImageData* input,
     input->GetDimensions(dims);
     double spacing[3];
     input->GetSpacing(spacing);
+    const vtkIdType numberOfVoxels = static_cast<vtkIdType>(dims[0]) * dims[1] * dims[2];
+
+    double innerMarginDistance = self->GetInnerMarginVoxels();
+    double outerMarginDistance = self->GetOuterMarginVoxels();
+    if (self->GetCalculateMarginInMM())
+      {
+      innerMarginDistance = self->GetInnerMarginMM();
+      outerMarginDistance = self->GetOuterMarginMM();
+      }
+
+    // Region of the image where the distance map is computed
+    int regionExtent[6] = { 0, dims[0] - 1, 0, dims[1] - 1, 0, dims[2] - 1 };
+    if (self->GetRestrictToEffectiveExtent())
+      {
+      int foregroundExtent[6] = { 0, -1, 0, -1, 0, -1 };
+      if (!GetForegroundIndexExtent(inPtr, dims, self->GetBackgroundValue(), foregroundExtent))
+        {
+        // There is no foreground, therefore all voxels are farther from the surface than the outer margin
+        std::fill(outPtr, outPtr + numberOfVoxels, static_cast<T>(0));
+        return;
+        }
+      for (int i = 0; i < 3; ++i)
+        {
+        // Voxels that are farther from the foreground than the outer margin are always background in the output.
+        // One more voxel of padding is needed so that surface voxels are detected the same way as in the full image.
+        double voxelSize = (self->GetCalculateMarginInMM() ? std::abs(spacing[i]) : 1.0);
+        int padding = 1;
+        if (outerMarginDistance > 0.0 && voxelSize > 0.0)
+          {
+          padding += static_cast<int>(std::ceil(std::min(outerMarginDistance / voxelSize, static_cast<double>(dims[i]))));
+          }
+        regionExtent[2 * i] = std::max(0, foregroundExtent[2 * i] - padding);
+        regionExtent[2 * i + 1] = std::min(dims[i] - 1, foregroundExtent[2 * i + 1] + padding);
+        }
+      }
+    const int regionDims[3] =
+      {
+      regionExtent[1] - regionExtent[0] + 1,
+      regionExtent[3] - regionExtent[2] + 1,
+      regionExtent[5] - regionExtent[4] + 1
+      };
+    const vtkIdType numberOfRegionVoxels = static_cast<vtkIdType>(regionDims[0]) * regionDims[1] * regionDims[2];
+    const bool fullImage = (numberOfRegionVoxels == numberOfVoxels);
 
     // Wrap scalars into an ITK image
     // - mostly rely on defaults for spacing, origin etc for this filter
@@ -114,28 +229,39 @@ void vtkITKImageMarginExecute(vtkITKImageMargin *self, vtkImageData* input,
     typename ImageType::IndexType index;
     typename ImageType::SizeType size;
 
-    inImage->GetPixelContainer()->SetImportPointer(inPtr, dims[0] * dims[1] * dims[2], false);
     index[0] = index[1] = index[2] = 0;
     region.SetIndex(index);
-    size[0] = dims[0]; size[1] = dims[1]; size[2] = dims[2];
+    size[0] = regionDims[0]; size[1] = regionDims[1]; size[2] = regionDims[2];
     region.SetSize(size);
-    inImage->SetLargestPossibleRegion(region);
-    inImage->SetBufferedRegion(region);
+    inImage->SetRegions(region);
+    if (fullImage)
+      {
+      inImage->GetPixelContainer()->SetImportPointer(inPtr, numberOfVoxels, false);
+      }
+    else
+      {
+      inImage->Allocate();
+      CopyRegion(inPtr, dims, regionExtent, inImage->GetBufferPointer(), true);
+      }
 
-    double innerMarginDistance = self->GetInnerMarginVoxels();
-    double outerMarginDistance = self->GetOuterMarginVoxels();
     if (self->GetCalculateMarginInMM())
       {
       inImage->SetSpacing(spacing);
-      innerMarginDistance = self->GetInnerMarginMM();
-      outerMarginDistance = self->GetOuterMarginMM();
       }
 
     itk::SmartPointer<ImageType> outputImage;
     outputImage = sdfMargin<ImageType>(inImage, self->GetBackgroundValue(), innerMarginDistance, outerMarginDistance);
 
     // Copy to the output
-    memcpy(outPtr, outputImage->GetBufferPointer(), outputImage->GetBufferedRegion().GetNumberOfPixels() * sizeof(T));
+    if (fullImage)
+      {
+      memcpy(outPtr, outputImage->GetBufferPointer(), outputImage->GetBufferedRegion().GetNumberOfPixels() * sizeof(T));
+      }
+    else
+      {
+      std::fill(outPtr, outPtr + numberOfVoxels, static_cast<T>(0));
+      CopyRegion(outPtr, dims, regionExtent, outputImage->GetBufferPointer(), false);
+      }
     }
   catch (itk::ExceptionObject & err)
     {
@@ -69,6 +69,15 @@ class VTK_ITK_EXPORT vtkITKImageMargin : public vtkSimpleImageToImageFilter
   vtkGetMacro(InnerMarginVoxels, double);
   vtkSetMacro(InnerMarginVoxels, double);
 
+  /// If enabled, the distance map is computed only in the region that contains all foreground voxels,
+  /// padded by the outer margin. Voxels outside this region are farther from the surface than the outer margin,
+  /// therefore they are background in the output. Computation time and memory usage depend on the size of the
+  /// segmented region instead of the size of the whole image. The output is the same as without restriction.
+  /// Enabled by default.
+  vtkGetMacro(RestrictToEffectiveExtent, bool);
+  vtkSetMacro(RestrictToEffectiveExtent, bool);
+  vtkBooleanMacro(RestrictToEffectiveExtent, bool);
+
 protected:
   int BackgroundValue{0};
   bool CalculateMarginInMM{true};
@@ -76,6 +85,7 @@ protected:
   double InnerMarginMM{0.0};
   double OuterMarginVoxels{0.0};
   double InnerMarginVoxels{0.0};
+  bool RestrictToEffectiveExtent{true};
 
 protected:
   vtkITKImageMargin();
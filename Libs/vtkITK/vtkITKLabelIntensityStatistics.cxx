@@ -0,0 +1,473 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkITKLabelIntensityStatistics.h"
+
+// VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkLongArray.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+
+vtkStandardNewMacro(vtkITKLabelIntensityStatistics);
+
+//----------------------------------------------------------------------------
+vtkITKLabelIntensityStatistics::vtkITKLabelIntensityStatistics()
+{
+  this->SetNumberOfInputPorts(2);
+  this->ComputeMedian = true;
+}
+
+//----------------------------------------------------------------------------
+vtkITKLabelIntensityStatistics::~vtkITKLabelIntensityStatistics() = default;
+
+//----------------------------------------------------------------------------
+void vtkITKLabelIntensityStatistics::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "ComputeMedian: " << (this->ComputeMedian ? "true" : "false") << "\n";
+  os << indent << "Percentiles:";
+  for (double percentile : this->Percentiles)
+    {
+    os << " " << percentile;
+    }
+  os << "\n";
+}
+
+//----------------------------------------------------------------------------
+int vtkITKLabelIntensityStatistics::FillInputPortInformation(
+  int port, vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+  if (port == 1)
+    {
+    info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkITKLabelIntensityStatistics::SetIntensityData(vtkImageData* intensityImage)
+{
+  this->SetInputData(1, intensityImage);
+}
+
+//----------------------------------------------------------------------------
+void vtkITKLabelIntensityStatistics::SetIntensityConnection(vtkAlgorithmOutput* algOutput)
+{
+  this->SetInputConnection(1, algOutput);
+}
+
+//----------------------------------------------------------------------------
+void vtkITKLabelIntensityStatistics::AddPercentile(double percentile)
+{
+  if (percentile < 0.0 || percentile > 100.0)
+    {
+    vtkErrorMacro("AddPercentile: Percentile must be in the range of 0 to 100, got " << percentile);
+    return;
+    }
+  this->Percentiles.push_back(percentile);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkITKLabelIntensityStatistics::RemoveAllPercentiles()
+{
+  if (this->Percentiles.empty())
+    {
+    return;
+    }
+  this->Percentiles.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkITKLabelIntensityStatistics::GetNumberOfPercentiles()
+{
+  return static_cast<int>(this->Percentiles.size());
+}
+
+//----------------------------------------------------------------------------
+double vtkITKLabelIntensityStatistics::GetPercentile(int index)
+{
+  if (index < 0 || index >= static_cast<int>(this->Percentiles.size()))
+    {
+    vtkErrorMacro("GetPercentile: Invalid percentile index " << index);
+    return 0.0;
+    }
+  return this->Percentiles[index];
+}
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Accumulated intensity statistics of a single label
+template <class TIntensity>
+struct LabelAccumulator
+{
+  vtkIdType VoxelCount = 0;
+  double Sum = 0.0;
+  double SumOfSquares = 0.0;
+  double Minimum = VTK_DOUBLE_MAX;
+  double Maximum = VTK_DOUBLE_MIN;
+  /// Intensity values of all voxels of the label, only stored if median or percentiles are requested
+  std::vector<TIntensity> Values;
+
+  void Merge(LabelAccumulator<TIntensity>& other)
+  {
+    this->VoxelCount += other.VoxelCount;
+    this->Sum += other.Sum;
+    this->SumOfSquares += other.SumOfSquares;
+    this->Minimum = std::min(this->Minimum, other.Minimum);
+    this->Maximum = std::max(this->Maximum, other.Maximum);
+    this->Values.insert(this->Values.end(), other.Values.begin(), other.Values.end());
+    std::vector<TIntensity>().swap(other.Values);
+  }
+};
+
+//----------------------------------------------------------------------------
+/// Accumulate statistics of all labels, processing a range of slices in each thread
+template <class TLabel, class TIntensity>
+class LabelIntensityStatisticsFunctor
+{
+public:
+  using AccumulatorMap = std::map<TLabel, LabelAccumulator<TIntensity> >;
+
+  LabelIntensityStatisticsFunctor(vtkImageData* labelmap, vtkImageData* intensityImage, const int extent[6], bool storeValues)
+    : Labelmap(labelmap)
+    , IntensityImage(intensityImage)
+    , StoreValues(storeValues)
+  {
+    std::copy(extent, extent + 6, this->Extent);
+    this->IntensityIncrement = (intensityImage ? intensityImage->GetNumberOfScalarComponents() : 0);
+  }
+
+  void Initialize()
+  {
+  }
+
+  void operator()(vtkIdType beginSlice, vtkIdType endSlice)
+  {
+    AccumulatorMap& accumulators = this->LocalAccumulators.Local();
+    // Consecutive voxels usually have the same label, avoid map lookup for them
+    TLabel lastLabel = 0;
+    LabelAccumulator<TIntensity>* accumulator = nullptr;
+    const int rowLength = this->Extent[1] - this->Extent[0] + 1;
+    for (vtkIdType k = beginSlice; k < endSlice; ++k)
+      {
+      for (int j = this->Extent[2]; j <= this->Extent[3]; ++j)
+        {
+        TLabel* labelPtr = static_cast<TLabel*>(this->Labelmap->GetScalarPointer(this->Extent[0], j, static_cast<int>(k)));
+        TIntensity* intensityPtr = nullptr;
+        if (this->IntensityImage)
+          {
+          intensityPtr = static_cast<TIntensity*>(this->IntensityImage->GetScalarPointer(this->Extent[0], j, static_cast<int>(k)));
+          }
+        for (int i = 0; i < rowLength; ++i)
+          {
+          TLabel label = labelPtr[i];
+          if (label == 0)
+            {
+            continue;
+            }
+          if (!accumulator || label != lastLabel)
+            {
+            accumulator = &accumulators[label];
+            lastLabel = label;
+            }
+          accumulator->VoxelCount++;
+          if (!intensityPtr)
+            {
+            continue;
+            }
+          TIntensity intensity = intensityPtr[i * this->IntensityIncrement];
+          double value = static_cast<double>(intensity);
+          accumulator->Sum += value;
+          accumulator->SumOfSquares += value * value;
+          accumulator->Minimum = std::min(accumulator->Minimum, value);
+          accumulator->Maximum = std::max(accumulator->Maximum, value);
+          if (this->StoreValues)
+            {
+            accumulator->Values.push_back(intensity);
+            }
+          }
+        }
+      }
+  }
+
+  void Reduce()
+  {
+    for (typename vtkSMPThreadLocal<AccumulatorMap>::iterator threadIt = this->LocalAccumulators.begin();
+      threadIt != this->LocalAccumulators.end(); ++threadIt)
+      {
+      for (auto& labelAccumulator : *threadIt)
+        {
+        this->Accumulators[labelAccumulator.first].Merge(labelAccumulator.second);
+        }
+      }
+  }
+
+  /// Statistics of all labels, available after processing is completed
+  AccumulatorMap Accumulators;
+
+private:
+  vtkImageData* Labelmap;
+  vtkImageData* IntensityImage;
+  int Extent[6];
+  int IntensityIncrement;
+  bool StoreValues;
+  vtkSMPThreadLocal<AccumulatorMap> LocalAccumulators;
+};
+
+//----------------------------------------------------------------------------
+/// Compute percentile of values by linear interpolation between closest ranks.
+/// Order of values is changed.
+template <class TIntensity>
+double ComputePercentile(std::vector<TIntensity>& values, double percentile)
+{
+  if (values.empty())
+    {
+    return 0.0;
+    }
+  double position = percentile / 100.0 * (values.size() - 1);
+  typename std::vector<TIntensity>::iterator lowerIt = values.begin() + static_cast<vtkIdType>(std::floor(position));
+  std::nth_element(values.begin(), lowerIt, values.end());
+  double lowerValue = static_cast<double>(*lowerIt);
+  double fraction = position - std::floor(position);
+  if (fraction == 0.0 || lowerIt + 1 == values.end())
+    {
+    return lowerValue;
+    }
+  // Values after the nth element are not smaller than it, the next rank is the smallest of them
+  double upperValue = static_cast<double>(*std::min_element(lowerIt + 1, values.end()));
+  return lowerValue + fraction * (upperValue - lowerValue);
+}
+
+//----------------------------------------------------------------------------
+vtkDoubleArray* AddDoubleColumn(vtkTable* table, const char* name, vtkIdType numberOfRows, int numberOfComponents = 1)
+{
+  vtkNew<vtkDoubleArray> array;
+  array->SetName(name);
+  array->SetNumberOfComponents(numberOfComponents);
+  array->SetNumberOfTuples(numberOfRows);
+  table->AddColumn(array);
+  return array;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+template <class TLabel, class TIntensity>
+void vtkITKLabelIntensityStatisticsExecute(vtkITKLabelIntensityStatistics* self,
+  vtkImageData* labelmap, vtkImageData* intensityImage, vtkTable* output)
+{
+  // Only voxels that are in both the labelmap and the intensity image are processed
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  if (intensityImage)
+    {
+    int intensityExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    intensityImage->GetExtent(intensityExtent);
+    for (int i = 0; i < 3; ++i)
+      {
+      extent[2 * i] = std::max(extent[2 * i], intensityExtent[2 * i]);
+      extent[2 * i + 1] = std::min(extent[2 * i + 1], intensityExtent[2 * i + 1]);
+      }
+    }
+
+  std::vector<double> percentiles;
+  if (intensityImage)
+    {
+    for (int i = 0; i < self->GetNumberOfPercentiles(); ++i)
+      {
+      percentiles.push_back(self->GetPercentile(i));
+      }
+    }
+  bool computeMedian = (intensityImage && self->GetComputeMedian());
+  bool storeValues = (computeMedian || !percentiles.empty());
+
+  LabelIntensityStatisticsFunctor<TLabel, TIntensity> functor(labelmap, intensityImage, extent, storeValues);
+  if (extent[0] <= extent[1] && extent[2] <= extent[3] && extent[4] <= extent[5])
+    {
+    vtkSMPTools::For(extent[4], extent[5] + 1, functor);
+    }
+  self->UpdateProgress(0.8);
+
+  // Fill output table, one row for each label value
+  vtkIdType numberOfLabels = static_cast<vtkIdType>(functor.Accumulators.size());
+  vtkNew<vtkLongArray> labelValueArray;
+  labelValueArray->SetName("LabelValue");
+  labelValueArray->SetNumberOfTuples(numberOfLabels);
+  output->AddColumn(labelValueArray);
+  vtkNew<vtkIdTypeArray> voxelCountArray;
+  voxelCountArray->SetName("VoxelCount");
+  voxelCountArray->SetNumberOfTuples(numberOfLabels);
+  output->AddColumn(voxelCountArray);
+  vtkDoubleArray* volumeArray = AddDoubleColumn(output, "Volume", numberOfLabels);
+  vtkDoubleArray* minimumArray = nullptr;
+  vtkDoubleArray* maximumArray = nullptr;
+  vtkDoubleArray* meanArray = nullptr;
+  vtkDoubleArray* standardDeviationArray = nullptr;
+  vtkDoubleArray* medianArray = nullptr;
+  vtkDoubleArray* percentilesArray = nullptr;
+  if (intensityImage)
+    {
+    minimumArray = AddDoubleColumn(output, "Minimum", numberOfLabels);
+    maximumArray = AddDoubleColumn(output, "Maximum", numberOfLabels);
+    meanArray = AddDoubleColumn(output, "Mean", numberOfLabels);
+    standardDeviationArray = AddDoubleColumn(output, "StandardDeviation", numberOfLabels);
+    }
+  if (computeMedian)
+    {
+    medianArray = AddDoubleColumn(output, "Median", numberOfLabels);
+    }
+  if (!percentiles.empty())
+    {
+    percentilesArray = AddDoubleColumn(output, "Percentiles", numberOfLabels, static_cast<int>(percentiles.size()));
+    for (size_t i = 0; i < percentiles.size(); ++i)
+      {
+      std::stringstream componentName;
+      componentName << percentiles[i];
+      percentilesArray->SetComponentName(static_cast<vtkIdType>(i), componentName.str().c_str());
+      }
+    }
+
+  double* spacing = labelmap->GetSpacing();
+  double voxelVolume = std::abs(spacing[0] * spacing[1] * spacing[2]);
+
+  vtkIdType rowIndex = 0;
+  for (auto& labelAccumulator : functor.Accumulators)
+    {
+    LabelAccumulator<TIntensity>& accumulator = labelAccumulator.second;
+    labelValueArray->SetValue(rowIndex, static_cast<long>(labelAccumulator.first));
+    voxelCountArray->SetValue(rowIndex, accumulator.VoxelCount);
+    volumeArray->SetValue(rowIndex, accumulator.VoxelCount * voxelVolume);
+    if (intensityImage)
+      {
+      double mean = accumulator.Sum / accumulator.VoxelCount;
+      double variance = accumulator.SumOfSquares / accumulator.VoxelCount - mean * mean;
+      minimumArray->SetValue(rowIndex, accumulator.Minimum);
+      maximumArray->SetValue(rowIndex, accumulator.Maximum);
+      meanArray->SetValue(rowIndex, mean);
+      standardDeviationArray->SetValue(rowIndex, variance > 0.0 ? std::sqrt(variance) : 0.0);
+      }
+    if (medianArray)
+      {
+      medianArray->SetValue(rowIndex, ComputePercentile(accumulator.Values, 50.0));
+      }
+    for (size_t i = 0; i < percentiles.size(); ++i)
+      {
+      percentilesArray->SetComponent(rowIndex, static_cast<int>(i), ComputePercentile(accumulator.Values, percentiles[i]));
+      }
+    // Release memory as soon as possible
+    std::vector<TIntensity>().swap(accumulator.Values);
+    ++rowIndex;
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class TIntensity>
+bool vtkITKLabelIntensityStatisticsExecuteLabel(vtkITKLabelIntensityStatistics* self,
+  vtkImageData* labelmap, vtkImageData* intensityImage, vtkTable* output)
+{
+#define CALL vtkITKLabelIntensityStatisticsExecute<VTK_TT, TIntensity>(self, labelmap, intensityImage, output)
+  switch (labelmap->GetScalarType())
+    {
+    vtkTemplateMacroCase(VTK_LONG_LONG, long long, CALL);
+    vtkTemplateMacroCase(VTK_UNSIGNED_LONG_LONG, unsigned long long, CALL);
+    vtkTemplateMacroCase(VTK_LONG, long, CALL);
+    vtkTemplateMacroCase(VTK_UNSIGNED_LONG, unsigned long, CALL);
+    vtkTemplateMacroCase(VTK_INT, int, CALL);
+    vtkTemplateMacroCase(VTK_UNSIGNED_INT, unsigned int, CALL);
+    vtkTemplateMacroCase(VTK_SHORT, short, CALL);
+    vtkTemplateMacroCase(VTK_UNSIGNED_SHORT, unsigned short, CALL);
+    vtkTemplateMacroCase(VTK_CHAR, char, CALL);
+    vtkTemplateMacroCase(VTK_SIGNED_CHAR, signed char, CALL);
+    vtkTemplateMacroCase(VTK_UNSIGNED_CHAR, unsigned char, CALL);
+    default:
+      vtkErrorWithObjectMacro(self, "vtkITKLabelIntensityStatistics: Labelmap must have integer scalar type");
+      return false;
+    }
+#undef CALL
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkITKLabelIntensityStatistics::RequestData(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** inputVector,
+  vtkInformationVector* outputVector)
+{
+  vtkTable* output = vtkTable::GetData(outputVector);
+  vtkImageData* labelmap = vtkImageData::GetData(inputVector[0]);
+  vtkImageData* intensityImage = vtkImageData::GetData(inputVector[1]);
+
+  vtkDebugMacro(<< "Executing label intensity statistics");
+
+  // Clear current results
+  output->Initialize();
+
+  if (!labelmap || !labelmap->GetPointData() || !labelmap->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro(<< "Scalars must be defined for the labelmap");
+    return 0;
+    }
+  if (labelmap->GetNumberOfScalarComponents() != 1)
+    {
+    vtkErrorMacro(<< "Only single component labelmaps are supported.");
+    return 0;
+    }
+  if (intensityImage && (!intensityImage->GetPointData() || !intensityImage->GetPointData()->GetScalars()))
+    {
+    vtkErrorMacro(<< "Scalars must be defined for the intensity image");
+    return 0;
+    }
+
+  bool success = false;
+  if (intensityImage)
+    {
+    switch (intensityImage->GetScalarType())
+      {
+      vtkTemplateMacro(success = vtkITKLabelIntensityStatisticsExecuteLabel<VTK_TT>(this, labelmap, intensityImage, output));
+      default:
+        vtkErrorMacro(<< "Unknown intensity image scalar type");
+        return 0;
+      }
+    }
+  else
+    {
+    // Intensity type is not used if there is no intensity image
+    success = vtkITKLabelIntensityStatisticsExecuteLabel<double>(this, labelmap, nullptr, output);
+    }
+  this->UpdateProgress(1.0);
+  return success ? 1 : 0;
+}
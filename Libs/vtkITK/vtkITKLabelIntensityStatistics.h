@@ -0,0 +1,86 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkITKLabelIntensityStatistics_h
+#define __vtkITKLabelIntensityStatistics_h
+
+#include "vtkITK.h"
+
+// VTK includes
+#include <vtkTable.h>
+#include <vtkTableAlgorithm.h>
+
+// std includes
+#include <vector>
+
+class vtkAlgorithmOutput;
+class vtkImageData;
+
+/// \brief Compute intensity statistics of all labels of a labelmap in a single pass.
+/// Voxel count and volume are computed for each non-zero label value of the labelmap (input port 0).
+/// If an intensity image is set (input port 1) then minimum, maximum, mean, standard deviation,
+/// and optionally median and percentiles of the intensity values are computed for each label as well.
+/// The labelmap and the intensity image are matched by voxel index, only the voxels within the
+/// extent of both images are taken into account.
+/// Standard deviation is the population standard deviation (same as in vtkImageAccumulate).
+/// Median and percentiles are computed from the exact voxel values, by linear interpolation
+/// between the closest ranks.
+/// Output statistics are represented in a vtkTable where each column represents a statistic
+/// and each row is a different label value, in increasing label value order.
+/// Voxels are processed by multiple threads using vtkSMPTools.
+class VTK_ITK_EXPORT vtkITKLabelIntensityStatistics : public vtkTableAlgorithm
+{
+public:
+  static vtkITKLabelIntensityStatistics *New();
+  vtkTypeMacro(vtkITKLabelIntensityStatistics, vtkTableAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set the intensity image. Optional, if not set then only voxel count and volume are computed.
+  void SetIntensityData(vtkImageData* intensityImage);
+  void SetIntensityConnection(vtkAlgorithmOutput* algOutput);
+
+  /// Compute median of the intensity values. Enabled by default.
+  /// Requires storing all labeled intensity values during computation.
+  vtkSetMacro(ComputeMedian, bool);
+  vtkGetMacro(ComputeMedian, bool);
+  vtkBooleanMacro(ComputeMedian, bool);
+
+  /// Percentiles (in the range of 0 to 100) of the intensity values that are computed for each label.
+  /// Results are stored in the "Percentiles" column, with one component for each percentile.
+  void AddPercentile(double percentile);
+  void RemoveAllPercentiles();
+  int GetNumberOfPercentiles();
+  double GetPercentile(int index);
+
+protected:
+  vtkITKLabelIntensityStatistics();
+  ~vtkITKLabelIntensityStatistics() override;
+
+  int FillInputPortInformation(int port, vtkInformation* info) override;
+  int RequestData(vtkInformation* request,
+    vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector) override;
+
+protected:
+  bool ComputeMedian;
+  std::vector<double> Percentiles;
+
+private:
+  vtkITKLabelIntensityStatistics(const vtkITKLabelIntensityStatistics&) = delete;
+  void operator=(const vtkITKLabelIntensityStatistics&) = delete;
+};
+
+#endif
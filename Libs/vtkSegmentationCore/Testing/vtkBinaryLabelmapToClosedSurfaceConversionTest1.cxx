@@ -0,0 +1,308 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkVersion.h> // must precede reference to VTK_MAJOR_VERSION
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
+  #include <vtkDiscreteFlyingEdges3D.h>
+#else
+  #include <vtkDiscreteMarchingCubes.h>
+#endif
+#include <vtkDataArray.h>
+#include <vtkImageConstantPad.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// SegmentationCore includes
+#include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
+#include "vtkOrientedImageData.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkSegmentationConverterFactory.h"
+
+// STD includes
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void FillBox(vtkImageData* labelmap, int boxExtent[6], int labelValue)
+{
+  for (int k = boxExtent[4]; k <= boxExtent[5]; ++k)
+    {
+    for (int j = boxExtent[2]; j <= boxExtent[3]; ++j)
+      {
+      for (int i = boxExtent[0]; i <= boxExtent[1]; ++i)
+        {
+        labelmap->SetScalarComponentFromDouble(i, j, k, 0, labelValue);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Extract surface from the full labelmap, without any cropping
+void CreateReferenceSurface(vtkImageData* labelmap, int labelValue, vtkPolyData* referenceSurface)
+{
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  vtkNew<vtkImageConstantPad> padder;
+  padder->SetInputData(labelmap);
+  padder->SetOutputWholeExtent(extent[0] - 1, extent[1] + 1, extent[2] - 1, extent[3] + 1, extent[4] - 1, extent[5] + 1);
+
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
+  vtkNew<vtkDiscreteFlyingEdges3D> marchingCubes;
+#else
+  vtkNew<vtkDiscreteMarchingCubes> marchingCubes;
+#endif
+  marchingCubes->SetInputConnection(padder->GetOutputPort());
+  marchingCubes->ComputeGradientsOff();
+  marchingCubes->ComputeNormalsOff();
+  marchingCubes->SetValue(0, labelValue);
+  marchingCubes->Update();
+  referenceSurface->ShallowCopy(marchingCubes->GetOutput());
+}
+
+//----------------------------------------------------------------------------
+bool CompareSurfaces(vtkPolyData* surface, vtkPolyData* referenceSurface, int line)
+{
+  if (surface->GetNumberOfPoints() == 0
+    || surface->GetNumberOfPoints() != referenceSurface->GetNumberOfPoints()
+    || surface->GetNumberOfPolys() != referenceSurface->GetNumberOfPolys())
+    {
+    std::cerr << line << ": Surface mismatch: " << surface->GetNumberOfPoints() << " points and "
+      << surface->GetNumberOfPolys() << " polygons, expected " << referenceSurface->GetNumberOfPoints() << " points and "
+      << referenceSurface->GetNumberOfPolys() << " polygons" << std::endl;
+    return false;
+    }
+  for (vtkIdType pointId = 0; pointId < surface->GetNumberOfPoints(); ++pointId)
+    {
+    double* point = surface->GetPoint(pointId);
+    double* referencePoint = referenceSurface->GetPoint(pointId);
+    if (point[0] != referencePoint[0] || point[1] != referencePoint[1] || point[2] != referencePoint[2])
+      {
+      std::cerr << line << ": Surface point " << pointId << " mismatch" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestCroppedSurfaceGeneration()
+{
+  // Shared labelmap with a small segment, a segment at the labelmap boundary, and a label
+  // that does not belong to any segment.
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetExtent(0, 59, 0, 49, 0, 39);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  int fullExtent[6] = { 0, 59, 0, 49, 0, 39 };
+  FillBox(labelmap, fullExtent, 0);
+  int box1[6] = { 5, 14, 5, 14, 5, 14 };
+  FillBox(labelmap, box1, 1);
+  int box2[6] = { 0, 9, 30, 49, 20, 39 };
+  FillBox(labelmap, box2, 2);
+  int box3[6] = { 40, 50, 20, 22, 10, 30 };
+  FillBox(labelmap, box3, 3);
+  int box4[6] = { 30, 35, 30, 35, 30, 35 };
+  FillBox(labelmap, box4, 4);
+
+  vtkNew<vtkSegmentation> segmentation;
+  for (int labelValue = 1; labelValue <= 3; ++labelValue)
+    {
+    vtkNew<vtkSegment> segment;
+    segment->SetLabelValue(labelValue);
+    segment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), labelmap);
+    segmentation->AddSegment(segment, "Segment_" + std::to_string(labelValue));
+    }
+  // Compare raw surface extraction results
+  segmentation->SetConversionParameter(vtkBinaryLabelmapToClosedSurfaceConversionRule::GetSmoothingFactorParameterName(), "0.0");
+  segmentation->SetConversionParameter(vtkBinaryLabelmapToClosedSurfaceConversionRule::GetComputeSurfaceNormalsParameterName(), "0");
+  if (!segmentation->CreateRepresentation(vtkSegmentationConverter::GetClosedSurfaceRepresentationName()))
+    {
+    std::cerr << __LINE__ << ": Conversion failed" << std::endl;
+    return false;
+    }
+
+  for (int labelValue = 1; labelValue <= 3; ++labelValue)
+    {
+    vtkPolyData* surface = vtkPolyData::SafeDownCast(segmentation->GetSegmentRepresentation(
+      "Segment_" + std::to_string(labelValue), vtkSegmentationConverter::GetClosedSurfaceRepresentationName()));
+    vtkNew<vtkPolyData> referenceSurface;
+    CreateReferenceSurface(labelmap, labelValue, referenceSurface);
+    if (!surface || !CompareSurfaces(surface, referenceSurface, __LINE__))
+      {
+      std::cerr << __LINE__ << ": Surface of label " << labelValue << " is invalid" << std::endl;
+      return false;
+      }
+    }
+
+  // Label extents are updated when the labelmap is modified
+  FillBox(labelmap, box1, 0);
+  int movedBox1[6] = { 20, 29, 5, 14, 5, 14 };
+  FillBox(labelmap, movedBox1, 1);
+  labelmap->Modified();
+  if (!segmentation->CreateRepresentation(vtkSegmentationConverter::GetClosedSurfaceRepresentationName(), true))
+    {
+    std::cerr << __LINE__ << ": Conversion failed" << std::endl;
+    return false;
+    }
+  vtkPolyData* movedSurface = vtkPolyData::SafeDownCast(segmentation->GetSegmentRepresentation(
+    "Segment_1", vtkSegmentationConverter::GetClosedSurfaceRepresentationName()));
+  vtkNew<vtkPolyData> movedReferenceSurface;
+  CreateReferenceSurface(labelmap, 1, movedReferenceSurface);
+  if (!movedSurface || !CompareSurfaces(movedSurface, movedReferenceSurface, __LINE__))
+    {
+    std::cerr << __LINE__ << ": Surface of modified label is invalid" << std::endl;
+    return false;
+    }
+
+  // Segment without voxels has empty surface
+  FillBox(labelmap, movedBox1, 0);
+  labelmap->Modified();
+  segmentation->CreateRepresentation(vtkSegmentationConverter::GetClosedSurfaceRepresentationName(), true);
+  vtkPolyData* emptySurface = vtkPolyData::SafeDownCast(segmentation->GetSegmentRepresentation(
+    "Segment_1", vtkSegmentationConverter::GetClosedSurfaceRepresentationName()));
+  if (!emptySurface || emptySurface->GetNumberOfPoints() != 0)
+    {
+    std::cerr << __LINE__ << ": Surface of empty segment is expected to be empty" << std::endl;
+    return false;
+    }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Create a segmentation with touching segments in a single shared labelmap
+void CreateMultiLabelSegmentation(vtkSegmentation* segmentation, int numberOfLabelsPerAxis)
+{
+  const int boxSize = 6;
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetExtent(0, numberOfLabelsPerAxis * boxSize - 1, 0, numberOfLabelsPerAxis * boxSize - 1, 0, boxSize * 2 - 1);
+  labelmap->AllocateScalars(VTK_SHORT, 1);
+  labelmap->GetPointData()->GetScalars()->Fill(0);
+  int labelValue = 0;
+  for (int j = 0; j < numberOfLabelsPerAxis; ++j)
+    {
+    for (int i = 0; i < numberOfLabelsPerAxis; ++i)
+      {
+      ++labelValue;
+      // Neighbor boxes touch each other, some of them touch the labelmap boundary
+      int box[6] = { i * boxSize, (i + 1) * boxSize - 1, j * boxSize, (j + 1) * boxSize - 1, labelValue % 3, boxSize + labelValue % 5 };
+      FillBox(labelmap, box, labelValue);
+      vtkNew<vtkSegment> segment;
+      segment->SetLabelValue(labelValue);
+      segment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), labelmap);
+      segmentation->AddSegment(segment, "Segment_" + std::to_string(labelValue));
+      }
+    }
+  segmentation->SetConversionParameter(vtkBinaryLabelmapToClosedSurfaceConversionRule::GetSmoothingFactorParameterName(), "0.0");
+  segmentation->SetConversionParameter(vtkBinaryLabelmapToClosedSurfaceConversionRule::GetComputeSurfaceNormalsParameterName(), "0");
+}
+
+//----------------------------------------------------------------------------
+bool TestMultiLabelExtraction()
+{
+  const int numberOfLabelsPerAxis = 10;
+  vtkNew<vtkSegmentation> singleLabelSegmentation;
+  CreateMultiLabelSegmentation(singleLabelSegmentation, numberOfLabelsPerAxis);
+  vtkNew<vtkSegmentation> multiLabelSegmentation;
+  CreateMultiLabelSegmentation(multiLabelSegmentation, numberOfLabelsPerAxis);
+  multiLabelSegmentation->SetConversionParameter(
+    vtkBinaryLabelmapToClosedSurfaceConversionRule::GetMultiLabelExtractionParameterName(), "1");
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  if (!singleLabelSegmentation->CreateRepresentation(vtkSegmentationConverter::GetClosedSurfaceRepresentationName()))
+    {
+    std::cerr << __LINE__ << ": Conversion failed" << std::endl;
+    return false;
+    }
+  timer->StopTimer();
+  double singleLabelTime = timer->GetElapsedTime();
+
+  timer->StartTimer();
+  if (!multiLabelSegmentation->CreateRepresentation(vtkSegmentationConverter::GetClosedSurfaceRepresentationName()))
+    {
+    std::cerr << __LINE__ << ": Multi-label conversion failed" << std::endl;
+    return false;
+    }
+  timer->StopTimer();
+  double multiLabelTime = timer->GetElapsedTime();
+
+  std::cout << multiLabelSegmentation->GetNumberOfSegments() << " segments converted to closed surface: "
+    << "single-label extraction " << singleLabelTime * 1000.0 << " ms, "
+    << "multi-label extraction " << multiLabelTime * 1000.0 << " ms" << std::endl;
+
+  // Surfaces contain the same points and triangles, only their order may be different
+  for (int segmentIndex = 0; segmentIndex < singleLabelSegmentation->GetNumberOfSegments(); ++segmentIndex)
+    {
+    vtkPolyData* singleLabelSurface = vtkPolyData::SafeDownCast(singleLabelSegmentation->GetNthSegment(segmentIndex)->GetRepresentation(
+      vtkSegmentationConverter::GetClosedSurfaceRepresentationName()));
+    vtkPolyData* multiLabelSurface = vtkPolyData::SafeDownCast(multiLabelSegmentation->GetNthSegment(segmentIndex)->GetRepresentation(
+      vtkSegmentationConverter::GetClosedSurfaceRepresentationName()));
+    if (!singleLabelSurface || !multiLabelSurface)
+      {
+      std::cerr << __LINE__ << ": Closed surface is missing in segment " << segmentIndex << std::endl;
+      return false;
+      }
+    double singleLabelBounds[6] = { 0.0, -1.0, 0.0, -1.0, 0.0, -1.0 };
+    singleLabelSurface->GetBounds(singleLabelBounds);
+    double multiLabelBounds[6] = { 0.0, -1.0, 0.0, -1.0, 0.0, -1.0 };
+    multiLabelSurface->GetBounds(multiLabelBounds);
+    if (multiLabelSurface->GetNumberOfPoints() == 0
+      || multiLabelSurface->GetNumberOfPoints() != singleLabelSurface->GetNumberOfPoints()
+      || multiLabelSurface->GetNumberOfPolys() != singleLabelSurface->GetNumberOfPolys()
+      || !std::equal(singleLabelBounds, singleLabelBounds + 6, multiLabelBounds))
+      {
+      std::cerr << __LINE__ << ": Closed surface mismatch in segment " << segmentIndex << ": multi-label extraction "
+        << multiLabelSurface->GetNumberOfPoints() << " points and " << multiLabelSurface->GetNumberOfPolys() << " polygons, expected "
+        << singleLabelSurface->GetNumberOfPoints() << " points and " << singleLabelSurface->GetNumberOfPolys() << " polygons" << std::endl;
+      return false;
+      }
+    }
+
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkBinaryLabelmapToClosedSurfaceConversionTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkBinaryLabelmapToClosedSurfaceConversionRule>::New() );
+
+  if (!TestCroppedSurfaceGeneration())
+    {
+    return EXIT_FAILURE;
+    }
+
+  if (!TestMultiLabelExtraction())
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Binary labelmap to closed surface conversion test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkTimerLog.h>
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkSegmentationHistory.h"
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+const int LABELMAP_SIZE = 100;
+
+//----------------------------------------------------------------------------
+void PaintBox(vtkOrientedImageData* labelmap, int step)
+{
+  // Boxes are placed at different positions in each step
+  const int boxSize = 10;
+  int corner[3] = { (step * 37) % (LABELMAP_SIZE - boxSize), (step * 53) % (LABELMAP_SIZE - boxSize), (step * 71) % (LABELMAP_SIZE - boxSize) };
+  unsigned char labelValue = static_cast<unsigned char>(step % 2 + 1);
+  for (int k = corner[2]; k < corner[2] + boxSize; ++k)
+    {
+    for (int j = corner[1]; j < corner[1] + boxSize; ++j)
+      {
+      for (int i = corner[0]; i < corner[0] + boxSize; ++i)
+        {
+        *static_cast<unsigned char*>(labelmap->GetScalarPointer(i, j, k)) = labelValue;
+        }
+      }
+    }
+  labelmap->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkTypeInt64 GetChecksum(vtkSegment* segment)
+{
+  vtkOrientedImageData* labelmap = vtkOrientedImageData::SafeDownCast(
+    segment->GetRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName()));
+  if (!labelmap)
+    {
+    return -1;
+    }
+  unsigned char* voxels = static_cast<unsigned char*>(labelmap->GetScalarPointer());
+  vtkIdType numberOfVoxels = labelmap->GetNumberOfPoints();
+  vtkTypeInt64 checksum = 0;
+  for (vtkIdType index = 0; index < numberOfVoxels; ++index)
+    {
+    checksum += static_cast<vtkTypeInt64>(voxels[index]) * (index % 1009 + 1);
+    }
+  return checksum;
+}
+
+//----------------------------------------------------------------------------
+bool TestDifferenceStates(bool compressionEnabled)
+{
+  const int numberOfSteps = 100;
+
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetDimensions(LABELMAP_SIZE, LABELMAP_SIZE, LABELMAP_SIZE);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  labelmap->GetPointData()->GetScalars()->Fill(0);
+  const vtkTypeInt64 labelmapMemorySize = static_cast<vtkTypeInt64>(labelmap->GetActualMemorySize()) * 1024;
+
+  // Segments share the same labelmap
+  vtkNew<vtkSegment> segment1;
+  segment1->SetLabelValue(1);
+  segment1->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), labelmap);
+  vtkNew<vtkSegment> segment2;
+  segment2->SetLabelValue(2);
+  segment2->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), labelmap);
+  vtkNew<vtkSegmentation> segmentation;
+  segmentation->AddSegment(segment1);
+  segmentation->AddSegment(segment2);
+
+  vtkNew<vtkSegmentationHistory> history;
+  history->SetCompressionEnabled(compressionEnabled);
+  history->SetMaximumNumberOfStates(numberOfSteps + 10);
+  history->SetSegmentation(segmentation);
+
+  // Save state then modify the labelmap in each step
+  std::vector<vtkTypeInt64> checksums;
+  vtkNew<vtkTimerLog> timer;
+  double saveTime = 0.0;
+  for (int step = 0; step < numberOfSteps; ++step)
+    {
+    checksums.push_back(GetChecksum(segment1));
+    timer->StartTimer();
+    history->SaveState();
+    timer->StopTimer();
+    saveTime += timer->GetElapsedTime();
+    PaintBox(labelmap, step);
+    }
+  checksums.push_back(GetChecksum(segment1));
+
+  if (history->GetNumberOfStates() != numberOfSteps)
+    {
+    std::cerr << __LINE__ << ": Expected " << numberOfSteps << " states, found: " << history->GetNumberOfStates() << std::endl;
+    return false;
+    }
+
+  // Only the most recent state stores a full copy of the labelmap
+  vtkTypeInt64 memorySize = history->GetMemorySize();
+  if (memorySize > 2 * labelmapMemorySize)
+    {
+    std::cerr << __LINE__ << ": Memory size of " << numberOfSteps << " states is too large: " << memorySize
+      << " bytes (labelmap size: " << labelmapMemorySize << " bytes)" << std::endl;
+    return false;
+    }
+
+  // Undo all steps
+  timer->StartTimer();
+  for (int step = numberOfSteps - 1; step >= 0; --step)
+    {
+    if (!history->RestorePreviousState())
+      {
+      std::cerr << __LINE__ << ": Failed to restore state " << step << std::endl;
+      return false;
+      }
+    if (GetChecksum(segment1) != checksums[step] || GetChecksum(segment2) != checksums[step])
+      {
+      std::cerr << __LINE__ << ": Labelmap content mismatch after undo to state " << step << std::endl;
+      return false;
+      }
+    }
+  timer->StopTimer();
+  double undoTime = timer->GetElapsedTime();
+  if (history->IsRestorePreviousStateAvailable())
+    {
+    std::cerr << __LINE__ << ": No more undo should be available" << std::endl;
+    return false;
+    }
+
+  // Redo all steps
+  for (int step = 1; step <= numberOfSteps; ++step)
+    {
+    if (!history->RestoreNextState())
+      {
+      std::cerr << __LINE__ << ": Failed to restore state " << step << std::endl;
+      return false;
+      }
+    if (GetChecksum(segment1) != checksums[step])
+      {
+      std::cerr << __LINE__ << ": Labelmap content mismatch after redo to state " << step << std::endl;
+      return false;
+      }
+    }
+
+  // Undo a few steps then modify: redo states are removed, undo still works
+  for (int i = 0; i < 10; ++i)
+    {
+    history->RestorePreviousState();
+    }
+  vtkOrientedImageData* restoredLabelmap = vtkOrientedImageData::SafeDownCast(
+    segment1->GetRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName()));
+  history->SaveState();
+  PaintBox(restoredLabelmap, 0);
+  if (history->IsRestoreNextStateAvailable())
+    {
+    std::cerr << __LINE__ << ": Redo should not be available after saving a new state" << std::endl;
+    return false;
+    }
+  history->RestorePreviousState();
+  if (GetChecksum(segment1) != checksums[numberOfSteps - 10])
+    {
+    std::cerr << __LINE__ << ": Labelmap content mismatch after undo of a new modification" << std::endl;
+    return false;
+    }
+  // The state before the undo was saved when the modification started, with the same content
+  history->RestorePreviousState();
+  history->RestorePreviousState();
+  if (GetChecksum(segment1) != checksums[numberOfSteps - 11])
+    {
+    std::cerr << __LINE__ << ": Labelmap content mismatch after undo of a new modification" << std::endl;
+    return false;
+    }
+
+  // Memory limit removes the oldest states (the current state and the states after it are kept)
+  int numberOfStatesBeforeLimit = history->GetNumberOfStates();
+  vtkTypeInt64 memorySizeBeforeLimit = history->GetMemorySize();
+  history->SetMaximumMemorySize(labelmapMemorySize + 1);
+  if (history->GetNumberOfStates() >= numberOfStatesBeforeLimit || history->GetMemorySize() >= memorySizeBeforeLimit)
+    {
+    std::cerr << __LINE__ << ": Memory limit did not remove states" << std::endl;
+    return false;
+    }
+  if (GetChecksum(segment1) != checksums[numberOfSteps - 11] || !history->IsRestoreNextStateAvailable())
+    {
+    std::cerr << __LINE__ << ": Memory limit removed the current or next states" << std::endl;
+    return false;
+    }
+
+  std::cout << "Compression: " << (compressionEnabled ? "enabled" : "disabled")
+    << "  States: " << numberOfSteps
+    << "  Memory: " << memorySize << " bytes (labelmap: " << labelmapMemorySize << " bytes)"
+    << "  SaveState: " << saveTime * 1000.0 / numberOfSteps << " ms/step"
+    << "  Undo: " << undoTime * 1000.0 / numberOfSteps << " ms/step" << std::endl;
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSegmentationHistoryTest2(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  if (!TestDifferenceStates(true))
+    {
+    return EXIT_FAILURE;
+    }
+  if (!TestDifferenceStates(false))
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Segmentation history test 2 passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,263 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// SegmentationCore includes
+#include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
+#include "vtkOrientedImageData.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkSegmentationConverterFactory.h"
+
+// STD includes
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const int NUMBER_OF_SEGMENTS_PER_AXIS[3] = { 5, 5, 4 };
+const int CUBE_SIZE = 8;
+const int CUBE_SPACING = 10;
+
+//----------------------------------------------------------------------------
+/// Create a segmentation with 100 segments stored in a single shared labelmap.
+/// Each segment is a cube with a size that depends on the label value.
+void CreateSegmentation(vtkSegmentation* segmentation)
+{
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetExtent(0, NUMBER_OF_SEGMENTS_PER_AXIS[0] * CUBE_SPACING - 1,
+    0, NUMBER_OF_SEGMENTS_PER_AXIS[1] * CUBE_SPACING - 1,
+    0, NUMBER_OF_SEGMENTS_PER_AXIS[2] * CUBE_SPACING - 1);
+  labelmap->AllocateScalars(VTK_SHORT, 1);
+  labelmap->GetPointData()->GetScalars()->Fill(0);
+
+  int labelValue = 0;
+  for (int k = 0; k < NUMBER_OF_SEGMENTS_PER_AXIS[2]; ++k)
+    {
+    for (int j = 0; j < NUMBER_OF_SEGMENTS_PER_AXIS[1]; ++j)
+      {
+      for (int i = 0; i < NUMBER_OF_SEGMENTS_PER_AXIS[0]; ++i)
+        {
+        ++labelValue;
+        int cubeSize = CUBE_SIZE - labelValue % 4;
+        for (int z = 1; z <= cubeSize; ++z)
+          {
+          for (int y = 1; y <= cubeSize; ++y)
+            {
+            for (int x = 1; x <= cubeSize; ++x)
+              {
+              labelmap->SetScalarComponentFromDouble(i * CUBE_SPACING + x, j * CUBE_SPACING + y, k * CUBE_SPACING + z, 0, labelValue);
+              }
+            }
+          }
+        vtkNew<vtkSegment> segment;
+        segment->SetName(("Segment_" + std::to_string(labelValue)).c_str());
+        segment->SetLabelValue(labelValue);
+        segment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), labelmap);
+        segmentation->AddSegment(segment);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+struct ProgressRecorder
+{
+  std::vector<double> ProgressValues;
+  bool AbortRequested = false;
+};
+
+//----------------------------------------------------------------------------
+void OnProgress(vtkObject* caller, unsigned long vtkNotUsed(eid), void* clientData, void* callData)
+{
+  ProgressRecorder* recorder = reinterpret_cast<ProgressRecorder*>(clientData);
+  recorder->ProgressValues.push_back(*reinterpret_cast<double*>(callData));
+  if (recorder->AbortRequested)
+    {
+    vtkSegmentation::SafeDownCast(caller)->AbortConversionOn();
+    }
+}
+
+//----------------------------------------------------------------------------
+bool ConvertSegmentation(vtkSegmentation* segmentation, bool parallel, ProgressRecorder& recorder, double& conversionTime)
+{
+  vtkNew<vtkCallbackCommand> progressCallback;
+  progressCallback->SetCallback(OnProgress);
+  progressCallback->SetClientData(&recorder);
+  segmentation->AddObserver(vtkCommand::ProgressEvent, progressCallback);
+  segmentation->SetParallelConversion(parallel);
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  bool success = segmentation->CreateRepresentation(vtkSegmentationConverter::GetClosedSurfaceRepresentationName());
+  timer->StopTimer();
+  conversionTime = timer->GetElapsedTime();
+
+  segmentation->RemoveObserver(progressCallback);
+  return success;
+}
+
+//----------------------------------------------------------------------------
+bool TestParallelConversion()
+{
+  vtkNew<vtkSegmentation> serialSegmentation;
+  if (serialSegmentation->GetParallelConversion())
+    {
+    std::cerr << __LINE__ << ": Parallel conversion is expected to be disabled by default" << std::endl;
+    return false;
+    }
+
+  // The setting is copied with the conversion parameters (used for applying the default segmentation node)
+  vtkNew<vtkSegmentation> defaultSegmentation;
+  defaultSegmentation->SetParallelConversion(true);
+  vtkNew<vtkSegmentation> copiedSegmentation;
+  copiedSegmentation->DeepCopy(defaultSegmentation);
+  vtkNew<vtkSegmentation> copiedParametersSegmentation;
+  copiedParametersSegmentation->CopyConversionParameters(defaultSegmentation);
+  if (!copiedSegmentation->GetParallelConversion() || !copiedParametersSegmentation->GetParallelConversion())
+    {
+    std::cerr << __LINE__ << ": Parallel conversion setting is expected to be copied" << std::endl;
+    return false;
+    }
+  CreateSegmentation(serialSegmentation);
+  ProgressRecorder serialProgress;
+  double serialTime = 0.0;
+  if (!ConvertSegmentation(serialSegmentation, false, serialProgress, serialTime))
+    {
+    std::cerr << __LINE__ << ": Serial conversion failed" << std::endl;
+    return false;
+    }
+
+  vtkNew<vtkSegmentation> parallelSegmentation;
+  CreateSegmentation(parallelSegmentation);
+  ProgressRecorder parallelProgress;
+  double parallelTime = 0.0;
+  if (!ConvertSegmentation(parallelSegmentation, true, parallelProgress, parallelTime))
+    {
+    std::cerr << __LINE__ << ": Parallel conversion failed" << std::endl;
+    return false;
+    }
+
+  std::cout << parallelSegmentation->GetNumberOfSegments() << " segments converted to closed surface: "
+    << "serial " << serialTime * 1000.0 << " ms, parallel " << parallelTime * 1000.0 << " ms" << std::endl;
+
+  // Parallel conversion must produce the same surfaces for the same segments
+  for (int segmentIndex = 0; segmentIndex < serialSegmentation->GetNumberOfSegments(); ++segmentIndex)
+    {
+    vtkPolyData* serialSurface = vtkPolyData::SafeDownCast(serialSegmentation->GetNthSegment(segmentIndex)->GetRepresentation(
+      vtkSegmentationConverter::GetClosedSurfaceRepresentationName()));
+    vtkPolyData* parallelSurface = vtkPolyData::SafeDownCast(parallelSegmentation->GetNthSegment(segmentIndex)->GetRepresentation(
+      vtkSegmentationConverter::GetClosedSurfaceRepresentationName()));
+    if (!serialSurface || !parallelSurface)
+      {
+      std::cerr << __LINE__ << ": Closed surface is missing in segment " << segmentIndex << std::endl;
+      return false;
+      }
+    if (serialSurface->GetNumberOfPoints() == 0
+      || serialSurface->GetNumberOfPoints() != parallelSurface->GetNumberOfPoints()
+      || serialSurface->GetNumberOfCells() != parallelSurface->GetNumberOfCells())
+      {
+      std::cerr << __LINE__ << ": Closed surface mismatch in segment " << segmentIndex << ": serial conversion "
+        << serialSurface->GetNumberOfPoints() << " points, parallel conversion "
+        << parallelSurface->GetNumberOfPoints() << " points" << std::endl;
+      return false;
+      }
+    }
+
+  // Progress is reported in increasing order, up to completion
+  for (ProgressRecorder* recorder : { &serialProgress, &parallelProgress })
+    {
+    if (recorder->ProgressValues.empty() || recorder->ProgressValues.back() != 1.0)
+      {
+      std::cerr << __LINE__ << ": Conversion progress is not reported" << std::endl;
+      return false;
+      }
+    for (size_t i = 1; i < recorder->ProgressValues.size(); ++i)
+      {
+      if (recorder->ProgressValues[i] < recorder->ProgressValues[i - 1])
+        {
+        std::cerr << __LINE__ << ": Conversion progress is decreasing" << std::endl;
+        return false;
+        }
+      }
+    }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestAbortConversion()
+{
+  for (bool parallel : { false, true })
+    {
+    vtkNew<vtkSegmentation> segmentation;
+    CreateSegmentation(segmentation);
+    ProgressRecorder recorder;
+    recorder.AbortRequested = true;
+    double conversionTime = 0.0;
+    if (ConvertSegmentation(segmentation, parallel, recorder, conversionTime))
+      {
+      std::cerr << __LINE__ << ": Aborted conversion is expected to fail" << std::endl;
+      return false;
+      }
+    if (recorder.ProgressValues.size() != 1)
+      {
+      std::cerr << __LINE__ << ": Conversion is not aborted after the first progress report" << std::endl;
+      return false;
+      }
+
+    // Conversion can be restarted
+    recorder.AbortRequested = false;
+    if (!ConvertSegmentation(segmentation, parallel, recorder, conversionTime))
+      {
+      std::cerr << __LINE__ << ": Conversion failed after abort" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSegmentationParallelConversionTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkBinaryLabelmapToClosedSurfaceConversionRule>::New() );
+
+  if (!TestParallelConversion())
+    {
+    return EXIT_FAILURE;
+    }
+
+  if (!TestAbortConversion())
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Segmentation parallel conversion test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -67,6 +67,59 @@
 #include <vtkInformation.h>
 #include <vtkExtractSelection.h>
 #include <vtkSelectionSource.h>
+#include <vtkCellArray.h>
+#include <vtkCollection.h>
+#include <vtkMarchingCubesTriangleCases.h>
+#include <vtkPoints.h>
+#include <vtkTimeStamp.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <unordered_map>
+
+//----------------------------------------------------------------------------
+class vtkBinaryLabelmapToClosedSurfaceConversionRule::vtkLabelmapLayerCache
+{
+public:
+  struct Layer
+    {
+    /// Used for detecting if the scalar array has been deleted
+    vtkWeakPointer<vtkDataArray> Scalars;
+    int Extent[6] = { 0, -1, 0, -1, 0, -1 };
+    vtkTimeStamp ComputeTime;
+    bool LabelExtentsComputed = false;
+    std::map<int, std::array<int, 6> > LabelExtents;
+    bool LabelSurfacesComputed = false;
+    std::map<int, vtkSmartPointer<vtkPolyData> > LabelSurfaces;
+    };
+
+  /// Get cached information of a labelmap layer. Information computed from a previous
+  /// content of the labelmap is removed. Mutex must be locked by the caller.
+  Layer& GetLayer(vtkImageData* labelmap)
+  {
+    vtkDataArray* scalars = labelmap->GetPointData()->GetScalars();
+    int extent[6] = { 0, -1, 0, -1, 0, -1 };
+    labelmap->GetExtent(extent);
+    Layer& layer = this->Layers[scalars];
+    if (layer.Scalars != scalars
+      || scalars->GetMTime() > layer.ComputeTime.GetMTime()
+      || !std::equal(extent, extent + 6, layer.Extent))
+      {
+      layer = Layer();
+      layer.Scalars = scalars;
+      std::copy(extent, extent + 6, layer.Extent);
+      layer.ComputeTime.Modified();
+      }
+    return layer;
+  }
+
+  std::mutex Mutex;
+  /// Information of labelmap layers, by scalar array (shallow copies of a labelmap share the same array)
+  std::map<vtkDataArray*, Layer> Layers;
+};
 
 //----------------------------------------------------------------------------
 vtkSegmentationConverterRuleNewMacro(vtkBinaryLabelmapToClosedSurfaceConversionRule);
@@ -74,6 +127,7 @@ vtkSegmentationConverterRuleNewMacro(vtkBinaryLabelmapToClosedSurfaceConversionR
 //----------------------------------------------------------------------------
 vtkBinaryLabelmapToClosedSurfaceConversionRule::vtkBinaryLabelmapToClosedSurfaceConversionRule()
 {
+  this->LayerCache = std::make_shared<vtkLabelmapLayerCache>();
   this->ConversionParameters[GetDecimationFactorParameterName()] = std::make_pair("0.0",
     "Desired reduction in the total number of polygons. Range: 0.0 (no decimation) to 1.0 (as much simplification as possible)."
     " Value of 0.8 typically reduces data set size by 80% without losing too much details.");
@@ -84,11 +138,26 @@ vtkBinaryLabelmapToClosedSurfaceConversionRule::vtkBinaryLabelmapToClosedSurface
     "0 = surface normals are not computed (slightly faster but produces less smooth surface display).");
   this->ConversionParameters[GetJointSmoothingParameterName()] = std::make_pair("0",
     "Perform joint smoothing.");
+  this->ConversionParameters[GetMultiLabelExtractionParameterName()] = std::make_pair("0",
+    "Extract surfaces of all segments of a shared labelmap in a single pass over the voxels."
+    " 1 = faster conversion of many segments, 0 (default) = surface of each segment is extracted separately.");
 }
 
 //----------------------------------------------------------------------------
 vtkBinaryLabelmapToClosedSurfaceConversionRule::~vtkBinaryLabelmapToClosedSurfaceConversionRule() = default;
 
+//----------------------------------------------------------------------------
+vtkSegmentationConverterRule* vtkBinaryLabelmapToClosedSurfaceConversionRule::Clone()
+{
+  vtkBinaryLabelmapToClosedSurfaceConversionRule* clone =
+    vtkBinaryLabelmapToClosedSurfaceConversionRule::SafeDownCast(this->Superclass::Clone());
+  if (clone)
+    {
+    clone->LayerCache = this->LayerCache;
+    }
+  return clone;
+}
+
 //----------------------------------------------------------------------------
 unsigned int vtkBinaryLabelmapToClosedSurfaceConversionRule::GetConversionCost(
     vtkDataObject* vtkNotUsed(sourceRepresentation)/*=nullptr*/,
@@ -132,6 +201,48 @@ vtkDataObject* vtkBinaryLabelmapToClosedSurfaceConversionRule::ConstructRepresen
     }
 }
 
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::PreConvert(vtkSegmentation* segmentation)
+{
+  if (!segmentation)
+    {
+    return true;
+    }
+
+  // The voxels of a labelmap may be modified without modifying its scalar array,
+  // therefore the cache is checked against the modification time of the labelmap layers.
+  vtkNew<vtkCollection> layerObjects;
+  segmentation->GetLayerObjects(layerObjects, this->GetSourceRepresentationName());
+
+  std::lock_guard<std::mutex> lock(this->LayerCache->Mutex);
+  std::map<vtkDataArray*, vtkLabelmapLayerCache::Layer>& layers = this->LayerCache->Layers;
+  for (auto layerIt = layers.begin(); layerIt != layers.end(); )
+    {
+    if (!layerIt->second.Scalars)
+      {
+      layerIt = layers.erase(layerIt);
+      }
+    else
+      {
+      ++layerIt;
+      }
+    }
+  for (int i = 0; i < layerObjects->GetNumberOfItems(); ++i)
+    {
+    vtkImageData* layer = vtkImageData::SafeDownCast(layerObjects->GetItemAsObject(i));
+    if (!layer || !layer->GetPointData()->GetScalars())
+      {
+      continue;
+      }
+    auto layerIt = layers.find(layer->GetPointData()->GetScalars());
+    if (layerIt != layers.end() && layer->GetMTime() > layerIt->second.ComputeTime.GetMTime())
+      {
+      layers.erase(layerIt);
+      }
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkSegment* segment)
 {
@@ -157,6 +268,7 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkSegment* segment
 
   double smoothingFactor = vtkVariant(this->ConversionParameters[GetSmoothingFactorParameterName()].first).ToDouble();
   int jointSmoothing = vtkVariant(this->ConversionParameters[GetJointSmoothingParameterName()].first).ToInt();
+  int multiLabelExtraction = vtkVariant(this->ConversionParameters[GetMultiLabelExtractionParameterName()].first).ToInt();
 
   if (jointSmoothing > 0 && smoothingFactor > 0)
     {
@@ -214,6 +326,17 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkSegment* segment
     vtkPolyData* thresholdedSurface = geometry->GetOutput();
     closedSurfacePolyData->ShallowCopy(thresholdedSurface);
     }
+  else if (multiLabelExtraction > 0)
+    {
+    vtkSmartPointer<vtkPolyData> labelSurface = this->GetLabelSurface(orientedBinaryLabelmap, segment->GetLabelValue());
+    if (!labelSurface)
+      {
+      vtkDebugMacro("Convert: No polygons can be created, label value is not found in the labelmap");
+      closedSurfacePolyData->Initialize();
+      return true;
+      }
+    return this->ProcessClosedSurface(labelSurface, orientedBinaryLabelmap, closedSurfacePolyData);
+    }
   else
     {
     std::vector<int> labelValue = { segment->GetLabelValue() };
@@ -259,20 +382,40 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::CreateClosedSurface(vtkOrie
     return true;
     }
 
-  /// If input labelmap has non-background border voxels, then those regions remain open in the output closed surface.
-  /// This function adds a 1 voxel padding to the labelmap in these cases.
-  bool paddingNecessary = this->IsLabelmapPaddingNecessary(binaryLabelmap);
-  if (paddingNecessary)
+  // Only process the region that contains the requested labels (segments of a shared labelmap
+  // often occupy a small fraction of the labelmap).
+  int labelsExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+  for (int labelValue : labelValues)
     {
-    vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
-    padder->SetInputData(binaryLabelmap);
-    int extent[6] = { 0, -1, 0, -1, 0, -1 };
-    binaryLabelmap->GetExtent(extent);
-    // Set the output extent to the new size
-    padder->SetOutputWholeExtent(extent[0] - 1, extent[1] + 1, extent[2] - 1, extent[3] + 1, extent[4] - 1, extent[5] + 1);
-    padder->Update();
-    binaryLabelmap = padder->GetOutput();
+    int labelExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    if (!this->GetLabelExtent(binaryLabelmap, labelValue, labelExtent))
+      {
+      continue;
+      }
+    for (int i = 0; i < 3; ++i)
+      {
+      labelsExtent[2 * i] = std::min(labelsExtent[2 * i], labelExtent[2 * i]);
+      labelsExtent[2 * i + 1] = std::max(labelsExtent[2 * i + 1], labelExtent[2 * i + 1]);
+      }
     }
+  if (labelsExtent[0] > labelsExtent[1])
+    {
+    vtkDebugMacro("Convert: No polygons can be created, none of the label values are found in the labelmap");
+    closedSurfacePolyData->Initialize();
+    return true;
+    }
+
+  // Crop the labelmap to the labels extent with a 1 voxel margin. Voxels of the margin that are outside
+  // of the input labelmap are filled with background, so that regions at the labelmap boundary are closed
+  // in the output surface. Voxel indices are preserved, so the surface is the same as the one extracted
+  // from the full labelmap.
+  vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
+  padder->SetInputData(binaryLabelmap);
+  padder->SetConstant(0);
+  padder->SetOutputWholeExtent(labelsExtent[0] - 1, labelsExtent[1] + 1, labelsExtent[2] - 1, labelsExtent[3] + 1,
+    labelsExtent[4] - 1, labelsExtent[5] + 1);
+  padder->Update();
+  binaryLabelmap = padder->GetOutput();
 
   // Clone labelmap and set identity geometry so that the whole transform can be done in IJK space and then
   // the whole transform can be applied on the poly data to transform it to the world coordinate system
@@ -281,11 +424,6 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::CreateClosedSurface(vtkOrie
   binaryLabelmapWithIdentityGeometry->SetOrigin(0, 0, 0);
   binaryLabelmapWithIdentityGeometry->SetSpacing(1.0, 1.0, 1.0);
 
-  // Get conversion parameters
-  double decimationFactor = vtkVariant(this->ConversionParameters[GetDecimationFactorParameterName()].first).ToDouble();
-  double smoothingFactor = vtkVariant(this->ConversionParameters[GetSmoothingFactorParameterName()].first).ToDouble();
-  int computeSurfaceNormals = vtkVariant(this->ConversionParameters[GetComputeSurfaceNormalsParameterName()].first).ToInt();
-
 #if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
   vtkNew<vtkDiscreteFlyingEdges3D> marchingCubes;
 #else
@@ -303,23 +441,30 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::CreateClosedSurface(vtkOrie
     ++valueIndex;
     }
 
-  vtkSmartPointer<vtkPolyData> convertedSegment = vtkSmartPointer<vtkPolyData>::New();
-
   // Run marching cubes
   marchingCubes->Update();
-  vtkSmartPointer<vtkPolyData> processingResult = marchingCubes->GetOutput();
-  if (processingResult->GetNumberOfPolys() == 0)
+  if (marchingCubes->GetOutput()->GetNumberOfPolys() == 0)
     {
     vtkDebugMacro("Convert: No polygons can be created, probably all voxels are empty");
-    convertedSegment = nullptr;
     closedSurfacePolyData->Initialize();
-    }
-
-  if (!convertedSegment)
-    {
     return true;
     }
 
+  return this->ProcessClosedSurface(marchingCubes->GetOutput(), orientedBinaryLabelmap, closedSurfacePolyData);
+}
+
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::ProcessClosedSurface(vtkPolyData* surfaceIjk,
+  vtkOrientedImageData* orientedBinaryLabelmap, vtkPolyData* closedSurfacePolyData)
+{
+  // Get conversion parameters
+  double decimationFactor = vtkVariant(this->ConversionParameters[GetDecimationFactorParameterName()].first).ToDouble();
+  double smoothingFactor = vtkVariant(this->ConversionParameters[GetSmoothingFactorParameterName()].first).ToDouble();
+  int computeSurfaceNormals = vtkVariant(this->ConversionParameters[GetComputeSurfaceNormalsParameterName()].first).ToInt();
+
+  vtkSmartPointer<vtkPolyData> processingResult = surfaceIjk;
+  vtkSmartPointer<vtkPolyData> convertedSegment = vtkSmartPointer<vtkPolyData>::New();
+
   // Decimate
   if (decimationFactor > 0.0)
     {
@@ -389,9 +534,25 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::CreateClosedSurface(vtkOrie
 bool vtkBinaryLabelmapToClosedSurfaceConversionRule::PostConvert(vtkSegmentation* vtkNotUsed(segmentation))
 {
   this->JointSmoothCache.clear();
+
+  // Label surfaces are only needed during conversion, release them to save memory
+  std::lock_guard<std::mutex> lock(this->LayerCache->Mutex);
+  for (auto& layer : this->LayerCache->Layers)
+    {
+    layer.second.LabelSurfaces.clear();
+    layer.second.LabelSurfacesComputed = false;
+    }
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::IsThreadSafe()
+{
+  double smoothingFactor = vtkVariant(this->ConversionParameters[GetSmoothingFactorParameterName()].first).ToDouble();
+  int jointSmoothing = vtkVariant(this->ConversionParameters[GetJointSmoothingParameterName()].first).ToInt();
+  return !(jointSmoothing > 0 && smoothingFactor > 0);
+}
+
 //----------------------------------------------------------------------------
 template<class ImageScalarType>
 void IsLabelmapPaddingNecessaryGeneric(vtkImageData* binaryLabelmap, bool &paddingNecessary)
@@ -439,6 +600,309 @@ void IsLabelmapPaddingNecessaryGeneric(vtkImageData* binaryLabelmap, bool &paddi
   return;
 }
 
+//----------------------------------------------------------------------------
+template<class ImageScalarType>
+void ComputeLabelExtentsGeneric(vtkImageData* labelmap, std::map<int, std::array<int, 6> >& labelExtents)
+{
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    return;
+    }
+  vtkIdType increments[3] = { 0, 0, 0 };
+  labelmap->GetIncrements(increments);
+  ImageScalarType* voxels = static_cast<ImageScalarType*>(labelmap->GetScalarPointerForExtent(extent));
+
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      ImageScalarType* rowVoxels = voxels + (k - extent[4]) * increments[2] + (j - extent[2]) * increments[1];
+      int i = extent[0];
+      while (i <= extent[1])
+        {
+        ImageScalarType value = rowVoxels[(i - extent[0]) * increments[0]];
+        if (value == 0)
+          {
+          ++i;
+          continue;
+          }
+        // Extents are updated once for each run of voxels with the same label
+        int runStart = i;
+        while (i < extent[1] && rowVoxels[(i + 1 - extent[0]) * increments[0]] == value)
+          {
+          ++i;
+          }
+        int labelValue = static_cast<int>(value);
+        std::map<int, std::array<int, 6> >::iterator labelIt = labelExtents.find(labelValue);
+        if (labelIt == labelExtents.end())
+          {
+          labelExtents[labelValue] = { { runStart, i, j, j, k, k } };
+          }
+        else
+          {
+          std::array<int, 6>& labelExtent = labelIt->second;
+          labelExtent[0] = std::min(labelExtent[0], runStart);
+          labelExtent[1] = std::max(labelExtent[1], i);
+          labelExtent[2] = std::min(labelExtent[2], j);
+          labelExtent[3] = std::max(labelExtent[3], j);
+          labelExtent[5] = k;
+          }
+        ++i;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::GetLabelExtent(vtkImageData* binaryLabelmap, int labelValue, int labelExtent[6])
+{
+  vtkDataArray* scalars = binaryLabelmap ? binaryLabelmap->GetPointData()->GetScalars() : nullptr;
+  if (!scalars)
+    {
+    return false;
+    }
+
+  std::lock_guard<std::mutex> lock(this->LayerCache->Mutex);
+  vtkLabelmapLayerCache::Layer& layer = this->LayerCache->GetLayer(binaryLabelmap);
+  if (!layer.LabelExtentsComputed)
+    {
+    switch (binaryLabelmap->GetScalarType())
+      {
+      vtkTemplateMacro(ComputeLabelExtentsGeneric<VTK_TT>(binaryLabelmap, layer.LabelExtents));
+      default:
+        vtkErrorMacro("GetLabelExtent: Unknown image scalar type!");
+        return false;
+      }
+    layer.LabelExtentsComputed = true;
+    }
+
+  std::map<int, std::array<int, 6> >::iterator labelIt = layer.LabelExtents.find(labelValue);
+  if (labelIt == layer.LabelExtents.end())
+    {
+    return false;
+    }
+  std::copy(labelIt->second.begin(), labelIt->second.end(), labelExtent);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> vtkBinaryLabelmapToClosedSurfaceConversionRule::GetLabelSurface(vtkImageData* binaryLabelmap, int labelValue)
+{
+  if (!binaryLabelmap || !binaryLabelmap->GetPointData()->GetScalars())
+    {
+    return nullptr;
+    }
+
+  std::lock_guard<std::mutex> lock(this->LayerCache->Mutex);
+  vtkLabelmapLayerCache::Layer& layer = this->LayerCache->GetLayer(binaryLabelmap);
+  if (!layer.LabelSurfacesComputed)
+    {
+    vtkBinaryLabelmapToClosedSurfaceConversionRule::CreateLabelSurfaces(binaryLabelmap, layer.LabelSurfaces);
+    layer.LabelSurfacesComputed = true;
+    }
+
+  std::map<int, vtkSmartPointer<vtkPolyData> >::iterator labelIt = layer.LabelSurfaces.find(labelValue);
+  if (labelIt == layer.LabelSurfaces.end())
+    {
+    return nullptr;
+    }
+  // Return a new data object, as surfaces may be processed concurrently
+  vtkSmartPointer<vtkPolyData> labelSurface = vtkSmartPointer<vtkPolyData>::New();
+  labelSurface->ShallowCopy(labelIt->second);
+  return labelSurface;
+}
+
+//----------------------------------------------------------------------------
+namespace
+{
+/// Points and triangles of the surface of a label
+struct LabelSurfaceData
+{
+  vtkSmartPointer<vtkPoints> Points;
+  vtkSmartPointer<vtkCellArray> Polys;
+  /// Point ID for each cube edge, to merge coincident points of neighbor cubes
+  std::unordered_map<vtkIdType, vtkIdType> EdgePointIds;
+};
+
+// Cube corners are ordered as in vtkMarchingCubes: (0,0,0), (1,0,0), (1,1,0), (0,1,0), (0,0,1), (1,0,1), (1,1,1), (0,1,1).
+// Each edge is specified by the offset of its first corner and its axis.
+const int CUBE_EDGE_START[12][3] =
+  {
+  { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 0 },
+  { 0, 0, 1 }, { 1, 0, 1 }, { 0, 1, 1 }, { 0, 0, 1 },
+  { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 }
+  };
+const int CUBE_EDGE_AXIS[12] = { 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 };
+}
+
+//----------------------------------------------------------------------------
+template<class ImageScalarType>
+void CreateLabelSurfacesGeneric(vtkImageData* labelmap, std::map<int, vtkSmartPointer<vtkPolyData> >& labelSurfaces)
+{
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    return;
+    }
+  vtkIdType increments[3] = { 0, 0, 0 };
+  labelmap->GetIncrements(increments);
+  ImageScalarType* voxels = static_cast<ImageScalarType*>(labelmap->GetScalarPointerForExtent(extent));
+
+  // Two neighbor slices of the labelmap are kept in a buffer, with one voxel of background
+  // padding around them, so that surfaces are closed at the labelmap boundary.
+  // Padded voxel (0,0,0) corresponds to voxel (extent[0]-1, extent[2]-1, extent[4]-1).
+  const vtkIdType paddedDimensions[3] = { extent[1] - extent[0] + 3, extent[3] - extent[2] + 3, extent[5] - extent[4] + 3 };
+  const vtkIdType paddedSliceSize = paddedDimensions[0] * paddedDimensions[1];
+  std::vector<ImageScalarType> sliceBuffers[2] = { std::vector<ImageScalarType>(paddedSliceSize, 0),
+    std::vector<ImageScalarType>(paddedSliceSize, 0) };
+  auto fillSlice = [&](std::vector<ImageScalarType>& slice, vtkIdType paddedK)
+    {
+    int k = static_cast<int>(paddedK) + extent[4] - 1;
+    if (k < extent[4] || k > extent[5])
+      {
+      std::fill(slice.begin(), slice.end(), 0);
+      return;
+      }
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      ImageScalarType* row = voxels + (k - extent[4]) * increments[2] + (j - extent[2]) * increments[1];
+      ImageScalarType* paddedRow = &slice[(j - extent[2] + 1) * paddedDimensions[0] + 1];
+      for (int i = 0; i <= extent[1] - extent[0]; ++i)
+        {
+        paddedRow[i] = row[i * increments[0]];
+        }
+      }
+    };
+
+  vtkMarchingCubesTriangleCases* triangleCases = vtkMarchingCubesTriangleCases::GetCases();
+  std::map<int, LabelSurfaceData> labelSurfaceData;
+  int lastLabelValue = 0;
+  LabelSurfaceData* lastLabelSurfaceData = nullptr;
+
+  fillSlice(sliceBuffers[0], 0);
+  for (vtkIdType k = 0; k < paddedDimensions[2] - 1; ++k)
+    {
+    fillSlice(sliceBuffers[(k + 1) % 2], k + 1);
+    const ImageScalarType* slice0 = sliceBuffers[k % 2].data();
+    const ImageScalarType* slice1 = sliceBuffers[(k + 1) % 2].data();
+    for (vtkIdType j = 0; j < paddedDimensions[1] - 1; ++j)
+      {
+      for (vtkIdType i = 0; i < paddedDimensions[0] - 1; ++i)
+        {
+        vtkIdType offset = j * paddedDimensions[0] + i;
+        ImageScalarType corners[8] =
+          {
+          slice0[offset], slice0[offset + 1], slice0[offset + 1 + paddedDimensions[0]], slice0[offset + paddedDimensions[0]],
+          slice1[offset], slice1[offset + 1], slice1[offset + 1 + paddedDimensions[0]], slice1[offset + paddedDimensions[0]]
+          };
+        bool uniform = true;
+        for (int corner = 1; corner < 8 && uniform; ++corner)
+          {
+          uniform = (corners[corner] == corners[0]);
+          }
+        if (uniform)
+          {
+          continue;
+          }
+
+        // Generate triangles for each label in the cube
+        for (int corner = 0; corner < 8; ++corner)
+          {
+          ImageScalarType value = corners[corner];
+          bool processed = (value == 0);
+          for (int previousCorner = 0; previousCorner < corner && !processed; ++previousCorner)
+            {
+            processed = (corners[previousCorner] == value);
+            }
+          if (processed)
+            {
+            continue;
+            }
+
+          int caseIndex = 0;
+          for (int caseCorner = corner; caseCorner < 8; ++caseCorner)
+            {
+            if (corners[caseCorner] == value)
+              {
+              caseIndex |= (1 << caseCorner);
+              }
+            }
+
+          int labelValue = static_cast<int>(value);
+          if (!lastLabelSurfaceData || labelValue != lastLabelValue)
+            {
+            lastLabelSurfaceData = &labelSurfaceData[labelValue];
+            lastLabelValue = labelValue;
+            if (!lastLabelSurfaceData->Points)
+              {
+              lastLabelSurfaceData->Points = vtkSmartPointer<vtkPoints>::New();
+              lastLabelSurfaceData->Polys = vtkSmartPointer<vtkCellArray>::New();
+              }
+            }
+          LabelSurfaceData& surfaceData = *lastLabelSurfaceData;
+
+          for (EDGE_LIST* edge = triangleCases[caseIndex].edges; edge[0] > -1; edge += 3)
+            {
+            vtkIdType pointIds[3] = { 0, 0, 0 };
+            for (int triangleCorner = 0; triangleCorner < 3; ++triangleCorner)
+              {
+              const int* edgeStart = CUBE_EDGE_START[edge[triangleCorner]];
+              int edgeAxis = CUBE_EDGE_AXIS[edge[triangleCorner]];
+              vtkIdType edgeId = (((k + edgeStart[2]) * paddedDimensions[1] + j + edgeStart[1]) * paddedDimensions[0]
+                + i + edgeStart[0]) * 3 + edgeAxis;
+              auto edgePointIt = surfaceData.EdgePointIds.find(edgeId);
+              if (edgePointIt != surfaceData.EdgePointIds.end())
+                {
+                pointIds[triangleCorner] = edgePointIt->second;
+                continue;
+                }
+              // Points are placed at the middle of the edge, as in discrete marching cubes
+              double point[3] =
+                {
+                static_cast<double>(i + edgeStart[0] + extent[0] - 1),
+                static_cast<double>(j + edgeStart[1] + extent[2] - 1),
+                static_cast<double>(k + edgeStart[2] + extent[4] - 1)
+                };
+              point[edgeAxis] += 0.5;
+              pointIds[triangleCorner] = surfaceData.Points->InsertNextPoint(point);
+              surfaceData.EdgePointIds[edgeId] = pointIds[triangleCorner];
+              }
+            surfaceData.Polys->InsertNextCell(3, pointIds);
+            }
+          }
+        }
+      }
+    }
+
+  for (auto& labelSurface : labelSurfaceData)
+    {
+    vtkSmartPointer<vtkPolyData> surface = vtkSmartPointer<vtkPolyData>::New();
+    surface->SetPoints(labelSurface.second.Points);
+    surface->SetPolys(labelSurface.second.Polys);
+    labelSurfaces[labelSurface.first] = surface;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkBinaryLabelmapToClosedSurfaceConversionRule::CreateLabelSurfaces(vtkImageData* labelmap,
+  std::map<int, vtkSmartPointer<vtkPolyData> >& labelSurfaces)
+{
+  labelSurfaces.clear();
+  if (!labelmap || !labelmap->GetPointData()->GetScalars())
+    {
+    return;
+    }
+  switch (labelmap->GetScalarType())
+    {
+    vtkTemplateMacro(CreateLabelSurfacesGeneric<VTK_TT>(labelmap, labelSurfaces));
+    default:
+      vtkErrorWithObjectMacro(labelmap, "CreateLabelSurfaces: Unknown image scalar type!");
+    }
+}
+
 //----------------------------------------------------------------------------
 bool vtkBinaryLabelmapToClosedSurfaceConversionRule::IsLabelmapPaddingNecessary(vtkImageData* binaryLabelmap)
 {
@@ -30,6 +30,9 @@
 // VTK includes
 #include <vtkPolyData.h>
 
+// STD includes
+#include <memory>
+
 /// \ingroup SegmentationCore
 /// \brief Convert binary labelmap representation (vtkOrientedImageData type) to
 ///   closed surface representation (vtkPolyData type). The conversion algorithm
@@ -49,12 +52,20 @@ public:
   /// If joint smoothing is enabled, surfaces will be created and smoothed as one vtkPolyData.
   /// Joint smoothing converts all segments in shared labelmap together, reducing smoothing artifacts.
   static const std::string GetJointSmoothingParameterName() { return "Joint smoothing"; };
+  /// Conversion parameter: multi-label extraction
+  /// If enabled (and joint smoothing is disabled), surfaces of all labels in a shared labelmap are extracted
+  /// in a single pass over the voxels, then each segment is decimated and smoothed separately.
+  static const std::string GetMultiLabelExtractionParameterName() { return "Multi-label extraction"; };
 
 public:
   static vtkBinaryLabelmapToClosedSurfaceConversionRule* New();
   vtkTypeMacro(vtkBinaryLabelmapToClosedSurfaceConversionRule, vtkSegmentationConverterRule);
   vtkSegmentationConverterRule* CreateRuleInstance() override;
 
+  /// Create a new instance of this rule and copy its contents.
+  /// The label extent cache is shared with the clone.
+  vtkSegmentationConverterRule* Clone() override;
+
   /// Constructs representation object from representation name for the supported representation classes
   /// (typically source and target representation VTK classes, subclasses of vtkDataObject)
   /// Note: Need to take ownership of the created object! For example using vtkSmartPointer<vtkDataObject>::Take
@@ -68,13 +79,25 @@ public:
   /// Perform the actual binary labelmap to closed surface conversion
   bool CreateClosedSurface(vtkOrientedImageData* inputImage, vtkPolyData* outputPolydata, std::vector<int> values);
 
+  /// Extract surfaces of all labels of a labelmap in a single pass over the voxels.
+  /// Surfaces are created by discrete marching cubes in IJK coordinate system, in separate poly data for each label value.
+  /// Regions at the labelmap boundary are closed.
+  static void CreateLabelSurfaces(vtkImageData* labelmap, std::map<int, vtkSmartPointer<vtkPolyData> >& labelSurfaces);
+
+  /// Remove cached label extents of modified labelmap layers
+  bool PreConvert(vtkSegmentation* segmentation) override;
+
   /// Update the target representation based on the source representation
   bool Convert(vtkSegment* segment) override;
 
   /// Perform postprocesing steps on the output
-  /// Clears the joint smoothing cache
+  /// Clears the joint smoothing cache and the cached label surfaces
   bool PostConvert(vtkSegmentation* segmentation) override;
 
+  /// Segments can be converted in parallel unless joint smoothing is enabled,
+  /// as the joint smoothing cache is shared between segments
+  bool IsThreadSafe() override;
+
   /// Get the cost of the conversion.
   unsigned int GetConversionCost(vtkDataObject* sourceRepresentation=nullptr, vtkDataObject* targetRepresentation=nullptr) override;
 
@@ -92,6 +115,20 @@ protected:
   /// This function checks whether this is the case.
   bool IsLabelmapPaddingNecessary(vtkImageData* binaryLabelMap);
 
+  /// Get the extent of voxels with the specified label value.
+  /// Extents of all labels are computed in a single pass over the labelmap and cached until the labelmap is modified.
+  /// \return False if the label value is not found in the labelmap
+  bool GetLabelExtent(vtkImageData* binaryLabelmap, int labelValue, int labelExtent[6]);
+
+  /// Get the surface of a label in IJK coordinate system.
+  /// Surfaces of all labels are extracted in a single pass over the labelmap and cached until PostConvert.
+  /// \return Surface of the label value, nullptr if the label value is not found in the labelmap
+  vtkSmartPointer<vtkPolyData> GetLabelSurface(vtkImageData* binaryLabelmap, int labelValue);
+
+  /// Decimate, smooth, transform to world coordinate system and compute normals of an extracted surface,
+  /// as specified by the conversion parameters
+  bool ProcessClosedSurface(vtkPolyData* surfaceIjk, vtkOrientedImageData* orientedBinaryLabelmap, vtkPolyData* closedSurfacePolyData);
+
 protected:
   vtkBinaryLabelmapToClosedSurfaceConversionRule();
   ~vtkBinaryLabelmapToClosedSurfaceConversionRule() override;
@@ -101,6 +138,12 @@ protected:
   /// The key used is the binary labelmap representation, which maps to the combined vtkPolyData containing surfaces for all segments in the segmentation
   std::map<vtkOrientedImageData*, vtkSmartPointer<vtkPolyData> > JointSmoothCache;
 
+  class vtkLabelmapLayerCache;
+  /// Cache for storing the extent and surface of each label in labelmap layers.
+  /// The cache is shared between clones of the rule so that each layer is scanned only once
+  /// if segments are converted in parallel.
+  std::shared_ptr<vtkLabelmapLayerCache> LayerCache;
+
 private:
   vtkBinaryLabelmapToClosedSurfaceConversionRule(const vtkBinaryLabelmapToClosedSurfaceConversionRule&) = delete;
   void operator=(const vtkBinaryLabelmapToClosedSurfaceConversionRule&) = delete;
@@ -40,6 +40,8 @@
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
 #include <vtkPolyData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkStringArray.h>
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
@@ -73,6 +75,9 @@ vtkSegmentation::vtkSegmentation()
 
   this->SegmentIdAutogeneratorIndex = 0;
 
+  this->ParallelConversion = false;
+  this->AbortConversion = false;
+
   this->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
 }
 
@@ -139,6 +144,7 @@ void vtkSegmentation::DeepCopy(vtkSegmentation* aSegmentation)
 
   // Copy conversion parameters
   this->Converter->DeepCopy(aSegmentation->Converter);
+  this->SetParallelConversion(aSegmentation->GetParallelConversion());
 
   // Deep copy segments list
   std::map<vtkDataObject*, vtkDataObject*> copiedDataObjects;
@@ -154,6 +160,7 @@ void vtkSegmentation::DeepCopy(vtkSegmentation* aSegmentation)
 void vtkSegmentation::CopyConversionParameters(vtkSegmentation* aSegmentation)
 {
   this->Converter->DeepCopy(aSegmentation->Converter);
+  this->SetParallelConversion(aSegmentation->GetParallelConversion());
 }
 
 //----------------------------------------------------------------------------
@@ -166,6 +173,7 @@ void vtkSegmentation::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Modified Time: " << this->GetMTime() << "\n";
 
   os << indent << "MasterRepresentationName:  " << this->MasterRepresentationName << "\n";
+  os << indent << "ParallelConversion:  " << (this->ParallelConversion ? "true" : "false") << "\n";
   os << indent << "Number of segments:  " << this->Segments.size() << "\n";
 
   for (std::deque< std::string >::iterator segmentIdIt = this->SegmentIds.begin();
@@ -1015,9 +1023,13 @@ bool vtkSegmentation::ConvertSegmentsUsingPath(std::vector<std::string> segmentI
     return true;
     }
 
+  this->AbortConversion = false;
+  double progressRange = 1.0 / path.size();
+  double progressStart = 0.0;
+
   // Execute each conversion step in the selected path
   vtkSegmentationConverter::ConversionPathType::iterator pathIt;
-  for (pathIt = path.begin(); pathIt != path.end(); ++pathIt)
+  for (pathIt = path.begin(); pathIt != path.end(); ++pathIt, progressStart += progressRange)
     {
     vtkSegmentationConverterRule* currentConversionRule = (*pathIt);
     if (!currentConversionRule)
@@ -1028,6 +1040,7 @@ bool vtkSegmentation::ConvertSegmentsUsingPath(std::vector<std::string> segmentI
 
     // Perform conversion step
     currentConversionRule->PreConvert(this);
+    std::vector<vtkSegment*> segmentsToConvert;
     for (auto segmentID : segmentIDs)
       {
       vtkSegment* segment = this->GetSegment(segmentID);
@@ -1050,15 +1063,175 @@ bool vtkSegmentation::ConvertSegmentsUsingPath(std::vector<std::string> segmentI
         {
         continue;
         }
-      currentConversionRule->Convert(segment);
+      segmentsToConvert.push_back(segment);
+      }
+
+    bool conversionSucceeded = true;
+    if (this->ParallelConversion && segmentsToConvert.size() > 1 && currentConversionRule->IsThreadSafe())
+      {
+      conversionSucceeded = this->ConvertSegmentsInParallel(currentConversionRule, segmentsToConvert, progressStart, progressRange);
+      }
+    else
+      {
+      for (size_t segmentIndex = 0; segmentIndex < segmentsToConvert.size() && !this->AbortConversion; ++segmentIndex)
+        {
+        currentConversionRule->Convert(segmentsToConvert[segmentIndex]);
+        double progress = progressStart + progressRange * (segmentIndex + 1) / segmentsToConvert.size();
+        this->InvokeEvent(vtkCommand::ProgressEvent, &progress);
+        }
       }
     currentConversionRule->PostConvert(this);
 
+    if (this->AbortConversion)
+      {
+      vtkDebugMacro("ConvertSegmentsUsingPath: Conversion aborted");
+      return false;
+      }
+    if (!conversionSucceeded)
+      {
+      vtkErrorMacro("ConvertSegmentsUsingPath: Conversion failed using rule " << currentConversionRule->GetName());
+      return false;
+      }
   }
 
   return true;
 }
 
+//-----------------------------------------------------------------------------
+namespace
+{
+/// Converts segments using thread-local copies of a conversion rule
+class ConvertSegmentsFunctor
+{
+public:
+  ConvertSegmentsFunctor(vtkSegmentationConverterRule* conversionRule, vtkSegmentation* segmentation)
+    : ConversionRule(conversionRule)
+    , Segmentation(segmentation)
+  {
+  }
+
+  void Initialize()
+  {
+    // Rule instances are reused between batches
+    vtkSmartPointer<vtkSegmentationConverterRule>& threadConversionRule = this->ThreadConversionRules.Local();
+    if (!threadConversionRule)
+      {
+      threadConversionRule = vtkSmartPointer<vtkSegmentationConverterRule>::Take(this->ConversionRule->Clone());
+      }
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    vtkSegmentationConverterRule* threadConversionRule = this->ThreadConversionRules.Local();
+    for (vtkIdType segmentIndex = begin; segmentIndex < end; ++segmentIndex)
+      {
+      if (this->Segmentation->GetAbortConversion())
+        {
+        return;
+        }
+      threadConversionRule->Convert(this->Segments[segmentIndex]);
+      }
+  }
+
+  void Reduce()
+  {
+  }
+
+  vtkSegmentationConverterRule* ConversionRule;
+  vtkSegmentation* Segmentation;
+  /// Temporary segments that the conversion is performed on
+  std::vector<vtkSmartPointer<vtkSegment> > Segments;
+  vtkSMPThreadLocal<vtkSmartPointer<vtkSegmentationConverterRule> > ThreadConversionRules;
+};
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSegmentation::ConvertSegmentsInParallel(vtkSegmentationConverterRule* conversionRule,
+  const std::vector<vtkSegment*>& segments, double progressStart, double progressRange)
+{
+  std::string sourceRepresentationName = conversionRule->GetSourceRepresentationName();
+  std::string targetRepresentationName = conversionRule->GetTargetRepresentationName();
+
+  // Set up temporary segments on this thread so that the conversion does not modify segments
+  // (and therefore does not invoke events) from other threads. Representations are shallow copied
+  // because concurrent filters cannot share the same input data object.
+  ConvertSegmentsFunctor functor(conversionRule, this);
+  for (vtkSegment* segment : segments)
+    {
+    vtkSmartPointer<vtkSegment> temporarySegment = vtkSmartPointer<vtkSegment>::New();
+    temporarySegment->SetLabelValue(segment->GetLabelValue());
+    std::vector<std::string> representationNames = { sourceRepresentationName, targetRepresentationName };
+    for (const std::string& representationName : representationNames)
+      {
+      vtkDataObject* representation = segment->GetRepresentation(representationName);
+      if (!representation)
+        {
+        continue;
+        }
+      vtkImageData* imageData = vtkImageData::SafeDownCast(representation);
+      if (imageData)
+        {
+        // Scalar range is computed and cached on first request, make sure it is not computed concurrently
+        imageData->GetScalarRange();
+        }
+      vtkSmartPointer<vtkDataObject> representationCopy = vtkSmartPointer<vtkDataObject>::Take(
+        conversionRule->ConstructRepresentationObjectByClass(representation->GetClassName()));
+      if (!representationCopy)
+        {
+        vtkErrorMacro("ConvertSegmentsInParallel: Failed to create representation of class " << representation->GetClassName());
+        return false;
+        }
+      representationCopy->ShallowCopy(representation);
+      temporarySegment->AddRepresentation(representationName, representationCopy);
+      }
+    functor.Segments.push_back(temporarySegment);
+    }
+
+  // Convert in batches to allow reporting progress and aborting from this thread
+  vtkIdType numberOfSegments = static_cast<vtkIdType>(segments.size());
+  vtkIdType batchSize = std::max(4 * vtkSMPTools::GetEstimatedNumberOfThreads(), 1);
+  for (vtkIdType batchStart = 0; batchStart < numberOfSegments; batchStart += batchSize)
+    {
+    vtkIdType batchEnd = std::min(batchStart + batchSize, numberOfSegments);
+    vtkSMPTools::For(batchStart, batchEnd, 1, functor);
+    if (this->AbortConversion)
+      {
+      return false;
+      }
+    double progress = progressStart + progressRange * batchEnd / numberOfSegments;
+    this->InvokeEvent(vtkCommand::ProgressEvent, &progress);
+    if (this->AbortConversion)
+      {
+      return false;
+      }
+    }
+
+  // Store results in segment order. Existing target representation objects are updated
+  // (instead of replaced), the same way as when the conversion is performed directly on the segment.
+  for (size_t segmentIndex = 0; segmentIndex < segments.size(); ++segmentIndex)
+    {
+    vtkSegment* segment = segments[segmentIndex];
+    vtkSegment* temporarySegment = functor.Segments[segmentIndex];
+    vtkDataObject* convertedRepresentation = temporarySegment->GetRepresentation(targetRepresentationName);
+    if (!convertedRepresentation)
+      {
+      continue;
+      }
+    vtkDataObject* targetRepresentation = segment->GetRepresentation(targetRepresentationName);
+    if (targetRepresentation)
+      {
+      targetRepresentation->ShallowCopy(convertedRepresentation);
+      }
+    else
+      {
+      segment->AddRepresentation(targetRepresentationName, convertedRepresentation);
+      }
+    segment->SetLabelValue(temporarySegment->GetLabelValue());
+    }
+
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 bool vtkSegmentation::ConvertSegmentUsingPath(vtkSegment* segment, vtkSegmentationConverter::ConversionPathType path, bool overwriteExisting/*=false*/)
 {
@@ -1177,7 +1350,11 @@ bool vtkSegmentation::CreateRepresentation(const std::string& targetRepresentati
   this->GetSegmentIDs(segmentIDs);
   if (!this->ConvertSegmentsUsingPath(segmentIDs, cheapestPath, alwaysConvert))
     {
-    vtkErrorMacro("CreateRepresentation: Conversion failed");
+    this->SetSegmentModifiedEnabled(wasSegmentModifiedEnabled);
+    if (!this->AbortConversion)
+      {
+      vtkErrorMacro("CreateRepresentation: Conversion failed");
+      }
     return false;
     }
 
@@ -472,6 +472,26 @@ public:
   /// the segmentation! Use \sa CreateRepresentation for that.
   virtual void SetMasterRepresentationName(const std::string& representationName);
 
+  /// Convert segments in parallel if the conversion rule supports it (\sa vtkSegmentationConverterRule::IsThreadSafe).
+  /// Converted representations are stored in the segments in the order of segments, from the calling thread.
+  /// Disabled by default, because conversion rules may use multi-threaded filters internally
+  /// and nested parallelism depends on the vtkSMPTools backend: the TBB backend shares its threads
+  /// between the outer and inner loops, while other backends may start more threads than
+  /// available cores. In Slicer it can be enabled for new segmentations in application settings
+  /// (Segmentations / Parallel conversion). Copied with the conversion parameters.
+  vtkGetMacro(ParallelConversion, bool);
+  vtkSetMacro(ParallelConversion, bool);
+  vtkBooleanMacro(ParallelConversion, bool);
+
+  /// Request interruption of the ongoing representation conversion.
+  /// Conversion progress is reported by vtkCommand::ProgressEvent (with a pointer to a double value
+  /// between 0 and 1 as call data), observers of that event may enable this flag to cancel the conversion.
+  /// Segments that were converted before the interruption may keep their new representation.
+  /// The flag is reset when a new conversion starts.
+  vtkGetMacro(AbortConversion, bool);
+  vtkSetMacro(AbortConversion, bool);
+  vtkBooleanMacro(AbortConversion, bool);
+
   /// Deep copies source segment to destination segment. If the same representation is found in baseline
   /// with up-to-date timestamp then the representation is reused from baseline.
   static void CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline,
@@ -488,6 +508,16 @@ protected:
   /// \return Success flag
   bool ConvertSegmentUsingPath(vtkSegment* segment, vtkSegmentationConverter::ConversionPathType path, bool overwriteExisting = false);
 
+  /// Convert segments using a thread-safe conversion rule, distributing the segments among threads.
+  /// Segments are converted in batches, progress is reported and abort is checked after each batch.
+  /// \param conversionRule Conversion step to perform
+  /// \param segments Segments to convert. Each segment must contain the source representation of the rule.
+  /// \param progressStart Progress value reported before conversion
+  /// \param progressRange Progress value increase by the end of the conversion
+  /// \return False if the conversion was aborted or failed
+  bool ConvertSegmentsInParallel(vtkSegmentationConverterRule* conversionRule, const std::vector<vtkSegment*>& segments,
+    double progressStart, double progressRange);
+
   /// Converts a single segment to a representation.
   bool ConvertSingleSegment(std::string segmentId, std::string targetRepresentationName);
 
@@ -560,6 +590,12 @@ protected:
 
   std::set<vtkSmartPointer<vtkDataObject> > MasterRepresentationCache;
 
+  /// Segments are converted in parallel if the conversion rule supports it
+  bool ParallelConversion;
+
+  /// Flag requesting interruption of the ongoing conversion
+  bool AbortConversion;
+
   friend class vtkMRMLSegmentationNode;
   friend class vtkSlicerSegmentationsModuleLogic;
   friend class vtkSegmentationModifier;
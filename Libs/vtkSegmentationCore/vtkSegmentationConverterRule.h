@@ -96,6 +96,13 @@ public:
   /// This step should be unneccessary if only converting a single segment
   virtual bool PostConvert(vtkSegmentation* vtkNotUsed(segmentation)) { return true; };
 
+  /// Determine if segments can be converted concurrently, each thread using its own instance
+  /// of the rule (created by \sa Clone). Convert is then called with a temporary segment that
+  /// contains shallow copies of the source (and existing target) representation and PreConvert
+  /// and PostConvert are only called on the original rule instance.
+  /// Rules that store state shared between segments during conversion must return false (default).
+  virtual bool IsThreadSafe() { return false; };
+
   /// Get the cost of the conversion.
   /// \return Expected duration of the conversion in milliseconds. If the arguments are omitted, then a rough average can be
   ///   given just to indicate the relative computational cost of the algorithm. If the objects are given, then a more educated
@@ -22,14 +22,19 @@
 #include "vtkSegmentationHistory.h"
 #include "vtkSegmentationConverterFactory.h"
 #include "vtkSegmentation.h"
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
 
 // VTK includes
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkCallbackCommand.h>
+#include <vtkPointData.h>
 
 // std includes
 #include <algorithm>
+#include <cstring>
+#include <set>
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSegmentationHistory);
@@ -40,6 +45,8 @@ vtkSegmentationHistory::vtkSegmentationHistory()
   this->Segmentation = nullptr;
 
   this->MaximumNumberOfStates = 5;
+  this->MaximumMemorySize = 0;
+  this->CompressionEnabled = true;
 
   this->LastRestoredState = 0;
   this->RestoreStateInProgress = false;
@@ -98,6 +105,9 @@ void vtkSegmentationHistory::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Modified Time: " << this->GetMTime() << "\n";
 
   os << indent << "Number of saved states:  " << this->SegmentationStates.size() << "\n";
+  os << indent << "MaximumNumberOfStates:  " << this->MaximumNumberOfStates << "\n";
+  os << indent << "MaximumMemorySize:  " << this->MaximumMemorySize << "\n";
+  os << indent << "CompressionEnabled:  " << (this->CompressionEnabled ? "true" : "false") << "\n";
 }
 
 //---------------------------------------------------------------------------
@@ -134,7 +144,7 @@ bool vtkSegmentationHistory::SaveState()
     // Previous saved state of the segment
     // (if the new state has exactly the same representation then only a shallow copy will be made)
     vtkSegment* baselineSegment = nullptr;
-    if (this->SegmentationStates.size() > 0)
+    if (this->SegmentationStates.size() > 0 && !this->SegmentationStates.back().LabelmapsReconstructed)
       {
       SegmentsMap::iterator baselineSegmentIt = this->SegmentationStates.back().Segments.find(*segmentIDIt);
       if (baselineSegmentIt != this->SegmentationStates.back().Segments.end())
@@ -148,6 +158,11 @@ bool vtkSegmentationHistory::SaveState()
     newSegmentationState.Segments[*segmentIDIt] = segmentClone;
     }
   this->SegmentationStates.push_back(newSegmentationState);
+  if (this->SegmentationStates.size() > 1)
+    {
+    // Only the most recent state needs to store full labelmaps
+    this->StoreLabelmapDifferences(static_cast<unsigned int>(this->SegmentationStates.size()) - 2);
+    }
 
   // Set the current state as last restored state
   this->LastRestoredState = (unsigned int)this->SegmentationStates.size();
@@ -209,7 +224,13 @@ bool vtkSegmentationHistory::RestoreState(unsigned int stateIndex)
 {
   this->RestoreStateInProgress = true;
 
-  SegmentationState restoredState = this->SegmentationStates[stateIndex];
+  SegmentationState restoredState;
+  if (!this->ReconstructState(stateIndex, restoredState))
+    {
+    vtkErrorMacro("vtkSegmentation::RestoreState failed: cannot reconstruct state " << stateIndex);
+    this->RestoreStateInProgress = false;
+    return false;
+    }
 
   std::set<std::string> segmentIDsToKeep;
   std::map<vtkDataObject*, vtkDataObject*> restoredRepresentations;
@@ -285,6 +306,23 @@ bool vtkSegmentationHistory::IsRestoreNextStateAvailable()
 //---------------------------------------------------------------------------
 void vtkSegmentationHistory::RemoveAllNextStates()
 {
+  if (this->SegmentationStates.size() <= this->LastRestoredState + 1)
+    {
+    // no next states
+    return;
+    }
+
+  // The state that becomes the most recent one must store full labelmaps,
+  // because differences of previous states are computed from them.
+  SegmentationState lastRestoredState;
+  if (!this->ReconstructState(this->LastRestoredState, lastRestoredState))
+    {
+    vtkErrorMacro("RemoveAllNextStates: failed to reconstruct state " << this->LastRestoredState << ", all states are removed");
+    this->RemoveAllStates();
+    return;
+    }
+  this->SegmentationStates[this->LastRestoredState] = lastRestoredState;
+
   bool modified = false;
   while ((this->SegmentationStates.size() > this->LastRestoredState + 1) && (!this->SegmentationStates.empty()))
     {
@@ -307,6 +345,18 @@ void vtkSegmentationHistory::RemoveAllObsoleteStates()
     this->LastRestoredState--;
     modified = true;
    }
+  if (this->MaximumMemorySize > 0)
+    {
+    // The oldest state can be removed without reconstructing any labelmaps,
+    // as no other states are computed from it.
+    while (this->SegmentationStates.size() > 1 && this->LastRestoredState > 0
+      && this->GetMemorySize() > this->MaximumMemorySize)
+      {
+      this->SegmentationStates.pop_front();
+      this->LastRestoredState--;
+      modified = true;
+      }
+    }
   if (modified)
     {
     this->Modified();
@@ -363,3 +413,374 @@ int vtkSegmentationHistory::GetNumberOfStates()
 {
   return this->SegmentationStates.size();
 }
+
+//---------------------------------------------------------------------------
+void vtkSegmentationHistory::SetMaximumMemorySize(vtkTypeInt64 maximumMemorySize)
+{
+  if (maximumMemorySize == this->MaximumMemorySize)
+    {
+    return;
+    }
+  this->MaximumMemorySize = maximumMemorySize;
+  this->RemoveAllObsoleteStates();
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+vtkTypeInt64 vtkSegmentationHistory::GetMemorySize()
+{
+  vtkTypeInt64 memorySize = 0;
+  std::set<vtkDataObject*> countedRepresentations;
+  for (const SegmentationState& state : this->SegmentationStates)
+    {
+    for (SegmentsMap::const_iterator segmentIt = state.Segments.begin(); segmentIt != state.Segments.end(); ++segmentIt)
+      {
+      std::vector<std::string> representationNames;
+      segmentIt->second->GetContainedRepresentationNames(representationNames);
+      for (const std::string& representationName : representationNames)
+        {
+        vtkDataObject* representation = segmentIt->second->GetRepresentation(representationName);
+        if (representation && countedRepresentations.insert(representation).second)
+          {
+          memorySize += static_cast<vtkTypeInt64>(representation->GetActualMemorySize()) * 1024;
+          }
+        }
+      }
+    for (const LabelmapDifference& difference : state.LabelmapDifferences)
+      {
+      memorySize += static_cast<vtkTypeInt64>(difference.Voxels.size());
+      }
+    }
+  return memorySize;
+}
+
+//---------------------------------------------------------------------------
+void vtkSegmentationHistory::StoreLabelmapDifferences(unsigned int stateIndex)
+{
+  if (stateIndex + 1 >= this->SegmentationStates.size())
+    {
+    vtkErrorMacro("StoreLabelmapDifferences failed: invalid state index " << stateIndex);
+    return;
+    }
+  SegmentationState& state = this->SegmentationStates[stateIndex];
+  SegmentationState& nextState = this->SegmentationStates[stateIndex + 1];
+  if (!state.LabelmapDifferences.empty())
+    {
+    // already stored as difference
+    return;
+    }
+
+  // Index of the difference in state.LabelmapDifferences for each labelmap.
+  // Shared labelmaps are stored only once. Labelmaps that must be kept as is are indicated by -1.
+  std::map<vtkDataObject*, int> labelmapDifferenceIndices;
+  for (SegmentsMap::iterator segmentIt = state.Segments.begin(); segmentIt != state.Segments.end(); ++segmentIt)
+    {
+    std::vector<std::string> representationNames;
+    segmentIt->second->GetContainedRepresentationNames(representationNames);
+    for (const std::string& representationName : representationNames)
+      {
+      vtkOrientedImageData* labelmap = vtkOrientedImageData::SafeDownCast(segmentIt->second->GetRepresentation(representationName));
+      if (!labelmap)
+        {
+        continue;
+        }
+      std::map<vtkDataObject*, int>::iterator differenceIndexIt = labelmapDifferenceIndices.find(labelmap);
+      if (differenceIndexIt != labelmapDifferenceIndices.end())
+        {
+        if (differenceIndexIt->second >= 0)
+          {
+          state.LabelmapDifferences[differenceIndexIt->second].Users.push_back(std::make_pair(segmentIt->first, representationName));
+          }
+        continue;
+        }
+
+      vtkOrientedImageData* referenceLabelmap = nullptr;
+      SegmentsMap::iterator referenceSegmentIt = nextState.Segments.find(segmentIt->first);
+      if (referenceSegmentIt != nextState.Segments.end())
+        {
+        referenceLabelmap = vtkOrientedImageData::SafeDownCast(referenceSegmentIt->second->GetRepresentation(representationName));
+        }
+      LabelmapDifference difference;
+      if (!referenceLabelmap || !this->ComputeLabelmapDifference(labelmap, referenceLabelmap, difference))
+        {
+        // keep the full labelmap
+        labelmapDifferenceIndices[labelmap] = -1;
+        continue;
+        }
+      difference.ReferenceSegmentId = segmentIt->first;
+      difference.ReferenceRepresentationName = representationName;
+      difference.Users.push_back(std::make_pair(segmentIt->first, representationName));
+      labelmapDifferenceIndices[labelmap] = static_cast<int>(state.LabelmapDifferences.size());
+      state.LabelmapDifferences.push_back(difference);
+      }
+    }
+
+  // Labelmaps are now stored as differences, release the full copies
+  for (const LabelmapDifference& difference : state.LabelmapDifferences)
+    {
+    for (const std::pair<std::string, std::string>& user : difference.Users)
+      {
+      state.Segments[user.first]->RemoveRepresentation(user.second);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+bool vtkSegmentationHistory::ReconstructState(unsigned int stateIndex, SegmentationState& reconstructedState)
+{
+  if (stateIndex >= this->SegmentationStates.size())
+    {
+    return false;
+    }
+
+  // Find the first state that stores full labelmaps
+  unsigned int fullStateIndex = stateIndex;
+  while (!this->SegmentationStates[fullStateIndex].LabelmapDifferences.empty())
+    {
+    fullStateIndex++;
+    if (fullStateIndex >= this->SegmentationStates.size())
+      {
+      vtkErrorMacro("ReconstructState failed: the most recent state is stored as difference");
+      return false;
+      }
+    }
+  reconstructedState = this->SegmentationStates[fullStateIndex];
+
+  // Labelmaps that were created during reconstruction (not referenced by the stored states),
+  // therefore they can be modified in place.
+  std::set<vtkDataObject*> reconstructedLabelmaps;
+
+  // Reconstruct labelmaps of previous states by applying the differences
+  for (int index = static_cast<int>(fullStateIndex) - 1; index >= static_cast<int>(stateIndex); --index)
+    {
+    const SegmentationState& storedState = this->SegmentationStates[index];
+    SegmentationState previousState;
+    previousState.Segments = storedState.Segments;
+    previousState.SegmentIds = storedState.SegmentIds;
+    previousState.LabelmapsReconstructed = true;
+
+    // Get reference labelmaps and count how many differences use each
+    std::vector<vtkOrientedImageData*> referenceLabelmaps;
+    std::map<vtkOrientedImageData*, int> referenceCounts;
+    for (const LabelmapDifference& difference : storedState.LabelmapDifferences)
+      {
+      vtkOrientedImageData* referenceLabelmap = nullptr;
+      SegmentsMap::iterator referenceSegmentIt = reconstructedState.Segments.find(difference.ReferenceSegmentId);
+      if (referenceSegmentIt != reconstructedState.Segments.end())
+        {
+        referenceLabelmap = vtkOrientedImageData::SafeDownCast(
+          referenceSegmentIt->second->GetRepresentation(difference.ReferenceRepresentationName));
+        }
+      if (!referenceLabelmap)
+        {
+        vtkErrorMacro("ReconstructState failed: reference labelmap of segment " << difference.ReferenceSegmentId << " not found");
+        return false;
+        }
+      referenceLabelmaps.push_back(referenceLabelmap);
+      referenceCounts[referenceLabelmap]++;
+      }
+
+    std::set<vtkDataObject*> previousReconstructedLabelmaps;
+    std::map<std::string, vtkSmartPointer<vtkSegment> > clonedSegments;
+    for (size_t differenceIndex = 0; differenceIndex < storedState.LabelmapDifferences.size(); ++differenceIndex)
+      {
+      const LabelmapDifference& difference = storedState.LabelmapDifferences[differenceIndex];
+      vtkOrientedImageData* referenceLabelmap = referenceLabelmaps[differenceIndex];
+      vtkSmartPointer<vtkOrientedImageData> labelmap;
+      if (referenceCounts[referenceLabelmap] == 1 && reconstructedLabelmaps.count(referenceLabelmap))
+        {
+        // the reference labelmap is not needed anymore, reuse it
+        labelmap = referenceLabelmap;
+        }
+      else
+        {
+        labelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+        labelmap->DeepCopy(referenceLabelmap);
+        }
+      if (!this->ApplyLabelmapDifference(labelmap, difference))
+        {
+        return false;
+        }
+      previousReconstructedLabelmaps.insert(labelmap);
+
+      for (const std::pair<std::string, std::string>& user : difference.Users)
+        {
+        // Segments in the stored state must not be modified, therefore a shallow copy is made
+        vtkSmartPointer<vtkSegment> segment = clonedSegments[user.first];
+        if (!segment)
+          {
+          vtkSegment* storedSegment = previousState.Segments[user.first];
+          segment = vtkSmartPointer<vtkSegment>::New();
+          segment->DeepCopyMetadata(storedSegment);
+          std::vector<std::string> representationNames;
+          storedSegment->GetContainedRepresentationNames(representationNames);
+          for (const std::string& representationName : representationNames)
+            {
+            segment->AddRepresentation(representationName, storedSegment->GetRepresentation(representationName));
+            }
+          clonedSegments[user.first] = segment;
+          previousState.Segments[user.first] = segment;
+          }
+        segment->AddRepresentation(user.second, labelmap);
+        }
+      }
+
+    reconstructedState = previousState;
+    reconstructedLabelmaps = previousReconstructedLabelmaps;
+    }
+
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSegmentationHistory::ComputeLabelmapDifference(vtkOrientedImageData* labelmap, vtkOrientedImageData* referenceLabelmap,
+  LabelmapDifference& difference)
+{
+  int emptyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  std::copy(emptyExtent, emptyExtent + 6, difference.Extent);
+  difference.Voxels.clear();
+  difference.Compressed = false;
+
+  if (labelmap == referenceLabelmap)
+    {
+    // same object, no difference
+    return true;
+    }
+  if (!labelmap->GetPointData()->GetScalars() || !referenceLabelmap->GetPointData()->GetScalars()
+    || labelmap->GetScalarType() != referenceLabelmap->GetScalarType()
+    || labelmap->GetNumberOfScalarComponents() != referenceLabelmap->GetNumberOfScalarComponents()
+    || !vtkOrientedImageDataResample::DoGeometriesMatch(labelmap, referenceLabelmap)
+    || !vtkOrientedImageDataResample::DoExtentsMatch(labelmap, referenceLabelmap))
+    {
+    return false;
+    }
+
+  // Find the bounding box of differing voxels
+  int* extent = labelmap->GetExtent();
+  const int voxelSize = labelmap->GetScalarSize() * labelmap->GetNumberOfScalarComponents();
+  const size_t rowSize = static_cast<size_t>(extent[1] - extent[0] + 1) * voxelSize;
+  int modifiedExtent[6] = { extent[1], extent[0], extent[3], extent[2], extent[5], extent[4] };
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      unsigned char* row = static_cast<unsigned char*>(labelmap->GetScalarPointer(extent[0], j, k));
+      unsigned char* referenceRow = static_cast<unsigned char*>(referenceLabelmap->GetScalarPointer(extent[0], j, k));
+      if (memcmp(row, referenceRow, rowSize) == 0)
+        {
+        continue;
+        }
+      int firstModifiedI = extent[0];
+      while (memcmp(row + (firstModifiedI - extent[0]) * voxelSize, referenceRow + (firstModifiedI - extent[0]) * voxelSize, voxelSize) == 0)
+        {
+        ++firstModifiedI;
+        }
+      int lastModifiedI = extent[1];
+      while (memcmp(row + (lastModifiedI - extent[0]) * voxelSize, referenceRow + (lastModifiedI - extent[0]) * voxelSize, voxelSize) == 0)
+        {
+        --lastModifiedI;
+        }
+      modifiedExtent[0] = std::min(modifiedExtent[0], firstModifiedI);
+      modifiedExtent[1] = std::max(modifiedExtent[1], lastModifiedI);
+      modifiedExtent[2] = std::min(modifiedExtent[2], j);
+      modifiedExtent[3] = std::max(modifiedExtent[3], j);
+      modifiedExtent[4] = std::min(modifiedExtent[4], k);
+      modifiedExtent[5] = std::max(modifiedExtent[5], k);
+      }
+    }
+  if (modifiedExtent[0] > modifiedExtent[1])
+    {
+    // identical contents
+    return true;
+    }
+  std::copy(modifiedExtent, modifiedExtent + 6, difference.Extent);
+
+  // Store voxels of the labelmap within the modified extent
+  const size_t modifiedRowSize = static_cast<size_t>(modifiedExtent[1] - modifiedExtent[0] + 1) * voxelSize;
+  for (int k = modifiedExtent[4]; k <= modifiedExtent[5]; ++k)
+    {
+    for (int j = modifiedExtent[2]; j <= modifiedExtent[3]; ++j)
+      {
+      unsigned char* row = static_cast<unsigned char*>(labelmap->GetScalarPointer(modifiedExtent[0], j, k));
+      if (!this->CompressionEnabled)
+        {
+        difference.Voxels.insert(difference.Voxels.end(), row, row + modifiedRowSize);
+        continue;
+        }
+      // Run-length encoding: number of repetitions (unsigned int) followed by the voxel value
+      for (size_t runStart = 0; runStart < modifiedRowSize; )
+        {
+        size_t runEnd = runStart + voxelSize;
+        while (runEnd < modifiedRowSize && memcmp(row + runStart, row + runEnd, voxelSize) == 0)
+          {
+          runEnd += voxelSize;
+          }
+        unsigned int runLength = static_cast<unsigned int>((runEnd - runStart) / voxelSize);
+        unsigned char* runLengthBytes = reinterpret_cast<unsigned char*>(&runLength);
+        difference.Voxels.insert(difference.Voxels.end(), runLengthBytes, runLengthBytes + sizeof(runLength));
+        difference.Voxels.insert(difference.Voxels.end(), row + runStart, row + runStart + voxelSize);
+        runStart = runEnd;
+        }
+      }
+    }
+  difference.Compressed = this->CompressionEnabled;
+  difference.Voxels.shrink_to_fit();
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSegmentationHistory::ApplyLabelmapDifference(vtkOrientedImageData* labelmap, const LabelmapDifference& difference)
+{
+  const int* modifiedExtent = difference.Extent;
+  if (modifiedExtent[0] > modifiedExtent[1] || modifiedExtent[2] > modifiedExtent[3] || modifiedExtent[4] > modifiedExtent[5])
+    {
+    // no difference
+    return true;
+    }
+  const int voxelSize = labelmap->GetScalarSize() * labelmap->GetNumberOfScalarComponents();
+  const size_t modifiedRowSize = static_cast<size_t>(modifiedExtent[1] - modifiedExtent[0] + 1) * voxelSize;
+  const unsigned char* voxels = difference.Voxels.data();
+  const unsigned char* voxelsEnd = voxels + difference.Voxels.size();
+  for (int k = modifiedExtent[4]; k <= modifiedExtent[5]; ++k)
+    {
+    for (int j = modifiedExtent[2]; j <= modifiedExtent[3]; ++j)
+      {
+      unsigned char* row = static_cast<unsigned char*>(labelmap->GetScalarPointer(modifiedExtent[0], j, k));
+      if (!difference.Compressed)
+        {
+        if (voxels + modifiedRowSize > voxelsEnd)
+          {
+          vtkErrorMacro("ApplyLabelmapDifference failed: not enough voxels stored");
+          return false;
+          }
+        memcpy(row, voxels, modifiedRowSize);
+        voxels += modifiedRowSize;
+        continue;
+        }
+      for (size_t position = 0; position < modifiedRowSize; )
+        {
+        unsigned int runLength = 0;
+        if (voxels + sizeof(runLength) + voxelSize > voxelsEnd)
+          {
+          vtkErrorMacro("ApplyLabelmapDifference failed: not enough voxels stored");
+          return false;
+          }
+        memcpy(&runLength, voxels, sizeof(runLength));
+        voxels += sizeof(runLength);
+        if (position + static_cast<size_t>(runLength) * voxelSize > modifiedRowSize)
+          {
+          vtkErrorMacro("ApplyLabelmapDifference failed: invalid run length");
+          return false;
+          }
+        for (unsigned int i = 0; i < runLength; ++i)
+          {
+          memcpy(row + position, voxels, voxelSize);
+          position += voxelSize;
+          }
+        voxels += voxelSize;
+        }
+      }
+    }
+  labelmap->Modified();
+  return true;
+}
@@ -34,6 +34,7 @@
 
 class vtkCallbackCommand;
 class vtkDataObject;
+class vtkOrientedImageData;
 class vtkSegment;
 class vtkSegmentation;
 
@@ -54,6 +55,8 @@ public:
 
   /// Saves all master representations of the segmentation in its current state.
   /// States more recent than the last restored state are removed.
+  /// Labelmaps of the previously saved state are replaced by the region where they differ
+  /// from the current labelmaps, which keeps the size of each state small.
   /// \return Success flag
   bool SaveState();
 
@@ -86,6 +89,24 @@ public:
   /// Get the current number of states.
   int GetNumberOfStates();
 
+  /// Limits how much memory (in bytes) the stored states may use.
+  /// If the memory usage exceeds the limit then the oldest states are removed
+  /// (the most recent state is always kept). Set to 0 for no limit (default).
+  void SetMaximumMemorySize(vtkTypeInt64 maximumMemorySize);
+
+  /// Get the limit of how much memory (in bytes) the stored states may use.
+  vtkGetMacro(MaximumMemorySize, vtkTypeInt64);
+
+  /// Get the memory (in bytes) used by all the stored states.
+  /// Representations that are shared between states are only counted once.
+  vtkTypeInt64 GetMemorySize();
+
+  /// Enable run-length encoding of modified labelmap regions stored in previous states.
+  /// Reduces memory usage at the cost of slightly longer save and restore times. Enabled by default.
+  vtkSetMacro(CompressionEnabled, bool);
+  vtkGetMacro(CompressionEnabled, bool);
+  vtkBooleanMacro(CompressionEnabled, bool);
+
 protected:
   /// Callback function called when the segmentation has been modified.
   /// It clears all states that are more recent than the last restored state.
@@ -95,27 +116,67 @@ protected:
   void RemoveAllNextStates();
 
   /// Delete all old states so that we keep only up to MaximumNumberOfStates states
+  /// and the memory usage does not exceed MaximumMemorySize
   void RemoveAllObsoleteStates();
 
   /// Restores a state defined by stateIndex.
   bool RestoreState(unsigned int stateIndex);
 
+  /// Replace labelmaps in the state defined by stateIndex by their differences
+  /// from the corresponding labelmaps in the next state.
+  void StoreLabelmapDifferences(unsigned int stateIndex);
+
 protected:
   vtkSegmentationHistory();
   ~vtkSegmentationHistory() override;
 
   typedef std::map<std::string, vtkSmartPointer<vtkSegment> > SegmentsMap;
 
+  /// Labelmap representation that is stored as the difference from a labelmap in the next state.
+  struct LabelmapDifference
+    {
+    /// Segment IDs and representation names in the state that refer to this labelmap
+    std::vector<std::pair<std::string, std::string> > Users;
+    /// Segment in the next state that contains the labelmap that this labelmap is computed from
+    std::string ReferenceSegmentId;
+    std::string ReferenceRepresentationName;
+    /// Region where the labelmap differs from the labelmap in the next state.
+    /// Empty extent if the two labelmaps are identical.
+    int Extent[6];
+    /// Voxels of the labelmap within Extent (run-length encoded if Compressed is true)
+    std::vector<unsigned char> Voxels;
+    bool Compressed;
+    };
+
   struct SegmentationState
     {
     SegmentsMap Segments;
     std::vector<std::string> SegmentIds; // order of segments
+    /// Labelmaps that are not stored in Segments but computed from labelmaps in the next state
+    std::vector<LabelmapDifference> LabelmapDifferences;
+    /// Labelmaps were reconstructed from differences, after the segmentation may have been modified,
+    /// therefore they cannot be used as baseline when saving the next state.
+    bool LabelmapsReconstructed{false};
     };
 
+  /// Get a state defined by stateIndex with all labelmaps reconstructed from the stored differences.
+  bool ReconstructState(unsigned int stateIndex, SegmentationState& reconstructedState);
+
+  /// Compute difference of a labelmap from the reference labelmap.
+  /// Returns false if the difference cannot be stored (e.g., the labelmap geometries are different).
+  bool ComputeLabelmapDifference(vtkOrientedImageData* labelmap, vtkOrientedImageData* referenceLabelmap,
+    LabelmapDifference& difference);
+
+  /// Write the voxels stored in the difference into the labelmap.
+  bool ApplyLabelmapDifference(vtkOrientedImageData* labelmap, const LabelmapDifference& difference);
+
+protected:
   vtkSegmentation* Segmentation;
   vtkCallbackCommand* SegmentationModifiedCallbackCommand;
   std::deque<SegmentationState> SegmentationStates;
   unsigned int MaximumNumberOfStates;
+  vtkTypeInt64 MaximumMemorySize;
+  bool CompressionEnabled;
 
   // Index of the state in SegmentationStates that was restored last.
   // If index == size of states then it means that the segmentation has changed
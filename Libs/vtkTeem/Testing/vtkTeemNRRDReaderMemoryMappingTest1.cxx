@@ -0,0 +1,270 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkTeem includes
+#include <vtkTeemNRRDReader.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+
+const int DIMENSIONS[3] = { 512, 512, 256 };
+
+//----------------------------------------------------------------------------
+short GetVoxelValue(vtkIdType index)
+{
+  return static_cast<short>((index * 37) % 4001 - 2000);
+}
+
+//----------------------------------------------------------------------------
+bool IsLittleEndian()
+{
+  const unsigned short value = 1;
+  return *reinterpret_cast<const unsigned char*>(&value) == 1;
+}
+
+//----------------------------------------------------------------------------
+/// Write a raw-encoded short volume. If dataFileName is empty then the data
+/// is attached to the header, otherwise the data is written into a separate file.
+bool WriteVolume(const std::string& headerFileName, const std::string& dataFileName)
+{
+  std::ofstream header(headerFileName.c_str(), std::ios::out | std::ios::binary);
+  header << "NRRD0004\n"
+    << "type: short\n"
+    << "dimension: 3\n"
+    << "space: left-posterior-superior\n"
+    << "sizes: " << DIMENSIONS[0] << " " << DIMENSIONS[1] << " " << DIMENSIONS[2] << "\n"
+    << "space directions: (0.5,0,0) (0,0.5,0) (0,0,1.5)\n"
+    << "kinds: domain domain domain\n"
+    << "endian: " << (IsLittleEndian() ? "little" : "big") << "\n"
+    << "encoding: raw\n"
+    << "space origin: (10,20,30)\n";
+  std::ofstream dataFile;
+  std::ostream* data = &header;
+  if (!dataFileName.empty())
+    {
+    header << "data file: " << dataFileName.substr(dataFileName.find_last_of('/') + 1) << "\n";
+    dataFile.open(dataFileName.c_str(), std::ios::out | std::ios::binary);
+    data = &dataFile;
+    }
+  header << "\n";
+
+  const vtkIdType sliceSize = DIMENSIONS[0] * DIMENSIONS[1];
+  short* slice = new short[sliceSize];
+  for (int k = 0; k < DIMENSIONS[2]; ++k)
+    {
+    for (vtkIdType i = 0; i < sliceSize; ++i)
+      {
+      slice[i] = GetVoxelValue(k * sliceSize + i);
+      }
+    data->write(reinterpret_cast<char*>(slice), sliceSize * sizeof(short));
+    }
+  delete[] slice;
+  return data->good();
+}
+
+//----------------------------------------------------------------------------
+/// Returns resident set size of the process in bytes (or -1 if not available)
+double GetResidentMemorySize()
+{
+#ifdef __linux__
+  std::ifstream statm("/proc/self/statm");
+  double sizePages = 0;
+  double residentPages = -1;
+  statm >> sizePages >> residentPages;
+  return residentPages * 4096.0;
+#else
+  return -1;
+#endif
+}
+
+//----------------------------------------------------------------------------
+int TestReadVolume(const std::string& fileName)
+{
+  vtkNew<vtkTeemNRRDReader> reader;
+  reader->SetFileName(fileName.c_str());
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  reader->Update();
+  timer->StopTimer();
+  double readTime = timer->GetElapsedTime();
+  if (reader->GetMemoryMapped())
+    {
+    std::cerr << "Line " << __LINE__ << ": memory mapping was not requested but it was used" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkImageData* image = reader->GetOutput();
+
+  double memoryBeforeRead = GetResidentMemorySize();
+  vtkNew<vtkTeemNRRDReader> mappedReader;
+  mappedReader->SetFileName(fileName.c_str());
+  mappedReader->UseMemoryMappingOn();
+  timer->StartTimer();
+  mappedReader->Update();
+  timer->StopTimer();
+  double mappedReadTime = timer->GetElapsedTime();
+  if (!mappedReader->GetMemoryMapped())
+    {
+    std::cerr << "Line " << __LINE__ << ": volume was not memory-mapped: " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkImageData* mappedImage = mappedReader->GetOutput();
+
+  // Geometry is the same
+  int* dimensions = mappedImage->GetDimensions();
+  if (dimensions[0] != DIMENSIONS[0] || dimensions[1] != DIMENSIONS[1] || dimensions[2] != DIMENSIONS[2]
+    || mappedImage->GetScalarType() != VTK_SHORT
+    || mappedImage->GetSpacing()[0] != image->GetSpacing()[0]
+    || mappedImage->GetSpacing()[2] != image->GetSpacing()[2])
+    {
+    std::cerr << "Line " << __LINE__ << ": geometry mismatch in " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int row = 0; row < 4; ++row)
+    {
+    for (int column = 0; column < 4; ++column)
+      {
+      if (mappedReader->GetRasToIjkMatrix()->GetElement(row, column) != reader->GetRasToIjkMatrix()->GetElement(row, column))
+        {
+        std::cerr << "Line " << __LINE__ << ": RAS to IJK matrix mismatch in " << fileName << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // Accessing a few slices only loads those slices into memory
+  const vtkIdType sliceSize = DIMENSIONS[0] * DIMENSIONS[1];
+  short* voxels = static_cast<short*>(image->GetScalarPointer());
+  short* mappedVoxels = static_cast<short*>(mappedImage->GetScalarPointer());
+  const int numberOfViewedSlices = 4;
+  for (int sliceIndex = 0; sliceIndex < numberOfViewedSlices; ++sliceIndex)
+    {
+    vtkIdType sliceOffset = (sliceIndex * DIMENSIONS[2] / numberOfViewedSlices) * sliceSize;
+    if (memcmp(voxels + sliceOffset, mappedVoxels + sliceOffset, sliceSize * sizeof(short)) != 0
+      || mappedVoxels[sliceOffset + 123] != GetVoxelValue(sliceOffset + 123))
+      {
+      std::cerr << "Line " << __LINE__ << ": voxel mismatch in slice " << sliceIndex << " of " << fileName << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  double memoryAfterViewingSlices = GetResidentMemorySize();
+  double volumeSize = static_cast<double>(sliceSize) * DIMENSIONS[2] * sizeof(short);
+  if (memoryBeforeRead >= 0 && memoryAfterViewingSlices - memoryBeforeRead > volumeSize * 0.25)
+    {
+    std::cerr << "Line " << __LINE__ << ": too much memory is used after viewing " << numberOfViewedSlices << " slices: "
+      << (memoryAfterViewingSlices - memoryBeforeRead) / 1e6 << " MB (volume size: " << volumeSize / 1e6 << " MB)" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // All voxels are the same
+  if (memcmp(voxels, mappedVoxels, static_cast<size_t>(volumeSize)) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": voxel mismatch in " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Modification of voxels does not change the file
+  mappedVoxels[0] = 1234;
+  vtkNew<vtkTeemNRRDReader> mappedReader2;
+  mappedReader2->SetFileName(fileName.c_str());
+  mappedReader2->UseMemoryMappingOn();
+  mappedReader2->Update();
+  short* mappedVoxels2 = static_cast<short*>(mappedReader2->GetOutput()->GetScalarPointer());
+  if (mappedVoxels2[0] != GetVoxelValue(0))
+    {
+    std::cerr << "Line " << __LINE__ << ": file was modified by changing memory-mapped voxels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << fileName << ": read: " << readTime * 1000.0 << " ms, memory-mapped read: " << mappedReadTime * 1000.0 << " ms";
+  if (memoryBeforeRead >= 0)
+    {
+    std::cout << ", memory used after viewing " << numberOfViewedSlices << " slices: "
+      << (memoryAfterViewingSlices - memoryBeforeRead) / 1e6 << " MB";
+    }
+  std::cout << std::endl;
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestFallbackForAsciiVolume(const std::string& fileName)
+{
+  std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+  file << "NRRD0004\ntype: unsigned char\ndimension: 3\nsizes: 2 2 2\nencoding: ascii\n\n1 2 3 4 5 6 7 8\n";
+  file.close();
+
+  vtkNew<vtkTeemNRRDReader> reader;
+  reader->SetFileName(fileName.c_str());
+  reader->UseMemoryMappingOn();
+  reader->Update();
+  if (reader->GetMemoryMapped())
+    {
+    std::cerr << "Line " << __LINE__ << ": ascii-encoded volume must not be memory-mapped" << std::endl;
+    return EXIT_FAILURE;
+    }
+  unsigned char* voxels = static_cast<unsigned char*>(reader->GetOutput()->GetScalarPointer());
+  if (voxels == nullptr || voxels[0] != 1 || voxels[7] != 8)
+    {
+    std::cerr << "Line " << __LINE__ << ": ascii-encoded volume was not read correctly" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkTeemNRRDReaderMemoryMappingTest1(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+
+  std::string attachedFileName = tempDir + "/vtkTeemNRRDReaderMemoryMappingTest1.nrrd";
+  std::string headerFileName = tempDir + "/vtkTeemNRRDReaderMemoryMappingTest1.nhdr";
+  std::string dataFileName = tempDir + "/vtkTeemNRRDReaderMemoryMappingTest1.raw";
+  if (!WriteVolume(attachedFileName, "") || !WriteVolume(headerFileName, dataFileName))
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to write test volumes into " << tempDir << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (TestReadVolume(attachedFileName) != EXIT_SUCCESS
+    || TestReadVolume(headerFileName) != EXIT_SUCCESS
+    || TestFallbackForAsciiVolume(tempDir + "/vtkTeemNRRDReaderMemoryMappingTest1Ascii.nrrd") != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  remove(attachedFileName.c_str());
+  remove(headerFileName.c_str());
+  remove(dataFileName.c_str());
+  return EXIT_SUCCESS;
+}
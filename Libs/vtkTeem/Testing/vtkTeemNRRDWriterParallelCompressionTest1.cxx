@@ -0,0 +1,202 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkTeem includes
+#include <vtkTeemNRRDReader.h>
+#include <vtkTeemNRRDWriter.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+// Slice size is 1 MB, the number of slices is the volume size in MB
+const int SLICE_DIMENSIONS[2] = { 1024, 1024 };
+
+//----------------------------------------------------------------------------
+unsigned char GetVoxelValue(vtkIdType index)
+{
+  // Smoothly varying pattern with some noise, compresses similarly to a labelmap
+  vtkIdType i = index % SLICE_DIMENSIONS[0];
+  vtkIdType j = (index / SLICE_DIMENSIONS[0]) % SLICE_DIMENSIONS[1];
+  vtkIdType k = index / (SLICE_DIMENSIONS[0] * SLICE_DIMENSIONS[1]);
+  return static_cast<unsigned char>(((i / 64 + j / 32 + k / 16) % 8) * 16 + ((index * 7919) >> 13) % 3);
+}
+
+//----------------------------------------------------------------------------
+bool VerifyVoxels(const unsigned char* voxels, vtkIdType numberOfVoxels, const std::string& description)
+{
+  if (voxels == nullptr)
+    {
+    std::cerr << "Line " << __LINE__ << ": no voxels are read from " << description << std::endl;
+    return false;
+    }
+  for (vtkIdType index = 0; index < numberOfVoxels; ++index)
+    {
+    if (voxels[index] != GetVoxelValue(index))
+      {
+      std::cerr << "Line " << __LINE__ << ": voxel mismatch at index " << index << " in " << description
+        << ": " << int(voxels[index]) << " (expected " << int(GetVoxelValue(index)) << ")" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool WriteVolume(vtkImageData* image, const std::string& fileName, bool parallel, double& throughputMBps)
+{
+  vtkNew<vtkTeemNRRDWriter> writer;
+  writer->SetInputData(image);
+  writer->SetFileName(fileName.c_str());
+  writer->SetUseCompression(true);
+  writer->SetUseParallelCompression(parallel);
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  writer->Write();
+  timer->StopTimer();
+  throughputMBps = image->GetNumberOfPoints() / 1e6 / timer->GetElapsedTime();
+  if (writer->GetWriteError())
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to write " << fileName << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool ReadVolume(const std::string& fileName, vtkIdType numberOfVoxels, double& throughputMBps)
+{
+  vtkNew<vtkTeemNRRDReader> reader;
+  reader->SetFileName(fileName.c_str());
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  reader->Update();
+  timer->StopTimer();
+  throughputMBps = numberOfVoxels / 1e6 / timer->GetElapsedTime();
+  vtkImageData* image = reader->GetOutput();
+  if (image->GetNumberOfPoints() != numberOfVoxels || image->GetScalarType() != VTK_UNSIGNED_CHAR)
+    {
+    std::cerr << "Line " << __LINE__ << ": invalid image read from " << fileName << std::endl;
+    return false;
+    }
+  return VerifyVoxels(static_cast<unsigned char*>(image->GetScalarPointer()), numberOfVoxels, fileName);
+}
+
+//----------------------------------------------------------------------------
+/// Check that the file can be read by the standard (sequential) Teem gzip decoder
+bool ReadVolumeUsingTeem(const std::string& fileName, vtkIdType numberOfVoxels, double& throughputMBps)
+{
+  Nrrd* nrrd = nrrdNew();
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  if (nrrdLoad(nrrd, fileName.c_str(), nullptr) != 0)
+    {
+    char* err = biffGetDone(NRRD);
+    std::cerr << "Line " << __LINE__ << ": Teem failed to read " << fileName << ": " << err << std::endl;
+    free(err);
+    nrrdNuke(nrrd);
+    return false;
+    }
+  timer->StopTimer();
+  throughputMBps = numberOfVoxels / 1e6 / timer->GetElapsedTime();
+  bool success = (static_cast<vtkIdType>(nrrdElementNumber(nrrd)) == numberOfVoxels)
+    && VerifyVoxels(static_cast<unsigned char*>(nrrd->data), numberOfVoxels, fileName + " (read by Teem)");
+  nrrdNuke(nrrd);
+  return success;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkTeemNRRDWriterParallelCompressionTest1(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp [volumeSizeMB]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+  int numberOfSlices = (argc > 2 ? atoi(argv[2]) : 1024);
+
+  vtkIdType numberOfVoxels = 0;
+  std::string sequentialFileName = tempDir + "/vtkTeemNRRDWriterParallelCompressionTest1Sequential.nrrd";
+  std::string parallelFileName = tempDir + "/vtkTeemNRRDWriterParallelCompressionTest1Parallel.nrrd";
+  std::string detachedFileName = tempDir + "/vtkTeemNRRDWriterParallelCompressionTest1Detached.nhdr";
+  double sequentialWriteMBps = 0.0;
+  double parallelWriteMBps = 0.0;
+  double detachedWriteMBps = 0.0;
+  {
+    vtkNew<vtkImageData> image;
+    image->SetDimensions(SLICE_DIMENSIONS[0], SLICE_DIMENSIONS[1], numberOfSlices);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    numberOfVoxels = image->GetNumberOfPoints();
+    unsigned char* voxels = static_cast<unsigned char*>(image->GetScalarPointer());
+    for (vtkIdType index = 0; index < numberOfVoxels; ++index)
+      {
+      voxels[index] = GetVoxelValue(index);
+      }
+
+    if (!WriteVolume(image, sequentialFileName, false, sequentialWriteMBps)
+      || !WriteVolume(image, parallelFileName, true, parallelWriteMBps)
+      // parallel compression is only used for attached data, detached data is written by Teem
+      || !WriteVolume(image, detachedFileName, true, detachedWriteMBps))
+      {
+      return EXIT_FAILURE;
+      }
+  }
+
+  // Compression ratio is similar
+  double sequentialFileSize = static_cast<double>(vtksys::SystemTools::FileLength(sequentialFileName));
+  double parallelFileSize = static_cast<double>(vtksys::SystemTools::FileLength(parallelFileName));
+  if (parallelFileSize > sequentialFileSize * 1.1 + 1e5)
+    {
+    std::cerr << "Line " << __LINE__ << ": parallel compressed file is too large: " << parallelFileSize
+      << " bytes (sequentially compressed: " << sequentialFileSize << " bytes)" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  double sequentialReadMBps = 0.0;
+  double parallelReadMBps = 0.0;
+  double teemReadMBps = 0.0;
+  double detachedReadMBps = 0.0;
+  if (!ReadVolume(sequentialFileName, numberOfVoxels, sequentialReadMBps)
+    || !ReadVolume(parallelFileName, numberOfVoxels, parallelReadMBps)
+    || !ReadVolumeUsingTeem(parallelFileName, numberOfVoxels, teemReadMBps)
+    || !ReadVolume(detachedFileName, numberOfVoxels, detachedReadMBps))
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Volume size: " << numberOfVoxels / 1e6 << " MB" << std::endl
+    << "Sequential compression: write " << sequentialWriteMBps << " MB/s, read " << sequentialReadMBps << " MB/s, "
+    << "file size " << sequentialFileSize / 1e6 << " MB" << std::endl
+    << "Parallel compression: write " << parallelWriteMBps << " MB/s, read " << parallelReadMBps << " MB/s "
+    << "(Teem sequential read: " << teemReadMBps << " MB/s), file size " << parallelFileSize / 1e6 << " MB" << std::endl;
+
+  vtksys::SystemTools::RemoveFile(sequentialFileName);
+  vtksys::SystemTools::RemoveFile(parallelFileName);
+  vtksys::SystemTools::RemoveFile(detachedFileName);
+  vtksys::SystemTools::RemoveFile(tempDir + "/vtkTeemNRRDWriterParallelCompressionTest1Detached.raw.gz");
+  return EXIT_SUCCESS;
+}
@@ -35,6 +35,7 @@
 #include "vtkFloatArray.h"
 #include "vtkImageData.h"
 #include <vtkInformation.h>
+#include <vtkInformationStringKey.h>
 #include <vtkInformationVector.h>
 #include "vtkIntArray.h"
 #include "vtkLongArray.h"
@@ -42,17 +43,280 @@
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
 #include "vtkShortArray.h"
+#include <vtkSMPTools.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include "vtkUnsignedCharArray.h"
 #include "vtkUnsignedShortArray.h"
 #include "vtkUnsignedIntArray.h"
 #include "vtkUnsignedLongArray.h"
+#include <vtk_zlib.h>
+#include <vtksys/Encoding.hxx>
+#include <vtksys/FStream.hxx>
 #include <vtksys/SystemTools.hxx>
 
 // Teem includes
 #include "teem/ten.h"
 
+// STD includes
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 vtkStandardNewMacro(vtkTeemNRRDReader);
+vtkInformationKeyMacro(vtkTeemNRRDReader, MEMORY_MAPPED_FILE_NAME, String);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Start address and length of memory-mapped views, indexed by the data pointer
+/// that is stored in the voxel array. Required for unmapping the view when the
+/// array is deleted.
+std::mutex& GetMappedViewsMutex()
+{
+  static std::mutex mappedViewsMutex;
+  return mappedViewsMutex;
+}
+
+std::map<void*, std::pair<void*, size_t> >& GetMappedViews()
+{
+  static std::map<void*, std::pair<void*, size_t> > mappedViews;
+  return mappedViews;
+}
+
+//----------------------------------------------------------------------------
+/// Map the specified part of the file into memory (copy-on-write: modification
+/// of the voxels does not change the file).
+/// Returns the pointer to the first byte of the requested part or nullptr on failure.
+void* MapFileView(const std::string& fileName, vtkTypeInt64 offset, size_t length)
+{
+#ifdef _WIN32
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  vtkTypeInt64 alignment = systemInfo.dwAllocationGranularity;
+#else
+  vtkTypeInt64 alignment = sysconf(_SC_PAGESIZE);
+#endif
+  vtkTypeInt64 alignedOffset = (offset / alignment) * alignment;
+  size_t viewLength = length + static_cast<size_t>(offset - alignedOffset);
+  void* viewAddress = nullptr;
+
+#ifdef _WIN32
+  HANDLE fileHandle = CreateFileW(vtksys::Encoding::ToWide(fileName).c_str(), GENERIC_READ, FILE_SHARE_READ,
+    nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+    return nullptr;
+    }
+  HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  CloseHandle(fileHandle);
+  if (mappingHandle == nullptr)
+    {
+    return nullptr;
+    }
+  viewAddress = MapViewOfFile(mappingHandle, FILE_MAP_COPY,
+    static_cast<DWORD>(alignedOffset >> 32), static_cast<DWORD>(alignedOffset & 0xFFFFFFFF), viewLength);
+  // the view keeps a reference to the mapping object
+  CloseHandle(mappingHandle);
+  if (viewAddress == nullptr)
+    {
+    return nullptr;
+    }
+#else
+  int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+  if (fileDescriptor < 0)
+    {
+    return nullptr;
+    }
+  viewAddress = mmap(nullptr, viewLength, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileDescriptor, static_cast<off_t>(alignedOffset));
+  // the mapping keeps a reference to the file
+  close(fileDescriptor);
+  if (viewAddress == MAP_FAILED)
+    {
+    return nullptr;
+    }
+#endif
+
+  void* data = static_cast<char*>(viewAddress) + (offset - alignedOffset);
+  std::lock_guard<std::mutex> lock(GetMappedViewsMutex());
+  GetMappedViews()[data] = std::make_pair(viewAddress, viewLength);
+  return data;
+}
+
+//----------------------------------------------------------------------------
+/// Free function of memory-mapped voxel arrays
+void UnmapFileView(void* data)
+{
+  std::pair<void*, size_t> view(nullptr, 0);
+    {
+    std::lock_guard<std::mutex> lock(GetMappedViewsMutex());
+    std::map<void*, std::pair<void*, size_t> >::iterator it = GetMappedViews().find(data);
+    if (it == GetMappedViews().end())
+      {
+      return;
+      }
+    view = it->second;
+    GetMappedViews().erase(it);
+    }
+#ifdef _WIN32
+  UnmapViewOfFile(view.first);
+#else
+  munmap(view.first, view.second);
+#endif
+}
+
+//----------------------------------------------------------------------------
+struct GzipMember
+{
+  size_t CompressedOffset; // offset of compressed data (after the member header)
+  size_t CompressedSize;
+  size_t DataOffset; // offset of the decompressed data in the output
+  size_t DataSize;
+  vtkTypeUInt32 Crc;
+};
+
+//----------------------------------------------------------------------------
+vtkTypeUInt32 ReadLittleEndian(const unsigned char* buffer, int numberOfBytes)
+{
+  vtkTypeUInt32 value = 0;
+  for (int i = numberOfBytes - 1; i >= 0; --i)
+    {
+    value = (value << 8) | buffer[i];
+    }
+  return value;
+}
+
+//----------------------------------------------------------------------------
+/// Size of the fixed part of a gzip member header, including the extra field length
+const size_t GzipFixedHeaderSize = 12;
+
+//----------------------------------------------------------------------------
+/// Returns true if the fixed header (GzipFixedHeaderSize bytes) starts a deflate-compressed
+/// gzip member that only has an extra field (FEXTRA flag), as written by vtkTeemNRRDWriter.
+bool IsGzipMemberHeaderWithExtraField(const unsigned char* header)
+{
+  return header[0] == 0x1f && header[1] == 0x8b && header[2] == 8 && header[3] == 4;
+}
+
+//----------------------------------------------------------------------------
+/// Get the complete size of a gzip member from the "SL" subfield of its extra field.
+/// Returns 0 if the extra field does not contain the member size.
+size_t GetGzipMemberSize(const unsigned char* extraField, size_t extraFieldSize)
+{
+  size_t memberSize = 0;
+  for (size_t subfieldPosition = 0; subfieldPosition + 4 <= extraFieldSize; )
+    {
+    const unsigned char* subfield = extraField + subfieldPosition;
+    size_t subfieldSize = ReadLittleEndian(subfield + 2, 2);
+    if (subfield[0] == 'S' && subfield[1] == 'L' && subfieldSize == 4 && subfieldPosition + 8 <= extraFieldSize)
+      {
+      memberSize = ReadLittleEndian(subfield + 4, 4);
+      }
+    subfieldPosition += 4 + subfieldSize;
+    }
+  return memberSize;
+}
+
+//----------------------------------------------------------------------------
+/// Find gzip members that store their complete size in an "SL" extra subfield
+/// (as written by vtkTeemNRRDWriter with parallel compression).
+/// Returns false if the data is not a sequence of such members.
+bool FindGzipMembers(const std::vector<unsigned char>& compressedData, std::vector<GzipMember>& members)
+{
+  const size_t fixedHeaderSize = GzipFixedHeaderSize;
+  const size_t trailerSize = 8;
+  size_t position = 0;
+  size_t dataOffset = 0;
+  while (position < compressedData.size())
+    {
+    const unsigned char* header = compressedData.data() + position;
+    size_t remainingSize = compressedData.size() - position;
+    if (remainingSize < fixedHeaderSize + trailerSize || !IsGzipMemberHeaderWithExtraField(header))
+      {
+      return false;
+      }
+    size_t extraFieldSize = ReadLittleEndian(header + 10, 2);
+    if (remainingSize < fixedHeaderSize + extraFieldSize + trailerSize)
+      {
+      return false;
+      }
+    size_t memberSize = GetGzipMemberSize(header + fixedHeaderSize, extraFieldSize);
+    if (memberSize < fixedHeaderSize + extraFieldSize + trailerSize || memberSize > remainingSize)
+      {
+      return false;
+      }
+    GzipMember member;
+    member.CompressedOffset = position + fixedHeaderSize + extraFieldSize;
+    member.CompressedSize = memberSize - fixedHeaderSize - extraFieldSize - trailerSize;
+    member.Crc = ReadLittleEndian(header + memberSize - trailerSize, 4);
+    member.DataSize = ReadLittleEndian(header + memberSize - 4, 4);
+    member.DataOffset = dataOffset;
+    members.push_back(member);
+    dataOffset += member.DataSize;
+    position += memberSize;
+    }
+  return !members.empty();
+}
+
+//----------------------------------------------------------------------------
+class DecompressGzipMembersFunctor
+{
+public:
+  DecompressGzipMembersFunctor(const unsigned char* compressedData, const std::vector<GzipMember>& members,
+    unsigned char* data, std::vector<char>& success)
+    : CompressedData(compressedData), Members(members), Data(data), Success(success)
+  {
+  }
+
+  void operator()(vtkIdType beginMember, vtkIdType endMember)
+  {
+    for (vtkIdType memberIndex = beginMember; memberIndex < endMember; ++memberIndex)
+      {
+      this->Success[memberIndex] = this->Decompress(this->Members[memberIndex]);
+      }
+  }
+
+private:
+  bool Decompress(const GzipMember& member)
+  {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // negative window bits: raw deflate stream, without gzip header and trailer
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+      {
+      return false;
+      }
+    unsigned char* output = this->Data + member.DataOffset;
+    stream.next_in = const_cast<Bytef*>(this->CompressedData + member.CompressedOffset);
+    stream.avail_in = static_cast<uInt>(member.CompressedSize);
+    stream.next_out = output;
+    stream.avail_out = static_cast<uInt>(member.DataSize);
+    int result = inflate(&stream, Z_FINISH);
+    size_t decompressedSize = stream.total_out;
+    inflateEnd(&stream);
+    return result == Z_STREAM_END && decompressedSize == member.DataSize
+      && crc32(0L, output, static_cast<uInt>(member.DataSize)) == member.Crc;
+  }
+
+  const unsigned char* CompressedData;
+  const std::vector<GzipMember>& Members;
+  unsigned char* Data;
+  std::vector<char>& Success;
+};
+
+} // end of anonymous namespace
 
 //----------------------------------------------------------------------------
 vtkTeemNRRDReader::vtkTeemNRRDReader()
@@ -62,6 +326,8 @@ vtkTeemNRRDReader::vtkTeemNRRDReader()
   this->MeasurementFrameMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
   this->nrrd = nrrdNew();
   this->UseNativeOrigin = true;
+  this->UseMemoryMapping = false;
+  this->MemoryMapped = false;
   this->ReadStatus = 0;
   this->PointDataType = -1;
   this->DataType = -1;
@@ -905,6 +1171,17 @@ void vtkTeemNRRDReader::ExecuteDataWithInformation(vtkDataObject *output, vtkInf
         vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()), 6);
     }
 
+  this->MemoryMapped = false;
+  if (this->UseMemoryMapping && this->GetFileName() != nullptr)
+    {
+    if (this->ReadMemoryMapped(output, outInfo))
+      {
+      this->MemoryMapped = true;
+      return;
+      }
+    vtkDebugMacro("Data in " << this->GetFileName() << " cannot be memory-mapped, read it into memory");
+    }
+
   vtkImageData *imageData = this->AllocateOutputData(output, outInfo);
 
   if (this->GetFileName() == nullptr)
@@ -915,7 +1192,12 @@ void vtkTeemNRRDReader::ExecuteDataWithInformation(vtkDataObject *output, vtkInf
 
   // Read in the this->nrrd.  Yes, this means that the header is being read
   // twice: once by ExecuteInformation, and once here
-  if ( nrrdLoad(this->nrrd, this->GetFileName(), nullptr) != 0 )
+  int parallelReadResult = this->ReadParallelCompressedData();
+  if (parallelReadResult < 0)
+    {
+    return;
+    }
+  if ( parallelReadResult == 0 && nrrdLoad(this->nrrd, this->GetFileName(), nullptr) != 0 )
     {
     char *err =  biffGetDone(NRRD); // would be nice to free(err)
     vtkErrorMacro("Read: Error reading " << this->GetFileName() << ":\n" << err);
@@ -1098,8 +1380,320 @@ void vtkTeemNRRDReader::ExecuteDataWithInformation(vtkDataObject *output, vtkInf
   nrrdEmpty(this->nrrd);
 }
 
+//----------------------------------------------------------------------------
+bool vtkTeemNRRDReader::GetDataLocation(const NrrdEncoding* encoding, std::string& dataFileName, vtkTypeInt64& dataOffset)
+{
+  Nrrd* headerNrrd = nrrdNew();
+  NrrdIoState *nio = nrrdIoStateNew();
+  nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
+  if (nrrdLoad(headerNrrd, this->GetFileName(), nio) != 0)
+    {
+    char *err = biffGetDone(NRRD);
+    free(err);
+    nrrdIoStateNix(nio);
+    nrrdNuke(headerNrrd);
+    return false;
+    }
+
+  size_t dataSize = nrrdElementSize(headerNrrd) * nrrdElementNumber(headerNrrd);
+  // byte skip of compressed data is applied after decompression
+  bool canMap = nio->encoding == encoding
+    && (encoding == nrrdEncodingRaw || nio->byteSkip == 0)
+    && (nio->endian == airMyEndian() || nrrdElementSize(headerNrrd) == 1)
+    && nio->dataFNFormat == nullptr
+    && nio->dataFNArr->len <= 1
+    && nio->lineSkip == 0;
+
+  bool attachedData = (nio->dataFNArr->len == 0);
+  if (canMap && !attachedData)
+    {
+    dataFileName = nio->dataFN[0];
+    if (!vtksys::SystemTools::FileIsFullPath(dataFileName))
+      {
+      std::string headerDirectory = nio->path ? std::string(nio->path)
+        : vtksys::SystemTools::GetFilenamePath(this->GetFileName());
+      dataFileName = headerDirectory + "/" + dataFileName;
+      }
+    }
+  else
+    {
+    dataFileName = this->GetFileName();
+    }
+  long int byteSkip = nio->byteSkip;
+  nrrdIoStateNix(nio);
+  nrrdNuke(headerNrrd);
+  if (!canMap)
+    {
+    return false;
+    }
+
+  vtksys::SystemTools::Stat_t fileStatus;
+  if (vtksys::SystemTools::Stat(dataFileName, &fileStatus) != 0)
+    {
+    return false;
+    }
+  vtkTypeInt64 fileSize = static_cast<vtkTypeInt64>(fileStatus.st_size);
+
+  if (byteSkip == -1)
+    {
+    // data is at the end of the file
+    dataOffset = fileSize - static_cast<vtkTypeInt64>(dataSize);
+    }
+  else
+    {
+    dataOffset = byteSkip;
+    if (attachedData)
+      {
+      // data starts after the empty line that terminates the header
+      std::ifstream file(dataFileName.c_str(), std::ios::in | std::ios::binary);
+      std::string line;
+      bool headerEndFound = false;
+      while (std::getline(file, line))
+        {
+        if (line.empty() || line == "\r")
+          {
+          headerEndFound = true;
+          break;
+          }
+        }
+      if (!headerEndFound)
+        {
+        return false;
+        }
+      std::streamoff headerSize = file.tellg();
+      if (headerSize < 0)
+        {
+        return false;
+        }
+      dataOffset += static_cast<vtkTypeInt64>(headerSize);
+      }
+    }
+
+  if (encoding != nrrdEncodingRaw)
+    {
+    // size of encoded data is not known
+    return dataOffset >= 0 && dataOffset < fileSize;
+    }
+  return dataOffset >= 0 && dataOffset + static_cast<vtkTypeInt64>(dataSize) <= fileSize;
+}
+
+//----------------------------------------------------------------------------
+int vtkTeemNRRDReader::ReadParallelCompressedData()
+{
+  if (!nrrdEncodingGzip->available())
+    {
+    return 0;
+    }
+  std::string dataFileName;
+  vtkTypeInt64 dataOffset = 0;
+  if (!this->GetDataLocation(nrrdEncodingGzip, dataFileName, dataOffset))
+    {
+    return 0;
+    }
+
+  vtksys::ifstream file(dataFileName.c_str(), std::ios::in | std::ios::binary);
+  if (!file.is_open())
+    {
+    vtkErrorMacro("ReadParallelCompressedData: Failed to open " << dataFileName);
+    return -1;
+    }
+  file.seekg(0, std::ios::end);
+  vtkTypeInt64 fileSize = static_cast<vtkTypeInt64>(file.tellg());
+  if (!file || fileSize < 0)
+    {
+    vtkErrorMacro("ReadParallelCompressedData: Failed to get size of " << dataFileName);
+    return -1;
+    }
+  if (fileSize - dataOffset < static_cast<vtkTypeInt64>(GzipFixedHeaderSize))
+    {
+    // not enough data for a gzip member, let nrrdLoad handle it
+    return 0;
+    }
+
+  // Check the header of the first member before reading the compressed data,
+  // to avoid reading the whole file twice if it was not written with parallel compression
+  std::vector<unsigned char> firstMemberHeader(GzipFixedHeaderSize);
+  file.seekg(dataOffset, std::ios::beg);
+  file.read(reinterpret_cast<char*>(firstMemberHeader.data()), firstMemberHeader.size());
+  if (!file)
+    {
+    vtkErrorMacro("ReadParallelCompressedData: Failed to read " << dataFileName);
+    return -1;
+    }
+  if (!IsGzipMemberHeaderWithExtraField(firstMemberHeader.data()))
+    {
+    return 0;
+    }
+  size_t extraFieldSize = ReadLittleEndian(firstMemberHeader.data() + 10, 2);
+  if (fileSize - dataOffset < static_cast<vtkTypeInt64>(GzipFixedHeaderSize + extraFieldSize))
+    {
+    return 0;
+    }
+  firstMemberHeader.resize(GzipFixedHeaderSize + extraFieldSize);
+  file.read(reinterpret_cast<char*>(firstMemberHeader.data() + GzipFixedHeaderSize), extraFieldSize);
+  if (!file)
+    {
+    vtkErrorMacro("ReadParallelCompressedData: Failed to read " << dataFileName);
+    return -1;
+    }
+  if (GetGzipMemberSize(firstMemberHeader.data() + GzipFixedHeaderSize, extraFieldSize) == 0)
+    {
+    // single-member gzip stream, let nrrdLoad handle it
+    return 0;
+    }
+
+  // Read compressed data
+  file.seekg(dataOffset, std::ios::beg);
+  std::vector<unsigned char> compressedData(static_cast<size_t>(fileSize - dataOffset));
+  file.read(reinterpret_cast<char*>(compressedData.data()), compressedData.size());
+  if (!file)
+    {
+    vtkErrorMacro("ReadParallelCompressedData: Failed to read " << dataFileName);
+    return -1;
+    }
+  file.close();
+
+  // Find gzip members
+  std::vector<GzipMember> members;
+  if (!FindGzipMembers(compressedData, members))
+    {
+    return 0;
+    }
+
+  // Read header
+  NrrdIoState *nio = nrrdIoStateNew();
+  nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
+  if (nrrdLoad(this->nrrd, this->GetFileName(), nio) != 0)
+    {
+    char *err = biffGetDone(NRRD);
+    vtkErrorMacro("ReadParallelCompressedData: Error reading " << this->GetFileName() << ":\n" << err);
+    free(err);
+    nrrdIoStateNix(nio);
+    return -1;
+    }
+  nrrdIoStateNix(nio);
+  size_t dataSize = nrrdElementSize(this->nrrd) * nrrdElementNumber(this->nrrd);
+  if (members.back().DataOffset + members.back().DataSize != dataSize)
+    {
+    // not all data is in the members, let nrrdLoad handle it
+    nrrdEmpty(this->nrrd);
+    return 0;
+    }
+
+  // Decompress
+  this->nrrd->data = malloc(dataSize);
+  if (this->nrrd->data == nullptr)
+    {
+    vtkErrorMacro("ReadParallelCompressedData: Failed to allocate " << dataSize << " bytes");
+    nrrdEmpty(this->nrrd);
+    return -1;
+    }
+  std::vector<char> success(members.size(), 0);
+  DecompressGzipMembersFunctor decompressFunctor(compressedData.data(), members,
+    static_cast<unsigned char*>(this->nrrd->data), success);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(members.size()), decompressFunctor);
+  if (std::find(success.begin(), success.end(), 0) != success.end())
+    {
+    vtkErrorMacro("ReadParallelCompressedData: Error decompressing data in " << dataFileName);
+    nrrdEmpty(this->nrrd);
+    return -1;
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+bool vtkTeemNRRDReader::ReadMemoryMapped(vtkDataObject *output, vtkInformation* outInfo)
+{
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 90)
+  vtkImageData *imageData = vtkImageData::SafeDownCast(output);
+  if (!imageData)
+    {
+    return false;
+    }
+  this->ExecuteInformation();
+  if (this->ReadStatus != 0 || this->DataType == VTK_VOID || this->DataType == VTK_BIT)
+    {
+    return false;
+    }
+
+  // Voxels must be stored in the file exactly as they are stored in memory:
+  // the only non-scalar axis must be the fastest and tensors must not be expanded.
+  unsigned int rangeAxisIdx[NRRD_DIM_MAX] = { 0 };
+  unsigned int rangeAxisNum = nrrdRangeAxesGet(this->nrrd, rangeAxisIdx);
+  if (rangeAxisNum > 1 || (rangeAxisNum == 1 && rangeAxisIdx[0] != 0)
+    || this->nrrd->axis[0].kind == nrrdKind3DMaskedSymMatrix
+    || this->nrrd->axis[0].kind == nrrdKind3DSymMatrix
+    || this->NrrdToVTKScalarType(this->nrrd->type) != this->DataType)
+    {
+    return false;
+    }
+
+  std::string dataFileName;
+  vtkTypeInt64 dataOffset = 0;
+  if (!this->GetDataLocation(nrrdEncodingRaw, dataFileName, dataOffset))
+    {
+    return false;
+    }
+
+  imageData->SetExtent(this->GetUpdateExtent());
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  imageData->GetExtent(extent);
+  vtkIdType numberOfTuples = vtkIdType(extent[1] - extent[0] + 1)
+    * vtkIdType(extent[3] - extent[2] + 1) * vtkIdType(extent[5] - extent[4] + 1);
+  vtkIdType numberOfValues = numberOfTuples * this->GetNumberOfComponents();
+  size_t dataSize = nrrdElementSize(this->nrrd) * nrrdElementNumber(this->nrrd);
+  if (numberOfValues <= 0
+    || static_cast<size_t>(numberOfValues) * vtkDataArray::GetDataTypeSize(this->DataType) != dataSize)
+    {
+    return false;
+    }
+
+  void* data = MapFileView(dataFileName, dataOffset, dataSize);
+  if (data == nullptr)
+    {
+    vtkWarningMacro("ReadMemoryMapped: failed to map " << dataFileName << " into memory");
+    return false;
+    }
+
+  vtkSmartPointer<vtkDataArray> pd = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(this->DataType));
+  pd->SetNumberOfComponents(this->GetNumberOfComponents());
+  pd->SetVoidArray(data, numberOfValues, 0, vtkAbstractArray::VTK_DATA_ARRAY_USER_DEFINED);
+  pd->SetArrayFreeFunction(UnmapFileView);
+  pd->SetName("NRRDImage");
+  pd->GetInformation()->Set(vtkTeemNRRDReader::MEMORY_MAPPED_FILE_NAME(), dataFileName.c_str());
+
+  switch (this->PointDataType)
+    {
+    case vtkDataSetAttributes::SCALARS:
+      imageData->GetPointData()->SetScalars(pd);
+      vtkDataObject::SetPointDataActiveScalarInfo(outInfo, this->DataType, this->GetNumberOfComponents());
+      break;
+    case vtkDataSetAttributes::VECTORS:
+      imageData->GetPointData()->SetVectors(pd);
+      break;
+    case vtkDataSetAttributes::NORMALS:
+      imageData->GetPointData()->SetNormals(pd);
+      break;
+    case vtkDataSetAttributes::TENSORS:
+      imageData->GetPointData()->SetTensors(pd);
+      break;
+    default:
+      vtkErrorMacro("Unknown PointData Type.");
+      return false;
+    }
+  this->ComputeDataIncrements();
+  return true;
+#else
+  (void)output;
+  (void)outInfo;
+  return false;
+#endif
+}
+
 //----------------------------------------------------------------------------
 void vtkTeemNRRDReader::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
+  os << indent << "UseMemoryMapping: " << this->UseMemoryMapping << "\n";
+  os << indent << "MemoryMapped: " << this->MemoryMapped << "\n";
 }
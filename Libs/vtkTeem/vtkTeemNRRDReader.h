@@ -46,6 +46,8 @@
 
 #include "teem/nrrd.h"
 
+class vtkInformationStringKey;
+
 /// \brief Reads Nearly Raw Raster Data files.
 ///
 /// Reads Nearly Raw Raster Data files using the nrrdio library as used in ITK
@@ -147,6 +149,26 @@ public:
     UseNativeOrigin = false;
   }
 
+  ///
+  /// If enabled then voxel data that is stored in the file in raw encoding,
+  /// in native byte order, and does not need any conversion is not read into memory,
+  /// but the voxel array refers to a copy-on-write memory-mapped view of the file.
+  /// Only those parts of the file are read from disk that are accessed.
+  /// If the data cannot be memory-mapped then it is read into memory.
+  /// Disabled by default.
+  vtkSetMacro(UseMemoryMapping, bool);
+  vtkGetMacro(UseMemoryMapping, bool);
+  vtkBooleanMacro(UseMemoryMapping, bool);
+
+  ///
+  /// Returns true if the voxel array of the last read refers to a memory-mapped file.
+  vtkGetMacro(MemoryMapped, bool);
+
+  ///
+  /// Key that is set in the information of memory-mapped voxel arrays. The value is the name
+  /// of the mapped file. Writers must not overwrite this file while the array refers to it.
+  static vtkInformationStringKey* MEMORY_MAPPED_FILE_NAME();
+
   int NrrdToVTKScalarType( const int nrrdPixelType ) const
   {
   switch( nrrdPixelType )
@@ -242,6 +264,22 @@ protected:
 
   static bool GetPointType(Nrrd* nrrdTemp, int& pointDataType, int &numOfComponents);
 
+  /// Set the output voxel array to a memory-mapped view of the file.
+  /// Returns false if the data cannot be memory-mapped.
+  bool ReadMemoryMapped(vtkDataObject *output, vtkInformation* outInfo);
+
+  /// Get the name of the file that contains the voxel data and the offset
+  /// of the first byte of the (possibly encoded) data in the file.
+  /// Returns false if the data is not stored in a single file with the
+  /// specified encoding in native byte order.
+  bool GetDataLocation(const NrrdEncoding* encoding, std::string& dataFileName, vtkTypeInt64& dataOffset);
+
+  /// Read data that was written by vtkTeemNRRDWriter with parallel compression enabled
+  /// into this->nrrd. The gzip members are decompressed in parallel.
+  /// Returns 1 on success, 0 if the data is not stored in independent gzip members
+  /// with known sizes (data must be read using nrrdLoad), and -1 on error.
+  int ReadParallelCompressedData();
+
   vtkSmartPointer<vtkMatrix4x4> RasToIjkMatrix;
   vtkSmartPointer<vtkMatrix4x4> MeasurementFrameMatrix;
   vtkSmartPointer<vtkMatrix4x4> NRRDWorldToRasMatrix;
@@ -256,6 +294,8 @@ protected:
   int DataType;
   int NumberOfComponents;
   bool UseNativeOrigin;
+  bool UseMemoryMapping;
+  bool MemoryMapped;
 
   std::map <std::string, std::string> HeaderKeyValue;
   std::string HeaderKeys; // buffer for returning key list
@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <cstring>
 #include <map>
+#include <string>
+#include <vector>
 
 #include "vtkTeemNRRDWriter.h"
 
@@ -7,7 +11,11 @@
 #include "vtkPointData.h"
 #include "vtkObjectFactory.h"
 #include "vtkInformation.h"
+#include <vtkSMPTools.h>
 #include <vtkVersion.h>
+#include <vtk_zlib.h>
+#include <vtksys/FStream.hxx>
+#include <vtksys/SystemTools.hxx>
 
 #include <vnl/vnl_math.h>
 #include <vnl/vnl_double_3.h>
@@ -20,6 +28,105 @@ class AxisInfoMapType : public std::map<unsigned int, std::string> {};
 
 vtkStandardNewMacro(vtkTeemNRRDWriter);
 
+namespace
+{
+
+// Each gzip member starts with a header that contains an extra field
+// with a single "SL" subfield, which stores the size of the complete member
+// (similarly to the BGZF format). Header: 10 bytes fixed header, 2 bytes extra
+// field length, 4 bytes subfield header, 4 bytes member size.
+const size_t GZIP_MEMBER_HEADER_SIZE = 20;
+// Trailer: CRC32 and size of uncompressed data
+const size_t GZIP_MEMBER_TRAILER_SIZE = 8;
+
+//----------------------------------------------------------------------------
+void WriteLittleEndian(unsigned char* buffer, vtkTypeUInt32 value, int numberOfBytes)
+{
+  for (int i = 0; i < numberOfBytes; ++i)
+    {
+    buffer[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Compress a block of data into a complete gzip member
+bool CompressGzipMember(const unsigned char* data, size_t dataSize, int compressionLevel, std::string& member)
+{
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // negative window bits: raw deflate stream, gzip header and trailer are written below
+  if (deflateInit2(&stream, compressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+    return false;
+    }
+  uLong maximumCompressedSize = deflateBound(&stream, static_cast<uLong>(dataSize));
+  member.resize(GZIP_MEMBER_HEADER_SIZE + maximumCompressedSize + GZIP_MEMBER_TRAILER_SIZE);
+  stream.next_in = const_cast<Bytef*>(data);
+  stream.avail_in = static_cast<uInt>(dataSize);
+  stream.next_out = reinterpret_cast<Bytef*>(&member[GZIP_MEMBER_HEADER_SIZE]);
+  stream.avail_out = static_cast<uInt>(maximumCompressedSize);
+  int result = deflate(&stream, Z_FINISH);
+  size_t compressedSize = stream.total_out;
+  deflateEnd(&stream);
+  if (result != Z_STREAM_END)
+    {
+    return false;
+    }
+  member.resize(GZIP_MEMBER_HEADER_SIZE + compressedSize + GZIP_MEMBER_TRAILER_SIZE);
+
+  unsigned char* header = reinterpret_cast<unsigned char*>(&member[0]);
+  header[0] = 0x1f; // ID1
+  header[1] = 0x8b; // ID2
+  header[2] = 8; // CM: deflate
+  header[3] = 4; // FLG: FEXTRA
+  WriteLittleEndian(header + 4, 0, 4); // MTIME: not available
+  header[8] = 0; // XFL
+  header[9] = 255; // OS: unknown
+  WriteLittleEndian(header + 10, 8, 2); // XLEN
+  header[12] = 'S'; // SI1
+  header[13] = 'L'; // SI2
+  WriteLittleEndian(header + 14, 4, 2); // subfield length
+  WriteLittleEndian(header + 16, static_cast<vtkTypeUInt32>(member.size()), 4);
+
+  unsigned char* trailer = header + GZIP_MEMBER_HEADER_SIZE + compressedSize;
+  WriteLittleEndian(trailer, static_cast<vtkTypeUInt32>(crc32(0L, data, static_cast<uInt>(dataSize))), 4);
+  WriteLittleEndian(trailer + 4, static_cast<vtkTypeUInt32>(dataSize), 4);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+class CompressGzipMembersFunctor
+{
+public:
+  CompressGzipMembersFunctor(const unsigned char* data, size_t dataSize, size_t blockSize, int compressionLevel,
+    std::vector<std::string>& members, std::vector<char>& success)
+    : Data(data), DataSize(dataSize), BlockSize(blockSize), CompressionLevel(compressionLevel),
+    Members(members), Success(success)
+  {
+  }
+
+  void operator()(vtkIdType beginBlock, vtkIdType endBlock)
+  {
+    for (vtkIdType blockIndex = beginBlock; blockIndex < endBlock; ++blockIndex)
+      {
+      size_t blockStart = static_cast<size_t>(blockIndex) * this->BlockSize;
+      size_t blockSize = std::min(this->BlockSize, this->DataSize - blockStart);
+      this->Success[blockIndex] = CompressGzipMember(this->Data + blockStart, blockSize,
+        this->CompressionLevel, this->Members[blockIndex]);
+      }
+  }
+
+private:
+  const unsigned char* Data;
+  size_t DataSize;
+  size_t BlockSize;
+  int CompressionLevel;
+  std::vector<std::string>& Members;
+  std::vector<char>& Success;
+};
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkTeemNRRDWriter::vtkTeemNRRDWriter()
 {
@@ -31,6 +138,8 @@ vtkTeemNRRDWriter::vtkTeemNRRDWriter()
   this->UseCompression = 1;
   // use default CompressionLevel
   this->CompressionLevel = -1;
+  this->UseParallelCompression = 0;
+  this->CompressionBlockSize = 1 << 20;
   this->DiffusionWeightedData = 0;
   this->FileType = VTK_BINARY;
   this->WriteErrorOff();
@@ -411,6 +520,19 @@ void vtkTeemNRRDWriter::WriteData()
     return;
     }
 
+  if (this->GetUseCompression() && this->GetUseParallelCompression()
+    && vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(this->GetFileName())) != ".nhdr")
+    {
+    if (!this->WriteParallelCompressed(nrrd))
+      {
+      vtkErrorMacro("Write: Error writing " << this->GetFileName());
+      this->WriteErrorOn();
+      }
+    // Free the nrrd struct but don't touch nrrd->data
+    nrrd = nrrdNix(nrrd);
+    return;
+    }
+
   NrrdIoState *nio = nrrdIoStateNew();
 
   // set encoding for data: compressed (raw), (uncompressed) raw, or ascii
@@ -451,9 +573,73 @@ void vtkTeemNRRDWriter::WriteData()
   nio = nrrdIoStateNix(nio);
 }
 
+//----------------------------------------------------------------------------
+bool vtkTeemNRRDWriter::WriteParallelCompressed(Nrrd* nrrd)
+{
+  // Get the header
+  NrrdIoState *nio = nrrdIoStateNew();
+  nio->encoding = nrrdEncodingGzip;
+  nio->zlibLevel = this->CompressionLevel;
+  nio->endian = airEndianUnknown;
+  nio->skipData = AIR_TRUE;
+  char* headerString = nullptr;
+  if (nrrdStringWrite(&headerString, nrrd, nio))
+    {
+    char *err = biffGetDone(NRRD);
+    vtkErrorMacro("WriteParallelCompressed: Error creating header: " << err);
+    free(err);
+    nio = nrrdIoStateNix(nio);
+    return false;
+    }
+  nio = nrrdIoStateNix(nio);
+  std::string header = headerString;
+  free(headerString);
+  // attached data starts after an empty line
+  if (header.size() < 2 || header.compare(header.size() - 2, 2, "\n\n") != 0)
+    {
+    header += "\n";
+    }
+
+  // Compress data
+  const unsigned char* data = static_cast<const unsigned char*>(nrrd->data);
+  size_t dataSize = nrrdElementSize(nrrd) * nrrdElementNumber(nrrd);
+  size_t blockSize = static_cast<size_t>(this->CompressionBlockSize);
+  vtkIdType numberOfBlocks = static_cast<vtkIdType>((dataSize + blockSize - 1) / blockSize);
+  std::vector<std::string> members(numberOfBlocks);
+  std::vector<char> success(numberOfBlocks, 0);
+  CompressGzipMembersFunctor compressFunctor(data, dataSize, blockSize, this->CompressionLevel, members, success);
+  vtkSMPTools::For(0, numberOfBlocks, compressFunctor);
+  if (std::find(success.begin(), success.end(), 0) != success.end())
+    {
+    vtkErrorMacro("WriteParallelCompressed: Error compressing data");
+    return false;
+    }
+
+  // Write file
+  vtksys::ofstream file(this->GetFileName(), std::ios::out | std::ios::binary);
+  if (!file)
+    {
+    vtkErrorMacro("WriteParallelCompressed: Failed to open file for writing: " << this->GetFileName());
+    return false;
+    }
+  file.write(header.c_str(), header.size());
+  for (std::vector<std::string>::iterator memberIt = members.begin(); memberIt != members.end(); ++memberIt)
+    {
+    file.write(memberIt->c_str(), memberIt->size());
+    std::string().swap(*memberIt);
+    }
+  file.close();
+  return !file.fail();
+}
+
+//----------------------------------------------------------------------------
 void vtkTeemNRRDWriter::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
+  os << indent << "UseCompression: " << this->UseCompression << "\n";
+  os << indent << "CompressionLevel: " << this->CompressionLevel << "\n";
+  os << indent << "UseParallelCompression: " << this->UseParallelCompression << "\n";
+  os << indent << "CompressionBlockSize: " << this->CompressionBlockSize << "\n";
 
   os << indent << "RAS to IJK Matrix: ";
      this->IJKToRASMatrix->PrintSelf(os,indent);
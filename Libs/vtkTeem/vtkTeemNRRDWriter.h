@@ -58,6 +58,22 @@ public:
   vtkSetClampMacro(CompressionLevel, int, 0, 9);
   vtkGetMacro(CompressionLevel, int);
 
+  /// If enabled then data is split into blocks that are compressed in parallel.
+  /// Each block is stored as a separate gzip member, therefore the file remains
+  /// readable by any NRRD reader. The compressed size of each member is stored
+  /// in the gzip header, which allows vtkTeemNRRDReader to decompress the
+  /// members in parallel, too.
+  /// Only used if compression is enabled and data is attached to the header (.nrrd file).
+  /// Disabled by default.
+  vtkSetMacro(UseParallelCompression, int);
+  vtkGetMacro(UseParallelCompression, int);
+  vtkBooleanMacro(UseParallelCompression, int);
+
+  /// Size of uncompressed data in each compressed block, in bytes.
+  /// Default is 1 MiB.
+  vtkSetClampMacro(CompressionBlockSize, int, 65536, 268435456);
+  vtkGetMacro(CompressionBlockSize, int);
+
   vtkSetClampMacro(FileType,int,VTK_ASCII,VTK_BINARY);
   vtkGetMacro(FileType,int);
   void SetFileTypeToASCII() {this->SetFileType(VTK_ASCII);};
@@ -109,6 +125,11 @@ protected:
   /// Write method. It is called by vtkWriter::Write();
   void WriteData() override;
 
+  ///
+  /// Write the header and the data compressed in parallel.
+  /// Returns false on failure.
+  bool WriteParallelCompressed(Nrrd* nrrd);
+
   ///
   /// Flag to set to on when a write error occurred
   int WriteError;
@@ -123,6 +144,8 @@ protected:
 
   int UseCompression;
   int CompressionLevel;
+  int UseParallelCompression;
+  int CompressionBlockSize;
   int FileType;
 
   AttributeMapType *Attributes;
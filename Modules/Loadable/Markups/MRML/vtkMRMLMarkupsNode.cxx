@@ -380,6 +380,8 @@ void vtkMRMLMarkupsNode::RemoveAllControlPoints()
     }
 
   this->ControlPoints.clear();
+  this->ControlPointIndexByID.clear();
+  this->ControlPointIndexByIDValid = true;
 
   if (!this->GetDisableModifiedEvent())
     {
@@ -545,6 +547,11 @@ int vtkMRMLMarkupsNode::AddControlPoint(ControlPoint *controlPoint, bool autoLab
     }
 
   this->ControlPoints.push_back(controlPoint);
+  if (this->ControlPointIndexByIDValid)
+    {
+    // the first control point is found if IDs are not unique
+    this->ControlPointIndexByID.emplace(controlPoint->ID, static_cast<int>(this->ControlPoints.size()) - 1);
+    }
 
   if (!this->GetDisableModifiedEvent())
     {
@@ -696,6 +703,19 @@ void vtkMRMLMarkupsNode::RemoveNthControlPoint(int pointIndex)
 
   bool positionWasDefined = (this->ControlPoints[static_cast<unsigned int>(pointIndex)]->PositionStatus == vtkMRMLMarkupsNode::PositionDefined);
 
+  if (this->ControlPointIndexByIDValid && pointIndex == this->GetNumberOfControlPoints() - 1)
+    {
+    // last point is removed, other indices remain valid
+    std::unordered_map<std::string, int>::iterator indexIt = this->ControlPointIndexByID.find(controlPoint->ID);
+    if (indexIt != this->ControlPointIndexByID.end() && indexIt->second == pointIndex)
+      {
+      this->ControlPointIndexByID.erase(indexIt);
+      }
+    }
+  else
+    {
+    this->InvalidateControlPointIndexByID();
+    }
   delete this->ControlPoints[static_cast<unsigned int> (pointIndex)];
   this->ControlPoints.erase(this->ControlPoints.begin() + pointIndex);
 
@@ -739,6 +759,7 @@ bool vtkMRMLMarkupsNode::InsertControlPoint(ControlPoint *controlPoint, int targ
 
   std::vector < ControlPoint* >::iterator pos = this->ControlPoints.begin() + destIndex;
   std::vector < ControlPoint* >::iterator result = this->ControlPoints.insert(pos, controlPoint);
+  this->InvalidateControlPointIndexByID();
 
   if (!this->GetDisableModifiedEvent())
     {
@@ -814,6 +835,7 @@ void vtkMRMLMarkupsNode::SwapControlPoints(int m1, int m2)
   *controlPoint1 = *controlPoint2;
   // and copy the backup of the first one into the second
   *controlPoint2 = controlPoint1Backup;
+  this->InvalidateControlPointIndexByID();
 
   if (!this->GetDisableModifiedEvent())
     {
@@ -1221,16 +1243,47 @@ int vtkMRMLMarkupsNode::GetNthControlPointIndexByID(const char* controlPointID)
     {
     return -1;
     }
-  for (int controlPointIndex = 0; controlPointIndex < this->GetNumberOfControlPoints(); controlPointIndex++)
+  this->UpdateControlPointIndexByID();
+  std::unordered_map<std::string, int>::iterator indexIt = this->ControlPointIndexByID.find(controlPointID);
+  if (indexIt == this->ControlPointIndexByID.end())
     {
-    ControlPoint *compareControlPoint = this->ControlPoints[controlPointIndex];
-    if (compareControlPoint &&
-        strcmp(compareControlPoint->ID.c_str(), controlPointID) == 0)
-      {
-      return controlPointIndex;
-      }
+    return -1;
     }
-  return -1;
+  int controlPointIndex = indexIt->second;
+  if (controlPointIndex >= this->GetNumberOfControlPoints()
+    || this->ControlPoints[controlPointIndex]->ID != controlPointID)
+    {
+    // ID of a control point was changed directly, rebuild the index
+    this->InvalidateControlPointIndexByID();
+    this->UpdateControlPointIndexByID();
+    indexIt = this->ControlPointIndexByID.find(controlPointID);
+    return (indexIt != this->ControlPointIndexByID.end() ? indexIt->second : -1);
+    }
+  return controlPointIndex;
+}
+
+//-------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::InvalidateControlPointIndexByID()
+{
+  this->ControlPointIndexByIDValid = false;
+}
+
+//-------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::UpdateControlPointIndexByID()
+{
+  if (this->ControlPointIndexByIDValid)
+    {
+    return;
+    }
+  this->ControlPointIndexByID.clear();
+  this->ControlPointIndexByID.reserve(this->ControlPoints.size());
+  int numberOfControlPoints = this->GetNumberOfControlPoints();
+  for (int controlPointIndex = 0; controlPointIndex < numberOfControlPoints; controlPointIndex++)
+    {
+    // the first control point is found if IDs are not unique
+    this->ControlPointIndexByID.emplace(this->ControlPoints[controlPointIndex]->ID, controlPointIndex);
+    }
+  this->ControlPointIndexByIDValid = true;
 }
 
 //-------------------------------------------------------------------------
@@ -1262,6 +1315,7 @@ void vtkMRMLMarkupsNode::SetNthControlPointID(int n, std::string id)
     return;
     }
   controlPoint->ID = id;
+  this->InvalidateControlPointIndexByID();
 }
 
 //---------------------------------------------------------------------------
@@ -1909,6 +1963,49 @@ void vtkMRMLMarkupsNode::GetControlPointLabels(vtkStringArray* labels)
 
 //---------------------------------------------------------------------------
 void vtkMRMLMarkupsNode::SetControlPointPositionsWorld(vtkPoints* points)
+{
+  if (!points)
+    {
+    this->RemoveAllControlPoints();
+    return;
+    }
+  vtkMRMLTransformNode* parentTransformNode = this->GetParentTransformNode();
+  if (!parentTransformNode)
+    {
+    this->SetControlPointPositions(points);
+    return;
+    }
+  // Get the transform once, instead of for each point
+  vtkNew<vtkGeneralTransform> worldToLocalTransform;
+  vtkMRMLTransformNode::GetTransformBetweenNodes(nullptr, parentTransformNode, worldToLocalTransform);
+  vtkNew<vtkPoints> pointsLocal;
+  worldToLocalTransform->TransformPoints(points, pointsLocal);
+  this->SetControlPointPositions(pointsLocal);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::GetControlPointPositionsWorld(vtkPoints* points)
+{
+  if (!points)
+    {
+    return;
+    }
+  vtkMRMLTransformNode* parentTransformNode = this->GetParentTransformNode();
+  if (!parentTransformNode)
+    {
+    this->GetControlPointPositions(points);
+    return;
+    }
+  vtkNew<vtkPoints> pointsLocal;
+  this->GetControlPointPositions(pointsLocal);
+  vtkNew<vtkGeneralTransform> localToWorldTransform;
+  vtkMRMLTransformNode::GetTransformBetweenNodes(parentTransformNode, nullptr, localToWorldTransform);
+  points->Reset();
+  localToWorldTransform->TransformPoints(pointsLocal, points);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::SetControlPointPositions(vtkPoints* points)
 {
   if (!points)
     {
@@ -1916,37 +2013,105 @@ void vtkMRMLMarkupsNode::SetControlPointPositionsWorld(vtkPoints* points)
     return;
     }
 
+  int numberOfPoints = static_cast<int>(points->GetNumberOfPoints());
+  if (this->MaximumNumberOfControlPoints != 0 && numberOfPoints > this->MaximumNumberOfControlPoints)
+    {
+    vtkErrorMacro("SetControlPointPositions: number of points (" << numberOfPoints
+      << ") is more than maximum number of control points allowed (" << this->MaximumNumberOfControlPoints << ")");
+    return;
+    }
+
   int wasModified = this->StartModify();
   this->IsUpdatingPoints = true;
 
-  vtkIdType numberOfPoints = points->GetNumberOfPoints();
-  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+  int numberOfExistingPoints = std::min(this->GetNumberOfControlPoints(), numberOfPoints);
+  bool positionDefined = false;
+  bool positionUndefined = false;
+
+  // Update existing points
+  for (int pointIndex = 0; pointIndex < numberOfExistingPoints; pointIndex++)
     {
-    double* posWorld = points->GetPoint(pointIndex);
-    if (pointIndex < this->GetNumberOfControlPoints())
+    ControlPoint* controlPoint = this->ControlPoints[pointIndex];
+    points->GetPoint(pointIndex, controlPoint->Position);
+    if (controlPoint->PositionStatus != PositionDefined)
       {
-      // point already exists, just update it
-      this->SetNthControlPointPositionWorldFromArray(pointIndex, posWorld);
+      controlPoint->PositionStatus = PositionDefined;
+      positionDefined = true;
       }
-    else
+    }
+
+  // Add new points. IDs and labels are generated the same way as in AddControlPoint
+  // but the label format string is only computed once.
+  if (numberOfPoints > numberOfExistingPoints)
+    {
+    std::string formatString = this->ReplaceListNameInMarkupLabelFormat();
+    char label[128];
+    label[sizeof(label) - 1] = 0; // make sure the string is zero-terminated
+    this->ControlPoints.reserve(numberOfPoints);
+    for (int pointIndex = numberOfExistingPoints; pointIndex < numberOfPoints; pointIndex++)
       {
-      // need to add a new point
-      vtkMRMLMarkupsNode::AddControlPointWorld(vtkVector3d(posWorld));
+      ControlPoint* controlPoint = new ControlPoint;
+      points->GetPoint(pointIndex, controlPoint->Position);
+      controlPoint->PositionStatus = PositionDefined;
+      controlPoint->ID = this->GenerateUniqueControlPointID();
+      snprintf(label, sizeof(label) - 1, formatString.c_str(), this->LastUsedControlPointNumber);
+      controlPoint->Label = label;
+      this->ControlPoints.push_back(controlPoint);
+      if (this->ControlPointIndexByIDValid)
+        {
+        this->ControlPointIndexByID.emplace(controlPoint->ID, pointIndex);
+        }
+      }
+    positionDefined = true;
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointAddedEvent);
+    }
+
+  // Remove extra points. Points are removed from the end, the same way as
+  // in RemoveNthControlPoint, so that the last control point number can be reused.
+  if (this->GetNumberOfControlPoints() > numberOfPoints)
+    {
+    for (int pointIndex = this->GetNumberOfControlPoints() - 1; pointIndex >= numberOfPoints; pointIndex--)
+      {
+      ControlPoint* controlPoint = this->ControlPoints[pointIndex];
+      if (controlPoint->Label == this->GenerateControlPointLabel(this->LastUsedControlPointNumber))
+        {
+        this->LastUsedControlPointNumber--;
+        }
+      if (controlPoint->PositionStatus == PositionDefined)
+        {
+        positionUndefined = true;
+        }
+      delete controlPoint;
       }
+    this->ControlPoints.resize(numberOfPoints);
+    this->InvalidateControlPointIndexByID();
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointRemovedEvent);
     }
-  while (this->GetNumberOfControlPoints() > numberOfPoints)
+
+  this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointModifiedEvent);
+  if (positionDefined)
+    {
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointPositionDefinedEvent);
+    }
+  if (positionUndefined)
     {
-    this->RemoveNthControlPoint(this->GetNumberOfControlPoints() - 1);
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointPositionUndefinedEvent);
     }
+  this->StorableModifiedTime.Modified();
 
   this->IsUpdatingPoints = false;
   // No need to call UpdateAllMeasurements(), because it is automatically
   // called in EndModify().
   this->EndModify(wasModified);
+
+  if (this->GetDisplayNode())
+    {
+    this->GetDisplayNode()->UpdateScalarRange();
+    }
 }
 
 //---------------------------------------------------------------------------
-void vtkMRMLMarkupsNode::GetControlPointPositionsWorld(vtkPoints* points)
+void vtkMRMLMarkupsNode::GetControlPointPositions(vtkPoints* points)
 {
   if (!points)
     {
@@ -1954,11 +2119,9 @@ void vtkMRMLMarkupsNode::GetControlPointPositionsWorld(vtkPoints* points)
     }
   int numberOfControlPoints = this->GetNumberOfControlPoints();
   points->SetNumberOfPoints(numberOfControlPoints);
-  double posWorld[3] = { 0.0 };
   for (int controlPointIndex = 0; controlPointIndex < numberOfControlPoints; controlPointIndex++)
     {
-    this->GetNthControlPointPositionWorld(controlPointIndex, posWorld);
-    points->SetPoint(controlPointIndex, posWorld);
+    points->SetPoint(controlPointIndex, this->ControlPoints[controlPointIndex]->Position);
     }
 }
 
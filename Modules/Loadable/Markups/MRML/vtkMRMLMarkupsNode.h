@@ -31,6 +31,9 @@
 #include <vtkSmartPointer.h>
 #include <vtkVector.h>
 
+// STD includes
+#include <unordered_map>
+
 class vtkParallelTransportFrame;
 class vtkMRMLUnitNode;
 
@@ -43,7 +46,9 @@ class vtkMRMLUnitNode;
 /// by the VTKWidget (there is one widget for each MRMLMarkupsNode per view).
 /// Visualization parameters for these nodes are controlled by the
 /// vtkMRMLMarkupsDisplayNode class.
-/// Each ControlPoint has a unique ID.
+/// Each ControlPoint has a unique ID. The ID must only be changed using
+/// SetNthControlPointID or ResetNthControlPointID, because control point indices
+/// are cached by ID for quick lookup.
 /// Each ControlPoint has an orientation defined by a by a 4 element vector:
 /// [0] = the angle of rotation in degrees, [1,2,3] = the axis of rotation.
 /// Default is 0.0, 0.0, 0.0, 1.0.
@@ -453,7 +458,8 @@ public:
   /// \deprecated Use GetNthControlPointID instead.
   std::string GetNthMarkupID(int n = 0) { return this->GetNthControlPointID(n); }
 
-  /// Get the Nth control point index based on it's ID
+  /// Get the Nth control point index based on it's ID.
+  /// Indices are cached, therefore lookup time does not depend on the number of control points.
   int GetNthControlPointIndexByID(const char* controlPointID);
   /// Get the Nth control point based on it's ID
   ControlPoint* GetNthControlPointByID(const char* controlPointID);
@@ -605,6 +611,17 @@ public:
   /// Get a copy of all control point positions in world coordinate system
   void GetControlPointPositionsWorld(vtkPoints* points);
 
+  /// Set all control point positions from a point list (in local coordinate system).
+  /// If points is nullptr then all control points are removed.
+  /// New control points are added if needed.
+  /// Existing control points are updated with the new positions.
+  /// Any extra existing control points are removed.
+  /// Events are only invoked once, after all the control points are updated.
+  void SetControlPointPositions(vtkPoints* points);
+
+  /// Get a copy of all control point positions in local coordinate system
+  void GetControlPointPositions(vtkPoints* points);
+
   /// 4x4 matrix detailing the orientation and position in world coordinates of the interaction handles.
   virtual vtkMatrix4x4* GetInteractionHandleToWorldMatrix();
 
@@ -642,6 +659,13 @@ protected:
   /// managed by the markups node.
   void SetNthControlPointID(int n, std::string id);
 
+  /// Mark the control point ID to index map out-of-date.
+  /// It must be called whenever control points are removed, inserted, or reordered.
+  void InvalidateControlPointIndexByID();
+
+  /// Rebuild the control point ID to index map if it is out-of-date.
+  void UpdateControlPointIndexByID();
+
   /// Generate a scene unique ID for a ControlPoint. If the scene is not set,
   /// returns a number based on the max number of ControlPoints that
   /// have been in this list
@@ -676,6 +700,12 @@ protected:
   /// Vector of control points
   ControlPointsListType ControlPoints;
 
+  /// Index of control points by their ID, used for quick lookup.
+  /// Updated when a control point is added to the end of the list and
+  /// rebuilt at the next lookup after any other change of the list.
+  std::unordered_map<std::string, int> ControlPointIndexByID;
+  bool ControlPointIndexByIDValid{true};
+
   /// Converts curve control points to curve points.
   vtkSmartPointer<vtkCurveGenerator> CurveGenerator;
 
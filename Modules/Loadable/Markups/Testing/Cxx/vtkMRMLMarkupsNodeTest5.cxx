@@ -0,0 +1,188 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+const int NUMBER_OF_POINTS = 100000;
+
+//-----------------------------------------------------------------------------
+void CountEvents(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+  void* clientData, void* vtkNotUsed(callData))
+{
+  int* numberOfEvents = reinterpret_cast<int*>(clientData);
+  (*numberOfEvents)++;
+}
+
+//-----------------------------------------------------------------------------
+int TestBulkPositions()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLMarkupsFiducialNode> markupsNode;
+  markupsNode->SetName("F");
+  scene->AddNode(markupsNode);
+
+  int numberOfPointAddedEvents = 0;
+  vtkNew<vtkCallbackCommand> pointAddedCallback;
+  pointAddedCallback->SetCallback(CountEvents);
+  pointAddedCallback->SetClientData(&numberOfPointAddedEvents);
+  markupsNode->AddObserver(vtkMRMLMarkupsNode::PointAddedEvent, pointAddedCallback);
+
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(NUMBER_OF_POINTS);
+  for (int pointIndex = 0; pointIndex < NUMBER_OF_POINTS; pointIndex++)
+    {
+    points->SetPoint(pointIndex, pointIndex, 2.0 * pointIndex, -pointIndex);
+    }
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  markupsNode->SetControlPointPositions(points);
+  timer->StopTimer();
+  double importTime = timer->GetElapsedTime();
+
+  CHECK_INT(markupsNode->GetNumberOfControlPoints(), NUMBER_OF_POINTS);
+  CHECK_INT(numberOfPointAddedEvents, 1);
+  CHECK_STD_STRING(markupsNode->GetNthControlPointLabel(0), "F-1");
+  CHECK_STD_STRING(markupsNode->GetNthControlPointLabel(NUMBER_OF_POINTS - 1), "F-100000");
+  double position[3] = { 0.0, 0.0, 0.0 };
+  markupsNode->GetNthControlPointPosition(NUMBER_OF_POINTS - 1, position);
+  CHECK_DOUBLE(position[1], 2.0 * (NUMBER_OF_POINTS - 1));
+
+  // Look up all points by ID
+  timer->StartTimer();
+  for (int pointIndex = 0; pointIndex < NUMBER_OF_POINTS; pointIndex++)
+    {
+    std::string id = markupsNode->GetNthControlPointID(pointIndex);
+    if (markupsNode->GetNthControlPointIndexByID(id.c_str()) != pointIndex)
+      {
+      std::cerr << "Line " << __LINE__ << ": control point " << pointIndex << " is not found by ID " << id << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  timer->StopTimer();
+  double lookupTime = timer->GetElapsedTime();
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID("invalid"), -1);
+
+  // Index is updated after removal, insertion, swap, and ID change
+  std::string removedID = markupsNode->GetNthControlPointID(10);
+  std::string lastID = markupsNode->GetNthControlPointID(NUMBER_OF_POINTS - 1);
+  markupsNode->RemoveNthControlPoint(10);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID(removedID.c_str()), -1);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID(lastID.c_str()), NUMBER_OF_POINTS - 2);
+  vtkMRMLMarkupsNode::ControlPoint* controlPoint = new vtkMRMLMarkupsNode::ControlPoint;
+  controlPoint->ID = "inserted";
+  markupsNode->InsertControlPoint(controlPoint, 0);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID("inserted"), 0);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID(lastID.c_str()), NUMBER_OF_POINTS - 1);
+  markupsNode->SwapControlPoints(0, 5);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID("inserted"), 5);
+  CHECK_BOOL(markupsNode->ResetNthControlPointID(5), true);
+  std::string renamedID = markupsNode->GetNthControlPointID(5);
+  CHECK_BOOL(renamedID != "inserted", true);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID("inserted"), -1);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID(renamedID.c_str()), 5);
+  markupsNode->RemoveNthControlPoint(markupsNode->GetNumberOfControlPoints() - 1);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID(lastID.c_str()), -1);
+
+  // Bulk get
+  vtkNew<vtkPoints> retrievedPoints;
+  timer->StartTimer();
+  markupsNode->GetControlPointPositions(retrievedPoints);
+  timer->StopTimer();
+  double getTime = timer->GetElapsedTime();
+  CHECK_INT(static_cast<int>(retrievedPoints->GetNumberOfPoints()), markupsNode->GetNumberOfControlPoints());
+
+  // Shrinking removes points from the end
+  vtkNew<vtkPoints> fewerPoints;
+  fewerPoints->InsertNextPoint(1.0, 2.0, 3.0);
+  fewerPoints->InsertNextPoint(4.0, 5.0, 6.0);
+  markupsNode->SetControlPointPositions(fewerPoints);
+  CHECK_INT(markupsNode->GetNumberOfControlPoints(), 2);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID(renamedID.c_str()), -1);
+  markupsNode->GetNthControlPointPosition(1, position);
+  CHECK_DOUBLE(position[2], 6.0);
+
+  // World coordinates
+  vtkNew<vtkMRMLLinearTransformNode> transformNode;
+  scene->AddNode(transformNode);
+  vtkNew<vtkMatrix4x4> matrix;
+  matrix->SetElement(0, 3, 100.0);
+  transformNode->SetMatrixTransformToParent(matrix);
+  markupsNode->SetAndObserveTransformNodeID(transformNode->GetID());
+  timer->StartTimer();
+  markupsNode->SetControlPointPositionsWorld(points);
+  timer->StopTimer();
+  double importWorldTime = timer->GetElapsedTime();
+  CHECK_INT(markupsNode->GetNumberOfControlPoints(), NUMBER_OF_POINTS);
+  markupsNode->GetNthControlPointPosition(1, position);
+  CHECK_DOUBLE(position[0], 1.0 - 100.0);
+  markupsNode->GetControlPointPositionsWorld(retrievedPoints);
+  retrievedPoints->GetPoint(1, position);
+  CHECK_DOUBLE(position[0], 1.0);
+
+  markupsNode->SetControlPointPositions(nullptr);
+  CHECK_INT(markupsNode->GetNumberOfControlPoints(), 0);
+
+  // Shrinking allows reusing the last control point number, the same way as RemoveNthControlPoint
+  vtkNew<vtkMRMLMarkupsFiducialNode> labelTestNode;
+  scene->AddNode(labelTestNode);
+  vtkNew<vtkPoints> threePoints;
+  threePoints->InsertNextPoint(0.0, 0.0, 0.0);
+  threePoints->InsertNextPoint(1.0, 0.0, 0.0);
+  threePoints->InsertNextPoint(2.0, 0.0, 0.0);
+  labelTestNode->SetControlPointPositions(threePoints);
+  std::string removedLabel = labelTestNode->GetNthControlPointLabel(2);
+  labelTestNode->SetControlPointPositions(fewerPoints);
+  CHECK_INT(labelTestNode->GetNumberOfControlPoints(), 2);
+  labelTestNode->AddControlPoint(vtkVector3d(3.0, 0.0, 0.0));
+  CHECK_STD_STRING(labelTestNode->GetNthControlPointLabel(2), removedLabel);
+  labelTestNode->RemoveNthControlPoint(2);
+  labelTestNode->AddControlPoint(vtkVector3d(3.0, 0.0, 0.0));
+  CHECK_STD_STRING(labelTestNode->GetNthControlPointLabel(2), removedLabel);
+
+  std::cout << "Number of points: " << NUMBER_OF_POINTS
+    << "  Import: " << importTime * 1000.0 << " ms"
+    << "  Import world: " << importWorldTime * 1000.0 << " ms"
+    << "  Get: " << getTime * 1000.0 << " ms"
+    << "  Lookup by ID: " << lookupTime * 1.0e9 / NUMBER_OF_POINTS << " ns/point" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkMRMLMarkupsNodeTest5(int vtkNotUsed(argc), char * vtkNotUsed(argv) [])
+{
+  CHECK_EXIT_SUCCESS(TestBulkPositions());
+  return EXIT_SUCCESS;
+}
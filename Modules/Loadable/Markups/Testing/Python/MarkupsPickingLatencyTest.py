@@ -0,0 +1,104 @@
+# markups control point picking latency test
+
+from __future__ import print_function
+import sys
+import time
+import numpy as np
+from vtk.util import numpy_support
+
+#
+# Measure time of mouse move events (that look for control points near the mouse pointer)
+# over a point list that contains a large number of control points.
+# Picking uses a display-space spatial index, therefore the time of a mouse move
+# should be independent of the number of control points.
+#
+# The mouse move time is only checked if --check-timing is specified
+# (added by CMake if Slicer_BUILD_BENCHMARKS is enabled), otherwise it is just reported.
+#
+
+numberOfControlPoints = 100000
+numberOfMouseMoves = 200
+maximumMouseMoveTimeSec = 0.05
+checkTiming = '--check-timing' in sys.argv
+
+slicer.app.layoutManager().setLayout(slicer.vtkMRMLLayoutNode.SlicerLayoutFourUpView)
+
+# Control points in a grid in the axial plane
+gridSize = int(np.ceil(np.sqrt(numberOfControlPoints)))
+positions = np.zeros([numberOfControlPoints, 3])
+positions[:,0] = (np.arange(numberOfControlPoints) % gridSize) * 0.5 - gridSize * 0.25
+positions[:,1] = (np.arange(numberOfControlPoints) // gridSize) * 0.5 - gridSize * 0.25
+points = vtk.vtkPoints()
+points.SetData(numpy_support.numpy_to_vtk(positions, deep=True))
+
+markupsNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLMarkupsFiducialNode')
+markupsNode.CreateDefaultDisplayNodes()
+markupsNode.GetDisplayNode().SetPointLabelsVisibility(False)
+startTime = time.time()
+markupsNode.SetControlPointPositionsWorld(points)
+print('Time to add {0} control points: {1:.3f} s'.format(numberOfControlPoints, time.time() - startTime))
+if markupsNode.GetNumberOfControlPoints() != numberOfControlPoints:
+  raise Exception("Unexpected number of control points: {0}".format(markupsNode.GetNumberOfControlPoints()))
+
+def measureMouseMoveTime(viewName, view, displayPositions):
+  interactor = view.interactorStyle().GetInteractor()
+  view.forceRender()
+  # First mouse move builds the picking index
+  interactor.SetEventPosition(int(displayPositions[0][0]), int(displayPositions[0][1]))
+  startTime = time.time()
+  interactor.MouseMoveEvent()
+  firstMouseMoveTime = time.time() - startTime
+  startTime = time.time()
+  for displayPosition in displayPositions:
+    interactor.SetEventPosition(int(displayPosition[0]), int(displayPosition[1]))
+    interactor.MouseMoveEvent()
+  mouseMoveTime = (time.time() - startTime) / len(displayPositions)
+  print('{0} view: first mouse move: {1:.1f} ms, mouse move: {2:.2f} ms'.format(
+    viewName, firstMouseMoveTime * 1000.0, mouseMoveTime * 1000.0))
+  if checkTiming and mouseMoveTime > maximumMouseMoveTimeSec:
+    raise Exception('{0} view: mouse move time is too long: {1:.3f} s'.format(viewName, mouseMoveTime))
+
+#
+# Slice view
+#
+
+sliceWidget = slicer.app.layoutManager().sliceWidget('Red')
+sliceNode = sliceWidget.mrmlSliceNode()
+sliceNode.SetOrientationToAxial()
+sliceNode.SetFieldOfView(50.0, 50.0, 1.0)
+sliceNode.SetSliceOffset(0.0)
+sliceView = sliceWidget.sliceView()
+sliceView.forceRender()
+
+# Mouse positions along the diagonal of the view
+viewSize = sliceNode.GetDimensions()
+mousePositions = [[viewSize[0] * i / numberOfMouseMoves, viewSize[1] * i / numberOfMouseMoves] for i in range(numberOfMouseMoves)]
+measureMouseMoveTime('Slice', sliceView, mousePositions)
+
+# Hovering over a control point makes it active
+pickedControlPointIndex = gridSize * (gridSize // 2) + gridSize // 2
+rasToXY = vtk.vtkMatrix4x4()
+vtk.vtkMatrix4x4.Invert(sliceNode.GetXYToRAS(), rasToXY)
+pickedPositionRas = list(positions[pickedControlPointIndex]) + [1.0]
+pickedPositionXY = rasToXY.MultiplyPoint(pickedPositionRas)
+interactor = sliceView.interactorStyle().GetInteractor()
+interactor.SetEventPosition(int(round(pickedPositionXY[0])), int(round(pickedPositionXY[1])))
+interactor.MouseMoveEvent()
+activeControlPointIndex = markupsNode.GetDisplayNode().GetActiveControlPoint()
+activePositionRas = positions[activeControlPointIndex] if activeControlPointIndex >= 0 else None
+if activePositionRas is None or np.linalg.norm(activePositionRas - positions[pickedControlPointIndex]) > 0.5:
+  raise Exception('Unexpected active control point: {0} (expected {1})'.format(activeControlPointIndex, pickedControlPointIndex))
+
+#
+# 3D view
+#
+
+threeDView = slicer.app.layoutManager().threeDWidget(0).threeDView()
+threeDView.resetFocalPoint()
+threeDView.forceRender()
+viewSize = threeDView.renderWindow().GetSize()
+mousePositions = [[viewSize[0] * i / numberOfMouseMoves, viewSize[1] * i / numberOfMouseMoves] for i in range(numberOfMouseMoves)]
+measureMouseMoveTime('3D', threeDView, mousePositions)
+
+slicer.mrmlScene.RemoveNode(markupsNode)
+print('Test passed')
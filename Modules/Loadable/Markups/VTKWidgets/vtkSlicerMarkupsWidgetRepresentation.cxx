@@ -51,6 +51,10 @@
 #include <vtkMRMLInteractionEventData.h>
 #include <vtkMRMLTransformNode.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+
 //----------------------------------------------------------------------
 static const double INTERACTION_HANDLE_RADIUS = 0.0625;
 static const double INTERACTION_HANDLE_DIAMETER = INTERACTION_HANDLE_RADIUS * 2.0;
@@ -520,13 +524,27 @@ void vtkSlicerMarkupsWidgetRepresentation::BuildLine(vtkPolyData* linePolyData,
 
 //----------------------------------------------------------------------
 void vtkSlicerMarkupsWidgetRepresentation::UpdateFromMRML(
-    vtkMRMLNode* vtkNotUsed(caller), unsigned long event, void *vtkNotUsed(callData))
+    vtkMRMLNode* caller, unsigned long event, void *vtkNotUsed(callData))
 {
   if (!this->InteractionPipeline)
     {
     this->SetupInteractionPipeline();
     }
 
+  // Only rebuild the picking index if control point positions or visibility may have changed.
+  // Display node changes (such as the active component changing while the mouse is moving)
+  // do not require rebuilding the index, view-specific changes are checked by subclasses
+  // when the index is used.
+  if (!event
+    || event == vtkMRMLTransformableNode::TransformModifiedEvent
+    || event == vtkMRMLMarkupsNode::PointModifiedEvent
+    || event == vtkMRMLMarkupsNode::PointAddedEvent
+    || event == vtkMRMLMarkupsNode::PointRemovedEvent
+    || (event == vtkCommand::ModifiedEvent && vtkMRMLMarkupsNode::SafeDownCast(caller)))
+    {
+    this->PickingIndexModified = true;
+    }
+
   if (!event || event == vtkMRMLTransformableNode::TransformModifiedEvent)
     {
     this->MarkupsTransformModifiedTime.Modified();
@@ -540,6 +558,10 @@ void vtkSlicerMarkupsWidgetRepresentation::UpdateFromMRML(
       {
       markupsNode = vtkMRMLMarkupsNode::SafeDownCast(this->MarkupsDisplayNode->GetDisplayableNode());
       }
+    if (markupsNode != this->MarkupsNode)
+      {
+      this->PickingIndexModified = true;
+      }
     this->SetMarkupsNode(markupsNode);
     }
 
@@ -1588,3 +1610,120 @@ void vtkSlicerMarkupsWidgetRepresentation::MarkupsInteractionPipeline::GetIntera
     this->HandleToWorldTransform->TransformPoint(positionWorld, positionWorld);
     }
 }
+
+//----------------------------------------------------------------------
+bool vtkSlicerMarkupsWidgetRepresentation::IsControlPointPickingIndexModified()
+{
+  return this->PickingIndexModified || this->PickingIndexBuildTime < this->GetMTime();
+}
+
+//----------------------------------------------------------------------
+void vtkSlicerMarkupsWidgetRepresentation::ControlPointPickingIndex::Clear()
+{
+  this->Points.clear();
+  this->Cells.clear();
+  this->CellSize = 1.0;
+  this->MaximumTolerance2 = 0.0;
+}
+
+//----------------------------------------------------------------------
+void vtkSlicerMarkupsWidgetRepresentation::ControlPointPickingIndex::AddPoint(
+  int controlPointIndex, const double displayPosition[3], double tolerance2)
+{
+  PointInfo point;
+  point.ControlPointIndex = controlPointIndex;
+  point.DisplayPosition[0] = displayPosition[0];
+  point.DisplayPosition[1] = displayPosition[1];
+  point.DisplayPosition[2] = displayPosition[2];
+  point.Tolerance2 = tolerance2;
+  this->Points.push_back(point);
+  this->MaximumTolerance2 = std::max(this->MaximumTolerance2, tolerance2);
+}
+
+//----------------------------------------------------------------------
+void vtkSlicerMarkupsWidgetRepresentation::ControlPointPickingIndex::Build()
+{
+  this->Cells.clear();
+  // Cell size must not be smaller than any picking tolerance, so that
+  // all pickable points are in the neighboring cells of the picked position.
+  this->CellSize = std::max(1.0, sqrt(this->MaximumTolerance2));
+  int numberOfPoints = static_cast<int>(this->Points.size());
+  for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
+    {
+    const double* displayPosition = this->Points[pointIndex].DisplayPosition;
+    vtkTypeUInt64 cellKey = this->GetCellKey(
+      this->GetCellCoordinate(displayPosition[0]), this->GetCellCoordinate(displayPosition[1]));
+    this->Cells[cellKey].push_back(pointIndex);
+    }
+}
+
+//----------------------------------------------------------------------
+int vtkSlicerMarkupsWidgetRepresentation::ControlPointPickingIndex::FindClosestPoint(
+  const double displayPosition[3], double& closestDistance2, vtkSlicerMarkupsWidgetRepresentation* representation)
+{
+  int closestControlPointIndex = -1;
+  if (this->Points.empty())
+    {
+    return closestControlPointIndex;
+    }
+  int cellX = this->GetCellCoordinate(displayPosition[0]);
+  int cellY = this->GetCellCoordinate(displayPosition[1]);
+  for (int neighborCellY = cellY - 1; neighborCellY <= cellY + 1; ++neighborCellY)
+    {
+    for (int neighborCellX = cellX - 1; neighborCellX <= cellX + 1; ++neighborCellX)
+      {
+      std::unordered_map<vtkTypeUInt64, std::vector<int> >::iterator cellIt =
+        this->Cells.find(this->GetCellKey(neighborCellX, neighborCellY));
+      if (cellIt == this->Cells.end())
+        {
+        continue;
+        }
+      for (int pointIndex : cellIt->second)
+        {
+        const PointInfo& point = this->Points[pointIndex];
+        double dist2 = vtkMath::Distance2BetweenPoints(point.DisplayPosition, displayPosition);
+        if (dist2 >= point.Tolerance2)
+          {
+          continue;
+          }
+        // If distances are equal then return the lowest control point index,
+        // as if the control points were checked in order.
+        if ((dist2 < closestDistance2
+          || (dist2 == closestDistance2 && closestControlPointIndex >= 0 && point.ControlPointIndex < closestControlPointIndex))
+          && (!representation || representation->IsControlPointPickable(point.ControlPointIndex)))
+          {
+          closestDistance2 = dist2;
+          closestControlPointIndex = point.ControlPointIndex;
+          }
+        }
+      }
+    }
+  return closestControlPointIndex;
+}
+
+//----------------------------------------------------------------------
+int vtkSlicerMarkupsWidgetRepresentation::ControlPointPickingIndex::GetNumberOfPoints()
+{
+  return static_cast<int>(this->Points.size());
+}
+
+//----------------------------------------------------------------------
+int vtkSlicerMarkupsWidgetRepresentation::ControlPointPickingIndex::GetCellCoordinate(double position)
+{
+  // Clamp far-away positions (that cannot be picked anyway) to avoid integer overflow
+  const double maximumCellCoordinate = 1.0e9;
+  double cellCoordinate = std::floor(position / this->CellSize);
+  if (vtkMath::IsNan(cellCoordinate))
+    {
+    return 0;
+    }
+  cellCoordinate = std::max(-maximumCellCoordinate, std::min(maximumCellCoordinate, cellCoordinate));
+  return static_cast<int>(cellCoordinate);
+}
+
+//----------------------------------------------------------------------
+vtkTypeUInt64 vtkSlicerMarkupsWidgetRepresentation::ControlPointPickingIndex::GetCellKey(int cellX, int cellY)
+{
+  return (static_cast<vtkTypeUInt64>(static_cast<vtkTypeUInt32>(cellX)) << 32)
+    | static_cast<vtkTypeUInt64>(static_cast<vtkTypeUInt32>(cellY));
+}
@@ -49,6 +49,9 @@
 
 #include "vtkSmartPointer.h"
 
+#include <unordered_map>
+#include <vector>
+
 class vtkActor2D;
 class vtkAppendPolyData;
 class vtkArcSource;
@@ -339,6 +342,59 @@ protected:
   /// Update the interaction pipeline
   virtual void UpdateInteractionPipeline();
 
+  /// Spatial index of pickable control point positions in display coordinates.
+  /// Points are sorted into a uniform grid of square cells. Cell size is not smaller than
+  /// the largest picking tolerance, therefore only the cells around the picked position
+  /// have to be checked, regardless of the number of control points.
+  class ControlPointPickingIndex
+  {
+  public:
+    /// Remove all points from the index.
+    void Clear();
+    /// Add a control point. Tolerance2 is the squared maximum picking distance of the point.
+    void AddPoint(int controlPointIndex, const double displayPosition[3], double tolerance2);
+    /// Sort points into grid cells. Must be called after all points are added.
+    void Build();
+    /// Get index of the closest control point that is within its picking tolerance and closer
+    /// than closestDistance2. Returns -1 if no such control point is found.
+    /// If representation is specified then control points that are not pickable
+    /// according to its IsControlPointPickable method are ignored.
+    int FindClosestPoint(const double displayPosition[3], double& closestDistance2,
+      vtkSlicerMarkupsWidgetRepresentation* representation = nullptr);
+    int GetNumberOfPoints();
+
+  protected:
+    struct PointInfo
+    {
+      int ControlPointIndex;
+      double DisplayPosition[3];
+      double Tolerance2;
+    };
+    vtkTypeUInt64 GetCellKey(int cellX, int cellY);
+    int GetCellCoordinate(double position);
+
+    std::vector<PointInfo> Points;
+    std::unordered_map<vtkTypeUInt64, std::vector<int> > Cells;
+    double CellSize{1.0};
+    double MaximumTolerance2{0.0};
+  };
+
+  /// Returns true if control points or the representation have changed since the picking index was built.
+  /// Subclasses must check view-specific changes, too.
+  bool IsControlPointPickingIndexModified();
+
+  /// Rebuild the picking index from current control point display positions, if needed.
+  virtual void UpdateControlPointPickingIndex() {}
+
+  /// Returns true if the control point can be picked in the current state of the view.
+  /// Conditions that change at every rendering (such as occlusion) are not stored in the
+  /// picking index but checked by this method when a control point is found.
+  virtual bool IsControlPointPickable(int vtkNotUsed(n)) { return true; }
+
+  ControlPointPickingIndex PickingIndex;
+  bool PickingIndexModified{true};
+  vtkTimeStamp PickingIndexBuildTime;
+
 private:
   vtkSlicerMarkupsWidgetRepresentation(const vtkSlicerMarkupsWidgetRepresentation&) = delete;
   void operator=(const vtkSlicerMarkupsWidgetRepresentation&) = delete;
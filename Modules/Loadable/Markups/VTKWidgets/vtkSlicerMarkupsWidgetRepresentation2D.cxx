@@ -30,6 +30,7 @@
 #include "vtkPiecewiseFunction.h"
 #include "vtkPlane.h"
 #include "vtkPointData.h"
+#include "vtkPoints.h"
 #include "vtkPointSetToLabelHierarchy.h"
 #include "vtkPolyDataMapper2D.h"
 #include "vtkProperty2D.h"
@@ -544,33 +545,69 @@ void vtkSlicerMarkupsWidgetRepresentation2D::CanInteract(
       }
     }
 
-  vtkIdType numberOfPoints = markupsNode->GetNumberOfControlPoints();
+  // Control point display positions are only computed when the points or the view change
+  this->UpdateControlPointPickingIndex();
+  int closestControlPointIndex = this->PickingIndex.FindClosestPoint(displayPosition3, closestDistance2);
+  if (closestControlPointIndex >= 0)
+    {
+    foundComponentType = vtkMRMLMarkupsDisplayNode::ComponentControlPoint;
+    foundComponentIndex = closestControlPointIndex;
+    }
+}
+
+//----------------------------------------------------------------------
+void vtkSlicerMarkupsWidgetRepresentation2D::UpdateControlPointPickingIndex()
+{
+  vtkMRMLSliceNode* sliceNode = this->GetSliceNode();
+  vtkMRMLMarkupsNode* markupsNode = this->GetMarkupsNode();
+  if (!sliceNode || !markupsNode)
+    {
+    this->PickingIndex.Clear();
+    return;
+    }
+  double maxPickingDistanceFromControlPoint2 = this->GetMaximumControlPointPickingDistance2();
+  bool sliceProjection = this->MarkupsDisplayNode && this->MarkupsDisplayNode->GetSliceProjection();
+  if (!this->IsControlPointPickingIndexModified()
+    && this->PickingIndexBuildTime > sliceNode->GetXYToRAS()->GetMTime()
+    && this->PickingIndexMaximumDistance2 == maxPickingDistanceFromControlPoint2
+    && this->PickingIndexSliceProjection == sliceProjection)
+    {
+    // up-to-date
+    return;
+    }
+
+  this->PickingIndex.Clear();
+
+  vtkNew<vtkPoints> pointsWorld;
+  markupsNode->GetControlPointPositionsWorld(pointsWorld);
+  int numberOfPoints = static_cast<int>(pointsWorld->GetNumberOfPoints());
 
   double pointDisplayPos[4] = { 0.0, 0.0, 0.0, 1.0 };
   double pointWorldPos[4] = { 0.0, 0.0, 0.0, 1.0 };
 
   vtkNew<vtkMatrix4x4> rasToxyMatrix;
-  sliceNode->GetXYToRAS()->Invert(sliceNode->GetXYToRAS(), rasToxyMatrix.GetPointer());
+  vtkMatrix4x4::Invert(sliceNode->GetXYToRAS(), rasToxyMatrix);
   for (int i = 0; i < numberOfPoints; i++)
     {
     if (!this->GetNthControlPointViewVisibility(i))
       {
       continue;
       }
-    markupsNode->GetNthControlPointPositionWorld(i, pointWorldPos);
+    pointsWorld->GetPoint(i, pointWorldPos);
     rasToxyMatrix->MultiplyPoint(pointWorldPos, pointDisplayPos);
-    if (this->MarkupsDisplayNode->GetSliceProjection())
+    if (sliceProjection)
       {
-      pointDisplayPos[2] = displayPosition3[2];
-      }
-    double dist2 = vtkMath::Distance2BetweenPoints(pointDisplayPos, displayPosition3);
-    if (dist2 < maxPickingDistanceFromControlPoint2 && dist2 < closestDistance2)
-      {
-      closestDistance2 = dist2;
-      foundComponentType = vtkMRMLMarkupsDisplayNode::ComponentControlPoint;
-      foundComponentIndex = i;
+      // display position z is always 0
+      pointDisplayPos[2] = 0.0;
       }
+    this->PickingIndex.AddPoint(i, pointDisplayPos, maxPickingDistanceFromControlPoint2);
     }
+  this->PickingIndex.Build();
+
+  this->PickingIndexMaximumDistance2 = maxPickingDistanceFromControlPoint2;
+  this->PickingIndexSliceProjection = sliceProjection;
+  this->PickingIndexModified = false;
+  this->PickingIndexBuildTime.Modified();
 }
 
 //----------------------------------------------------------------------
@@ -119,6 +119,14 @@ protected:
   // in pixels.
   double GetMaximumControlPointPickingDistance2();
 
+  /// Rebuild the picking index if control points, their visibility, or the slice view has changed.
+  void UpdateControlPointPickingIndex() override;
+
+  /// Maximum picking distance that was used for building the picking index
+  double PickingIndexMaximumDistance2{0.0};
+  /// Slice projection setting that was used for building the picking index
+  bool PickingIndexSliceProjection{false};
+
   bool GetAllControlPointsVisible() override;
 
   /// Check, if the point is displayable in the current slice geometry
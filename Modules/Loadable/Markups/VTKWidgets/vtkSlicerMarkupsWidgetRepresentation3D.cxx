@@ -27,6 +27,7 @@
 #include "vtkMatrix4x4.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
+#include "vtkPoints.h"
 #include "vtkPointSetToLabelHierarchy.h"
 #include "vtkPolyDataMapper.h"
 #include "vtkProperty.h"
@@ -393,104 +394,141 @@ void vtkSlicerMarkupsWidgetRepresentation3D::CanInteract(
       }
     }
 
+  if (interactionEventData->IsDisplayPositionValid())
+    {
+    // Control point display positions are only computed when the points or the view change
+    this->UpdateControlPointPickingIndex();
+    int closestControlPointIndex = this->PickingIndex.FindClosestPoint(displayPosition3, closestDistance2, this);
+    if (closestControlPointIndex >= 0)
+      {
+      foundComponentType = vtkMRMLMarkupsDisplayNode::ComponentControlPoint;
+      foundComponentIndex = closestControlPointIndex;
+      }
+    return;
+    }
+
+  const double* worldPosition = interactionEventData->GetWorldPosition();
+  double worldTolerance = this->ControlPointSize / 2.0 +
+    this->PickingTolerance / interactionEventData->GetWorldToPhysicalScale();
   vtkIdType numberOfPoints = markupsNode->GetNumberOfControlPoints();
   for (int i = 0; i < numberOfPoints; i++)
     {
-    if (!markupsNode->GetNthControlPointVisibility(i))
+    if (!this->IsControlPointPickable(i))
       {
       continue;
       }
-    double centerPosWorld[4] = { 0.0, 0.0, 0.0, 1.0 };
-    double centerPosDisplay[4] = { 0.0, 0.0, 0.0, 1.0 };
+    double centerPosWorld[3] = { 0.0, 0.0, 0.0 };
     markupsNode->GetNthControlPointPositionWorld(i, centerPosWorld);
-    this->Renderer->SetWorldPoint(centerPosWorld);
-
-    // Check SelectVisiblePoints output to see if the point is occluded or not.
-    // SelectVisiblePoints is very sensitive to when it is executed (it has to check the z buffer after
-    // opaque geometry is rendered but 2D labels are not yet), therefore we do not
-    // update its output but just use the last output generated for the last rendering.
-    bool pointVisible = false;
-    if (this->MarkupsDisplayNode
-      && this->MarkupsDisplayNode->GetOccludedVisibility()
-      && this->MarkupsDisplayNode->GetOccludedOpacity() > 0.0)
+    double dist2 = vtkMath::Distance2BetweenPoints(centerPosWorld, worldPosition);
+    if (dist2 < worldTolerance * worldTolerance && dist2 < closestDistance2)
       {
-      pointVisible = true;
+      closestDistance2 = dist2;
+      foundComponentType = vtkMRMLMarkupsDisplayNode::ComponentControlPoint;
+      foundComponentIndex = i;
       }
-    for (int controlPointType = 0; controlPointType <= Active && !pointVisible; ++controlPointType)
+    }
+}
+
+//----------------------------------------------------------------------
+bool vtkSlicerMarkupsWidgetRepresentation3D::IsControlPointPickable(int n)
+{
+  vtkMRMLMarkupsNode* markupsNode = this->GetMarkupsNode();
+  if (!markupsNode->GetNthControlPointVisibility(n))
+    {
+    return false;
+    }
+  if (this->MarkupsDisplayNode
+    && this->MarkupsDisplayNode->GetOccludedVisibility()
+    && this->MarkupsDisplayNode->GetOccludedOpacity() > 0.0)
+    {
+    return true;
+    }
+
+  // Check SelectVisiblePoints output to see if the point is occluded or not.
+  // SelectVisiblePoints is very sensitive to when it is executed (it has to check the z buffer after
+  // opaque geometry is rendered but 2D labels are not yet), therefore we do not
+  // update its output but just use the last output generated for the last rendering.
+  for (int controlPointType = 0; controlPointType <= Active; ++controlPointType)
+    {
+    if ((controlPointType == Unselected && markupsNode->GetNthControlPointSelected(n))
+      || (controlPointType == Selected && !markupsNode->GetNthControlPointSelected(n)))
       {
-      if ((controlPointType == Unselected && markupsNode->GetNthControlPointSelected(i))
-        || (controlPointType == Selected && !markupsNode->GetNthControlPointSelected(i)))
-        {
-        continue;
-        }
-      ControlPointsPipeline3D* controlPoints = this->GetControlPointsPipeline(controlPointType);
-      vtkPolyData* visiblePointsPoly = controlPoints->SelectVisiblePoints->GetOutput();
-      if (!visiblePointsPoly || !visiblePointsPoly->GetPointData())
-        {
-        continue;
-        }
-      vtkIdTypeArray* visiblePointIndices = vtkIdTypeArray::SafeDownCast(visiblePointsPoly->GetPointData()->GetAbstractArray("controlPointIndices"));
-      if (!visiblePointIndices)
-        {
-        continue;
-        }
-      if (visiblePointIndices->LookupValue(i) >= 0)
-        {
-        // visible
-        pointVisible = true;
-        break;
-        }
+      continue;
       }
-    if (!pointVisible)
+    ControlPointsPipeline3D* controlPoints = this->GetControlPointsPipeline(controlPointType);
+    vtkPolyData* visiblePointsPoly = controlPoints->SelectVisiblePoints->GetOutput();
+    if (!visiblePointsPoly || !visiblePointsPoly->GetPointData())
       {
       continue;
       }
-    if (interactionEventData->IsDisplayPositionValid())
+    vtkIdTypeArray* visiblePointIndices = vtkIdTypeArray::SafeDownCast(visiblePointsPoly->GetPointData()->GetAbstractArray("controlPointIndices"));
+    if (!visiblePointIndices)
       {
-      double pixelTolerance = this->ControlPointSize / 2.0 / this->GetViewScaleFactorAtPosition(centerPosWorld)
-        + this->PickingTolerance * this->ScreenScaleFactor;
-      this->Renderer->SetWorldPoint(centerPosWorld);
-      this->Renderer->WorldToDisplay();
-      this->Renderer->GetDisplayPoint(centerPosDisplay);
-      centerPosDisplay[2] = 0.0;
-      double dist2 = vtkMath::Distance2BetweenPoints(centerPosDisplay, displayPosition3);
-      if (dist2 < pixelTolerance * pixelTolerance && dist2 < closestDistance2)
-        {
-        closestDistance2 = dist2;
-        foundComponentType = vtkMRMLMarkupsDisplayNode::ComponentControlPoint;
-        foundComponentIndex = i;
-        }
+      continue;
       }
-    else
+    if (visiblePointIndices->LookupValue(n) >= 0)
       {
-      const double* worldPosition = interactionEventData->GetWorldPosition();
-      double worldTolerance = this->ControlPointSize / 2.0 +
-        this->PickingTolerance / interactionEventData->GetWorldToPhysicalScale();
-      double dist2 = vtkMath::Distance2BetweenPoints(centerPosWorld, worldPosition);
-      if (dist2 < worldTolerance * worldTolerance && dist2 < closestDistance2)
-        {
-        closestDistance2 = dist2;
-        foundComponentType = vtkMRMLMarkupsDisplayNode::ComponentControlPoint;
-        foundComponentIndex = i;
-        }
+      // visible
+      return true;
       }
     }
+  return false;
+}
 
-  /* This would probably faster for many points:
+//----------------------------------------------------------------------
+void vtkSlicerMarkupsWidgetRepresentation3D::UpdateControlPointPickingIndex()
+{
+  vtkMRMLMarkupsNode* markupsNode = this->GetMarkupsNode();
+  if (!markupsNode || !this->Renderer || !this->Renderer->GetActiveCamera())
+    {
+    this->PickingIndex.Clear();
+    return;
+    }
 
-  this->BuildLocator();
+  // Display positions depend on the camera and the renderer size, picking tolerance depends on
+  // the control point size. Occlusion changes at each rendering, therefore it is not stored
+  // in the index but checked by IsControlPointPickable when a point is found.
+  int* rendererSize = this->Renderer->GetSize();
+  bool modified = this->IsControlPointPickingIndexModified()
+    || this->PickingIndexBuildTime < this->Renderer->GetActiveCamera()->GetMTime()
+    || this->PickingIndexRendererSize[0] != rendererSize[0]
+    || this->PickingIndexRendererSize[1] != rendererSize[1]
+    || this->PickingIndexControlPointSize != this->ControlPointSize;
+  if (!modified)
+    {
+    // up-to-date
+    return;
+    }
 
-  double closestDistance2 = VTK_DOUBLE_MAX;
-  int closestNode = static_cast<int> (this->Locator->FindClosestPointWithinRadius(
-    this->PixelTolerance, displayPos, closestDistance2));
+  this->PickingIndex.Clear();
 
-  if (closestNode != this->GetActiveNode())
+  vtkNew<vtkPoints> pointsWorld;
+  markupsNode->GetControlPointPositionsWorld(pointsWorld);
+  int numberOfPoints = static_cast<int>(pointsWorld->GetNumberOfPoints());
+  for (int i = 0; i < numberOfPoints; i++)
     {
-    this->SetActiveNode(closestNode);
-    this->NeedToRender = 1;
+    if (!markupsNode->GetNthControlPointVisibility(i))
+      {
+      continue;
+      }
+    double centerPosWorld[4] = { 0.0, 0.0, 0.0, 1.0 };
+    double centerPosDisplay[4] = { 0.0, 0.0, 0.0, 1.0 };
+    pointsWorld->GetPoint(i, centerPosWorld);
+    double pixelTolerance = this->ControlPointSize / 2.0 / this->GetViewScaleFactorAtPosition(centerPosWorld)
+      + this->PickingTolerance * this->ScreenScaleFactor;
+    this->Renderer->SetWorldPoint(centerPosWorld);
+    this->Renderer->WorldToDisplay();
+    this->Renderer->GetDisplayPoint(centerPosDisplay);
+    centerPosDisplay[2] = 0.0;
+    this->PickingIndex.AddPoint(i, centerPosDisplay, pixelTolerance * pixelTolerance);
     }
-  return (this->GetActiveNode() >= 0);
-  */
+  this->PickingIndex.Build();
+
+  this->PickingIndexRendererSize[0] = rendererSize[0];
+  this->PickingIndexRendererSize[1] = rendererSize[1];
+  this->PickingIndexControlPointSize = this->ControlPointSize;
+  this->PickingIndexModified = false;
+  this->PickingIndexBuildTime.Modified();
 }
 
 //----------------------------------------------------------------------
@@ -104,6 +104,18 @@ protected:
 
   void UpdateInteractionPipeline() override;
 
+  /// Returns true if the control point is visible and not occluded in the last rendering.
+  bool IsControlPointPickable(int n) override;
+
+  /// Rebuild the picking index if control points, their visibility, or the camera has changed.
+  /// Occlusion is not stored in the index, it is checked when a control point is found.
+  void UpdateControlPointPickingIndex() override;
+
+  /// Renderer size that was used for building the picking index
+  int PickingIndexRendererSize[2]{ 0, 0 };
+  /// Control point size that was used for building the picking index
+  double PickingIndexControlPointSize{0.0};
+
   class ControlPointsPipeline3D : public ControlPointsPipeline
   {
   public:
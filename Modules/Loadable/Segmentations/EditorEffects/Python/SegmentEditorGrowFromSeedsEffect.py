@@ -103,6 +103,7 @@ The effect uses <a href="http://interactivemedical.org/imic2014/CameraReadyPaper
       self.growCutFilter = vtkSlicerSegmentationsModuleLogic.vtkImageGrowCutSegment()
       self.growCutFilter.SetIntensityVolume(self.clippedMasterImageData)
       self.growCutFilter.SetMaskVolume(self.clippedMaskImageData)
+      self.growCutFilter.SetNumberOfThreads(os.cpu_count() or 1)
       maskExtent = self.clippedMaskImageData.GetExtent() if self.clippedMaskImageData else None
       if maskExtent is not None and maskExtent[0] <= maskExtent[1] and maskExtent[2] <= maskExtent[3] and maskExtent[4] <= maskExtent[5]:
         # Mask is used.
@@ -1,5 +1,7 @@
 #include "vtkImageGrowCutSegment.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
@@ -8,6 +10,7 @@
 #include <vtkMath.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkTimerLog.h>
@@ -26,6 +29,189 @@ const int MaskPixelTypeID = VTK_UNSIGNED_CHAR;
 const NodeKeyValueType DIST_INF = std::numeric_limits<NodeKeyValueType>::max();
 const NodeKeyValueType DIST_EPSILON = 1e-3;
 
+// Minimum number of slices processed by a thread. Splitting the volume into thinner slabs would
+// increase the number of updates that need to be propagated between slabs.
+const NodeIndexType MINIMUM_NUMBER_OF_SLICES_PER_SLAB = 8;
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Distance values are non-negative floating-point numbers, therefore their bit patterns
+// can be compared as unsigned integers.
+typedef unsigned int RadixKeyType;
+
+inline RadixKeyType DistanceToRadixKey(NodeKeyValueType distance)
+{
+  RadixKeyType key;
+  memcpy(&key, &distance, sizeof(key));
+  return key;
+}
+
+//----------------------------------------------------------------------------
+/// Monotone priority queue for the Dijkstra algorithm.
+///
+/// Items are sorted into buckets by the highest bit in which their key differs from the
+/// last extracted key. Insertion is O(1), extraction is amortized O(log C), and only the items
+/// on the growing front are stored. Instead of decreasing the key of an item, the item is inserted
+/// again with the smaller key, and the outdated entry is skipped when it is extracted.
+/// Keys of inserted items must not be smaller than the last extracted key.
+class RadixHeap
+{
+public:
+  struct Item
+    {
+    RadixKeyType Key;
+    NodeIndexType Index;
+    };
+
+  RadixHeap()
+    : Size(0)
+    , LastKey(0)
+  {
+  }
+
+  bool IsEmpty() const
+  {
+    return this->Size == 0;
+  }
+
+  void Clear()
+  {
+    for (int i = 0; i < NumberOfBuckets; i++)
+      {
+      this->Buckets[i].clear();
+      }
+    this->Size = 0;
+    this->LastKey = 0;
+  }
+
+  void ReleaseMemory()
+  {
+    for (int i = 0; i < NumberOfBuckets; i++)
+      {
+      std::vector<Item>().swap(this->Buckets[i]);
+      }
+  }
+
+  void Push(RadixKeyType key, NodeIndexType index)
+  {
+    Item item = { key, index };
+    this->Buckets[this->GetBucketIndex(key)].push_back(item);
+    this->Size++;
+  }
+
+  Item Pop()
+  {
+    if (this->Buckets[0].empty())
+      {
+      // Find the first non-empty bucket and redistribute its items using its minimum as the new last key
+      int bucketIndex = 1;
+      while (this->Buckets[bucketIndex].empty())
+        {
+        bucketIndex++;
+        }
+      std::vector<Item>& bucket = this->Buckets[bucketIndex];
+      RadixKeyType minimumKey = bucket[0].Key;
+      for (const Item& item : bucket)
+        {
+        minimumKey = std::min(minimumKey, item.Key);
+        }
+      this->LastKey = minimumKey;
+      for (const Item& item : bucket)
+        {
+        this->Buckets[this->GetBucketIndex(item.Key)].push_back(item);
+        }
+      bucket.clear();
+      }
+    Item item = this->Buckets[0].back();
+    this->Buckets[0].pop_back();
+    this->Size--;
+    if (this->Size == 0)
+      {
+      // All keys are non-negative, therefore any key can be inserted into an empty queue
+      this->LastKey = 0;
+      }
+    return item;
+  }
+
+protected:
+  static const int NumberOfBuckets = sizeof(RadixKeyType) * 8 + 1;
+
+  int GetBucketIndex(RadixKeyType key) const
+  {
+    RadixKeyType differentBits = key ^ this->LastKey;
+#if defined(__GNUC__) || defined(__clang__)
+    return differentBits == 0 ? 0 : static_cast<int>(sizeof(RadixKeyType) * 8) - __builtin_clz(differentBits);
+#else
+    int bucketIndex = 0;
+    while (differentBits)
+      {
+      differentBits >>= 1;
+      bucketIndex++;
+      }
+    return bucketIndex;
+#endif
+  }
+
+  std::vector<Item> Buckets[NumberOfBuckets];
+  vtkIdType Size;
+  RadixKeyType LastKey;
+};
+
+//----------------------------------------------------------------------------
+/// Returns true if a voxel has to be updated with the distance and label of a newly found path.
+///
+/// A path is better if it is shorter, or if it has the same length and a smaller label.
+/// This tie-break makes the result unique: each voxel gets the smallest label among the
+/// labels of the seeds that are closest to it. Therefore, the result does not depend on the
+/// order in which voxels are processed, and the bucket queue engine produces exactly the same
+/// output with any number of threads. Seeds and masked voxels keep their labels.
+/// The Fibonacci heap engine keeps the first path found, therefore its result may differ
+/// only in voxels that are at equal distance from seeds of different labels.
+template<typename LabelPixelType>
+inline bool IsBetterPath(NodeKeyValueType newDistance, LabelPixelType newLabel,
+  NodeKeyValueType currentDistance, LabelPixelType currentLabel,
+  NodeIndexType index, const LabelPixelType* seedLabelVolumePtr, const MaskPixelType* maskLabelVolumePtr)
+{
+  if (newDistance != currentDistance)
+    {
+    return newDistance < currentDistance;
+    }
+  if (newLabel >= currentLabel)
+    {
+    return false;
+    }
+  return seedLabelVolumePtr[index] == 0 && (maskLabelVolumePtr == nullptr || maskLabelVolumePtr[index] == 0);
+}
+
+//----------------------------------------------------------------------------
+/// Label update proposed by a voxel to a neighbor voxel in a different slab
+template<typename LabelPixelType>
+struct SlabUpdate
+{
+  NodeIndexType Index;
+  NodeKeyValueType Distance;
+  LabelPixelType Label;
+};
+
+//----------------------------------------------------------------------------
+/// Part of the volume (range of slices) processed by one thread
+template<typename LabelPixelType>
+struct Slab
+{
+  NodeIndexType BeginIndex;
+  NodeIndexType EndIndex;
+  RadixHeap Heap;
+  /// Updates received from neighbor slabs
+  std::vector< SlabUpdate<LabelPixelType> > IncomingUpdates;
+  /// Updates for the previous and next slab
+  std::vector< SlabUpdate<LabelPixelType> > OutgoingUpdatesPrevious;
+  std::vector< SlabUpdate<LabelPixelType> > OutgoingUpdatesNext;
+};
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 class vtkImageGrowCutSegment::vtkInternal
 {
@@ -35,6 +221,62 @@ public:
 
   void Reset();
 
+  /// Allocate result and distance volumes, and compute neighborhood
+  template<typename LabelPixelType>
+  void InitializeBuffers(vtkImageData *seedLabelVolume, double distancePenalty);
+
+  template<typename IntensityPixelType, typename LabelPixelType>
+  bool InitializationBucketQueue(std::vector< Slab<LabelPixelType> >& slabs,
+    vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume, double distancePenalty);
+
+  template<typename IntensityPixelType, typename LabelPixelType>
+  void DijkstraBasedClassificationBucketQueue(std::vector< Slab<LabelPixelType> >& slabs,
+    vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume);
+
+  /// Grow regions within a slab, starting from the voxels in the slab's heap
+  template<typename IntensityPixelType, typename LabelPixelType>
+  void GrowInSlab(Slab<LabelPixelType>& slab, IntensityPixelType* imSrc,
+    LabelPixelType* seedLabelVolumePtr, MaskPixelType* maskLabelVolumePtr,
+    LabelPixelType* resultLabelVolumePtr, NodeKeyValueType* distanceVolumePtr);
+
+  /// Grow regions in each slab of a range of slabs (used with vtkSMPTools)
+  template<typename IntensityPixelType, typename LabelPixelType>
+  class GrowInSlabsFunctor
+  {
+  public:
+    GrowInSlabsFunctor(vtkInternal* internal, std::vector< Slab<LabelPixelType> >& slabs,
+      IntensityPixelType* imSrc, LabelPixelType* seedLabelVolumePtr, MaskPixelType* maskLabelVolumePtr,
+      LabelPixelType* resultLabelVolumePtr, NodeKeyValueType* distanceVolumePtr)
+      : Internal(internal)
+      , Slabs(slabs)
+      , ImSrc(imSrc)
+      , SeedLabelVolumePtr(seedLabelVolumePtr)
+      , MaskLabelVolumePtr(maskLabelVolumePtr)
+      , ResultLabelVolumePtr(resultLabelVolumePtr)
+      , DistanceVolumePtr(distanceVolumePtr)
+    {
+    }
+
+    void operator()(vtkIdType beginSlab, vtkIdType endSlab) const
+    {
+      for (vtkIdType slabIndex = beginSlab; slabIndex < endSlab; ++slabIndex)
+        {
+        this->Internal->template GrowInSlab<IntensityPixelType, LabelPixelType>(this->Slabs[slabIndex],
+          this->ImSrc, this->SeedLabelVolumePtr, this->MaskLabelVolumePtr,
+          this->ResultLabelVolumePtr, this->DistanceVolumePtr);
+        }
+    }
+
+  protected:
+    vtkInternal* Internal;
+    std::vector< Slab<LabelPixelType> >& Slabs;
+    IntensityPixelType* ImSrc;
+    LabelPixelType* SeedLabelVolumePtr;
+    MaskPixelType* MaskLabelVolumePtr;
+    LabelPixelType* ResultLabelVolumePtr;
+    NodeKeyValueType* DistanceVolumePtr;
+  };
+
   template<typename IntensityPixelType, typename LabelPixelType>
   bool InitializationAHP(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume, double distancePenalty);
 
@@ -43,10 +285,11 @@ public:
 
   template <class SourceVolType>
   bool ExecuteGrowCut(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume,
-    vtkImageData *resultLabelVolume, double distancePenalty);
+    vtkImageData *resultLabelVolume, double distancePenalty, int engine, int numberOfThreads);
 
   template< class SourceVolType, class SeedVolType>
-  bool ExecuteGrowCut2(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume, double distancePenalty);
+  bool ExecuteGrowCut2(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume,
+    double distancePenalty, int engine, int numberOfThreads);
 
   // Stores the shortest distance from known labels to each point
   // If a point is set to DIST_INF then that point will modified, as a shorter distance path will be found.
@@ -106,6 +349,71 @@ void vtkImageGrowCutSegment::vtkInternal::Reset()
   m_ResultLabelVolume->Initialize();
 }
 
+//-----------------------------------------------------------------------------
+template<typename LabelPixelType>
+void vtkImageGrowCutSegment::vtkInternal::InitializeBuffers(vtkImageData *seedLabelVolume, double distancePenalty)
+{
+  NodeIndexType dimXYZ = m_DimX * m_DimY * m_DimZ;
+  m_ResultLabelVolume->SetOrigin(seedLabelVolume->GetOrigin());
+  m_ResultLabelVolume->SetSpacing(seedLabelVolume->GetSpacing());
+  m_ResultLabelVolume->SetExtent(seedLabelVolume->GetExtent());
+  m_ResultLabelVolume->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
+  m_DistanceVolume->SetOrigin(seedLabelVolume->GetOrigin());
+  m_DistanceVolume->SetSpacing(seedLabelVolume->GetSpacing());
+  m_DistanceVolume->SetExtent(seedLabelVolume->GetExtent());
+  m_DistanceVolume->AllocateScalars(NodeKeyValueTypeID, 1);
+
+  // Compute index offset
+  m_DistancePenalty = distancePenalty;
+  m_NeighborIndexOffsets.clear();
+  m_NeighborDistancePenalties.clear();
+  // Neighbors are traversed in the order of m_NeighborIndexOffsets,
+  // therefore one would expect that the offsets should
+  // be as continuous as possible (e.g., x coordinate
+  // should change most quickly), but that resulted in
+  // about 5-6% longer computation time. Therefore,
+  // we put indices in order x1y1z1, x1y1z2, x1y1z3, etc.
+  double* spacing = seedLabelVolume->GetSpacing();
+  for (long ix = -1; ix <= 1; ix++)
+  {
+    for (long iy = -1; iy <= 1; iy++)
+    {
+      for (long iz = -1; iz <= 1; iz++)
+      {
+        if (ix == 0 && iy == 0 && iz == 0)
+          {
+          continue;
+          }
+        m_NeighborIndexOffsets.push_back(ix + long(m_DimX)*(iy + long(m_DimY)*iz));
+        m_NeighborDistancePenalties.push_back(this->m_DistancePenalty * sqrt((spacing[0] * ix) * (spacing[0] * ix)
+          + (spacing[1] * iy) * (spacing[1] * iy) + (spacing[2] * iz) * (spacing[2] * iz)));
+        }
+      }
+    }
+
+  // Determine neighborhood size for computation at each voxel.
+  // The neighborhood size is everywhere the same (size of m_NeighborIndexOffsets)
+  // except at the edges of the volume, where the neighborhood size is 0.
+  m_NumberOfNeighbors.resize(dimXYZ);
+  const unsigned char numberOfNeighbors = static_cast<unsigned char>(m_NeighborIndexOffsets.size());
+  unsigned char* nbSizePtr = &(m_NumberOfNeighbors[0]);
+  for (NodeIndexType z = 0; z < m_DimZ; z++)
+    {
+    bool zEdge = (z == 0 || z == m_DimZ - 1);
+    for (NodeIndexType y = 0; y < m_DimY; y++)
+      {
+      bool yEdge = (y == 0 || y == m_DimY - 1);
+      *(nbSizePtr++) = 0; // x == 0 (there is always padding, so we don't need to check if m_DimX>0)
+      unsigned char nbSize = (zEdge || yEdge) ? 0 : numberOfNeighbors;
+      for (NodeIndexType x = m_DimX-2; x > 0; x--)
+        {
+        *(nbSizePtr++) = nbSize;
+        }
+      *(nbSizePtr++) = 0; // x == m_DimX-1 (there is always padding, so we don'neighborNewDistance need to check if m_DimX>1)
+      }
+    }
+}
+
 //-----------------------------------------------------------------------------
 template<typename IntensityPixelType, typename LabelPixelType>
 bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(
@@ -148,67 +456,10 @@ bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(
 
   if (!m_bSegInitialized)
     {
-    m_ResultLabelVolume->SetOrigin(seedLabelVolume->GetOrigin());
-    m_ResultLabelVolume->SetSpacing(seedLabelVolume->GetSpacing());
-    m_ResultLabelVolume->SetExtent(seedLabelVolume->GetExtent());
-    m_ResultLabelVolume->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
-    m_DistanceVolume->SetOrigin(seedLabelVolume->GetOrigin());
-    m_DistanceVolume->SetSpacing(seedLabelVolume->GetSpacing());
-    m_DistanceVolume->SetExtent(seedLabelVolume->GetExtent());
-    m_DistanceVolume->AllocateScalars(NodeKeyValueTypeID, 1);
+    this->InitializeBuffers<LabelPixelType>(seedLabelVolume, distancePenalty);
     LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
     NodeKeyValueType* distanceVolumePtr = static_cast<NodeKeyValueType*>(m_DistanceVolume->GetScalarPointer());
 
-    // Compute index offset
-    m_DistancePenalty = distancePenalty;
-    m_NeighborIndexOffsets.clear();
-    m_NeighborDistancePenalties.clear();
-    // Neighbors are traversed in the order of m_NeighborIndexOffsets,
-    // therefore one would expect that the offsets should
-    // be as continuous as possible (e.g., x coordinate
-    // should change most quickly), but that resulted in
-    // about 5-6% longer computation time. Therefore,
-    // we put indices in order x1y1z1, x1y1z2, x1y1z3, etc.
-    double* spacing = seedLabelVolume->GetSpacing();
-    for (long ix = -1; ix <= 1; ix++)
-    {
-      for (long iy = -1; iy <= 1; iy++)
-      {
-        for (long iz = -1; iz <= 1; iz++)
-        {
-          if (ix == 0 && iy == 0 && iz == 0)
-            {
-            continue;
-            }
-          m_NeighborIndexOffsets.push_back(ix + long(m_DimX)*(iy + long(m_DimY)*iz));
-          m_NeighborDistancePenalties.push_back(this->m_DistancePenalty * sqrt((spacing[0] * ix) * (spacing[0] * ix)
-            + (spacing[1] * iy) * (spacing[1] * iy) + (spacing[2] * iz) * (spacing[2] * iz)));
-          }
-        }
-      }
-
-    // Determine neighborhood size for computation at each voxel.
-    // The neighborhood size is everywhere the same (size of m_NeighborIndexOffsets)
-    // except at the edges of the volume, where the neighborhood size is 0.
-    m_NumberOfNeighbors.resize(dimXYZ);
-    const unsigned char numberOfNeighbors = static_cast<unsigned char>(m_NeighborIndexOffsets.size());
-    unsigned char* nbSizePtr = &(m_NumberOfNeighbors[0]);
-    for (NodeIndexType z = 0; z < m_DimZ; z++)
-      {
-      bool zEdge = (z == 0 || z == m_DimZ - 1);
-      for (NodeIndexType y = 0; y < m_DimY; y++)
-        {
-        bool yEdge = (y == 0 || y == m_DimY - 1);
-        *(nbSizePtr++) = 0; // x == 0 (there is always padding, so we don't need to check if m_DimX>0)
-        unsigned char nbSize = (zEdge || yEdge) ? 0 : numberOfNeighbors;
-        for (NodeIndexType x = m_DimX-2; x > 0; x--)
-          {
-          *(nbSizePtr++) = nbSize;
-          }
-        *(nbSizePtr++) = 0; // x == m_DimX-1 (there is always padding, so we don'neighborNewDistance need to check if m_DimX>1)
-        }
-      }
-
     if (!maskLabelVolumePtr)
       {
       // no mask
@@ -402,10 +653,205 @@ void vtkImageGrowCutSegment::vtkInternal::DijkstraBasedClassificationAHP(
   m_HeapNodes = nullptr;
 }
 
+//-----------------------------------------------------------------------------
+template<typename IntensityPixelType, typename LabelPixelType>
+bool vtkImageGrowCutSegment::vtkInternal::InitializationBucketQueue(
+    std::vector< Slab<LabelPixelType> >& slabs,
+    vtkImageData *seedLabelVolume,
+    vtkImageData *maskLabelVolume,
+    double distancePenalty)
+{
+  LabelPixelType* seedLabelVolumePtr = static_cast<LabelPixelType*>(seedLabelVolume->GetScalarPointer());
+  MaskPixelType* maskLabelVolumePtr = nullptr;
+  if (maskLabelVolume != nullptr)
+    {
+    maskLabelVolumePtr = static_cast<MaskPixelType*>(maskLabelVolume->GetScalarPointer());
+    }
+
+  if (!m_bSegInitialized)
+    {
+    this->InitializeBuffers<LabelPixelType>(seedLabelVolume, distancePenalty);
+    }
+  LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+  NodeKeyValueType* distanceVolumePtr = static_cast<NodeKeyValueType*>(m_DistanceVolume->GetScalarPointer());
+
+  for (Slab<LabelPixelType>& slab : slabs)
+    {
+    slab.Heap.Clear();
+    slab.IncomingUpdates.clear();
+    slab.OutgoingUpdatesPrevious.clear();
+    slab.OutgoingUpdatesNext.clear();
+    const RadixKeyType seedKey = DistanceToRadixKey(DIST_EPSILON);
+    for (NodeIndexType index = slab.BeginIndex; index < slab.EndIndex; index++)
+      {
+      LabelPixelType seedValue = seedLabelVolumePtr[index];
+      if (!m_bSegInitialized)
+        {
+        if (maskLabelVolumePtr && maskLabelVolumePtr[index] != 0)
+          {
+          // masked region, small distance will prevent overwriting of masked voxels
+          resultLabelVolumePtr[index] = 0;
+          distanceVolumePtr[index] = DIST_EPSILON;
+          continue;
+          }
+        resultLabelVolumePtr[index] = seedValue;
+        if (seedValue == 0)
+          {
+          distanceVolumePtr[index] = DIST_INF;
+          }
+        else
+          {
+          // only seeds are added to the queue, other voxels are added when they are reached
+          distanceVolumePtr[index] = DIST_EPSILON;
+          slab.Heap.Push(seedKey, index);
+          }
+        }
+      else if (seedValue != 0)
+        {
+        // Only grow from new/changed seeds, old seeds have been already propagated
+        if (resultLabelVolumePtr[index] != seedValue // changed seed
+          || distanceVolumePtr[index] > DIST_EPSILON // new seed
+          )
+          {
+          distanceVolumePtr[index] = DIST_EPSILON;
+          resultLabelVolumePtr[index] = seedValue;
+          slab.Heap.Push(seedKey, index);
+          }
+        }
+      }
+    }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+template<typename IntensityPixelType, typename LabelPixelType>
+void vtkImageGrowCutSegment::vtkInternal::GrowInSlab(Slab<LabelPixelType>& slab, IntensityPixelType* imSrc,
+  LabelPixelType* seedLabelVolumePtr, MaskPixelType* maskLabelVolumePtr,
+  LabelPixelType* resultLabelVolumePtr, NodeKeyValueType* distanceVolumePtr)
+{
+  // Apply updates received from neighbor slabs
+  for (const SlabUpdate<LabelPixelType>& update : slab.IncomingUpdates)
+    {
+    if (IsBetterPath(update.Distance, update.Label, distanceVolumePtr[update.Index], resultLabelVolumePtr[update.Index],
+      update.Index, seedLabelVolumePtr, maskLabelVolumePtr))
+      {
+      distanceVolumePtr[update.Index] = update.Distance;
+      resultLabelVolumePtr[update.Index] = update.Label;
+      slab.Heap.Push(DistanceToRadixKey(update.Distance), update.Index);
+      }
+    }
+  slab.IncomingUpdates.clear();
+
+  while (!slab.Heap.IsEmpty())
+    {
+    RadixHeap::Item item = slab.Heap.Pop();
+    NodeIndexType index = item.Index;
+    NodeKeyValueType currentDistance = distanceVolumePtr[index];
+    if (item.Key != DistanceToRadixKey(currentDistance))
+      {
+      // outdated entry, the voxel has been added to the queue again with a smaller distance
+      continue;
+      }
+    LabelPixelType currentLabel = resultLabelVolumePtr[index];
+
+    // Update neighbors
+    NodeKeyValueType pixCenter = imSrc[index];
+    unsigned char nbSize = m_NumberOfNeighbors[index];
+    for (unsigned char i = 0; i < nbSize; i++)
+      {
+      NodeIndexType indexNgbh = index + m_NeighborIndexOffsets[i];
+      NodeKeyValueType neighborNewDistance = fabs(pixCenter - imSrc[indexNgbh]) + currentDistance + m_NeighborDistancePenalties[i];
+      if (indexNgbh < slab.BeginIndex || indexNgbh >= slab.EndIndex)
+        {
+        // neighbor is processed by another thread, send it the update
+        SlabUpdate<LabelPixelType> update = { indexNgbh, neighborNewDistance, currentLabel };
+        if (indexNgbh < slab.BeginIndex)
+          {
+          slab.OutgoingUpdatesPrevious.push_back(update);
+          }
+        else
+          {
+          slab.OutgoingUpdatesNext.push_back(update);
+          }
+        continue;
+        }
+      if (IsBetterPath(neighborNewDistance, currentLabel, distanceVolumePtr[indexNgbh], resultLabelVolumePtr[indexNgbh],
+        indexNgbh, seedLabelVolumePtr, maskLabelVolumePtr))
+        {
+        distanceVolumePtr[indexNgbh] = neighborNewDistance;
+        resultLabelVolumePtr[indexNgbh] = currentLabel;
+        slab.Heap.Push(DistanceToRadixKey(neighborNewDistance), indexNgbh);
+        }
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+template<typename IntensityPixelType, typename LabelPixelType>
+void vtkImageGrowCutSegment::vtkInternal::DijkstraBasedClassificationBucketQueue(
+  std::vector< Slab<LabelPixelType> >& slabs,
+  vtkImageData *intensityVolume,
+  vtkImageData *seedLabelVolume,
+  vtkImageData *maskLabelVolume)
+{
+  LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+  NodeKeyValueType* distanceVolumePtr = static_cast<NodeKeyValueType*>(m_DistanceVolume->GetScalarPointer());
+  IntensityPixelType* imSrc = static_cast<IntensityPixelType*>(intensityVolume->GetScalarPointer());
+  LabelPixelType* seedLabelVolumePtr = static_cast<LabelPixelType*>(seedLabelVolume->GetScalarPointer());
+  MaskPixelType* maskLabelVolumePtr = nullptr;
+  if (maskLabelVolume != nullptr)
+    {
+    maskLabelVolumePtr = static_cast<MaskPixelType*>(maskLabelVolume->GetScalarPointer());
+    }
+
+  if (slabs.size() == 1)
+    {
+    this->GrowInSlab<IntensityPixelType, LabelPixelType>(slabs[0], imSrc, seedLabelVolumePtr, maskLabelVolumePtr,
+      resultLabelVolumePtr, distanceVolumePtr);
+    }
+  else
+    {
+    // Each thread grows regions in its own slab. Updates that reach voxels of neighbor slabs
+    // are collected and passed to the neighbor slab in the next round. Rounds are repeated
+    // until no more updates are exchanged between slabs.
+    GrowInSlabsFunctor<IntensityPixelType, LabelPixelType> growInSlabsFunctor(this, slabs, imSrc,
+      seedLabelVolumePtr, maskLabelVolumePtr, resultLabelVolumePtr, distanceVolumePtr);
+    bool updatesPending = true;
+    while (updatesPending)
+      {
+      // Use grain size of 1 so that each slab can be processed by a different thread
+      vtkSMPTools::For(0, static_cast<vtkIdType>(slabs.size()), 1, growInSlabsFunctor);
+
+      updatesPending = false;
+      for (size_t slabIndex = 0; slabIndex < slabs.size(); slabIndex++)
+        {
+        Slab<LabelPixelType>& slab = slabs[slabIndex];
+        if (slabIndex > 0 && !slab.OutgoingUpdatesPrevious.empty())
+          {
+          std::vector< SlabUpdate<LabelPixelType> >& incomingUpdates = slabs[slabIndex - 1].IncomingUpdates;
+          incomingUpdates.insert(incomingUpdates.end(), slab.OutgoingUpdatesPrevious.begin(), slab.OutgoingUpdatesPrevious.end());
+          updatesPending = true;
+          }
+        if (slabIndex + 1 < slabs.size() && !slab.OutgoingUpdatesNext.empty())
+          {
+          std::vector< SlabUpdate<LabelPixelType> >& incomingUpdates = slabs[slabIndex + 1].IncomingUpdates;
+          incomingUpdates.insert(incomingUpdates.end(), slab.OutgoingUpdatesNext.begin(), slab.OutgoingUpdatesNext.end());
+          updatesPending = true;
+          }
+        slab.OutgoingUpdatesPrevious.clear();
+        slab.OutgoingUpdatesNext.clear();
+        }
+      }
+    }
+
+  m_bSegInitialized = true;
+}
+
 //-----------------------------------------------------------------------------
 template< class IntensityPixelType, class LabelPixelType>
 bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut2(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume,
-  vtkImageData *maskLabelVolume, double distancePenalty)
+  vtkImageData *maskLabelVolume, double distancePenalty, int engine, int numberOfThreads)
 {
   int* imSize = intensityVolume->GetDimensions();
 
@@ -432,19 +878,39 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut2(vtkImageData *intensit
     return false;
     }
 
-  if (!InitializationAHP<IntensityPixelType, LabelPixelType>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty))
+  if (engine == vtkImageGrowCutSegment::EngineFibonacciHeap)
     {
-    return false;
+    if (!InitializationAHP<IntensityPixelType, LabelPixelType>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty))
+      {
+      return false;
+      }
+    DijkstraBasedClassificationAHP<IntensityPixelType, LabelPixelType>(intensityVolume, seedLabelVolume, maskLabelVolume);
+    return true;
+    }
+
+  // Split the volume into slabs along the Z axis, one slab per thread.
+  // Queues are only needed during the computation, therefore slabs are not kept between executions.
+  int numberOfSlabs = std::max(1, std::min(numberOfThreads, static_cast<int>(m_DimZ / MINIMUM_NUMBER_OF_SLICES_PER_SLAB)));
+  std::vector< Slab<LabelPixelType> > slabs(numberOfSlabs);
+  NodeIndexType sliceSize = m_DimX * m_DimY;
+  for (int slabIndex = 0; slabIndex < numberOfSlabs; slabIndex++)
+    {
+    slabs[slabIndex].BeginIndex = sliceSize * (m_DimZ * slabIndex / numberOfSlabs);
+    slabs[slabIndex].EndIndex = sliceSize * (m_DimZ * (slabIndex + 1) / numberOfSlabs);
     }
 
-  DijkstraBasedClassificationAHP<IntensityPixelType, LabelPixelType>(intensityVolume, seedLabelVolume, maskLabelVolume);
+  if (!InitializationBucketQueue<IntensityPixelType, LabelPixelType>(slabs, seedLabelVolume, maskLabelVolume, distancePenalty))
+    {
+    return false;
+    }
+  DijkstraBasedClassificationBucketQueue<IntensityPixelType, LabelPixelType>(slabs, intensityVolume, seedLabelVolume, maskLabelVolume);
   return true;
 }
 
 //----------------------------------------------------------------------------
 template <class SourceVolType>
 bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume,
-  vtkImageData *maskLabelVolume, vtkImageData *resultLabelVolume, double distancePenalty)
+  vtkImageData *maskLabelVolume, vtkImageData *resultLabelVolume, double distancePenalty, int engine, int numberOfThreads)
 {
   int* extent = intensityVolume->GetExtent();
   double* spacing = intensityVolume->GetSpacing();
@@ -520,7 +986,8 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut(vtkImageData *intensity
   bool success = false;
   switch (seedLabelVolume->GetScalarType())
   {
-    vtkTemplateMacro((success = ExecuteGrowCut2<SourceVolType, VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty)));
+    vtkTemplateMacro((success = ExecuteGrowCut2<SourceVolType, VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume,
+      distancePenalty, engine, numberOfThreads)));
   default:
     vtkGenericWarningMacro("vtkOrientedImageDataResample::MergeImage: Unknown ScalarType");
   }
@@ -543,6 +1010,8 @@ vtkImageGrowCutSegment::vtkImageGrowCutSegment()
   this->SetNumberOfInputPorts(3);
   this->SetNumberOfOutputPorts(1);
   this->DistancePenalty = 0.0;
+  this->Engine = EngineBucketQueue;
+  this->NumberOfThreads = 1;
 }
 
 //-----------------------------------------------------------------------------
@@ -576,7 +1045,8 @@ void vtkImageGrowCutSegment::ExecuteDataWithInformation(
 
   switch (intensityVolume->GetScalarType())
     {
-    vtkTemplateMacro(this->Internal->ExecuteGrowCut<VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, resultLabelVolume, this->DistancePenalty));
+    vtkTemplateMacro(this->Internal->ExecuteGrowCut<VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, resultLabelVolume,
+      this->DistancePenalty, this->Engine, this->NumberOfThreads));
     break;
     }
   logger->StopTimer();
@@ -604,9 +1074,51 @@ void vtkImageGrowCutSegment::Reset()
   this->Internal->Reset();
 }
 
+//-----------------------------------------------------------------------------
+void vtkImageGrowCutSegment::SetEngine(int engine)
+{
+  if (engine < 0 || engine >= Engine_Last)
+    {
+    vtkErrorMacro("SetEngine failed: invalid engine " << engine);
+    return;
+    }
+  if (this->Engine == engine)
+    {
+    return;
+    }
+  this->Engine = engine;
+  // cached buffers of the other engine cannot be reused
+  this->Reset();
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+vtkTypeInt64 vtkImageGrowCutSegment::EstimateMemoryUsage(const int dimensions[3], int seedLabelScalarType, int engine/*=EngineBucketQueue*/)
+{
+  vtkTypeInt64 numberOfVoxels = vtkTypeInt64(dimensions[0]) * vtkTypeInt64(dimensions[1]) * vtkTypeInt64(dimensions[2]);
+  vtkTypeInt64 labelSize = 0;
+  switch (seedLabelScalarType)
+    {
+    vtkTemplateMacro(labelSize = sizeof(VTK_TT));
+    default:
+      labelSize = sizeof(double);
+    }
+  // result label, distance, number of neighbors
+  vtkTypeInt64 bytesPerVoxel = labelSize + sizeof(NodeKeyValueType) + sizeof(unsigned char);
+  if (engine == EngineFibonacciHeap)
+    {
+    // a heap node is allocated for each voxel
+    return numberOfVoxels * (bytesPerVoxel + sizeof(FibHeapNode));
+    }
+  // The queue only stores the growing front, assume that it contains at most a quarter of the voxels.
+  return numberOfVoxels * bytesPerVoxel + numberOfVoxels / 4 * sizeof(RadixHeap::Item);
+}
+
 //-----------------------------------------------------------------------------
 void vtkImageGrowCutSegment::PrintSelf(ostream &os, vtkIndent indent)
 {
-  // XXX Implement this function
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "DistancePenalty: " << this->DistancePenalty << "\n";
+  os << indent << "Engine: " << (this->Engine == EngineFibonacciHeap ? "FibonacciHeap" : "BucketQueue") << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
 }
@@ -36,6 +36,35 @@ public:
   vtkGetMacro(DistancePenalty, double);
   vtkSetMacro(DistancePenalty, double);
 
+  enum
+    {
+    /// Dijkstra algorithm using a bucket (radix) priority queue that only stores the growing front.
+    /// Requires less memory and it is faster than the Fibonacci heap. Supports multi-threading.
+    EngineBucketQueue,
+    /// Dijkstra algorithm using a Fibonacci heap that stores a node for each voxel.
+    EngineFibonacciHeap,
+    Engine_Last // must be last
+    };
+
+  /// Algorithm used for computing the shortest distance from the seeds.
+  /// Default is EngineBucketQueue. Changing the engine resets the filter.
+  virtual void SetEngine(int engine);
+  vtkGetMacro(Engine, int);
+  void SetEngineToBucketQueue() { this->SetEngine(EngineBucketQueue); };
+  void SetEngineToFibonacciHeap() { this->SetEngine(EngineFibonacciHeap); };
+
+  /// Number of threads used for growing the regions. The volume is split into slabs
+  /// along the Z axis and regions are grown in the slabs in parallel.
+  /// Only used by EngineBucketQueue. Default is 1.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_INT_MAX);
+  vtkGetMacro(NumberOfThreads, int);
+
+  /// Estimate the memory (in bytes) required for computing segmentation of a volume
+  /// with the given dimensions and seed label volume scalar type.
+  /// For EngineBucketQueue the size of the growing front is estimated, therefore the
+  /// actual memory usage may be higher for very noisy images.
+  static vtkTypeInt64 EstimateMemoryUsage(const int dimensions[3], int seedLabelScalarType, int engine=EngineBucketQueue);
+
 protected:
   vtkImageGrowCutSegment();
   ~vtkImageGrowCutSegment() override;
@@ -52,6 +81,8 @@ private:
   class vtkInternal;
   vtkInternal * Internal;
   double DistancePenalty;
+  int Engine;
+  int NumberOfThreads;
 };
 
 #endif
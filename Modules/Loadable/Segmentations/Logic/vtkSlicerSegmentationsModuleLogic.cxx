@@ -2431,6 +2431,29 @@ void vtkSlicerSegmentationsModuleLogic::SetDefaultSurfaceSmoothingEnabled(bool e
     smoothingFactorStr);
 }
 
+//-----------------------------------------------------------------------------
+bool vtkSlicerSegmentationsModuleLogic::GetDefaultParallelConversionEnabled()
+{
+  vtkMRMLSegmentationNode* defaultSegmentationNode = this->GetDefaultSegmentationNode();
+  if (!defaultSegmentationNode || !defaultSegmentationNode->GetSegmentation())
+    {
+    return false;
+    }
+  return defaultSegmentationNode->GetSegmentation()->GetParallelConversion();
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerSegmentationsModuleLogic::SetDefaultParallelConversionEnabled(bool enabled)
+{
+  vtkMRMLSegmentationNode* defaultSegmentationNode = this->GetDefaultSegmentationNode();
+  if (!defaultSegmentationNode || !defaultSegmentationNode->GetSegmentation())
+    {
+    vtkErrorMacro("vtkSlicerSegmentationsModuleLogic::SetDefaultParallelConversionEnabled failed: invalid default segmentation node");
+    return;
+    }
+  defaultSegmentationNode->GetSegmentation()->SetParallelConversion(enabled);
+}
+
 //-----------------------------------------------------------------------------
 std::string vtkSlicerSegmentationsModuleLogic::GetSafeFileName(std::string originalName)
 {
@@ -377,6 +377,11 @@ public:
   bool GetDefaultSurfaceSmoothingEnabled();
   void SetDefaultSurfaceSmoothingEnabled(bool enabled);
 
+  /// Get/Set default parallel conversion enabled flag for new segmentation nodes.
+  /// \sa vtkSegmentation::SetParallelConversion
+  bool GetDefaultParallelConversionEnabled();
+  void SetDefaultParallelConversionEnabled(bool enabled);
+
   enum SegmentStatus
   {
     NotStarted,
@@ -20,6 +20,7 @@
 
 // MRMLDisplayableManager includes
 #include "vtkMRMLSegmentationsDisplayableManager2D.h"
+#include <vtkMRMLIndexedPlaneCutter.h>
 
 // MRML includes
 #include <vtkMRMLFolderDisplayNode.h>
@@ -38,17 +39,9 @@
 #include "vtkOrientedImageDataResample.h"
 
 // VTK includes
-#include <vtkVersion.h> // must precede reference to VTK_MAJOR_VERSION
 #include <vtkActor2D.h>
 #include <vtkCallbackCommand.h>
 #include <vtkCellArray.h>
-#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
-#include <vtkCompositeDataGeometryFilter.h>
-#include <vtkPlaneCutter.h>
-#else
-#include <vtkCutter.h>
-#endif
-#include <vtkCleanPolyData.h>
 #include <vtkContourTriangulator.h>
 #include <vtkDataSetAttributes.h>
 #include <vtkDoubleArray.h>
@@ -144,34 +137,21 @@ public:
       this->WorldToNodeTransform = vtkSmartPointer<vtkGeneralTransform>::New();
 
       this->SliceIntersectionUpdatedTime = 0;
+      this->LookupTableUpToDate = false;
 
       // Create poly data pipeline
       this->PolyDataOutlineActor = vtkSmartPointer<vtkActor2D>::New();
       this->PolyDataFillActor = vtkSmartPointer<vtkActor2D>::New();
-#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
-      this->Cutter = vtkSmartPointer<vtkPlaneCutter>::New();
-#else
-      this->Cutter = vtkSmartPointer<vtkCutter>::New();
-#endif
+      this->Cutter = vtkSmartPointer<vtkMRMLIndexedPlaneCutter>::New();
       this->ModelWarper = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
       this->Plane = vtkSmartPointer<vtkPlane>::New();
       this->Triangulator = vtkSmartPointer<vtkContourTriangulator>::New();
 
       // Set up poly data outline pipeline
-#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
       this->Cutter->SetInputConnection(this->ModelWarper->GetOutputPort());
       this->Cutter->SetPlane(this->Plane);
-      this->Cutter->BuildTreeOff(); // the cutter crashes for complex geometries if build tree is enabled
-      vtkSmartPointer<vtkTransformPolyDataFilter> polyDataOutlineTransformer = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-      vtkNew<vtkCompositeDataGeometryFilter> geometryFilter; // merge multi-piece output of vtkPlaneCutter
-      geometryFilter->SetInputConnection(this->Cutter->GetOutputPort());
-      polyDataOutlineTransformer->SetInputConnection(geometryFilter->GetOutputPort());
-#else
-      this->Cutter->SetCutFunction(this->Plane);
-      this->Cutter->SetGenerateCutScalars(0);
       vtkSmartPointer<vtkTransformPolyDataFilter> polyDataOutlineTransformer = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
       polyDataOutlineTransformer->SetInputConnection(this->Cutter->GetOutputPort());
-#endif
       polyDataOutlineTransformer->SetTransform(this->WorldToSliceTransform);
       vtkSmartPointer<vtkPolyDataMapper2D> polyDataOutlineMapper = vtkSmartPointer<vtkPolyDataMapper2D>::New();
       polyDataOutlineMapper->SetInputConnection(polyDataOutlineTransformer->GetOutputPort());
@@ -180,14 +160,8 @@ public:
       this->PolyDataOutlineActor->SetVisibility(0);
 
       // Set up poly data fill pipeline
-#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
-      vtkNew<vtkCleanPolyData> pointMerger;
-      pointMerger->PointMergingOn();
-      pointMerger->SetInputConnection(geometryFilter->GetOutputPort());
-      this->Triangulator->SetInputConnection(pointMerger->GetOutputPort());
-#else
+      // (cutter output contains merged points, therefore the contour can be triangulated directly)
       this->Triangulator->SetInputConnection(this->Cutter->GetOutputPort());
-#endif
       vtkSmartPointer<vtkTransformPolyDataFilter> polyDataFillTransformer = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
       polyDataFillTransformer->SetInputConnection(this->Triangulator->GetOutputPort());
       polyDataFillTransformer->SetTransform(this->WorldToSliceTransform);
@@ -256,11 +230,7 @@ public:
     vtkSmartPointer<vtkActor2D> PolyDataFillActor;
     vtkSmartPointer<vtkTransformPolyDataFilter> ModelWarper;
     vtkSmartPointer<vtkPlane> Plane;
-#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
-    vtkSmartPointer<vtkPlaneCutter> Cutter;
-#else
-    vtkSmartPointer<vtkCutter> Cutter;
-#endif
+    vtkSmartPointer<vtkMRMLIndexedPlaneCutter> Cutter; // keeps a cell index of the surface to speed up cutting at different slice positions
     vtkSmartPointer<vtkContourTriangulator> Triangulator;
 
     vtkSmartPointer<vtkActor2D> ImageOutlineActor;
@@ -273,6 +243,7 @@ public:
     vtkSmartPointer<vtkImageThreshold> ImageThreshold;
 
     vtkMTimeType SliceIntersectionUpdatedTime;
+    bool LookupTableUpToDate;
     };
 
   typedef std::map<vtkSmartPointer<vtkDataObject>, Pipeline*> PipelineMapType; // first: representation object; second: display pipeline
@@ -301,7 +272,7 @@ public:
   void UpdateDisplayNode(vtkMRMLSegmentationDisplayNode* displayNode);
   void UpdateAllDisplayNodesForSegment(vtkMRMLSegmentationNode* segmentationNode);
   void UpdateSegmentPipelines(vtkMRMLSegmentationDisplayNode*, PipelineMapType&);
-  void UpdateDisplayNodePipeline(vtkMRMLSegmentationDisplayNode*, PipelineMapType&);
+  void UpdateDisplayNodePipeline(vtkMRMLSegmentationDisplayNode*, PipelineMapType&, bool sliceChangedOnly=false);
   void RemoveDisplayNode(vtkMRMLSegmentationDisplayNode* displayNode);
 
   // Observations
@@ -315,6 +286,7 @@ public:
   bool UseDisplayableNode(vtkMRMLSegmentationNode* node);
   void ClearDisplayableNodes();
   bool IsSegmentVisibleInCurrentSlice(vtkMRMLSegmentationDisplayNode* displayNode, Pipeline* pipeline, const std::string &segmentID);
+  bool AreBoundsVisibleInCurrentSlice(vtkMRMLSegmentationDisplayNode* displayNode, Pipeline* pipeline, double segmentBounds_Segment[6]);
 
 private:
   vtkSmartPointer<vtkMatrix4x4> SliceXYToRAS;
@@ -391,7 +363,7 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateSliceNode()
   PipelinesCacheType::iterator displayNodeIt;
   for (displayNodeIt = this->DisplayPipelines.begin(); displayNodeIt != this->DisplayPipelines.end(); ++displayNodeIt)
     {
-    this->UpdateDisplayNodePipeline(displayNodeIt->first, displayNodeIt->second);
+    this->UpdateDisplayNodePipeline(displayNodeIt->first, displayNodeIt->second, true);
     }
 }
 
@@ -703,7 +675,8 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateSegmentPipelin
 }
 
 //---------------------------------------------------------------------------
-void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePipeline(vtkMRMLSegmentationDisplayNode* displayNode, PipelineMapType &pipelines)
+void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePipeline(vtkMRMLSegmentationDisplayNode* displayNode,
+  PipelineMapType &pipelines, bool sliceChangedOnly/*=false*/)
 {
   // Sets visibility, set pipeline polydata input, update color calculate and set pipeline segments.
   if (!displayNode)
@@ -770,13 +743,33 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
     return;
     }
 
-  // For all pipelines (pipeline per segment)
+  // Group segment IDs by representation object in a single pass.
+  // Segments in a shared labelmap layer have the same representation object,
+  // therefore they are displayed using a single pipeline.
+  std::map<vtkDataObject*, std::vector<std::string> > segmentIdsForDataObject;
+  std::vector<std::string> segmentIDs;
+  segmentation->GetSegmentIDs(segmentIDs);
+  for (const std::string& segmentId : segmentIDs)
+    {
+    vtkSegment* segment = segmentation->GetSegment(segmentId);
+    if (segment)
+      {
+      segmentIdsForDataObject[segment->GetRepresentation(shownRepresenatationName)].push_back(segmentId);
+      }
+    }
+
+  // For all pipelines (pipeline per representation object)
   for (PipelineMapType::iterator pipelineIt=pipelines.begin(); pipelineIt!=pipelines.end(); ++pipelineIt)
     {
     Pipeline* pipeline = pipelineIt->second;
+    if (!sliceChangedOnly)
+      {
+      // Display properties may have changed
+      pipeline->LookupTableUpToDate = false;
+      }
 
     vtkDataObject* dataObject = pipelineIt->first;
-    std::vector<std::string> sharedSegmentIds = segmentation->GetSegmentIDsForDataObject(dataObject, displayNode->GetDisplayRepresentationName2D());
+    const std::vector<std::string>& sharedSegmentIds = segmentIdsForDataObject[dataObject];
 
     // Get representation to display
     vtkPolyData* polyData = vtkPolyData::SafeDownCast(dataObject);
@@ -792,9 +785,28 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
       }
 
     bool pipelineVisiblity = false;
-    for (std::string segmentId : sharedSegmentIds)
+    if (!sharedSegmentIds.empty() && polyData
+      && shownRepresenatationName == vtkSegmentationConverter::GetClosedSurfaceRepresentationName())
+      {
+      // All segments of the pipeline share the same representation object,
+      // so the slice intersection only needs to be checked once.
+      double bounds_Segment[6] = { 0.0, -1.0, 0.0, -1.0, 0.0, -1.0 };
+      polyData->GetBounds(bounds_Segment);
+      pipelineVisiblity = this->AreBoundsVisibleInCurrentSlice(displayNode, pipeline, bounds_Segment);
+      }
+    else if (!sharedSegmentIds.empty() && imageData && (shownRepresenatationName == vtkSegmentationConverter::GetBinaryLabelmapRepresentationName()
+      || shownRepresenatationName == vtkSegmentationConverter::GetFractionalLabelmapRepresentationName()))
       {
-      pipelineVisiblity |= this->IsSegmentVisibleInCurrentSlice(displayNode, pipeline, segmentId);
+      double bounds_Segment[6] = { 0.0, -1.0, 0.0, -1.0, 0.0, -1.0 };
+      imageData->GetBounds(bounds_Segment);
+      pipelineVisiblity = this->AreBoundsVisibleInCurrentSlice(displayNode, pipeline, bounds_Segment);
+      }
+    else
+      {
+      for (const std::string& segmentId : sharedSegmentIds)
+        {
+        pipelineVisiblity |= this->IsSegmentVisibleInCurrentSlice(displayNode, pipeline, segmentId);
+        }
       }
 
     if (!pipelineVisiblity)
@@ -942,113 +954,119 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
         maximumValue = scalarRange->GetValue(1);
         }
 
-      // Set segment color
-      int minLabelmapValue = 0;
-      int maxLabelmapValue = 0;
-
-      for (std::string segmentId : sharedSegmentIds)
-        {
-        vtkSegment* segment = segmentation->GetSegment(segmentId);
-        int labelmapValue = segment->GetLabelValue();
-        minLabelmapValue = std::min(minLabelmapValue, labelmapValue);
-        maxLabelmapValue = std::max(maxLabelmapValue, labelmapValue);
-        }
-
-      if (displayNode->GetDisplayRepresentationName2D() == vtkSegmentationConverter::GetFractionalLabelmapRepresentationName())
+      // Update lookup tables of all segments in the layer in one pass.
+      // Colors do not depend on the slice position, so they are not updated
+      // when only the slice is moved.
+      if (!pipeline->LookupTableUpToDate)
         {
-        pipeline->LookupTableFill->SetNumberOfTableValues(maximumValue - minimumValue + 1);
-        pipeline->LookupTableFill->SetTableRange(minimumValue, maximumValue);
-        }
-      else
-        {
-        int numberOfValues = maxLabelmapValue - minLabelmapValue + 1;
-        pipeline->LookupTableOutline->SetNumberOfTableValues(numberOfValues);
-        pipeline->LookupTableOutline->SetRange(minLabelmapValue, maxLabelmapValue);
-        pipeline->LookupTableOutline->IndexedLookupOff();
-        pipeline->LookupTableOutline->Build();
-
-        pipeline->LookupTableFill->SetNumberOfTableValues(numberOfValues);
-        pipeline->LookupTableFill->SetRange(minLabelmapValue, maxLabelmapValue);
-        pipeline->LookupTableFill->IndexedLookupOff();
-        pipeline->LookupTableFill->Build();
-
-        int index = pipeline->LookupTableOutline->GetIndex(0.0);
-        pipeline->LookupTableOutline->SetTableValue(index, 0, 0, 0, 0);
-        index = pipeline->LookupTableFill->GetIndex(0.0);
-        pipeline->LookupTableFill->SetTableValue(index, 0, 0, 0, 0);
-        }
-
-      for (std::string segmentId : sharedSegmentIds)
-        {
-        vtkSegment* segment = segmentation->GetSegment(segmentId);
-        int labelmapValue = segment->GetLabelValue();
-
-        // Get visibility
-        vtkMRMLSegmentationDisplayNode::SegmentDisplayProperties properties;
-        displayNode->GetSegmentDisplayProperties(segmentId, properties);
+        int minLabelmapValue = 0;
+        int maxLabelmapValue = 0;
 
-        double outlineOpacity = hierarchyOpacity * properties.Opacity2DOutline * displayNode->GetOpacity2DOutline() * genericDisplayNode->GetOpacity();
-        bool segmentOutlineVisible = displayNodeVisible && properties.Visible
-          && properties.Visible2DOutline && displayNode->GetVisibility2DOutline() && (outlineOpacity > 0.0);
-        if (!segmentOutlineVisible)
-          {
-          outlineOpacity = 0.0;
-          }
-
-        double fillOpacity = hierarchyOpacity * properties.Opacity2DFill * displayNode->GetOpacity2DFill() * genericDisplayNode->GetOpacity();
-        bool segmentFillVisible = displayNodeVisible && properties.Visible
-          && properties.Visible2DFill && displayNode->GetVisibility2DFill() && (fillOpacity > 0.0);
-        if (!segmentFillVisible)
+        for (std::string segmentId : sharedSegmentIds)
           {
-          fillOpacity = 0.0;
+          vtkSegment* segment = segmentation->GetSegment(segmentId);
+          int labelmapValue = segment->GetLabelValue();
+          minLabelmapValue = std::min(minLabelmapValue, labelmapValue);
+          maxLabelmapValue = std::max(maxLabelmapValue, labelmapValue);
           }
 
-        // Get displayed color (if no override is defined then use the color from the segment)
-        double color[4] = { vtkSegment::SEGMENT_COLOR_INVALID[0], vtkSegment::SEGMENT_COLOR_INVALID[1], vtkSegment::SEGMENT_COLOR_INVALID[2], 1.0};
-        if (overrideHierarchyDisplayNode)
+        if (displayNode->GetDisplayRepresentationName2D() == vtkSegmentationConverter::GetFractionalLabelmapRepresentationName())
           {
-          overrideHierarchyDisplayNode->GetColor(color);
+          pipeline->LookupTableFill->SetNumberOfTableValues(maximumValue - minimumValue + 1);
+          pipeline->LookupTableFill->SetTableRange(minimumValue, maximumValue);
           }
         else
           {
-          displayNode->GetSegmentColor(segmentId, color);
+          int numberOfValues = maxLabelmapValue - minLabelmapValue + 1;
+          pipeline->LookupTableOutline->SetNumberOfTableValues(numberOfValues);
+          pipeline->LookupTableOutline->SetRange(minLabelmapValue, maxLabelmapValue);
+          pipeline->LookupTableOutline->IndexedLookupOff();
+          pipeline->LookupTableOutline->Build();
+
+          pipeline->LookupTableFill->SetNumberOfTableValues(numberOfValues);
+          pipeline->LookupTableFill->SetRange(minLabelmapValue, maxLabelmapValue);
+          pipeline->LookupTableFill->IndexedLookupOff();
+          pipeline->LookupTableFill->Build();
+
+          int index = pipeline->LookupTableOutline->GetIndex(0.0);
+          pipeline->LookupTableOutline->SetTableValue(index, 0, 0, 0, 0);
+          index = pipeline->LookupTableFill->GetIndex(0.0);
+          pipeline->LookupTableFill->SetTableValue(index, 0, 0, 0, 0);
           }
 
-        if (displayNode->GetDisplayRepresentationName2D() == vtkSegmentationConverter::GetFractionalLabelmapRepresentationName())
+        for (std::string segmentId : sharedSegmentIds)
           {
-          pipeline->LookupTableFill->SetRampToLinear();
-          if (!this->SmoothFractionalLabelMapBorder)
+          vtkSegment* segment = segmentation->GetSegment(segmentId);
+          int labelmapValue = segment->GetLabelValue();
+
+          // Get visibility
+          vtkMRMLSegmentationDisplayNode::SegmentDisplayProperties properties;
+          displayNode->GetSegmentDisplayProperties(segmentId, properties);
+
+          double outlineOpacity = hierarchyOpacity * properties.Opacity2DOutline * displayNode->GetOpacity2DOutline() * genericDisplayNode->GetOpacity();
+          bool segmentOutlineVisible = displayNodeVisible && properties.Visible
+            && properties.Visible2DOutline && displayNode->GetVisibility2DOutline() && (outlineOpacity > 0.0);
+          if (!segmentOutlineVisible)
+            {
+            outlineOpacity = 0.0;
+            }
+
+          double fillOpacity = hierarchyOpacity * properties.Opacity2DFill * displayNode->GetOpacity2DFill() * genericDisplayNode->GetOpacity();
+          bool segmentFillVisible = displayNodeVisible && properties.Visible
+            && properties.Visible2DFill && displayNode->GetVisibility2DFill() && (fillOpacity > 0.0);
+          if (!segmentFillVisible)
             {
-            pipeline->LookupTableFill->SetNumberOfTableValues(2);
+            fillOpacity = 0.0;
+            }
+
+          // Get displayed color (if no override is defined then use the color from the segment)
+          double color[4] = { vtkSegment::SEGMENT_COLOR_INVALID[0], vtkSegment::SEGMENT_COLOR_INVALID[1], vtkSegment::SEGMENT_COLOR_INVALID[2], 1.0};
+          if (overrideHierarchyDisplayNode)
+            {
+            overrideHierarchyDisplayNode->GetColor(color);
             }
           else
             {
-            pipeline->LookupTableFill->SetNumberOfTableValues(maximumValue - minimumValue + 1);
+            displayNode->GetSegmentColor(segmentId, color);
+            }
+
+          if (displayNode->GetDisplayRepresentationName2D() == vtkSegmentationConverter::GetFractionalLabelmapRepresentationName())
+            {
+            pipeline->LookupTableFill->SetRampToLinear();
+            if (!this->SmoothFractionalLabelMapBorder)
+              {
+              pipeline->LookupTableFill->SetNumberOfTableValues(2);
+              }
+            else
+              {
+              pipeline->LookupTableFill->SetNumberOfTableValues(maximumValue - minimumValue + 1);
+              }
+            double hsv[3] = { 0,0,0 };
+            vtkMath::RGBToHSV(color, hsv);
+            pipeline->LookupTableFill->SetHueRange(hsv[0], hsv[0]);
+            pipeline->LookupTableFill->SetSaturationRange(hsv[1], hsv[1]);
+            pipeline->LookupTableFill->SetValueRange(hsv[2], hsv[2]);
+            pipeline->LookupTableFill->SetAlphaRange(0.0,
+              hierarchyOpacity* properties.Opacity2DFill* displayNode->GetOpacity2DFill()* genericDisplayNode->GetOpacity());
+            pipeline->LookupTableFill->SetTableRange(minimumValue, maximumValue);
+            pipeline->LookupTableFill->ForceBuild();
+
+            pipeline->LookupTableOutline->SetTableValue(0,color[0], color[1], color[2], 0.0);
+            pipeline->LookupTableOutline->SetTableValue(1,
+              color[0], color[1], color[2],
+              hierarchyOpacity* properties.Opacity2DOutline* displayNode->GetOpacity2DOutline()* genericDisplayNode->GetOpacity());
+            pipeline->LookupTableOutline->SetNumberOfTableValues(2);
+            pipeline->LookupTableOutline->SetTableRange(0, 1);
+            }
+          else
+            {
+            int index = pipeline->LookupTableFill->GetIndex(labelmapValue);
+            pipeline->LookupTableOutline->SetTableValue(index, color[0], color[1], color[2], outlineOpacity);
+            index = pipeline->LookupTableFill->GetIndex(labelmapValue);
+            pipeline->LookupTableFill->SetTableValue(index, color[0], color[1], color[2], fillOpacity);
             }
-          double hsv[3] = { 0,0,0 };
-          vtkMath::RGBToHSV(color, hsv);
-          pipeline->LookupTableFill->SetHueRange(hsv[0], hsv[0]);
-          pipeline->LookupTableFill->SetSaturationRange(hsv[1], hsv[1]);
-          pipeline->LookupTableFill->SetValueRange(hsv[2], hsv[2]);
-          pipeline->LookupTableFill->SetAlphaRange(0.0,
-            hierarchyOpacity* properties.Opacity2DFill* displayNode->GetOpacity2DFill()* genericDisplayNode->GetOpacity());
-          pipeline->LookupTableFill->SetTableRange(minimumValue, maximumValue);
-          pipeline->LookupTableFill->ForceBuild();
-
-          pipeline->LookupTableOutline->SetTableValue(0,color[0], color[1], color[2], 0.0);
-          pipeline->LookupTableOutline->SetTableValue(1,
-            color[0], color[1], color[2],
-            hierarchyOpacity* properties.Opacity2DOutline* displayNode->GetOpacity2DOutline()* genericDisplayNode->GetOpacity());
-          pipeline->LookupTableOutline->SetNumberOfTableValues(2);
-          pipeline->LookupTableOutline->SetTableRange(0, 1);
-          }
-        else
-          {
-          int index = pipeline->LookupTableFill->GetIndex(labelmapValue);
-          pipeline->LookupTableOutline->SetTableValue(index, color[0], color[1], color[2], outlineOpacity);
-          index = pipeline->LookupTableFill->GetIndex(labelmapValue);
-          pipeline->LookupTableFill->SetTableValue(index, color[0], color[1], color[2], fillOpacity);
           }
+        pipeline->LookupTableUpToDate = true;
         }
       pipeline->Reslice->SetBackgroundLevel(minimumValue);
 
@@ -1258,6 +1276,13 @@ bool vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::IsSegmentVisibleInCu
     segment->GetBounds(segmentBounds_Segment);
     }
 
+  return this->AreBoundsVisibleInCurrentSlice(displayNode, pipeline, segmentBounds_Segment);
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::AreBoundsVisibleInCurrentSlice(
+  vtkMRMLSegmentationDisplayNode* displayNode, Pipeline* pipeline, double segmentBounds_Segment[6])
+{
   vtkSmartPointer<vtkGeneralTransform> segmentationToSliceTransform = vtkSmartPointer<vtkGeneralTransform>::New();
   vtkNew<vtkMatrix4x4> rasToSliceXY;
   vtkMatrix4x4::Invert(this->SliceXYToRAS, rasToSliceXY.GetPointer());
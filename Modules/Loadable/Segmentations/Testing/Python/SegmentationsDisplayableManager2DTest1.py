@@ -0,0 +1,223 @@
+import logging
+import time
+import unittest
+import numpy as np
+import vtk, slicer
+
+'''
+This class tests display of segments stored in a shared labelmap layer in a slice view.
+Segments of a shared layer are resliced and colored by a single pipeline per layer,
+and the lookup tables are only rebuilt when display properties change, not when
+the slice moves. Slice scrolling time is reported as a function of the number of segments.
+'''
+
+class SegmentationsDisplayableManager2DTest1(unittest.TestCase):
+
+  #------------------------------------------------------------------------------
+  def setUp(self):
+    """ Do whatever is needed to reset the state - typically a scene clear will be enough.
+    """
+    slicer.mrmlScene.Clear(0)
+
+  #------------------------------------------------------------------------------
+  def runTest(self):
+    """Run as few or as many tests as needed here.
+    """
+    self.setUp()
+    self.test_SegmentationsDisplayableManager2DTest1()
+
+  #------------------------------------------------------------------------------
+  def test_SegmentationsDisplayableManager2DTest1(self):
+    self.assertIsNotNone( slicer.modules.segmentations )
+
+    self.TestSection_SetupSliceView()
+    for numberOfSegments in [1, 10, 50, 150]:
+      self.TestSection_SliceScroll(numberOfSegments)
+    self.TestSection_UpdateOnlyAffectedPipelines()
+    logging.info('Test finished')
+
+  #------------------------------------------------------------------------------
+  def TestSection_SetupSliceView(self):
+    self.sliceNode = slicer.vtkMRMLSliceNode()
+    self.sliceNode.SetLayoutName('Red')
+    self.sliceNode.SetOrientationToAxial()
+    slicer.mrmlScene.AddNode(self.sliceNode)
+
+    self.sliceWidget = slicer.qMRMLSliceWidget()
+    self.sliceWidget.setMRMLScene(slicer.mrmlScene)
+    self.sliceWidget.setMRMLSliceNode(self.sliceNode)
+    self.sliceWidget.resize(512, 512)
+    self.sliceWidget.show()
+
+    # Make sure the displayable manager class is wrapped, so that its methods are accessible
+    import vtkSlicerSegmentationsModuleMRMLDisplayableManagerPython
+    self.displayableManager = self.sliceWidget.sliceView().displayableManagerByClassName(
+      'vtkMRMLSegmentationsDisplayableManager2D')
+    self.assertIsNotNone(self.displayableManager)
+
+  #------------------------------------------------------------------------------
+  def createSharedLabelmapSegmentation(self, numberOfSegments, firstRow=0):
+    # Segments are boxes arranged in a grid in the axial plane, extending through
+    # all slices, so that all of them are visible in every axial slice.
+    dimensions = [128, 128, 64]
+    self.boxSize = 8
+    self.boxesPerRow = dimensions[0] // self.boxSize
+    voxels = np.zeros([dimensions[2], dimensions[1], dimensions[0]], dtype=np.uint8)
+    for segmentIndex in range(numberOfSegments):
+      i, j = self.getBoxCornerIJ(segmentIndex, firstRow)
+      voxels[:, j:j+self.boxSize-1, i:i+self.boxSize-1] = segmentIndex + 1
+
+    labelmapNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLLabelMapVolumeNode')
+    slicer.util.updateVolumeFromArray(labelmapNode, voxels)
+
+    segmentationNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLSegmentationNode')
+    segmentationNode.CreateDefaultDisplayNodes()
+    slicer.modules.segmentations.logic().ImportLabelmapToSegmentationNode(labelmapNode, segmentationNode)
+    slicer.mrmlScene.RemoveNode(labelmapNode)
+
+    # Distinct, fully opaque fill colors, so that segments can be identified in the rendered image
+    segmentation = segmentationNode.GetSegmentation()
+    for segmentIndex in range(numberOfSegments):
+      segmentation.GetNthSegment(segmentIndex).SetColor(self.getSegmentColor(segmentIndex))
+    displayNode = segmentationNode.GetDisplayNode()
+    displayNode.SetOpacity2DFill(1.0)
+    displayNode.SetVisibility2DOutline(False)
+    return segmentationNode
+
+  #------------------------------------------------------------------------------
+  def getBoxCornerIJ(self, segmentIndex, firstRow=0):
+    return [(segmentIndex % self.boxesPerRow) * self.boxSize, (segmentIndex // self.boxesPerRow + firstRow) * self.boxSize]
+
+  #------------------------------------------------------------------------------
+  def getSegmentColor(self, segmentIndex):
+    return [(40 + segmentIndex * 7) % 256 / 255.0, (200 - segmentIndex) % 256 / 255.0, (90 + segmentIndex * 3) % 256 / 255.0]
+
+  #------------------------------------------------------------------------------
+  def getSegmentationImageActors(self):
+    """Returns visible fill actors of labelmap pipelines and the lookup tables of all labelmap pipelines.
+    Only the segmentations displayable manager uses vtkImageMapper in slice views."""
+    fillActors = []
+    lookupTables = []
+    renderers = self.sliceWidget.sliceView().renderWindow().GetRenderers()
+    for rendererIndex in range(renderers.GetNumberOfItems()):
+      actors = renderers.GetItemAsObject(rendererIndex).GetActors2D()
+      for actorIndex in range(actors.GetNumberOfItems()):
+        actor = actors.GetItemAsObject(actorIndex)
+        mapper = actor.GetMapper()
+        if not mapper or not mapper.IsA('vtkImageMapper'):
+          continue
+        colorMapper = mapper.GetInputAlgorithm()
+        lookupTables.append(colorMapper.GetLookupTable())
+        if actor.GetVisibility() and colorMapper.GetInputAlgorithm().IsA('vtkImageReslice'):
+          fillActors.append(actor)
+    return fillActors, lookupTables
+
+  #------------------------------------------------------------------------------
+  def checkDisplayedSegments(self, segmentationNode, segmentIndices, firstRow=0):
+    sliceView = self.sliceWidget.sliceView()
+    sliceView.forceRender()
+    windowToImage = vtk.vtkWindowToImageFilter()
+    windowToImage.SetInput(sliceView.renderWindow())
+    windowToImage.Update()
+    capturedImage = windowToImage.GetOutput()
+
+    segmentation = segmentationNode.GetSegmentation()
+    rasToXY = vtk.vtkMatrix4x4()
+    vtk.vtkMatrix4x4.Invert(self.sliceNode.GetXYToRAS(), rasToXY)
+    for segmentIndex in segmentIndices:
+      segmentID = segmentation.GetNthSegmentID(segmentIndex)
+      labelmap = segmentation.GetSegment(segmentID).GetRepresentation(
+        slicer.vtkSegmentationConverter.GetBinaryLabelmapRepresentationName())
+      imageToWorld = vtk.vtkMatrix4x4()
+      labelmap.GetImageToWorldMatrix(imageToWorld)
+
+      # Center of the box in the current slice
+      i, j = self.getBoxCornerIJ(segmentIndex, firstRow)
+      centerRas = imageToWorld.MultiplyPoint([i + self.boxSize // 2 - 1, j + self.boxSize // 2 - 1, 0, 1])
+      centerRas = [centerRas[0], centerRas[1], self.sliceNode.GetSliceOffset(), 1.0]
+
+      # Segment is found at the position
+      visibleSegmentIDs = vtk.vtkStringArray()
+      self.displayableManager.GetVisibleSegmentsForPosition(centerRas[:3], segmentationNode.GetDisplayNode(), visibleSegmentIDs)
+      self.assertEqual(visibleSegmentIDs.GetNumberOfValues(), 1)
+      self.assertEqual(visibleSegmentIDs.GetValue(0), segmentID)
+
+      # Segment is displayed with its color
+      centerXY = rasToXY.MultiplyPoint(centerRas)
+      x = int(round(centerXY[0]))
+      y = int(round(centerXY[1]))
+      expectedColor = segmentation.GetSegment(segmentID).GetColor()
+      for component in range(3):
+        displayedValue = capturedImage.GetScalarComponentAsDouble(x, y, 0, component)
+        self.assertAlmostEqual(displayedValue, expectedColor[component] * 255.0, delta=3.0,
+          msg='Segment {0} displayed color component {1} is {2}, expected {3}'.format(
+          segmentID, component, displayedValue, expectedColor[component] * 255.0))
+
+  #------------------------------------------------------------------------------
+  def TestSection_SliceScroll(self, numberOfSegments):
+    segmentationNode = self.createSharedLabelmapSegmentation(numberOfSegments)
+    segmentation = segmentationNode.GetSegmentation()
+    self.assertEqual(segmentation.GetNumberOfSegments(), numberOfSegments)
+    self.assertEqual(segmentation.GetNumberOfLayers(), 1)
+
+    sliceView = self.sliceWidget.sliceView()
+    self.sliceWidget.sliceLogic().FitSliceToAll()
+    bounds = [0.0] * 6
+    segmentationNode.GetRASBounds(bounds)
+    centerSliceOffset = (bounds[4] + bounds[5]) / 2.0
+    self.sliceNode.SetSliceOffset(centerSliceOffset)
+    sliceView.forceRender()
+
+    # All segments of the shared layer are displayed by a single pipeline
+    fillActors, lookupTables = self.getSegmentationImageActors()
+    self.assertEqual(len(fillActors), 1)
+    lookupTableMTimes = [lookupTable.GetMTime() for lookupTable in lookupTables]
+
+    numberOfSlices = 50
+    startTime = time.time()
+    for sliceIndex in range(numberOfSlices):
+      self.sliceNode.SetSliceOffset(centerSliceOffset + sliceIndex - numberOfSlices / 2)
+      sliceView.forceRender()
+    sliceScrollTime = (time.time() - startTime) / numberOfSlices
+
+    logging.info('Number of segments: {0}  Slice scroll time: {1:.2f} ms/slice'.format(
+      numberOfSegments, sliceScrollTime * 1000.0))
+
+    # Moving the slice does not rebuild lookup tables
+    self.assertEqual([lookupTable.GetMTime() for lookupTable in lookupTables], lookupTableMTimes)
+
+    # First, middle, and last segment are displayed correctly after scrolling
+    self.sliceNode.SetSliceOffset(centerSliceOffset + 3)
+    self.checkDisplayedSegments(segmentationNode, sorted(set([0, numberOfSegments // 2, numberOfSegments - 1])))
+
+    slicer.mrmlScene.RemoveNode(segmentationNode)
+
+  #------------------------------------------------------------------------------
+  def TestSection_UpdateOnlyAffectedPipelines(self):
+    # Two segmentations in different rows of the view
+    segmentationNode1 = self.createSharedLabelmapSegmentation(10)
+    self.sliceWidget.sliceLogic().FitSliceToAll()
+    bounds = [0.0] * 6
+    segmentationNode1.GetRASBounds(bounds)
+    self.sliceNode.SetSliceOffset((bounds[4] + bounds[5]) / 2.0)
+    self.sliceWidget.sliceView().forceRender()
+    _, lookupTables1 = self.getSegmentationImageActors()
+
+    segmentationNode2 = self.createSharedLabelmapSegmentation(5, firstRow=4)
+    self.sliceWidget.sliceView().forceRender()
+    fillActors, lookupTables = self.getSegmentationImageActors()
+    self.assertEqual(len(fillActors), 2)
+    lookupTables2 = [lookupTable for lookupTable in lookupTables if lookupTable not in lookupTables1]
+    self.assertEqual(len(lookupTables2), 2)
+    self.checkDisplayedSegments(segmentationNode1, [0, 9])
+    self.checkDisplayedSegments(segmentationNode2, [0, 4], firstRow=4)
+
+    # Changing a segment color only updates the pipeline of the layer that contains the segment
+    lookupTableMTimes1 = [lookupTable.GetMTime() for lookupTable in lookupTables1]
+    segmentationNode2.GetSegmentation().GetNthSegment(4).SetColor(1.0, 1.0, 0.0)
+    self.checkDisplayedSegments(segmentationNode2, [0, 4], firstRow=4)
+    self.checkDisplayedSegments(segmentationNode1, [0, 9])
+    self.assertEqual([lookupTable.GetMTime() for lookupTable in lookupTables1], lookupTableMTimes1)
+
+    slicer.mrmlScene.RemoveNode(segmentationNode1)
+    slicer.mrmlScene.RemoveNode(segmentationNode2)
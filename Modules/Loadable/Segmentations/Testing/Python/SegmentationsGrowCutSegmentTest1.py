@@ -0,0 +1,169 @@
+import logging
+import os
+import time
+import unittest
+import numpy as np
+import vtk, slicer
+from vtk.util import numpy_support
+
+'''
+This class validates the bucket queue grow-cut engine against the Fibonacci heap engine
+on the grow-cut tutorial data set (BaselineVolume) and checks that the bucket queue engine
+gives the same result with any number of threads.
+'''
+
+class SegmentationsGrowCutSegmentTest1(unittest.TestCase):
+
+  #------------------------------------------------------------------------------
+  def setUp(self):
+    """ Do whatever is needed to reset the state - typically a scene clear will be enough.
+    """
+    slicer.mrmlScene.Clear(0)
+
+  #------------------------------------------------------------------------------
+  def runTest(self):
+    """Run as few or as many tests as needed here.
+    """
+    self.setUp()
+    self.test_SegmentationsGrowCutSegmentTest1()
+
+  #------------------------------------------------------------------------------
+  def test_SegmentationsGrowCutSegmentTest1(self):
+    import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+    self.vtkImageGrowCutSegment = vtkSlicerSegmentationsModuleLogic.vtkImageGrowCutSegment
+
+    self.TestSection_TieBreak()
+
+    self.TestSection_LoadData()
+
+    fibonacciLabels = self.computeGrowCut(self.vtkImageGrowCutSegment.EngineFibonacciHeap, 1)
+    bucketLabels = self.computeGrowCut(self.vtkImageGrowCutSegment.EngineBucketQueue, 1)
+    numberOfThreads = max(2, os.cpu_count() or 1)
+    bucketLabelsMultiThreaded = self.computeGrowCut(self.vtkImageGrowCutSegment.EngineBucketQueue, numberOfThreads)
+
+    for fibonacciResult, bucketResult, bucketResultMultiThreaded in zip(fibonacciLabels, bucketLabels, bucketLabelsMultiThreaded):
+      self.assertLabelsAgree(fibonacciResult, bucketResult)
+      self.assertTrue(np.array_equal(bucketResult, bucketResultMultiThreaded))
+
+    self.TestSection_MemoryEstimate()
+    logging.info('Test finished')
+
+  #------------------------------------------------------------------------------
+  def createImageData(self, voxels, scalarType):
+    imageData = vtk.vtkImageData()
+    imageData.SetDimensions(voxels.shape[2], voxels.shape[1], voxels.shape[0])
+    imageData.GetPointData().SetScalars(numpy_support.numpy_to_vtk(voxels.ravel(), deep=True, array_type=scalarType))
+    return imageData
+
+  #------------------------------------------------------------------------------
+  def TestSection_TieBreak(self):
+    # Constant image with two seeds: label 2 at x=1 and label 1 at x=7.
+    # The voxel at x=4 is at the same distance from both seeds, the bucket queue engine must give it the smaller label.
+    # The Fibonacci heap engine keeps the first path found, therefore it is not checked here.
+    intensity = np.zeros([3, 3, 9], dtype=np.int16)
+    seeds = np.zeros(intensity.shape, dtype=np.uint8)
+    seeds[1, 1, 1] = 2
+    seeds[1, 1, 7] = 1
+    intensityImage = self.createImageData(intensity, vtk.VTK_SHORT)
+    seedImage = self.createImageData(seeds, vtk.VTK_UNSIGNED_CHAR)
+    for numberOfThreads in [1, 2]:
+      growCutFilter = self.vtkImageGrowCutSegment()
+      growCutFilter.SetEngine(self.vtkImageGrowCutSegment.EngineBucketQueue)
+      growCutFilter.SetNumberOfThreads(numberOfThreads)
+      growCutFilter.SetDistancePenalty(1.0)
+      growCutFilter.SetIntensityVolume(intensityImage)
+      growCutFilter.SetSeedLabelVolume(seedImage)
+      growCutFilter.Update()
+      labels = numpy_support.vtk_to_numpy(growCutFilter.GetOutput().GetPointData().GetScalars()).reshape(intensity.shape)
+      self.assertEqual(list(labels[1, 1, 1:8]), [2, 2, 2, 1, 1, 1, 1])
+
+  #------------------------------------------------------------------------------
+  def TestSection_LoadData(self):
+    import SampleData
+    volumeNode = SampleData.downloadSample('BaselineVolume')
+    self.intensityImage = volumeNode.GetImageData()
+
+    # Seeds of the grow-cut tutorial (NeurosurgicalPlanningTutorialMarkupsSelfTest),
+    # drawn in the axial slice at S=58.7 with a 4 mm brush.
+    cysticTumorPoints = [[-7.4, 71], [-11, 73], [-12, 85], [-13, 91], [-15, 78]]
+    solidTumorPoints = [[-0.5, 118.5], [-7.4, 116]]
+    backgroundPoints = [[-40, 50], [30, 50], [30, 145], [-40, 145], [-40, 50]]
+
+    self.seedVoxels = np.zeros(slicer.util.arrayFromVolume(volumeNode).shape, dtype=np.uint8)
+    self.paintSeedLine(volumeNode, cysticTumorPoints, 1)
+    self.paintSeedLine(volumeNode, solidTumorPoints, 2)
+    self.paintSeedLine(volumeNode, backgroundPoints, 3)
+    self.assertEqual(len(np.unique(self.seedVoxels)), 4)
+    self.seedImage = self.createImageData(self.seedVoxels, vtk.VTK_UNSIGNED_CHAR)
+
+  #------------------------------------------------------------------------------
+  def paintSeedLine(self, volumeNode, pointsRA, label, sliceOffset=58.7, brushRadius=2.0):
+    rasToIjk = vtk.vtkMatrix4x4()
+    volumeNode.GetRASToIJKMatrix(rasToIjk)
+    spacing = np.array(volumeNode.GetSpacing())
+    brushRadiusIjk = np.ceil(brushRadius / spacing).astype(int)
+    for startPointRA, endPointRA in zip(pointsRA[:-1], pointsRA[1:]):
+      startPoint = np.array([startPointRA[0], startPointRA[1], sliceOffset])
+      endPoint = np.array([endPointRA[0], endPointRA[1], sliceOffset])
+      numberOfSamples = int(np.linalg.norm(endPoint - startPoint) / brushRadius) + 1
+      for t in np.linspace(0.0, 1.0, numberOfSamples + 1):
+        pointIjk = np.array(rasToIjk.MultiplyPoint(list(startPoint + t * (endPoint - startPoint)) + [1.0])[:3])
+        # Paint voxels within the brush radius, searching only in the bounding box of the brush
+        boxMin = np.maximum(np.round(pointIjk).astype(int) - brushRadiusIjk, 0)
+        boxMax = np.minimum(np.round(pointIjk).astype(int) + brushRadiusIjk + 1, self.seedVoxels.shape[::-1])
+        k, j, i = np.mgrid[boxMin[2]:boxMax[2], boxMin[1]:boxMax[1], boxMin[0]:boxMax[0]]
+        insideBrush = ((i - pointIjk[0]) * spacing[0])**2 + ((j - pointIjk[1]) * spacing[1])**2 \
+          + ((k - pointIjk[2]) * spacing[2])**2 <= brushRadius**2
+        self.seedVoxels[k[insideBrush], j[insideBrush], i[insideBrush]] = label
+
+  #------------------------------------------------------------------------------
+  def computeGrowCut(self, engine, numberOfThreads):
+    """Returns the results of the initial computation and of an update after adding seeds."""
+    growCutFilter = self.vtkImageGrowCutSegment()
+    growCutFilter.SetEngine(engine)
+    growCutFilter.SetNumberOfThreads(numberOfThreads)
+    growCutFilter.SetIntensityVolume(self.intensityImage)
+    growCutFilter.SetSeedLabelVolume(self.seedImage)
+
+    startTime = time.time()
+    growCutFilter.Update()
+    initialTime = time.time() - startTime
+    initialLabels = numpy_support.vtk_to_numpy(growCutFilter.GetOutput().GetPointData().GetScalars()).copy()
+
+    # Update after adding background seeds in the first slices (uses cached distance map)
+    seeds = self.seedVoxels.copy()
+    seeds[0:2][seeds[0:2] == 0] = 3
+    growCutFilter.SetSeedLabelVolume(self.createImageData(seeds, vtk.VTK_UNSIGNED_CHAR))
+    startTime = time.time()
+    growCutFilter.Update()
+    updateTime = time.time() - startTime
+    updatedLabels = numpy_support.vtk_to_numpy(growCutFilter.GetOutput().GetPointData().GetScalars()).copy()
+
+    logging.info('Engine: {0}  Number of threads: {1}  Initial computation: {2:.3f} s  Update: {3:.3f} s'.format(
+      'FibonacciHeap' if engine == self.vtkImageGrowCutSegment.EngineFibonacciHeap else 'BucketQueue',
+      numberOfThreads, initialTime, updateTime))
+
+    return [initialLabels, updatedLabels]
+
+  #------------------------------------------------------------------------------
+  def assertLabelsAgree(self, expectedLabels, actualLabels):
+    self.assertEqual(expectedLabels.shape, actualLabels.shape)
+    # Engines may only differ in voxels that are at equal distance from seeds of different labels
+    # (the Fibonacci heap engine keeps the first path found, the bucket queue engine the smallest label).
+    for label in [1, 2, 3]:
+      self.assertGreater(np.count_nonzero(actualLabels == label), 0)
+    numberOfDifferentVoxels = np.count_nonzero(expectedLabels != actualLabels)
+    logging.info('Number of voxels that differ from the Fibonacci heap engine result: {0}'.format(numberOfDifferentVoxels))
+    self.assertLess(numberOfDifferentVoxels, expectedLabels.size * 0.001)
+
+  #------------------------------------------------------------------------------
+  def TestSection_MemoryEstimate(self):
+    dimensions = [256, 256, 256]
+    bucketQueueMemory = self.vtkImageGrowCutSegment.EstimateMemoryUsage(dimensions, vtk.VTK_SHORT,
+      self.vtkImageGrowCutSegment.EngineBucketQueue)
+    fibonacciHeapMemory = self.vtkImageGrowCutSegment.EstimateMemoryUsage(dimensions, vtk.VTK_SHORT,
+      self.vtkImageGrowCutSegment.EngineFibonacciHeap)
+    logging.info('Estimated memory usage for {0}x{1}x{2} volume: BucketQueue: {3:.1f} MB  FibonacciHeap: {4:.1f} MB'.format(
+      dimensions[0], dimensions[1], dimensions[2], bucketQueueMemory / 1.0e6, fibonacciHeapMemory / 1.0e6))
+    self.assertGreater(bucketQueueMemory, 0)
+    self.assertLess(bucketQueueMemory, fibonacciHeapMemory)
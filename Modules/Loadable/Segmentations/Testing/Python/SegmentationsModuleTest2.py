@@ -42,6 +42,7 @@ class SegmentationsModuleTest2(unittest.TestCase):
     self.TestSection_SharedLabelmapMultipleLayerEditing()
     self.TestSection_IslandEffects()
     self.TestSection_MarginEffects()
+    self.TestSection_MarginRestrictedToEffectiveExtent()
     logging.info('Test finished')
 
   #------------------------------------------------------------------------------
@@ -313,6 +314,46 @@ class SegmentationsModuleTest2(unittest.TestCase):
       self.runMarginEffect(segment1, segment2, dataType, self.segmentEditorNode.OverwriteNone)
       self.assertEqual(self.segmentation.GetNumberOfLayers(), 2)
 
+  def TestSection_MarginRestrictedToEffectiveExtent(self):
+    logging.info("Running test on margin computation restricted to effective extent")
+    import vtkITK
+    from vtk.util import numpy_support
+
+    # Image with a small region in the middle and a region that touches the image boundary
+    labelmap = vtk.vtkImageData()
+    labelmap.SetDimensions(60, 50, 40)
+    labelmap.SetSpacing(0.8, 1.0, 2.5)
+    labelmap.AllocateScalars(vtk.VTK_UNSIGNED_CHAR, 1)
+    labelmap.GetPointData().GetScalars().Fill(0)
+    for k in range(15, 22):
+      for j in range(20, 26):
+        for i in range(25, 40):
+          labelmap.SetScalarComponentFromDouble(i, j, k, 0, 1)
+    for k in range(0, 5):
+      for j in range(40, 50):
+        for i in range(0, 8):
+          labelmap.SetScalarComponentFromDouble(i, j, k, 0, 1)
+
+    # (calculate margin in mm, inner margin, outer margin)
+    marginParameters = [(True, float('-inf'), 3.0), (True, -2.0, 0.0), (True, -1.0, 4.0), (False, float('-inf'), 2.0)]
+    for calculateMarginInMM, innerMargin, outerMargin in marginParameters:
+      outputs = []
+      for restrictToEffectiveExtent in [False, True]:
+        margin = vtkITK.vtkITKImageMargin()
+        margin.SetInputData(labelmap)
+        margin.SetCalculateMarginInMM(calculateMarginInMM)
+        if calculateMarginInMM:
+          margin.SetInnerMarginMM(innerMargin)
+          margin.SetOuterMarginMM(outerMargin)
+        else:
+          margin.SetInnerMarginVoxels(innerMargin)
+          margin.SetOuterMarginVoxels(outerMargin)
+        margin.SetRestrictToEffectiveExtent(restrictToEffectiveExtent)
+        margin.Update()
+        outputs.append(numpy_support.vtk_to_numpy(margin.GetOutput().GetPointData().GetScalars()))
+      self.assertTrue(outputs[0].any())
+      self.assertTrue((outputs[0] == outputs[1]).all())
+
   def runMarginEffect(self, segment1, segment2, dataType, overwriteMode):
     logging.info("Running margin effect with data type: {0}, and overwriteMode {1}".format(dataType, overwriteMode))
     marginEffect = slicer.modules.segmenteditor.widgetRepresentation().self().editor.effectByName("Margin")
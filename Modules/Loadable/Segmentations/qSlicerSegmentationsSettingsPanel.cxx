@@ -84,6 +84,7 @@ void qSlicerSegmentationsSettingsPanelPrivate::init()
   // Default values
   this->AutoOpacitiesCheckBox->setChecked(true);
   this->SurfaceSmoothingCheckBox->setChecked(true);
+  this->ParallelConversionCheckBox->setChecked(false);
 
   // Register settings
   q->registerProperty("Segmentations/AutoOpacities", this->AutoOpacitiesCheckBox,
@@ -92,6 +93,9 @@ void qSlicerSegmentationsSettingsPanelPrivate::init()
   q->registerProperty("Segmentations/DefaultSurfaceSmoothing", this->SurfaceSmoothingCheckBox,
                       "checked", SIGNAL(toggled(bool)),
                       "Enable closed surface representation smoothing by default", ctkSettingsPanel::OptionNone);
+  q->registerProperty("Segmentations/ParallelConversion", this->ParallelConversionCheckBox,
+                      "checked", SIGNAL(toggled(bool)),
+                      "Convert segments in parallel in new segmentations", ctkSettingsPanel::OptionNone);
   q->registerProperty("Segmentations/DefaultTerminologyEntry", q,
                       "defaultTerminologyEntry", SIGNAL(defaultTerminologyEntryChanged(QString)),
                       "Defult terminology entry", ctkSettingsPanel::OptionNone);
@@ -107,6 +111,8 @@ void qSlicerSegmentationsSettingsPanelPrivate::init()
                    q, SLOT(setAutoOpacities(bool)));
   QObject::connect(this->SurfaceSmoothingCheckBox, SIGNAL(toggled(bool)),
                    q, SLOT(setDefaultSurfaceSmoothing(bool)));
+  QObject::connect(this->ParallelConversionCheckBox, SIGNAL(toggled(bool)),
+                   q, SLOT(setDefaultParallelConversion(bool)));
   QObject::connect(this->EditDefaultTerminologyEntryPushButton, SIGNAL(clicked()),
                    q, SLOT(onEditDefaultTerminologyEntry()));
 
@@ -160,6 +166,15 @@ void qSlicerSegmentationsSettingsPanel::setDefaultSurfaceSmoothing(bool on)
     }
 }
 
+// --------------------------------------------------------------------------
+void qSlicerSegmentationsSettingsPanel::setDefaultParallelConversion(bool on)
+{
+  if (this->segmentationsLogic())
+    {
+    this->segmentationsLogic()->SetDefaultParallelConversionEnabled(on);
+    }
+}
+
 // --------------------------------------------------------------------------
 QString qSlicerSegmentationsSettingsPanel::defaultTerminologyEntry()
 {
@@ -216,4 +231,5 @@ void qSlicerSegmentationsSettingsPanel::updateDefaultSegmentationNodeFromWidget(
 {
   Q_D(qSlicerSegmentationsSettingsPanel);
   this->setDefaultSurfaceSmoothing(d->SurfaceSmoothingCheckBox->isChecked());
+  this->setDefaultParallelConversion(d->ParallelConversionCheckBox->isChecked());
 }
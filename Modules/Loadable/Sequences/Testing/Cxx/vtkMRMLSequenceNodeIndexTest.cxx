@@ -0,0 +1,178 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include <vtkMRMLScriptedModuleNode.h>
+#include <vtkMRMLSequenceNode.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include "vtkMRMLCoreTestingMacros.h"
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+std::string ToString(double value)
+{
+  std::ostringstream ss;
+  ss << value;
+  return ss.str();
+}
+
+//-----------------------------------------------------------------------------
+int TestNumericIndexUpdates()
+{
+  vtkNew<vtkMRMLSequenceNode> seqNode;
+  seqNode->SetIndexType(vtkMRMLSequenceNode::NumericIndex);
+  vtkNew<vtkMRMLScriptedModuleNode> dataNode;
+
+  // Index values are inserted out of order
+  const double indexValues[] = { 30, 10, 20, 50, 40 };
+  for (double indexValue : indexValues)
+    {
+    CHECK_NOT_NULL(seqNode->SetDataNodeAtValue(dataNode, ToString(indexValue)));
+    }
+  CHECK_INT(seqNode->GetNumberOfDataNodes(), 5);
+  for (int i = 0; i < 5; i++)
+    {
+    CHECK_INT(seqNode->GetItemNumberFromIndexValue(ToString((i + 1) * 10.0)), i);
+    }
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("35"), -1);
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("35", false), 2);
+
+  // Removal shifts item numbers
+  seqNode->RemoveDataNodeAtValue("20");
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("20"), -1);
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("30"), 1);
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("50"), 3);
+
+  // Changing an index value moves the item
+  CHECK_BOOL(seqNode->UpdateIndexValue("10", "45"), true);
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("10"), -1);
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("30"), 0);
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("45"), 2);
+  CHECK_STD_STRING(seqNode->GetNthIndexValue(2), "45");
+
+  // Bulk modification of the index
+  seqNode->ReadIndexValues("node1:1;node2:2;node3:3");
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("3"), 2);
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("45"), -1);
+
+  seqNode->RemoveAllDataNodes();
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("1"), -1);
+
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+int TestTextIndexUpdates()
+{
+  vtkNew<vtkMRMLSequenceNode> seqNode;
+  seqNode->SetIndexType(vtkMRMLSequenceNode::TextIndex);
+  vtkNew<vtkMRMLScriptedModuleNode> dataNode;
+
+  const char* indexValues[] = { "first", "second", "third" };
+  for (const char* indexValue : indexValues)
+    {
+    CHECK_NOT_NULL(seqNode->SetDataNodeAtValue(dataNode, indexValue));
+    }
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("second"), 1);
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("fourth"), -1);
+
+  // Append after lookup
+  CHECK_NOT_NULL(seqNode->SetDataNodeAtValue(dataNode, "fourth"));
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("fourth"), 3);
+
+  // Remove from the middle
+  seqNode->RemoveDataNodeAtValue("first");
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("first"), -1);
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("second"), 0);
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("fourth"), 2);
+
+  // Rename
+  CHECK_BOOL(seqNode->UpdateIndexValue("third", "renamed"), true);
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("third"), -1);
+  CHECK_INT(seqNode->GetItemNumberFromIndexValue("renamed"), 1);
+
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+int TestIndexPerformance()
+{
+  // Time of recording frames in order and seeking to random frames
+  // is expected to grow only slowly with the number of frames.
+  const int numberOfFramesList[] = { 1000, 10000 };
+  const int numberOfSeeks = 10000;
+  vtkNew<vtkMRMLScriptedModuleNode> dataNode;
+  for (int numberOfFrames : numberOfFramesList)
+    {
+    for (int indexType = vtkMRMLSequenceNode::NumericIndex; indexType <= vtkMRMLSequenceNode::TextIndex; indexType++)
+      {
+      vtkNew<vtkMRMLSequenceNode> seqNode;
+      seqNode->SetIndexType(indexType);
+
+      vtkNew<vtkTimerLog> timer;
+      timer->StartTimer();
+      for (int i = 0; i < numberOfFrames; i++)
+        {
+        seqNode->SetDataNodeAtValue(dataNode, ToString(i * 0.1));
+        }
+      timer->StopTimer();
+      double recordTime = timer->GetElapsedTime();
+      CHECK_INT(seqNode->GetNumberOfDataNodes(), numberOfFrames);
+
+      srand(0);
+      timer->StartTimer();
+      for (int i = 0; i < numberOfSeeks; i++)
+        {
+        int itemNumber = rand() % numberOfFrames;
+        if (seqNode->GetItemNumberFromIndexValue(ToString(itemNumber * 0.1)) != itemNumber)
+          {
+          std::cerr << "Seek to item " << itemNumber << " failed" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      timer->StopTimer();
+      double seekTime = timer->GetElapsedTime();
+
+      std::cout << "Index type: " << seqNode->GetIndexTypeAsString()
+                << "  Number of frames: " << numberOfFrames
+                << "  Record: " << recordTime * 1000000.0 / numberOfFrames << " us/frame"
+                << "  Random seek: " << seekTime * 1000000.0 / numberOfSeeks << " us/seek"
+                << std::endl;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkMRMLSequenceNodeIndexTest(int vtkNotUsed(argc), char * vtkNotUsed(argv) [])
+{
+  CHECK_EXIT_SUCCESS(TestNumericIndexUpdates());
+  CHECK_EXIT_SUCCESS(TestTextIndexUpdates());
+  CHECK_EXIT_SUCCESS(TestIndexPerformance());
+  return EXIT_SUCCESS;
+}
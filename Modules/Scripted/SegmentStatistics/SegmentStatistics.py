@@ -450,9 +450,8 @@ class SegmentStatisticsLogic(ScriptedLoadableModuleLogic):
         logging.debug("computeStatistics will not return any results: there are no visible segments")
 
       # update statistics for all segment IDs
-      for segmentIndex in range(visibleSegmentIds.GetNumberOfValues()):
-        segmentID = visibleSegmentIds.GetValue(segmentIndex)
-        self.updateStatisticsForSegment(segmentID)
+      segmentIDs = [visibleSegmentIds.GetValue(segmentIndex) for segmentIndex in range(visibleSegmentIds.GetNumberOfValues())]
+      self.updateStatisticsForSegments(segmentIDs)
     finally:
       if not transformedSegmentationNode is None:
         # We made a copy and hardened the segmentation transform
@@ -464,28 +463,41 @@ class SegmentStatisticsLogic(ScriptedLoadableModuleLogic):
     Update statistical measures for specified segment.
     Note: This will not change or reset measurement results of other segments
     """
-    import vtkSegmentationCorePython as vtkSegmentationCore
+    self.updateStatisticsForSegments([segmentID])
 
+  def updateStatisticsForSegments(self, segmentIDs):
+    """
+    Update statistical measures for specified segments.
+    Plugins compute measurements of all the segments at once, which is faster than
+    updating the segments one by one.
+    Note: This will not change or reset measurement results of other segments
+    """
     segmentationNode = slicer.mrmlScene.GetNodeByID(self.getParameterNode().GetParameter("Segmentation"))
 
-    if not segmentationNode.GetSegmentation().GetSegment(segmentID):
-      logging.debug("updateStatisticsForSegment will not update any results because the segment doesn't exist")
-      return
-
-    segment = segmentationNode.GetSegmentation().GetSegment(segmentID)
+    existingSegmentIDs = []
     statistics = self.getStatistics()
-    if segmentID not in statistics["SegmentIDs"]:
-      statistics["SegmentIDs"].append(segmentID)
-    statistics[segmentID,"Segment"] = segment.GetName()
+    for segmentID in segmentIDs:
+      segment = segmentationNode.GetSegmentation().GetSegment(segmentID)
+      if not segment:
+        logging.debug("updateStatisticsForSegments will not update any results for segment "+segmentID+" because the segment doesn't exist")
+        continue
+      existingSegmentIDs.append(segmentID)
+      if segmentID not in statistics["SegmentIDs"]:
+        statistics["SegmentIDs"].append(segmentID)
+      statistics[segmentID,"Segment"] = segment.GetName()
+    if not existingSegmentIDs:
+      return
 
     # apply all enabled plugins
     for plugin in self.plugins:
       pluginName = plugin.__class__.__name__
       if self.getParameterNode().GetParameter(pluginName+'.enabled')=='True':
-        stats = plugin.computeStatistics(segmentID)
-        for key in stats:
-          statistics[segmentID,pluginName+'.'+key] = stats[key]
-          statistics["MeasurementInfo"][pluginName+'.'+key] = plugin.getMeasurementInfo(key)
+        statisticsForSegments = plugin.computeStatisticsForSegments(existingSegmentIDs)
+        for segmentID in existingSegmentIDs:
+          stats = statisticsForSegments.get(segmentID, {})
+          for key in stats:
+            statistics[segmentID,pluginName+'.'+key] = stats[key]
+            statistics["MeasurementInfo"][pluginName+'.'+key] = plugin.getMeasurementInfo(key)
 
   def getPluginByKey(self, key):
     """Get plugin responsible for obtaining measurement value for given key"""
@@ -704,6 +716,9 @@ class SegmentStatisticsTest(ScriptedLoadableModuleTest):
     self.setUp()
     self.test_SegmentStatisticsPlugins()
 
+    self.setUp()
+    self.test_SegmentStatisticsMultiLabel()
+
   def test_SegmentStatisticsBasic(self):
     """
     This tests some aspects of the label statistics
@@ -926,6 +941,136 @@ class SegmentStatisticsTest(ScriptedLoadableModuleTest):
     self.delayDisplay('test_SegmentStatisticsPlugins passed!')
 
 
+  def computeReferenceStatistics(self, segmentationNode, segmentID, grayscaleNode):
+    """Compute statistics of a single segment by VTK image filters, which were
+    used by segment statistics plugins before single-pass multi-label statistics
+    computation was introduced.
+    """
+    import vtkSegmentationCorePython as vtkSegmentationCore
+
+    referenceGeometry_Reference = vtkSegmentationCore.vtkOrientedImageData()
+    referenceGeometry_Reference.SetExtent(grayscaleNode.GetImageData().GetExtent())
+    ijkToRasMatrix = vtk.vtkMatrix4x4()
+    grayscaleNode.GetIJKToRASMatrix(ijkToRasMatrix)
+    referenceGeometry_Reference.SetGeometryFromImageToWorldMatrix(ijkToRasMatrix)
+
+    segmentLabelmap = vtkSegmentationCore.vtkOrientedImageData()
+    segmentationNode.GetBinaryLabelmapRepresentation(segmentID, segmentLabelmap)
+
+    # Labelmap statistics
+    thresh = vtk.vtkImageThreshold()
+    thresh.SetInputData(segmentLabelmap)
+    thresh.ThresholdByLower(0)
+    thresh.SetInValue(0)
+    thresh.SetOutValue(1)
+    thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
+    thresh.Update()
+    stencil = vtk.vtkImageToImageStencil()
+    stencil.SetInputData(thresh.GetOutput())
+    stencil.ThresholdByUpper(1)
+    stencil.Update()
+    stat = vtk.vtkImageAccumulate()
+    stat.SetInputData(thresh.GetOutput())
+    stat.SetStencilData(stencil.GetOutput())
+    stat.Update()
+    stats = {"LabelmapSegmentStatisticsPlugin.voxel_count": stat.GetVoxelCount()}
+
+    # Scalar volume statistics
+    segmentLabelmap_Reference = vtkSegmentationCore.vtkOrientedImageData()
+    vtkSegmentationCore.vtkOrientedImageDataResample.ResampleOrientedImageToReferenceOrientedImage(
+      segmentLabelmap, referenceGeometry_Reference, segmentLabelmap_Reference, False, False)
+    thresh.SetInputData(segmentLabelmap_Reference)
+    thresh.Update()
+    stencil.Update()
+    stat.SetInputData(grayscaleNode.GetImageData())
+    stat.Update()
+    medians = vtk.vtkImageHistogramStatistics()
+    medians.SetInputData(grayscaleNode.GetImageData())
+    medians.SetStencilData(stencil.GetOutput())
+    medians.Update()
+    stats["ScalarVolumeSegmentStatisticsPlugin.voxel_count"] = stat.GetVoxelCount()
+    stats["ScalarVolumeSegmentStatisticsPlugin.min"] = stat.GetMin()[0]
+    stats["ScalarVolumeSegmentStatisticsPlugin.max"] = stat.GetMax()[0]
+    stats["ScalarVolumeSegmentStatisticsPlugin.mean"] = stat.GetMean()[0]
+    stats["ScalarVolumeSegmentStatisticsPlugin.stdev"] = stat.GetStandardDeviation()[0]
+    stats["ScalarVolumeSegmentStatisticsPlugin.median"] = medians.GetMedian()
+    return stats
+
+  def test_SegmentStatisticsMultiLabel(self):
+    """
+    This tests that statistics computed for all segments in a single pass
+    match statistics computed for each segment separately
+    """
+
+    self.delayDisplay("Starting test_SegmentStatisticsMultiLabel")
+
+    import SampleData
+    import time
+    from SegmentStatistics import SegmentStatisticsLogic
+
+    self.delayDisplay("Load master volume")
+
+    masterVolumeNode = SampleData.downloadSample('MRBrainTumor1')
+
+    self.delayDisplay("Create segmentation containing many spheres")
+
+    segmentationNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLSegmentationNode')
+    segmentationNode.CreateDefaultDisplayNodes()
+    segmentationNode.SetReferenceImageGeometryParameterFromVolumeNode(masterVolumeNode)
+
+    # Overlapping spheres are stored in separate layers
+    for segmentIndex in range(30):
+      sphereSource = vtk.vtkSphereSource()
+      sphereSource.SetRadius(5 + segmentIndex % 7)
+      sphereSource.SetCenter(-40 + (segmentIndex % 6) * 16, 10 + (segmentIndex // 6) * 12, 30 - (segmentIndex % 3) * 10)
+      sphereSource.Update()
+      uniqueSegmentID = segmentationNode.GetSegmentation().GenerateUniqueSegmentID("Test")
+      segmentationNode.AddSegmentFromClosedSurfaceRepresentation(sphereSource.GetOutput(), uniqueSegmentID)
+    segmentationNode.CreateBinaryLabelmapRepresentation()
+
+    self.delayDisplay("Compute statistics")
+
+    segStatLogic = SegmentStatisticsLogic()
+    segStatLogic.getParameterNode().SetParameter("Segmentation", segmentationNode.GetID())
+    segStatLogic.getParameterNode().SetParameter("ScalarVolume", masterVolumeNode.GetID())
+    segStatLogic.getParameterNode().SetParameter("ClosedSurfaceSegmentStatisticsPlugin.enabled", str(False))
+    for percentileKey in ["percentile_5", "percentile_95"]:
+      segStatLogic.getParameterNode().SetParameter("ScalarVolumeSegmentStatisticsPlugin."+percentileKey+".enabled", str(True))
+    startTime = time.time()
+    segStatLogic.computeStatistics()
+    multiLabelTime = time.time() - startTime
+    statistics = segStatLogic.getStatistics()
+
+    self.delayDisplay("Compare to statistics computed for each segment separately")
+
+    startTime = time.time()
+    referenceStatistics = {}
+    for segmentID in statistics["SegmentIDs"]:
+      referenceStatistics[segmentID] = self.computeReferenceStatistics(segmentationNode, segmentID, masterVolumeNode)
+    referenceTime = time.time() - startTime
+    logging.info("Statistics of {0} segments computed in {1:.2f}s (computing each segment separately: {2:.2f}s)".format(
+      len(statistics["SegmentIDs"]), multiLabelTime, referenceTime))
+
+    self.assertEqual(len(statistics["SegmentIDs"]), 30)
+    for segmentID in statistics["SegmentIDs"]:
+      reference = referenceStatistics[segmentID]
+      for key in ["LabelmapSegmentStatisticsPlugin.voxel_count", "ScalarVolumeSegmentStatisticsPlugin.voxel_count",
+          "ScalarVolumeSegmentStatisticsPlugin.min", "ScalarVolumeSegmentStatisticsPlugin.max"]:
+        self.assertEqual(statistics[segmentID, key], reference[key])
+      for key in ["ScalarVolumeSegmentStatisticsPlugin.mean", "ScalarVolumeSegmentStatisticsPlugin.stdev"]:
+        self.assertAlmostEqual(statistics[segmentID, key], reference[key], delta=1e-6 * max(1.0, abs(reference[key])))
+      # Reference median is computed from a histogram, therefore it may differ by up to the bin size
+      self.assertAlmostEqual(statistics[segmentID, "ScalarVolumeSegmentStatisticsPlugin.median"],
+        reference["ScalarVolumeSegmentStatisticsPlugin.median"], delta=1.0)
+      self.assertTrue(statistics[segmentID, "ScalarVolumeSegmentStatisticsPlugin.min"]
+        <= statistics[segmentID, "ScalarVolumeSegmentStatisticsPlugin.percentile_5"]
+        <= statistics[segmentID, "ScalarVolumeSegmentStatisticsPlugin.median"]
+        <= statistics[segmentID, "ScalarVolumeSegmentStatisticsPlugin.percentile_95"]
+        <= statistics[segmentID, "ScalarVolumeSegmentStatisticsPlugin.max"])
+
+    self.delayDisplay('test_SegmentStatisticsMultiLabel passed!')
+
+
 class Slicelet(object):
   """A slicer slicelet is a module widget that comes up in stand alone mode
   implemented as a python class.
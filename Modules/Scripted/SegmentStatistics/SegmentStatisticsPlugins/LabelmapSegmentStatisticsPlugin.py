@@ -42,6 +42,9 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
     #... developer may add extra options to configure other parameters
 
   def computeStatistics(self, segmentID):
+    return self.computeStatisticsForSegments([segmentID]).get(segmentID, {})
+
+  def computeStatisticsForSegments(self, segmentIDs):
     import vtkSegmentationCorePython as vtkSegmentationCore
     requestedKeys = self.getRequestedKeys()
 
@@ -55,339 +58,340 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
     if not containsLabelmapRepresentation:
       return {}
 
-    segmentLabelmap = slicer.vtkOrientedImageData()
-    segmentationNode.GetBinaryLabelmapRepresentation(segmentID, segmentLabelmap)
-    if (not segmentLabelmap
-      or not segmentLabelmap.GetPointData()
-      or not segmentLabelmap.GetPointData().GetScalars()):
-      # No input label data
-      return {}
-
-    # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-    labelValue = 1
-    backgroundValue = 0
-    thresh = vtk.vtkImageThreshold()
-    thresh.SetInputData(segmentLabelmap)
-    thresh.ThresholdByLower(0)
-    thresh.SetInValue(backgroundValue)
-    thresh.SetOutValue(labelValue)
-    thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
-    thresh.Update()
-
-    #  Use binary labelmap as a stencil
-    stencil = vtk.vtkImageToImageStencil()
-    stencil.SetInputData(thresh.GetOutput())
-    stencil.ThresholdByUpper(labelValue)
-    stencil.Update()
-
-    stat = vtk.vtkImageAccumulate()
-    stat.SetInputData(thresh.GetOutput())
-    stat.SetStencilData(stencil.GetOutput())
-    stat.Update()
-
-    # Add data to statistics list
-    cubicMMPerVoxel = reduce(lambda x,y: x*y, segmentLabelmap.GetSpacing())
-    ccPerCubicMM = 0.001
-    stats = {}
-    if "voxel_count" in requestedKeys:
-      stats["voxel_count"] = stat.GetVoxelCount()
-    if "volume_mm3" in requestedKeys:
-      stats["volume_mm3"] = stat.GetVoxelCount() * cubicMMPerVoxel
-    if "volume_cm3" in requestedKeys:
-      stats["volume_cm3"] = stat.GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM
-
     calculateShapeStats = False
     for shapeKey in self.shapeKeys:
       if shapeKey in requestedKeys:
         calculateShapeStats = True
         break
 
-    if calculateShapeStats:
-      directions = vtk.vtkMatrix4x4()
-      segmentLabelmap.GetDirectionMatrix(directions)
-
-      # Remove oriented bounding box from requested keys and replace with individual keys
-      requestedOptions = requestedKeys
-      statFilterOptions = self.shapeKeys
-      calculateOBB = (
-        "obb_diameter_mm" in requestedKeys or
-        "obb_origin_ras" in requestedKeys or
-        "obb_direction_ras_x" in requestedKeys or
-        "obb_direction_ras_y" in requestedKeys or
-        "obb_direction_ras_z" in requestedKeys
-        )
-
-      if calculateOBB:
-        temp = statFilterOptions
-        statFilterOptions = []
-        for option in temp:
-          if not option in self.obbKeys:
-            statFilterOptions.append(option)
-        statFilterOptions.append("oriented_bounding_box")
-
-        temp = requestedOptions
-        requestedOptions = []
-        for option in temp:
-          if not option in self.obbKeys:
-            requestedOptions.append(option)
-        requestedOptions.append("oriented_bounding_box")
-
-      calculatePrincipalAxis = (
-        "principal_axis_x" in requestedKeys or
-        "principal_axis_y" in requestedKeys or
-        "principal_axis_z" in requestedKeys
-        )
-      if calculatePrincipalAxis:
-        temp = statFilterOptions
-        statFilterOptions = []
-        for option in temp:
-          if not option in self.principalAxisKeys:
-            statFilterOptions.append(option)
-        statFilterOptions.append("principal_axes")
-
-        temp = requestedOptions
-        requestedOptions = []
-        for option in temp:
-          if not option in self.principalAxisKeys:
-            requestedOptions.append(option)
-        requestedOptions.append("principal_axes")
-        requestedOptions.append("centroid_ras")
-
-      shapeStat = vtkITK.vtkITKLabelShapeStatistics()
-      shapeStat.SetInputData(thresh.GetOutput())
-      shapeStat.SetDirections(directions)
-      for shapeKey in statFilterOptions:
-        shapeStat.SetComputeShapeStatistic(self.keyToShapeStatisticNames[shapeKey], shapeKey in requestedOptions)
-      shapeStat.Update()
-
-      # If segmentation node is transformed, apply that transform to get RAS coordinates
-      transformSegmentToRas = vtk.vtkGeneralTransform()
-      slicer.vtkMRMLTransformNode.GetTransformBetweenNodes(segmentationNode.GetParentTransformNode(), None, transformSegmentToRas)
-
-      statTable = shapeStat.GetOutput()
-      if "centroid_ras" in requestedKeys:
-        centroidRAS = [0,0,0]
-        centroidTuple = None
-        centroidArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["centroid_ras"])
-        if centroidArray is None:
-          logging.error("Could not calculate centroid_ras!")
-        else:
-          centroidTuple = centroidArray.GetTuple(0)
-        if centroidTuple is not None:
-          transformSegmentToRas.TransformPoint(centroidTuple, centroidRAS)
-          stats["centroid_ras"] = centroidRAS
-
-      if "roundness" in requestedKeys:
-        roundnessTuple = None
-        roundnessArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["roundness"])
-        if roundnessArray is None:
-          logging.error("Could not calculate roundness!")
-        else:
-          roundnessTuple = roundnessArray.GetTuple(0)
-        if roundnessTuple is not None:
-          roundness = roundnessTuple[0]
-          stats["roundness"] = roundness
-
-      if "flatness" in requestedKeys:
-        flatnessTuple = None
-        flatnessArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["flatness"])
-        if flatnessArray is None:
-          logging.error("Could not calculate flatness!")
-        else:
-          flatnessTuple = flatnessArray.GetTuple(0)
-        if flatnessTuple is not None:
-          flatness = flatnessTuple[0]
-          stats["flatness"] = flatness
-
-      if "elongation" in requestedKeys:
-        elongationTuple = None
-        elongationArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["elongation"])
-        if elongationArray is None:
-          logging.error("Could not calculate elongation!")
-        else:
-          elongationTuple = elongationArray.GetTuple(0)
-        if elongationTuple is not None:
-          elongation = elongationTuple[0]
-          stats["elongation"] = elongation
-
-      if "feret_diameter_mm" in requestedKeys:
-        feretDiameterTuple = None
-        feretDiameterArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["feret_diameter_mm"])
-        if feretDiameterArray is None:
-          logging.error("Could not calculate feret_diameter_mm!")
-        else:
-          feretDiameterTuple = feretDiameterArray.GetTuple(0)
-        if feretDiameterTuple is not None:
-          feretDiameter = feretDiameterTuple[0]
-          stats["feret_diameter_mm"] = feretDiameter
-
-      if "surface_area_mm2" in requestedKeys:
-        perimeterTuple = None
-        perimeterArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["surface_area_mm2"])
-        if perimeterArray is None:
-          logging.error("Could not calculate surface_area_mm2!")
-        else:
-          perimeterTuple = perimeterArray.GetTuple(0)
-        if perimeterTuple is not None:
-          perimeter = perimeterTuple[0]
-          stats["surface_area_mm2"] = perimeter
-
-      if "obb_origin_ras" in requestedKeys:
-        obbOriginTuple = None
-        obbOriginRAS = [0,0,0]
-        obbOriginArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_origin_ras"])
-        if obbOriginArray is None:
-          logging.error("Could not calculate obb_origin_ras!")
-        else:
-          obbOriginTuple = obbOriginArray.GetTuple(0)
-        if obbOriginTuple is not None:
-          transformSegmentToRas.TransformPoint(obbOriginTuple, obbOriginRAS)
-          stats["obb_origin_ras"] = obbOriginRAS
-
-      if "obb_diameter_mm" in requestedKeys:
-        obbDiameterMMTuple = None
-        obbDiameterArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_diameter_mm"])
-        if obbDiameterArray is None:
-          logging.error("Could not calculate obb_diameter_mm!")
-        else:
-          obbDiameterMMTuple = obbDiameterArray.GetTuple(0)
-        if obbDiameterMMTuple is not None:
-          obbDiameterMM = list(obbDiameterMMTuple)
-          stats["obb_diameter_mm"] = obbDiameterMM
-
-      if "obb_direction_ras_x" in requestedKeys:
-        obbOriginTuple = None
-        obbOriginArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_origin_ras"])
-        if obbOriginArray is None:
-          logging.error("Could not calculate obb_direction_ras_x!")
-        else:
-          obbOriginTuple = obbOriginArray.GetTuple(0)
-
-        obbDirectionXTuple = None
-        obbDirectionXArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_direction_ras_x"])
-        if obbDirectionXArray is None:
-          logging.error("Could not calculate obb_direction_ras_x!")
-        else:
-          obbDirectionXTuple = obbDirectionXArray.GetTuple(0)
-
-        if obbOriginTuple is not None and obbDirectionXTuple is not None:
-          obbDirectionX = list(obbDirectionXTuple)
-          transformSegmentToRas.TransformVectorAtPoint(obbOriginTuple, obbDirectionX, obbDirectionX)
-          stats["obb_direction_ras_x"] = obbDirectionX
-
-      if "obb_direction_ras_y" in requestedKeys:
-        obbOriginTuple = None
-        obbOriginArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_origin_ras"])
-        if obbOriginArray is None:
-          logging.error("Could not calculate obb_direction_ras_y!")
-        else:
-          obbOriginTuple = obbOriginArray.GetTuple(0)
-
-        obbDirectionYTuple = None
-        obbDirectionYArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_direction_ras_y"])
-        if obbDirectionYArray is None:
-          logging.error("Could not calculate obb_direction_ras_y!")
-        else:
-          obbDirectionYTuple = obbDirectionYArray.GetTuple(0)
-
-        if obbOriginTuple is not None and obbDirectionYTuple is not None:
-          obbDirectionY = list(obbDirectionYTuple)
-          transformSegmentToRas.TransformVectorAtPoint(obbOriginTuple, obbDirectionY, obbDirectionY)
-          stats["obb_direction_ras_y"] = obbDirectionY
-
-      if "obb_direction_ras_z" in requestedKeys:
-        obbOriginTuple = None
-        obbOriginArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_origin_ras"])
-        if obbOriginArray is None:
-          logging.error("Could not calculate obb_direction_ras_z!")
-        else:
-          obbOriginTuple = obbOriginArray.GetTuple(0)
-
-        obbDirectionZTuple = None
-        obbDirectionZArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_direction_ras_z"])
-        if obbDirectionZArray is None:
-          logging.error("Could not calculate obb_direction_ras_z!")
-        else:
-          obbDirectionZTuple = obbDirectionZArray.GetTuple(0)
-
-        if obbOriginTuple is not None and obbDirectionZTuple is not None:
-          obbDirectionZ = list(obbDirectionZTuple)
-          transformSegmentToRas.TransformVectorAtPoint(obbOriginTuple, obbDirectionZ, obbDirectionZ)
-          stats["obb_direction_ras_z"] = obbDirectionZ
-
-      if "principal_moments" in requestedKeys:
-        principalMomentsTuple = None
-        principalMomentsArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_moments"])
-        if principalMomentsArray is None:
-          logging.error("Could not calculate principal_moments!")
-        else:    
-          principalMomentsTuple = principalMomentsArray.GetTuple(0)
-        if principalMomentsTuple is not None:
-          principalMoments = list(principalMomentsTuple)
-          stats["principal_moments"] = principalMoments
-
-      if "principal_axis_x" in requestedKeys:
-        centroidRASTuple = None
-        centroidRASArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["centroid_ras"])
-        if centroidRASArray is None:
-          logging.error("Could not calculate principal_axis_x!")
-        else:
-          centroidRASTuple = centroidRASArray.GetTuple(0)
-
-        principalAxisXTuple = None
-        principalAxisXArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_axis_x"])
-        if principalAxisXArray is None:
-          logging.error("Could not calculate principal_axis_x!")
-        else:
-          principalAxisXTuple = principalAxisXArray.GetTuple(0)
-
-        if centroidRASTuple is not None and principalAxisXTuple is not None:
-          principalAxisX = list(principalAxisXTuple)
-          transformSegmentToRas.TransformVectorAtPoint(centroidRASTuple, principalAxisX, principalAxisX)
-          stats["principal_axis_x"] = principalAxisX
-
-      if "principal_axis_y" in requestedKeys:
-        centroidRASTuple = None
-        centroidRASArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["centroid_ras"])
-        if centroidRASArray is None:
-          logging.error("Could not calculate principal_axis_y!")
-        else:
-          centroidRASTuple = centroidRASArray.GetTuple(0)
-
-        principalAxisYTuple = None
-        principalAxisYArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_axis_y"])
-        if principalAxisYArray is None:
-          logging.error("Could not calculate principal_axis_y!")
-        else:
-          principalAxisYTuple = principalAxisYArray.GetTuple(0)
-
-        if centroidRASTuple is not None and principalAxisYTuple is not None:
-          principalAxisY = list(principalAxisYTuple)
-          transformSegmentToRas.TransformVectorAtPoint(centroidRASTuple, principalAxisY, principalAxisY)
-          stats["principal_axis_y"] = principalAxisY
-
-      if "principal_axis_z" in requestedKeys:
-        centroidRASTuple = None
-        centroidRASArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["centroid_ras"])
-        if centroidRASArray is None:
-          logging.error("Could not calculate principal_axis_z!")
-        else:
-          centroidRASTuple = centroidRASArray.GetTuple(0)
-
-        principalAxisZTuple = None
-        principalAxisZArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_axis_z"])
-        if principalAxisZArray is None:
-          logging.error("Could not calculate principal_axis_z!")
-        else:
-          principalAxisZTuple = principalAxisZArray.GetTuple(0)
-
-        if centroidRASTuple is not None and principalAxisZTuple is not None:
-          principalAxisZ = list(principalAxisZTuple)
-          transformSegmentToRas.TransformVectorAtPoint(centroidRASTuple, principalAxisZ, principalAxisZ)
-          stats["principal_axis_z"] = principalAxisZ
-
-
-    return stats
+    # If segmentation node is transformed, apply that transform to get RAS coordinates
+    transformSegmentToRas = vtk.vtkGeneralTransform()
+    slicer.vtkMRMLTransformNode.GetTransformBetweenNodes(segmentationNode.GetParentTransformNode(), None, transformSegmentToRas)
+
+    ccPerCubicMM = 0.001
+    statisticsForSegments = {}
+    for layerLabelmap, layerSegmentIDs in self.getSegmentIDsByLayer(segmentationNode.GetSegmentation(), segmentIDs):
+      if (not layerLabelmap
+        or not layerLabelmap.GetPointData()
+        or not layerLabelmap.GetPointData().GetScalars()):
+        # No input label data
+        continue
+
+      # Statistics of all segments that are stored in the same labelmap are computed in a single pass
+      labelStat = vtkITK.vtkITKLabelIntensityStatistics()
+      labelStat.SetInputData(layerLabelmap)
+      labelStat.Update()
+      voxelCountArray = labelStat.GetOutput().GetColumnByName("VoxelCount")
+      labelStatRowIndices = self.getRowIndicesByLabelValue(labelStat.GetOutput())
+
+      if calculateShapeStats:
+        shapeStatTable = self.computeShapeStatistics(layerLabelmap, requestedKeys)
+        shapeStatRowIndices = self.getRowIndicesByLabelValue(shapeStatTable)
+
+      # Add data to statistics list
+      cubicMMPerVoxel = reduce(lambda x,y: x*y, layerLabelmap.GetSpacing())
+      for segmentID in layerSegmentIDs:
+        labelValue = segmentationNode.GetSegmentation().GetSegment(segmentID).GetLabelValue()
+        voxelCount = 0
+        if labelValue in labelStatRowIndices:
+          voxelCount = int(voxelCountArray.GetValue(labelStatRowIndices[labelValue]))
+        stats = {}
+        if "voxel_count" in requestedKeys:
+          stats["voxel_count"] = voxelCount
+        if "volume_mm3" in requestedKeys:
+          stats["volume_mm3"] = voxelCount * cubicMMPerVoxel
+        if "volume_cm3" in requestedKeys:
+          stats["volume_cm3"] = voxelCount * cubicMMPerVoxel * ccPerCubicMM
+        if calculateShapeStats and labelValue in shapeStatRowIndices:
+          self.addShapeStatistics(shapeStatTable, shapeStatRowIndices[labelValue], requestedKeys, transformSegmentToRas, stats)
+        statisticsForSegments[segmentID] = stats
+
+    return statisticsForSegments
+
+  def computeShapeStatistics(self, labelmap, requestedKeys):
+    """Compute requested shape statistics of all labels of the labelmap"""
+    directions = vtk.vtkMatrix4x4()
+    labelmap.GetDirectionMatrix(directions)
+
+    # Remove oriented bounding box from requested keys and replace with individual keys
+    requestedOptions = requestedKeys
+    statFilterOptions = self.shapeKeys
+    calculateOBB = (
+      "obb_diameter_mm" in requestedKeys or
+      "obb_origin_ras" in requestedKeys or
+      "obb_direction_ras_x" in requestedKeys or
+      "obb_direction_ras_y" in requestedKeys or
+      "obb_direction_ras_z" in requestedKeys
+      )
+
+    if calculateOBB:
+      temp = statFilterOptions
+      statFilterOptions = []
+      for option in temp:
+        if not option in self.obbKeys:
+          statFilterOptions.append(option)
+      statFilterOptions.append("oriented_bounding_box")
+
+      temp = requestedOptions
+      requestedOptions = []
+      for option in temp:
+        if not option in self.obbKeys:
+          requestedOptions.append(option)
+      requestedOptions.append("oriented_bounding_box")
+
+    calculatePrincipalAxis = (
+      "principal_axis_x" in requestedKeys or
+      "principal_axis_y" in requestedKeys or
+      "principal_axis_z" in requestedKeys
+      )
+    if calculatePrincipalAxis:
+      temp = statFilterOptions
+      statFilterOptions = []
+      for option in temp:
+        if not option in self.principalAxisKeys:
+          statFilterOptions.append(option)
+      statFilterOptions.append("principal_axes")
+
+      temp = requestedOptions
+      requestedOptions = []
+      for option in temp:
+        if not option in self.principalAxisKeys:
+          requestedOptions.append(option)
+      requestedOptions.append("principal_axes")
+      requestedOptions.append("centroid_ras")
+
+    shapeStat = vtkITK.vtkITKLabelShapeStatistics()
+    shapeStat.SetInputData(labelmap)
+    shapeStat.SetDirections(directions)
+    for shapeKey in statFilterOptions:
+      shapeStat.SetComputeShapeStatistic(self.keyToShapeStatisticNames[shapeKey], shapeKey in requestedOptions)
+    shapeStat.Update()
+
+    return shapeStat.GetOutput()
+
+  def addShapeStatistics(self, statTable, rowIndex, requestedKeys, transformSegmentToRas, stats):
+    """Add shape statistics of a label to the statistics dictionary, from the specified row of the shape statistics table"""
+    if "centroid_ras" in requestedKeys:
+      centroidRAS = [0,0,0]
+      centroidTuple = None
+      centroidArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["centroid_ras"])
+      if centroidArray is None:
+        logging.error("Could not calculate centroid_ras!")
+      else:
+        centroidTuple = centroidArray.GetTuple(rowIndex)
+      if centroidTuple is not None:
+        transformSegmentToRas.TransformPoint(centroidTuple, centroidRAS)
+        stats["centroid_ras"] = centroidRAS
+
+    if "roundness" in requestedKeys:
+      roundnessTuple = None
+      roundnessArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["roundness"])
+      if roundnessArray is None:
+        logging.error("Could not calculate roundness!")
+      else:
+        roundnessTuple = roundnessArray.GetTuple(rowIndex)
+      if roundnessTuple is not None:
+        roundness = roundnessTuple[0]
+        stats["roundness"] = roundness
+
+    if "flatness" in requestedKeys:
+      flatnessTuple = None
+      flatnessArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["flatness"])
+      if flatnessArray is None:
+        logging.error("Could not calculate flatness!")
+      else:
+        flatnessTuple = flatnessArray.GetTuple(rowIndex)
+      if flatnessTuple is not None:
+        flatness = flatnessTuple[0]
+        stats["flatness"] = flatness
+
+    if "elongation" in requestedKeys:
+      elongationTuple = None
+      elongationArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["elongation"])
+      if elongationArray is None:
+        logging.error("Could not calculate elongation!")
+      else:
+        elongationTuple = elongationArray.GetTuple(rowIndex)
+      if elongationTuple is not None:
+        elongation = elongationTuple[0]
+        stats["elongation"] = elongation
+
+    if "feret_diameter_mm" in requestedKeys:
+      feretDiameterTuple = None
+      feretDiameterArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["feret_diameter_mm"])
+      if feretDiameterArray is None:
+        logging.error("Could not calculate feret_diameter_mm!")
+      else:
+        feretDiameterTuple = feretDiameterArray.GetTuple(rowIndex)
+      if feretDiameterTuple is not None:
+        feretDiameter = feretDiameterTuple[0]
+        stats["feret_diameter_mm"] = feretDiameter
+
+    if "surface_area_mm2" in requestedKeys:
+      perimeterTuple = None
+      perimeterArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["surface_area_mm2"])
+      if perimeterArray is None:
+        logging.error("Could not calculate surface_area_mm2!")
+      else:
+        perimeterTuple = perimeterArray.GetTuple(rowIndex)
+      if perimeterTuple is not None:
+        perimeter = perimeterTuple[0]
+        stats["surface_area_mm2"] = perimeter
+
+    if "obb_origin_ras" in requestedKeys:
+      obbOriginTuple = None
+      obbOriginRAS = [0,0,0]
+      obbOriginArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_origin_ras"])
+      if obbOriginArray is None:
+        logging.error("Could not calculate obb_origin_ras!")
+      else:
+        obbOriginTuple = obbOriginArray.GetTuple(rowIndex)
+      if obbOriginTuple is not None:
+        transformSegmentToRas.TransformPoint(obbOriginTuple, obbOriginRAS)
+        stats["obb_origin_ras"] = obbOriginRAS
+
+    if "obb_diameter_mm" in requestedKeys:
+      obbDiameterMMTuple = None
+      obbDiameterArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_diameter_mm"])
+      if obbDiameterArray is None:
+        logging.error("Could not calculate obb_diameter_mm!")
+      else:
+        obbDiameterMMTuple = obbDiameterArray.GetTuple(rowIndex)
+      if obbDiameterMMTuple is not None:
+        obbDiameterMM = list(obbDiameterMMTuple)
+        stats["obb_diameter_mm"] = obbDiameterMM
+
+    if "obb_direction_ras_x" in requestedKeys:
+      obbOriginTuple = None
+      obbOriginArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_origin_ras"])
+      if obbOriginArray is None:
+        logging.error("Could not calculate obb_direction_ras_x!")
+      else:
+        obbOriginTuple = obbOriginArray.GetTuple(rowIndex)
+
+      obbDirectionXTuple = None
+      obbDirectionXArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_direction_ras_x"])
+      if obbDirectionXArray is None:
+        logging.error("Could not calculate obb_direction_ras_x!")
+      else:
+        obbDirectionXTuple = obbDirectionXArray.GetTuple(rowIndex)
+
+      if obbOriginTuple is not None and obbDirectionXTuple is not None:
+        obbDirectionX = list(obbDirectionXTuple)
+        transformSegmentToRas.TransformVectorAtPoint(obbOriginTuple, obbDirectionX, obbDirectionX)
+        stats["obb_direction_ras_x"] = obbDirectionX
+
+    if "obb_direction_ras_y" in requestedKeys:
+      obbOriginTuple = None
+      obbOriginArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_origin_ras"])
+      if obbOriginArray is None:
+        logging.error("Could not calculate obb_direction_ras_y!")
+      else:
+        obbOriginTuple = obbOriginArray.GetTuple(rowIndex)
+
+      obbDirectionYTuple = None
+      obbDirectionYArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_direction_ras_y"])
+      if obbDirectionYArray is None:
+        logging.error("Could not calculate obb_direction_ras_y!")
+      else:
+        obbDirectionYTuple = obbDirectionYArray.GetTuple(rowIndex)
+
+      if obbOriginTuple is not None and obbDirectionYTuple is not None:
+        obbDirectionY = list(obbDirectionYTuple)
+        transformSegmentToRas.TransformVectorAtPoint(obbOriginTuple, obbDirectionY, obbDirectionY)
+        stats["obb_direction_ras_y"] = obbDirectionY
+
+    if "obb_direction_ras_z" in requestedKeys:
+      obbOriginTuple = None
+      obbOriginArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_origin_ras"])
+      if obbOriginArray is None:
+        logging.error("Could not calculate obb_direction_ras_z!")
+      else:
+        obbOriginTuple = obbOriginArray.GetTuple(rowIndex)
+
+      obbDirectionZTuple = None
+      obbDirectionZArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_direction_ras_z"])
+      if obbDirectionZArray is None:
+        logging.error("Could not calculate obb_direction_ras_z!")
+      else:
+        obbDirectionZTuple = obbDirectionZArray.GetTuple(rowIndex)
+
+      if obbOriginTuple is not None and obbDirectionZTuple is not None:
+        obbDirectionZ = list(obbDirectionZTuple)
+        transformSegmentToRas.TransformVectorAtPoint(obbOriginTuple, obbDirectionZ, obbDirectionZ)
+        stats["obb_direction_ras_z"] = obbDirectionZ
+
+    if "principal_moments" in requestedKeys:
+      principalMomentsTuple = None
+      principalMomentsArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_moments"])
+      if principalMomentsArray is None:
+        logging.error("Could not calculate principal_moments!")
+      else:    
+        principalMomentsTuple = principalMomentsArray.GetTuple(rowIndex)
+      if principalMomentsTuple is not None:
+        principalMoments = list(principalMomentsTuple)
+        stats["principal_moments"] = principalMoments
+
+    if "principal_axis_x" in requestedKeys:
+      centroidRASTuple = None
+      centroidRASArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["centroid_ras"])
+      if centroidRASArray is None:
+        logging.error("Could not calculate principal_axis_x!")
+      else:
+        centroidRASTuple = centroidRASArray.GetTuple(rowIndex)
+
+      principalAxisXTuple = None
+      principalAxisXArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_axis_x"])
+      if principalAxisXArray is None:
+        logging.error("Could not calculate principal_axis_x!")
+      else:
+        principalAxisXTuple = principalAxisXArray.GetTuple(rowIndex)
+
+      if centroidRASTuple is not None and principalAxisXTuple is not None:
+        principalAxisX = list(principalAxisXTuple)
+        transformSegmentToRas.TransformVectorAtPoint(centroidRASTuple, principalAxisX, principalAxisX)
+        stats["principal_axis_x"] = principalAxisX
+
+    if "principal_axis_y" in requestedKeys:
+      centroidRASTuple = None
+      centroidRASArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["centroid_ras"])
+      if centroidRASArray is None:
+        logging.error("Could not calculate principal_axis_y!")
+      else:
+        centroidRASTuple = centroidRASArray.GetTuple(rowIndex)
+
+      principalAxisYTuple = None
+      principalAxisYArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_axis_y"])
+      if principalAxisYArray is None:
+        logging.error("Could not calculate principal_axis_y!")
+      else:
+        principalAxisYTuple = principalAxisYArray.GetTuple(rowIndex)
+
+      if centroidRASTuple is not None and principalAxisYTuple is not None:
+        principalAxisY = list(principalAxisYTuple)
+        transformSegmentToRas.TransformVectorAtPoint(centroidRASTuple, principalAxisY, principalAxisY)
+        stats["principal_axis_y"] = principalAxisY
+
+    if "principal_axis_z" in requestedKeys:
+      centroidRASTuple = None
+      centroidRASArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["centroid_ras"])
+      if centroidRASArray is None:
+        logging.error("Could not calculate principal_axis_z!")
+      else:
+        centroidRASTuple = centroidRASArray.GetTuple(rowIndex)
+
+      principalAxisZTuple = None
+      principalAxisZArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_axis_z"])
+      if principalAxisZArray is None:
+        logging.error("Could not calculate principal_axis_z!")
+      else:
+        principalAxisZTuple = principalAxisZArray.GetTuple(rowIndex)
+
+      if centroidRASTuple is not None and principalAxisZTuple is not None:
+        principalAxisZ = list(principalAxisZTuple)
+        transformSegmentToRas.TransformVectorAtPoint(centroidRASTuple, principalAxisZ, principalAxisZ)
+        stats["principal_axis_z"] = principalAxisZ
+
 
   def getMeasurementInfo(self, key):
     """Get information (name, description, units, ...) about the measurement for the given key"""
@@ -1,4 +1,5 @@
 import vtk, slicer
+import vtkITK
 from SegmentStatisticsPlugins import SegmentStatisticsPluginBase
 from functools import reduce
 
@@ -9,11 +10,15 @@ class ScalarVolumeSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
   def __init__(self):
     super(ScalarVolumeSegmentStatisticsPlugin,self).__init__()
     self.name = "Scalar Volume"
-    self.keys = ["voxel_count", "volume_mm3", "volume_cm3", "min", "max", "mean", "median", "stdev"]
-    self.defaultKeys = self.keys # calculate all measurements by default
+    self.percentileKeys = {"percentile_5": 5.0, "percentile_25": 25.0, "percentile_75": 75.0, "percentile_95": 95.0}
+    self.defaultKeys = ["voxel_count", "volume_mm3", "volume_cm3", "min", "max", "mean", "median", "stdev"]
+    self.keys = self.defaultKeys + sorted(self.percentileKeys.keys(), key=lambda key: self.percentileKeys[key])
     #... developer may add extra options to configure other parameters
 
   def computeStatistics(self, segmentID):
+    return self.computeStatisticsForSegments([segmentID]).get(segmentID, {})
+
+  def computeStatisticsForSegments(self, segmentIDs):
     import vtkSegmentationCorePython as vtkSegmentationCore
     requestedKeys = self.getRequestedKeys()
 
@@ -51,68 +56,63 @@ class ScalarVolumeSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
     cubicMMPerVoxel = reduce(lambda x,y: x*y, referenceGeometry_Reference.GetSpacing())
     ccPerCubicMM = 0.001
 
-    segmentLabelmap = vtkSegmentationCore.vtkOrientedImageData()
-    segmentationNode.GetBinaryLabelmapRepresentation(segmentID, segmentLabelmap)
-    if (not segmentLabelmap
-      or not segmentLabelmap.GetPointData()
-      or not segmentLabelmap.GetPointData().GetScalars()):
-      # No input label data
-      return {}
-
-    segmentLabelmap_Reference = vtkSegmentationCore.vtkOrientedImageData()
-    vtkSegmentationCore.vtkOrientedImageDataResample.ResampleOrientedImageToReferenceOrientedImage(
-      segmentLabelmap, referenceGeometry_Reference, segmentLabelmap_Reference,
-      False, # nearest neighbor interpolation
-      False, # no padding
-      segmentationToReferenceGeometryTransform)
-
-    # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-    labelValue = 1
-    backgroundValue = 0
-    thresh = vtk.vtkImageThreshold()
-    thresh.SetInputData(segmentLabelmap_Reference)
-    thresh.ThresholdByLower(0)
-    thresh.SetInValue(backgroundValue)
-    thresh.SetOutValue(labelValue)
-    thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
-    thresh.Update()
-
-    #  Use binary labelmap as a stencil
-    stencil = vtk.vtkImageToImageStencil()
-    stencil.SetInputData(thresh.GetOutput())
-    stencil.ThresholdByUpper(labelValue)
-    stencil.Update()
-
-    stat = vtk.vtkImageAccumulate()
-    stat.SetInputData(grayscaleNode.GetImageData())
-    stat.SetStencilData(stencil.GetOutput())
-    stat.Update()
-
-    medians = vtk.vtkImageHistogramStatistics()
-    medians.SetInputData(grayscaleNode.GetImageData())
-    medians.SetStencilData(stencil.GetOutput())
-    medians.Update()
-
-    # create statistics list
-    stats = {}
-    if "voxel_count" in requestedKeys:
-      stats["voxel_count"] = stat.GetVoxelCount()
-    if "volume_mm3" in requestedKeys:
-      stats["volume_mm3"] = stat.GetVoxelCount() * cubicMMPerVoxel
-    if "volume_cm3" in requestedKeys:
-      stats["volume_cm3"] = stat.GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM
-    if stat.GetVoxelCount()>0:
-      if "min" in requestedKeys:
-        stats["min"] = stat.GetMin()[0]
-      if "max" in requestedKeys:
-        stats["max"] = stat.GetMax()[0]
-      if "mean" in requestedKeys:
-        stats["mean"] = stat.GetMean()[0]
-      if "stdev" in requestedKeys:
-        stats["stdev"] = stat.GetStandardDeviation()[0]
-      if "median" in requestedKeys:
-        stats["median"] = medians.GetMedian()
-    return stats
+    computeMedian = "median" in requestedKeys
+    requestedPercentileKeys = [key for key in self.percentileKeys if key in requestedKeys]
+
+    statisticsForSegments = {}
+    for layerLabelmap, layerSegmentIDs in self.getSegmentIDsByLayer(segmentationNode.GetSegmentation(), segmentIDs):
+      if (not layerLabelmap
+        or not layerLabelmap.GetPointData()
+        or not layerLabelmap.GetPointData().GetScalars()):
+        # No input label data
+        continue
+
+      layerLabelmap_Reference = vtkSegmentationCore.vtkOrientedImageData()
+      vtkSegmentationCore.vtkOrientedImageDataResample.ResampleOrientedImageToReferenceOrientedImage(
+        layerLabelmap, referenceGeometry_Reference, layerLabelmap_Reference,
+        False, # nearest neighbor interpolation
+        False, # no padding
+        segmentationToReferenceGeometryTransform)
+
+      # Statistics of all segments that are stored in the same labelmap are computed in a single pass
+      stat = vtkITK.vtkITKLabelIntensityStatistics()
+      stat.SetInputData(layerLabelmap_Reference)
+      stat.SetIntensityData(grayscaleNode.GetImageData())
+      stat.SetComputeMedian(computeMedian)
+      for percentileKey in requestedPercentileKeys:
+        stat.AddPercentile(self.percentileKeys[percentileKey])
+      stat.Update()
+      statTable = stat.GetOutput()
+      rowIndices = self.getRowIndicesByLabelValue(statTable)
+
+      # create statistics list
+      for segmentID in layerSegmentIDs:
+        labelValue = segmentationNode.GetSegmentation().GetSegment(segmentID).GetLabelValue()
+        rowIndex = rowIndices[labelValue] if labelValue in rowIndices else None
+        voxelCount = int(statTable.GetColumnByName("VoxelCount").GetValue(rowIndex)) if rowIndex is not None else 0
+        stats = {}
+        if "voxel_count" in requestedKeys:
+          stats["voxel_count"] = voxelCount
+        if "volume_mm3" in requestedKeys:
+          stats["volume_mm3"] = voxelCount * cubicMMPerVoxel
+        if "volume_cm3" in requestedKeys:
+          stats["volume_cm3"] = voxelCount * cubicMMPerVoxel * ccPerCubicMM
+        if voxelCount>0:
+          if "min" in requestedKeys:
+            stats["min"] = statTable.GetColumnByName("Minimum").GetValue(rowIndex)
+          if "max" in requestedKeys:
+            stats["max"] = statTable.GetColumnByName("Maximum").GetValue(rowIndex)
+          if "mean" in requestedKeys:
+            stats["mean"] = statTable.GetColumnByName("Mean").GetValue(rowIndex)
+          if "stdev" in requestedKeys:
+            stats["stdev"] = statTable.GetColumnByName("StandardDeviation").GetValue(rowIndex)
+          if "median" in requestedKeys:
+            stats["median"] = statTable.GetColumnByName("Median").GetValue(rowIndex)
+          for percentileIndex, percentileKey in enumerate(requestedPercentileKeys):
+            stats[percentileKey] = statTable.GetColumnByName("Percentiles").GetComponent(rowIndex, percentileIndex)
+        statisticsForSegments[segmentID] = stats
+
+    return statisticsForSegments
 
   def getMeasurementInfo(self, key):
     """Get information (name, description, units, ...) about the measurement for the given key"""
@@ -186,4 +186,12 @@ class ScalarVolumeSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
                                    unitsDicomCode=scalarVolumeUnits.GetAsString(),
                                    derivationDicomCode=self.createCodedEntry('386136009','SCT','Standard Deviation', True))
 
+    for percentileKey, percentile in self.percentileKeys.items():
+      info[percentileKey] = \
+        self.createMeasurementInfo(name="%gth percentile" % percentile,
+                                     description="%gth percentile of scalar values" % percentile,
+                                     units=scalarVolumeUnits.GetCodeMeaning(),
+                                     quantityDicomCode=scalarVolumeQuantity.GetAsString(),
+                                     unitsDicomCode=scalarVolumeUnits.GetAsString())
+
     return info[key] if key in info else None
@@ -51,12 +51,49 @@ class SegmentStatisticsPluginBase(object):
     if self.parameterNode and self.parameterNodeObserver:
       self.parameterNode.RemoveObserver(self.parameterNodeObserver)
 
+  @staticmethod
+  def getSegmentIDsByLayer(segmentation, segmentIDs):
+    """Group segments by the shared binary labelmap (layer) that stores them.
+    Returns list of (layer labelmap, list of segment IDs) pairs.
+    """
+    import vtkSegmentationCorePython as vtkSegmentationCore
+    binaryLabelmapName = vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName()
+    segmentIDsByLayerIndex = {}
+    for segmentID in segmentIDs:
+      if not segmentation.GetSegment(segmentID):
+        continue
+      layerIndex = segmentation.GetLayerIndex(segmentID, binaryLabelmapName)
+      if layerIndex < 0:
+        continue
+      segmentIDsByLayerIndex.setdefault(layerIndex, []).append(segmentID)
+    return [(segmentation.GetLayerDataObject(layerIndex, binaryLabelmapName), layerSegmentIDs)
+      for layerIndex, layerSegmentIDs in sorted(segmentIDsByLayerIndex.items())]
+
+  @staticmethod
+  def getRowIndicesByLabelValue(table):
+    """Get dictionary mapping label values to row indices of a label statistics table"""
+    labelValueArray = table.GetColumnByName("LabelValue")
+    if not labelValueArray:
+      return {}
+    return {int(labelValueArray.GetValue(rowIndex)): rowIndex for rowIndex in range(labelValueArray.GetNumberOfTuples())}
+
   def computeStatistics(self, segmentID):
     """Compute measurements for requested keys on the given segment and return
     as dictionary mapping key's to measurement results
     """
     pass
 
+  def computeStatisticsForSegments(self, segmentIDs):
+    """Compute measurements for requested keys on the given segments and return
+    as dictionary mapping segment IDs to measurement results.
+    Plugins that can compute measurements of multiple segments more efficiently than
+    one by one (for example, all segments of a shared labelmap in a single pass) should override this method.
+    """
+    statisticsForSegments = {}
+    for segmentID in segmentIDs:
+      statisticsForSegments[segmentID] = self.computeStatistics(segmentID)
+    return statisticsForSegments
+
   def getMeasurementInfo(self, key):
     """Get information (name, description, units, ...) about the measurement for the given key.
     Utilize createMeasurementInfo() to create the dictionary containing the measurement information.